@@ -453,6 +453,17 @@ public:
 	}
 
 
+	///getContiguousNodeArray and getNumContiguousNodes give access to the nodes of a non-quantized tree, in the order of a stackless walk
+	SIMD_FORCE_INLINE const NodeArray&	getContiguousNodeArray() const
+	{
+		return	m_contiguousNodes;
+	}
+
+	SIMD_FORCE_INLINE int	getNumContiguousNodes() const
+	{
+		return	m_curNodeIndex;
+	}
+
 	SIMD_FORCE_INLINE BvhSubtreeInfoArray&	getSubtreeInfoArray()
 	{
 		return m_SubtreeHeaders;
@@ -108,10 +108,16 @@ void btConvexTriangleCallback::processTriangle(btVector3* triangle,int partId, i
 		btTriangleShape tm(triangle[0],triangle[1],triangle[2]);	
 		tm.setMargin(m_collisionMarginTriangle);
 		
-		btCollisionShape* tmpShape = ob->getCollisionShape();
-		ob->internalSetTemporaryCollisionShape( &tm );
+		// STK: use a temporary object for the triangle instead of changing
+		// the shape of the concave object, which is shared by all pairs with
+		// the track. This allows STKCollisionDispatcher to process these
+		// pairs in parallel.
+		btCollisionObject triOb;
+		triOb.setWorldTransform(ob->getWorldTransform());
+		triOb.setInterpolationWorldTransform(ob->getInterpolationWorldTransform());
+		triOb.internalSetTemporaryCollisionShape( &tm );
 
-		btCollisionAlgorithm* colAlgo = ci.m_dispatcher1->findAlgorithm(m_convexBody,m_triBody,m_manifoldPtr);
+		btCollisionAlgorithm* colAlgo = ci.m_dispatcher1->findAlgorithm(m_convexBody,&triOb,m_manifoldPtr);
 
 		if (m_resultOut->getBody0Internal() == m_triBody)
 		{
@@ -122,10 +128,9 @@ void btConvexTriangleCallback::processTriangle(btVector3* triangle,int partId, i
 			m_resultOut->setShapeIdentifiersB(partId,triangleIndex);
 		}
 	
-		colAlgo->processCollision(m_convexBody,m_triBody,*m_dispatchInfoPtr,m_resultOut);
+		colAlgo->processCollision(m_convexBody,&triOb,*m_dispatchInfoPtr,m_resultOut);
 		colAlgo->~btCollisionAlgorithm();
 		ci.m_dispatcher1->freeCollisionAlgorithm(colAlgo);
-		ob->internalSetTemporaryCollisionShape( tmpShape);
 	}
 
 
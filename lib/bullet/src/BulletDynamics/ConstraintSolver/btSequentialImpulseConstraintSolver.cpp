@@ -1240,8 +1240,10 @@ void	btSequentialImpulseConstraintSolver::reset()
 
 btRigidBody& btSequentialImpulseConstraintSolver::getFixedBody()
 {
+	// STK: the constructor already sets a zero mass, don't set it again on
+	// each call, since several solvers can run in parallel (see
+	// STKDynamicsWorld::solveConstraints).
 	static btRigidBody s_fixed(0, 0,0);
-	s_fixed.setMassProps(btScalar(0.),btVector3(btScalar(0.),btScalar(0.),btScalar(0.)));
 	return s_fixed;
 }
 
@@ -16,7 +16,10 @@
 #define BT_QUICK_PROF_H
 
 //To disable built-in profiling, please comment out next line
-//#define BT_NO_PROFILE 1
+// STK: the profile tree is not thread safe, and the physics world can be
+// stepped with a thread pool (see STKDynamicsWorld). STK doesn't use the
+// profile, so it is disabled.
+#define BT_NO_PROFILE 1
 #ifndef BT_NO_PROFILE
 #include <stdio.h>//@todo remove this, backwards compatibility
 #include "btScalar.h"
@@ -458,6 +458,17 @@ namespace UserConfigParams
     PARAM_PREFIX BoolUserConfigParam          m_karts_powerup_gui
             PARAM_DEFAULT(  BoolUserConfigParam(false, "karts-powerup-gui",
             &m_race_setup_group, "Show other karts' held powerups in race gui.") );
+    PARAM_PREFIX IntUserConfigParam          m_ai_threads
+            PARAM_DEFAULT(  IntUserConfigParam(-1, "ai-threads",
+            &m_race_setup_group, "Number of extra threads used to compute the "
+            "decisions of the AI karts, -1 means one less than the number of "
+            "cpu cores (at most 3), 0 disables it.") );
+
+    PARAM_PREFIX IntUserConfigParam          m_physics_threads
+            PARAM_DEFAULT(  IntUserConfigParam(0, "physics-threads",
+            &m_race_setup_group, "Number of extra threads used to step the "
+            "physics, 0 disables it. The result is the same with any number "
+            "of threads.") );
 
     // ---- Wiimote data
     PARAM_PREFIX GroupUserConfigParam        m_wiimote_group
@@ -692,6 +703,9 @@ namespace UserConfigParams
     /** If gamepad debugging is enabled. */
     PARAM_PREFIX bool m_unit_testing PARAM_DEFAULT(false);
 
+    /** If benchmarks should be run (--benchmark). */
+    PARAM_PREFIX bool m_benchmark PARAM_DEFAULT(false);
+
     /** If gamepad debugging is enabled. */
     PARAM_PREFIX bool m_gamepad_debug PARAM_DEFAULT( false );
 
@@ -717,6 +731,21 @@ namespace UserConfigParams
     /** True if physics debugging should be enabled. */
     PARAM_PREFIX bool m_physics_debug PARAM_DEFAULT( false );
 
+    /** True if the suspension rays of the wheels of a kart are cast as one
+     *  packet (disabled with --no-raycast-packets). */
+    PARAM_PREFIX bool m_raycast_packets PARAM_DEFAULT( true );
+
+    /** True if each raycast of a packet should be compared with a single
+     *  raycast (--check-raycasts). */
+    PARAM_PREFIX bool m_check_raycasts PARAM_DEFAULT( false );
+
+    /** True if the wall time of the startup phases should be printed
+     *  (--startup-profile). */
+    PARAM_PREFIX bool m_startup_profile PARAM_DEFAULT( false );
+
+    /** True if parsed XML files are cached (disabled with --no-xml-cache). */
+    PARAM_PREFIX bool m_xml_cache PARAM_DEFAULT( true );
+
     /** True if fps should be printed each frame. */
     PARAM_PREFIX bool m_fps_debug PARAM_DEFAULT(false);
 
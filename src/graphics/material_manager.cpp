@@ -19,6 +19,7 @@
 
 #include "graphics/material_manager.hpp"
 
+#include <algorithm>
 #include <stdexcept>
 #include <sstream>
 
@@ -31,8 +32,12 @@
 #include "io/xml_node.hpp"
 #include "modes/profile_world.hpp"
 #include "modes/world.hpp"
+#include "physics/spm_collision_loader.hpp"
 #include "tracks/track.hpp"
+#include "tracks/track_manager.hpp"
+#include "utils/file_utils.hpp"
 #include "utils/string_utils.hpp"
+#include "utils/time.hpp"
 
 #include <ITexture.h>
 #include <SMaterial.h>
@@ -45,6 +50,7 @@ MaterialManager::MaterialManager()
     /* Create list - and default material zero */
 
     m_materials.reserve(256);
+    m_linear_search = false;
     // We can't call init/loadMaterial here, since the global variable
     // material_manager has not yet been initialised, and
     // material_manager is used in the Material constructor.
@@ -67,6 +73,8 @@ MaterialManager::~MaterialManager()
         delete m_materials[i];
     }
     m_materials.clear();
+    m_fname_index.clear();
+    m_full_path_index.clear();
 
     for (std::map<std::string, Material*> ::iterator it =
          m_default_sp_materials.begin(); it != m_default_sp_materials.end();
@@ -100,54 +108,82 @@ Material* MaterialManager::getMaterialSPM(std::string lay_one_tex_lc,
     const bool is_full_path = !lay_one_tex_lc.empty() &&
         (lay_one_tex_lc.find('/') != std::string::npos ||
         lay_one_tex_lc.find('\\') != std::string::npos);
-    if (is_full_path)
+    Material *m = NULL;
+    if (m_linear_search)
     {
-        // Search backward so that temporary (track) textures are found first
-        for (int i = (int)m_materials.size() - 1; i >= 0; i--)
+        if (!lay_one_tex_lc.empty())
         {
-            if (m_materials[i]->getTexFullPath() == lay_one_tex_lc)
-            {
-                const std::string& mat_lay_two = m_materials[i]->getUVTwoTexture();
-                if (mat_lay_two.empty() && lay_two_tex_lc.empty())
-                {
-                    return m_materials[i];
-                }
-                else if (!mat_lay_two.empty() && !lay_two_tex_lc.empty())
-                {
-                    if (mat_lay_two == lay_two_tex_lc)
-                    {
-                        return m_materials[i];
-                    }
-                }
-            }
+            m = findMaterialSPMLinear(lay_one_tex_lc, lay_two_tex_lc,
+                                      is_full_path);
         }
     }
+    else if (is_full_path)
+    {
+        auto it = m_full_path_index.find(lay_one_tex_lc);
+        if (it != m_full_path_index.end())
+            m = findMaterialSPM(&it->second, lay_two_tex_lc);
+    }
     else if (!lay_one_tex_lc.empty())
     {
-        for (int i = (int)m_materials.size() - 1; i >= 0; i--)
-        {
-            if (m_materials[i]->getTexFname() == lay_one_tex_lc)
-            {
-                const std::string& mat_lay_two = m_materials[i]->getUVTwoTexture();
-                if (mat_lay_two.empty() && lay_two_tex_lc.empty())
-                {
-                    return m_materials[i];
-                }
-                else if (!mat_lay_two.empty() && !lay_two_tex_lc.empty())
-                {
-                    if (mat_lay_two == lay_two_tex_lc)
-                    {
-                        return m_materials[i];
-                    }
-                }
-            }
-        }   // for i
+        auto it = m_fname_index.find(lay_one_tex_lc);
+        if (it != m_fname_index.end())
+            m = findMaterialSPM(&it->second, lay_two_tex_lc);
     }
+    if (m)
+        return m;
     return getDefaultSPMaterial(def_shader_name,
         is_full_path ?
         original_layer_one : StringUtils::getBasename(original_layer_one),
         is_full_path);
-}
+}   // getMaterialSPM
+
+//-----------------------------------------------------------------------------
+/** Returns the last material of the given indices in m_materials which uses
+ *  the same second layer texture (or none if lay_two_tex_lc is empty), or
+ *  NULL if there is no such material.
+ */
+Material* MaterialManager::findMaterialSPM(const std::vector<int> *indices,
+                                       const std::string &lay_two_tex_lc) const
+{
+    // Search backward so that temporary (track) textures are found first
+    for (int i = (int)indices->size() - 1; i >= 0; i--)
+    {
+        Material *m = m_materials[(*indices)[i]];
+        const std::string& mat_lay_two = m->getUVTwoTexture();
+        if (mat_lay_two.empty() && lay_two_tex_lc.empty())
+            return m;
+        else if (!mat_lay_two.empty() && mat_lay_two == lay_two_tex_lc)
+            return m;
+    }
+    return NULL;
+}   // findMaterialSPM
+
+//-----------------------------------------------------------------------------
+/** Returns the last material in m_materials with the given first and second
+ *  layer texture, or NULL if there is no such material. This is the search
+ *  getMaterialSPM() used before the indices were added, it is only kept so
+ *  that benchmark() can compare both.
+ */
+Material* MaterialManager::findMaterialSPMLinear(
+                                       const std::string &lay_one_tex_lc,
+                                       const std::string &lay_two_tex_lc,
+                                       bool is_full_path) const
+{
+    // Search backward so that temporary (track) textures are found first
+    for (int i = (int)m_materials.size() - 1; i >= 0; i--)
+    {
+        Material *m = m_materials[i];
+        if ((is_full_path ? m->getTexFullPath() : m->getTexFname()) !=
+            lay_one_tex_lc)
+            continue;
+        const std::string& mat_lay_two = m->getUVTwoTexture();
+        if (mat_lay_two.empty() && lay_two_tex_lc.empty())
+            return m;
+        else if (!mat_lay_two.empty() && mat_lay_two == lay_two_tex_lc)
+            return m;
+    }
+    return NULL;
+}   // findMaterialSPMLinear
 
 //-----------------------------------------------------------------------------
 Material* MaterialManager::getMaterialFor(video::ITexture* t)
@@ -156,27 +192,19 @@ Material* MaterialManager::getMaterialFor(video::ITexture* t)
 
     if (!img_path.empty() && (img_path.findFirst('/') != -1 || img_path.findFirst('\\') != -1))
     {
-        // Search backward so that temporary (track) textures are found first
-        for (int i = (int)m_materials.size() - 1; i >= 0; i--)
-        {
-            if (m_materials[i]->getTexFullPath() == img_path.c_str())
-            {
-                return m_materials[i];
-            }
-        }
+        // The last index is the one of a temporary (track) texture
+        auto it = m_full_path_index.find(img_path.c_str());
+        if (it != m_full_path_index.end())
+            return m_materials[it->second.back()];
     }
     else
     {
         core::stringc image(StringUtils::getBasename(img_path.c_str()).c_str());
         image.make_lower();
 
-        for (int i = (int)m_materials.size() - 1; i >= 0; i--)
-        {
-            if (m_materials[i]->getTexFname() == image.c_str())
-            {
-                return m_materials[i];
-            }
-        }   // for i
+        auto it = m_fname_index.find(image.c_str());
+        if (it != m_fname_index.end())
+            return m_materials[it->second.back()];
     }
     return NULL;
 }
@@ -251,10 +279,79 @@ void MaterialManager::setAllUntexturedMaterialFlags(scene::IMeshBuffer *mb)
 //-----------------------------------------------------------------------------
 int MaterialManager::addEntity(Material *m)
 {
-    m_materials.push_back(m);
+    addMaterial(m);
     return (int)m_materials.size()-1;
 }
 
+//-----------------------------------------------------------------------------
+/** Appends a material to m_materials and adds it to the name indices.
+ */
+void MaterialManager::addMaterial(Material *m)
+{
+    const int index = (int)m_materials.size();
+    m_materials.push_back(m);
+    m_fname_index[m->getTexFname()].push_back(index);
+    // A material without path is never found by full path
+    if (!m->getTexFullPath().empty())
+        m_full_path_index[m->getTexFullPath()].push_back(index);
+}   // addMaterial
+
+//-----------------------------------------------------------------------------
+/** Removes the last material from m_materials and the name indices, and
+ *  deletes it.
+ */
+void MaterialManager::removeLastMaterial()
+{
+    const int index = (int)m_materials.size() - 1;
+    Material *m = m_materials[index];
+    // The last material always has the largest index of its names
+    auto fname = m_fname_index.find(m->getTexFname());
+    assert(fname != m_fname_index.end() && fname->second.back() == index);
+    fname->second.pop_back();
+    if (fname->second.empty())
+        m_fname_index.erase(fname);
+    if (!m->getTexFullPath().empty())
+    {
+        auto path = m_full_path_index.find(m->getTexFullPath());
+        assert(path != m_full_path_index.end() &&
+               path->second.back() == index);
+        path->second.pop_back();
+        if (path->second.empty())
+            m_full_path_index.erase(path);
+    }
+    delete m;
+    m_materials.pop_back();
+}   // removeLastMaterial
+
+//-----------------------------------------------------------------------------
+/** Called by Material::install() when the texture name of a material is
+ *  changed, to move it to the right entry of the name index. Nothing is done
+ *  for materials which are not (yet) in m_materials.
+ *  \param m The material.
+ *  \param old_fname The texture name before the change.
+ */
+void MaterialManager::updateTexFname(Material *m, const std::string &old_fname)
+{
+    auto old_it = m_fname_index.find(old_fname);
+    if (old_it == m_fname_index.end())
+        return;
+    std::vector<int> &old_indices = old_it->second;
+    for (int i = (int)old_indices.size() - 1; i >= 0; i--)
+    {
+        const int index = old_indices[i];
+        if (m_materials[index] != m)
+            continue;
+        old_indices.erase(old_indices.begin() + i);
+        if (old_indices.empty())
+            m_fname_index.erase(old_it);
+        // Keep the indices sorted, so that the last one is still found first
+        std::vector<int> &new_indices = m_fname_index[m->getTexFname()];
+        new_indices.insert(std::lower_bound(new_indices.begin(),
+                                            new_indices.end(), index), index);
+        return;
+    }
+}   // updateTexFname
+
 //-----------------------------------------------------------------------------
 void MaterialManager::loadMaterial()
 {
@@ -322,7 +419,7 @@ bool MaterialManager::pushTempMaterial(const XMLNode *root,
         }
         try
         {
-            m_materials.push_back(new Material(node, deprecated));
+            addMaterial(new Material(node, deprecated));
         }
         catch(std::exception& e)
         {
@@ -339,9 +436,8 @@ void MaterialManager::popTempMaterial()
 {
     for(int i=(int)m_materials.size()-1; i>=this->m_shared_material_index; i--)
     {
-        delete m_materials[i];
-        m_materials.pop_back();
-    }   // for i6
+        removeLastMaterial();
+    }   // for i
 }   // popTempMaterial
 
 //-----------------------------------------------------------------------------
@@ -385,16 +481,14 @@ Material *MaterialManager::getMaterial(const std::string& fname,
     core::stringc basename_lower(basename.c_str());
     basename_lower.make_lower();
 
-    // Search backward so that temporary (track) textures are found first
-    for (int i = (int)m_materials.size()-1; i>=0; i-- )
-    {
-        if (m_materials[i]->getTexFname() == basename_lower.c_str())
-            return m_materials[i];
-    }
+    // The last index is the one of a temporary (track) texture
+    auto it = m_fname_index.find(basename_lower.c_str());
+    if (it != m_fname_index.end())
+        return m_materials[it->second.back()];
 
     // Add the new material
     Material* m = new Material(fname, is_full_path, complain_if_not_found, install);
-    m_materials.push_back(m);
+    addMaterial(m);
     if(make_permanent)
     {
         assert(m_shared_material_index==(int)m_materials.size()-1);
@@ -441,10 +535,120 @@ bool MaterialManager::hasMaterial(const std::string& fname)
 {
     std::string basename=StringUtils::getBasename(fname);
 
-    // Search backward so that temporary (track) textures are found first
-    for(int i = (int)m_materials.size()-1; i>=0; i-- )
+    return m_fname_index.find(basename) != m_fname_index.end();
+}   // hasMaterial
+
+// ----------------------------------------------------------------------------
+/** Compares the material lookups done while loading a track, using the name
+ *  indices, with the backward search of all materials that was used before.
+ *  For the (up to) three shipped tracks with the largest static models, the
+ *  mesh buffers of the main track model and of all static objects are read
+ *  like a server loads them (see SPMCollisionLoader), which looks up the
+ *  material of each buffer with getMaterialSPM(). This is timed with both
+ *  searches, and the materials found are compared.
+ */
+void MaterialManager::benchmark()
+{
+    MaterialManager *mm = material_manager;
+    if (!mm || !track_manager)
+        return;
+
+    // Find the tracks with the largest static models
+    std::vector<std::pair<uint64_t, Track*> > tracks;
+    for (unsigned i = 0; i < track_manager->getNumberOfTracks(); i++)
     {
-        if(m_materials[i]->getTexFname()==basename) return true;
+        Track *track = track_manager->getTrack(i);
+        if (track->isAddon())
+            continue;
+        std::vector<Track::StaticModel> models;
+        track->getStaticModels(&models);
+        uint64_t size = 0;
+        for (const Track::StaticModel &model : models)
+        {
+            struct stat st;
+            if (FileUtils::statU8Path(model.m_full_path, &st) == 0)
+                size += st.st_size;
+        }
+        if (size > 0)
+            tracks.push_back(std::make_pair(size, track));
     }
-    return false;
-}
+    std::sort(tracks.begin(), tracks.end(),
+        [](const std::pair<uint64_t, Track*> &a,
+           const std::pair<uint64_t, Track*> &b)
+        {
+            return a.first > b.first;
+        });
+    if (tracks.size() > 3)
+        tracks.resize(3);
+
+    // Loads all static models of a track, and returns the materials of
+    // all mesh buffers
+    auto load_models = [](const std::vector<Track::StaticModel> &models,
+                          std::vector<const Material*> *materials)
+    {
+        materials->clear();
+        std::vector<SPMCollisionLoader::Buffer> buffers;
+        for (const Track::StaticModel &model : models)
+        {
+            if (!SPMCollisionLoader::load(model.m_full_path, &buffers))
+                continue;
+            for (const SPMCollisionLoader::Buffer &b : buffers)
+                materials->push_back(b.m_material);
+        }
+    };
+
+    const unsigned repeats = 3;
+    for (const std::pair<uint64_t, Track*> &t : tracks)
+    {
+        Track *track = t.second;
+        std::vector<Track::StaticModel> models;
+        track->getStaticModels(&models);
+
+        file_manager->pushTextureSearchPath(track->getTrackFile(""),
+            StringUtils::insertValues("tracks/%s",
+                                      track->getIdent().c_str()));
+        file_manager->pushModelSearchPath(track->getTrackFile(""));
+        const int first = (int)mm->m_materials.size();
+        const std::string materials_file =
+            track->getTrackFile("materials.xml");
+        const bool has_materials = file_manager->fileExists(materials_file);
+        if (has_materials)
+            mm->pushTempMaterial(materials_file);
+
+        std::vector<const Material*> linear_materials, indexed_materials;
+        mm->m_linear_search = true;
+        uint64_t start = StkTime::getMonoTimeUs();
+        for (unsigned r = 0; r < repeats; r++)
+            load_models(models, &linear_materials);
+        const uint64_t linear_us = StkTime::getMonoTimeUs() - start;
+
+        mm->m_linear_search = false;
+        start = StkTime::getMonoTimeUs();
+        for (unsigned r = 0; r < repeats; r++)
+            load_models(models, &indexed_materials);
+        const uint64_t indexed_us = StkTime::getMonoTimeUs() - start;
+
+        unsigned mismatches = 0;
+        for (unsigned i = 0; i < linear_materials.size() &&
+                             i < indexed_materials.size(); i++)
+        {
+            if (linear_materials[i] != indexed_materials[i])
+                mismatches++;
+        }
+
+        Log::info("Benchmark", "Track '%s': %d models (%.1f MB), %d track "
+            "and %d shared materials, %u mesh buffers, loaded %u times: "
+            "linear search %.2f ms, index %.2f ms, %u mismatches%s.",
+            track->getIdent().c_str(), (int)models.size(),
+            t.first / 1048576.0f, (int)mm->m_materials.size() - first, first,
+            (unsigned)indexed_materials.size(), repeats, linear_us / 1000.0f,
+            indexed_us / 1000.0f, mismatches,
+            linear_materials.size() == indexed_materials.size() ? "" :
+            ", DIFFERENT NUMBER OF BUFFERS");
+
+        if (has_materials)
+            mm->popTempMaterial();
+        file_manager->popModelSearchPath();
+        file_manager->popTextureSearchPath();
+    }
+}   // benchmark
@@ -31,6 +31,7 @@ using namespace irr;
 
 #include <irrlicht.h>
 #include <string>
+#include <unordered_map>
 #include <vector>
 #include <map>
 
@@ -50,8 +51,28 @@ private:
 
     std::vector<Material*> m_materials;
 
+    /** The indices in m_materials of all materials with a given texture
+     *  file name, and with a given full path, in increasing order. The last
+     *  index of a name is the material a backward search of m_materials
+     *  would find, i.e. temporary (track) materials are found before shared
+     *  ones. */
+    std::unordered_map<std::string, std::vector<int> > m_fname_index;
+    std::unordered_map<std::string, std::vector<int> > m_full_path_index;
+
     std::map<std::string, Material*> m_default_sp_materials;
 
+    /** Only used by benchmark(): if set, getMaterialSPM() searches all
+     *  materials backward instead of using the indices. */
+    bool m_linear_search;
+
+    void      addMaterial(Material *m);
+    void      removeLastMaterial();
+    Material* findMaterialSPM(const std::vector<int> *indices,
+                              const std::string &lay_two_tex_lc) const;
+    Material* findMaterialSPMLinear(const std::string &lay_one_tex_lc,
+                                    const std::string &lay_two_tex_lc,
+                                    bool is_full_path) const;
+
 public:
               MaterialManager();
              ~MaterialManager();
@@ -87,6 +108,8 @@ public:
                                    const std::string& layer_one_lc = "",
                                    bool full_path = false);
     Material* getLatestMaterial() { return m_materials[m_materials.size()-1]; }
+    void      updateTexFname(Material *m, const std::string &old_fname);
+    static void benchmark();
 };   // MaterialManager
 
 extern MaterialManager *material_manager;
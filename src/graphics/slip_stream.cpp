@@ -29,6 +29,7 @@
 #include "io/file_manager.hpp"
 #include "karts/abstract_kart.hpp"
 #include "karts/controller/controller.hpp"
+#include "karts/kart_grid.hpp"
 #include "karts/kart_properties.hpp"
 #include "karts/max_speed.hpp"
 #include "modes/world.hpp"
@@ -38,6 +39,8 @@
 #include "utils/constants.hpp"
 #include "utils/mini_glm.hpp"
 
+#include <algorithm>
+
 /** Creates the slip stream object
  *  \param kart Pointer to the kart to which the slip stream
  *              belongs to.
@@ -683,15 +686,30 @@ void SlipStream::update(int ticks)
     bool is_inner_sstreaming = false;
     bool is_outer_sstreaming = false;
     m_target_kart            = NULL;
-    std::vector<float> target_value;
-
-    // Note that this loop can not be simply replaced with a shorter loop
-    // using only the karts with a better position - since a kart might
-    // be a lap behind
-    for(unsigned int i=0; i<num_karts; i++)
+    std::vector<float> target_value(num_karts, 0.0f);
+
+    // Only the karts passing the quick distance test below can give
+    // slipstream, so only karts close by need to be tested. Note that this
+    // can not be simply replaced with a loop using only the karts with a
+    // better position - since a kart might be a lap behind. The previous
+    // target is always tested, since it must be reset if it doesn't give
+    // slipstream anymore.
+    const KartGrid &grid = world->getKartGrid();
+    std::vector<unsigned int> near_karts;
+    grid.findKarts(m_kart->getXYZ(), grid.getMaxSlipstreamReach()
+                   + 0.5f*m_kart->getKartLength() + 1.0f, &near_karts);
+    if (m_previous_target_id >= 0 &&
+        !std::binary_search(near_karts.begin(), near_karts.end(),
+                            (unsigned int)m_previous_target_id))
+    {
+        near_karts.insert(std::lower_bound(near_karts.begin(),
+                                           near_karts.end(),
+                                           (unsigned int)m_previous_target_id),
+                          (unsigned int)m_previous_target_id);
+    }
+    for(unsigned int i : near_karts)
     {
         m_target_kart= world->getKart(i);
-        target_value.push_back(0);
 
         // Don't test for slipstream with itself, a kart that is being
         // rescued or exploding, a ghost kart or an eliminated kart
@@ -787,7 +805,12 @@ void SlipStream::update(int ticks)
             is_outer_sstreaming     = true;
             continue;
         }
-    }   // for i < num_karts
+    }   // for i in near_karts
+
+    // The loop over all karts used to leave the last kart as target if
+    // no kart gives slipstream, keep this for the AI (see
+    // SkiddingAI::checkCrashes)
+    m_target_kart = num_karts > 0 ? world->getKart(num_karts - 1) : NULL;
 
     int best_target=-1;
     float best_target_value=0.0f;
@@ -32,6 +32,7 @@
 #include "utils/file_utils.hpp"
 #include "utils/log.hpp"
 #include "utils/string_utils.hpp"
+#include "utils/thread_pool.hpp"
 
 #ifdef ANDROID
 #include "io/assets_android.hpp"
@@ -252,6 +253,8 @@ FileManager::FileManager()
     checkAndCreateScreenshotDir();
     checkAndCreateReplayDir();
     checkAndCreateCachedTexturesDir();
+    checkAndCreateCachedPhysicsDir();
+    checkAndCreateCachedXMLDir();
     checkAndCreateGPDir();
 
     redirectOutput();
@@ -496,6 +499,7 @@ FileManager::~FileManager()
 
     // Clean up rest of file manager
     // =============================
+    clearPreloadedXMLTrees();
     popMusicSearchPath();
     popModelSearchPath();
     popTextureSearchPath();
@@ -540,8 +544,16 @@ void FileManager::addRootDirs(const std::string &roots)
 }   // addRootDirs
 
 //-----------------------------------------------------------------------------
+/** Creates an XML reader for a file. Opening the file searches the file
+ *  archives of the irrlicht file system, which other threads can change, so
+ *  this is done under m_file_system_lock. The reader reads and closes the
+ *  whole file when it is created, so it can be used without the lock, e.g.
+ *  to parse several files in parallel (see preloadXMLTrees()).
+ *  \param filename Name of the XML file.
+ */
 io::IXMLReader *FileManager::createXMLReader(const std::string &filename)
 {
+    std::lock_guard<std::mutex> lock(m_file_system_lock);
     return m_file_system->createXMLReader(filename.c_str());
 }   // getXMLReader
 //-----------------------------------------------------------------------------
@@ -550,6 +562,10 @@ io::IXMLReader *FileManager::createXMLReader(const std::string &filename)
  */
 XMLNode *FileManager::createXMLTree(const std::string &filename)
 {
+    XMLNode *preloaded = takePreloadedXMLTree(filename);
+    if (preloaded)
+        return preloaded;
+
     try
     {
         XMLNode* node = new XMLNode(filename);
@@ -595,6 +611,92 @@ XMLNode *FileManager::createXMLTreeFromString(const std::string & content)
     }
 }   // createXMLTreeFromString
 
+//-----------------------------------------------------------------------------
+/** Parses the given XML files in parallel and keeps the trees, so that the
+ *  next createXMLTree() call for one of these files only has to take the
+ *  tree. This is used at startup, where hundreds of kart.xml, track.xml and
+ *  materials.xml files are read one after another, while the managers then
+ *  use the trees on the main thread in the same order as before. Files which
+ *  can't be parsed are not kept, so the error is reported when they are
+ *  actually read. The workers only read the files under m_file_system_lock
+ *  (see createXMLReader()), the parsing is done in parallel.
+ *  \param files The XML files, with the same names as later used in
+ *         createXMLTree().
+ *  \param num_threads Number of worker threads used in addition to the
+ *         calling thread.
+ */
+void FileManager::preloadXMLTrees(const std::vector<std::string> &files,
+                                  unsigned num_threads)
+{
+    std::vector<XMLNode*> trees(files.size(), NULL);
+    std::function<void(unsigned)> parse = [&files, &trees](unsigned i)
+    {
+        try
+        {
+            trees[i] = new XMLNode(files[i]);
+        }
+        catch (std::runtime_error&)
+        {
+            trees[i] = NULL;
+        }
+    };
+
+    if (num_threads > 0 && files.size() > 1)
+    {
+        ThreadPool pool(num_threads, "XMLPreload");
+        pool.parallelFor((unsigned)files.size(), parse);
+    }
+    else
+    {
+        for (unsigned int i = 0; i < files.size(); i++)
+            parse(i);
+    }
+
+    std::lock_guard<std::mutex> lock(m_preloaded_xml_lock);
+    for (unsigned int i = 0; i < files.size(); i++)
+    {
+        if (!trees[i])
+            continue;
+        XMLNode* &tree = m_preloaded_xml[files[i]];
+        // The same file can be listed more than once
+        delete tree;
+        tree = trees[i];
+    }
+}   // preloadXMLTrees
+
+//-----------------------------------------------------------------------------
+/** Returns the tree of a file parsed by preloadXMLTrees() and passes its
+ *  ownership to the caller, or NULL if the file was not preloaded.
+ *  \param filename Name of the XML file.
+ */
+XMLNode *FileManager::takePreloadedXMLTree(const std::string &filename)
+{
+    std::lock_guard<std::mutex> lock(m_preloaded_xml_lock);
+    if (m_preloaded_xml.empty())
+        return NULL;
+    std::map<std::string, XMLNode*>::iterator i =
+        m_preloaded_xml.find(filename);
+    if (i == m_preloaded_xml.end())
+        return NULL;
+    XMLNode *tree = i->second;
+    m_preloaded_xml.erase(i);
+    return tree;
+}   // takePreloadedXMLTree
+
+//-----------------------------------------------------------------------------
+/** Frees all preloaded trees which were not used, e.g. of karts that were
+ *  skipped. Called once startup is done, so that later changes of a file
+ *  (e.g. when installing an addon) are read again.
+ */
+void FileManager::clearPreloadedXMLTrees()
+{
+    std::lock_guard<std::mutex> lock(m_preloaded_xml_lock);
+    for (std::map<std::string, XMLNode*>::iterator i = m_preloaded_xml.begin();
+         i != m_preloaded_xml.end(); i++)
+        delete i->second;
+    m_preloaded_xml.clear();
+}   // clearPreloadedXMLTrees
+
 //-----------------------------------------------------------------------------
 /** In order to add and later remove paths we have to specify the absolute
  *  filename (and replace '\' with '/' on windows).
@@ -826,6 +928,23 @@ std::string FileManager::getCachedTexturesDir() const
     return m_cached_textures_dir;
 }   // getCachedTexturesDir
 
+//-----------------------------------------------------------------------------
+/** Returns the directory in which the collision trees of tracks should be
+ *  cached.
+ */
+std::string FileManager::getCachedPhysicsDir() const
+{
+    return m_cached_physics_dir;
+}   // getCachedPhysicsDir
+
+//-----------------------------------------------------------------------------
+/** Returns the directory in which the parsed XML files are cached.
+ */
+std::string FileManager::getCachedXMLDir() const
+{
+    return m_cached_xml_dir;
+}   // getCachedXMLDir
+
 //-----------------------------------------------------------------------------
 /** Returns the directory in which user-defined grand prix should be stored.
  */
@@ -1168,6 +1287,56 @@ void FileManager::checkAndCreateCachedTexturesDir()
 
 }   // checkAndCreateCachedTexturesDir
 
+// ----------------------------------------------------------------------------
+/** Creates the directory for the cached collision trees of tracks. This will
+ *  set m_cached_physics_dir with the appropriate path.
+ */
+void FileManager::checkAndCreateCachedPhysicsDir()
+{
+#if defined(WIN32)
+    m_cached_physics_dir = m_user_config_dir + "cached-physics/";
+#elif defined(__APPLE__)
+    m_cached_physics_dir = getenv("HOME");
+    m_cached_physics_dir += "/Library/Application Support/SuperTuxKart/CachedPhysics/";
+#else
+    m_cached_physics_dir = checkAndCreateLinuxDir("XDG_CACHE_HOME", "supertuxkart", ".cache/", ".");
+    m_cached_physics_dir += "cached-physics/";
+#endif
+
+    if (!checkAndCreateDirectory(m_cached_physics_dir))
+    {
+        Log::error("FileManager", "Can not create cached physics directory '%s', "
+            "falling back to '.'.", m_cached_physics_dir.c_str());
+        m_cached_physics_dir = "./";
+    }
+
+}   // checkAndCreateCachedPhysicsDir
+
+// ----------------------------------------------------------------------------
+/** Creates the directory for the cache of parsed XML files. This will set
+ *  m_cached_xml_dir with the appropriate path.
+ */
+void FileManager::checkAndCreateCachedXMLDir()
+{
+#if defined(WIN32)
+    m_cached_xml_dir = m_user_config_dir + "cached-xml/";
+#elif defined(__APPLE__)
+    m_cached_xml_dir = getenv("HOME");
+    m_cached_xml_dir += "/Library/Application Support/SuperTuxKart/CachedXML/";
+#else
+    m_cached_xml_dir = checkAndCreateLinuxDir("XDG_CACHE_HOME", "supertuxkart", ".cache/", ".");
+    m_cached_xml_dir += "cached-xml/";
+#endif
+
+    if (!checkAndCreateDirectory(m_cached_xml_dir))
+    {
+        Log::error("FileManager", "Can not create cached xml directory '%s', "
+            "falling back to '.'.", m_cached_xml_dir.c_str());
+        m_cached_xml_dir = "./";
+    }
+
+}   // checkAndCreateCachedXMLDir
+
 // ----------------------------------------------------------------------------
 /** Creates the directories for user-defined grand prix. This will set m_gp_dir
  *  with the appropriate path.
@@ -25,6 +25,7 @@
  * Contains generic utility classes for file I/O (especially XML handling).
  */
 
+#include <map>
 #include <mutex>
 #include <string>
 #include <vector>
@@ -68,6 +69,13 @@ public:
 private:
     mutable std::mutex m_file_system_lock;
 
+    /** XML trees parsed in advance by preloadXMLTrees(), indexed by the
+     *  file name. A tree is removed when createXMLTree() takes it. */
+    std::map<std::string, XMLNode*> m_preloaded_xml;
+
+    /** Protects m_preloaded_xml. */
+    std::mutex m_preloaded_xml_lock;
+
     /** The names of the various subdirectories of the asset types. */
     std::vector< std::string > m_subdir_name;
 
@@ -98,6 +106,13 @@ private:
     /** Directory where resized textures are cached. */
     std::string       m_cached_textures_dir;
 
+    /** Directory where the collision trees and arena paths of tracks are
+     *  cached. */
+    std::string       m_cached_physics_dir;
+
+    /** Directory where the parsed XML files are cached. */
+    std::string       m_cached_xml_dir;
+
     /** Directory where user-defined grand prix are stored. */
     std::string       m_gp_dir;
 
@@ -128,6 +143,8 @@ private:
     void              checkAndCreateScreenshotDir();
     void              checkAndCreateReplayDir();
     void              checkAndCreateCachedTexturesDir();
+    void              checkAndCreateCachedPhysicsDir();
+    void              checkAndCreateCachedXMLDir();
     void              checkAndCreateGPDir();
     void              discoverPaths();
     void              addAssetsSearchPath();
@@ -150,10 +167,16 @@ public:
     io::IXMLReader   *createXMLReader(const std::string &filename);
     XMLNode          *createXMLTree(const std::string &filename);
     XMLNode          *createXMLTreeFromString(const std::string & content);
+    void              preloadXMLTrees(const std::vector<std::string> &files,
+                                      unsigned num_threads);
+    XMLNode          *takePreloadedXMLTree(const std::string &filename);
+    void              clearPreloadedXMLTrees();
 
     std::string       getScreenshotDir() const;
     std::string       getReplayDir() const;
     std::string       getCachedTexturesDir() const;
+    std::string       getCachedPhysicsDir() const;
+    std::string       getCachedXMLDir() const;
     std::string       getGPDir() const;
     bool              checkAndCreateDirectory(const std::string &path);
     bool              checkAndCreateDirectoryP(const std::string &path);
@@ -0,0 +1,621 @@
+//
+//  SuperTuxKart - a fun racing game with go-kart
+//  Copyright (C) 2019 SuperTuxKart-Team
+//
+//  This program is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU General Public License
+//  as published by the Free Software Foundation; either version 3
+//  of the License, or (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+
+
+#include "io/xml_cache.hpp"
+
+#include "io/file_manager.hpp"
+#include "io/xml_node.hpp"
+#include "utils/file_utils.hpp"
+#include "utils/log.hpp"
+#include "utils/time.hpp"
+
+#include <cstdio>
+#include <cstring>
+#include <sys/stat.h>
+
+XMLCache *xml_cache = NULL;
+
+// ----------------------------------------------------------------------------
+namespace
+{
+    /** Version of the XML cache file, must be increased if the format of
+     *  the file or the way XMLNode trees are built changes. */
+    const uint32_t XML_CACHE_VERSION = 1;
+
+    /** The header of the XML cache file. It is followed by a FileRecord
+     *  for each file, the lengths of all names and values, the elements of
+     *  all files, the characters of all values and of all names. */
+    struct XMLCacheHeader
+    {
+        char     m_magic[8];
+        uint32_t m_version;
+        /** Detects files written on a machine with a different byte order
+         *  or wchar_t size. */
+        uint32_t m_endian;
+        uint32_t m_wchar_size;
+        uint32_t m_num_names;
+        uint32_t m_num_values;
+        uint32_t m_num_files;
+        uint64_t m_data_size;
+        uint64_t m_data_hash;
+    };   // XMLCacheHeader
+
+    /** Describes a cached file. */
+    struct FileRecord
+    {
+        uint32_t m_name;
+        uint32_t m_num_elements;
+        int64_t  m_mtime;
+        uint64_t m_size;
+    };   // FileRecord
+
+    // ------------------------------------------------------------------------
+    /** Checks that the elements starting at pos form a valid element with
+     *  all indices in range, and sets pos to the first index after it.
+     */
+    bool checkElement(const std::vector<uint32_t> &elements, size_t *pos,
+                      size_t num_names, size_t num_values, unsigned depth)
+    {
+        // Deeper trees only come from a damaged file
+        if (depth > 256 || *pos + 2 > elements.size() ||
+            elements[*pos] >= num_names)
+            return false;
+        const uint32_t num_attributes = elements[*pos + 1];
+        *pos += 2;
+        if (elements.size() - *pos < 2 * (uint64_t)num_attributes + 1)
+            return false;
+        for (uint32_t i = 0; i < num_attributes; i++, *pos += 2)
+        {
+            if (elements[*pos] >= num_names ||
+                elements[*pos + 1] >= num_values)
+                return false;
+        }
+        const uint32_t num_children = elements[(*pos)++];
+        for (uint32_t i = 0; i < num_children; i++)
+        {
+            if (!checkElement(elements, pos, num_names, num_values,
+                              depth + 1))
+                return false;
+        }
+        return true;
+    }   // checkElement
+}   // namespace
+
+// ----------------------------------------------------------------------------
+/** Assigns an index to each different name and value. */
+struct XMLCache::StringTables
+{
+    std::vector<std::string>   *m_names;
+    std::vector<core::stringw> *m_values;
+    std::unordered_map<std::string, uint32_t>  m_name_index;
+    std::unordered_map<std::wstring, uint32_t> m_value_index;
+
+    StringTables(std::vector<std::string> *names,
+                 std::vector<core::stringw> *values)
+        : m_names(names), m_values(values) {}
+    // ------------------------------------------------------------------------
+    uint32_t addName(const std::string &name)
+    {
+        auto it = m_name_index.emplace(name, (uint32_t)m_names->size());
+        if (it.second)
+            m_names->push_back(name);
+        return it.first->second;
+    }   // addName
+    // ------------------------------------------------------------------------
+    uint32_t addValue(const core::stringw &value)
+    {
+        auto it = m_value_index.emplace(
+            std::wstring(value.c_str(), value.size()),
+            (uint32_t)m_values->size());
+        if (it.second)
+            m_values->push_back(value);
+        return it.first->second;
+    }   // addValue
+};   // StringTables
+
+// ----------------------------------------------------------------------------
+/** Creates an empty cache, call load() to read the cache file.
+ *  \param cache_file Name of the file the cache is stored in.
+ *  \param excluded_dir Files in this directory are not cached.
+ */
+XMLCache::XMLCache(const std::string &cache_file,
+                   const std::string &excluded_dir)
+{
+    m_cache_file   = cache_file;
+    m_excluded_dir = excluded_dir;
+    m_modified     = false;
+}   // XMLCache
+
+// ----------------------------------------------------------------------------
+/** Loads the cache file. Returns false if the file does not exist, is from
+ *  a different version or is damaged, in which case the cache is empty.
+ */
+bool XMLCache::load()
+{
+    FILE *f = fopen(m_cache_file.c_str(), "rb");
+    if (!f)
+        return false;
+
+    XMLCacheHeader header;
+    if (fread(&header, sizeof(header), 1, f) != 1         ||
+        memcmp(header.m_magic, "STKXML", 7) != 0          ||
+        header.m_version    != XML_CACHE_VERSION          ||
+        header.m_endian     != 0x01020304                 ||
+        header.m_wchar_size != sizeof(wchar_t)            ||
+        header.m_data_size  >  0x7fffffff                    )
+    {
+        fclose(f);
+        Log::info("XMLCache", "Cache '%s' is outdated.",
+                  m_cache_file.c_str());
+        return false;
+    }
+
+    std::vector<char> data((size_t)header.m_data_size);
+    bool ok = data.empty() || fread(data.data(), data.size(), 1, f) == 1;
+    fclose(f);
+    ok = ok && FileUtils::hashBytes(data.data(), data.size()) ==
+               header.m_data_hash;
+
+    // Copies the next count items of the data, or fails if there is not
+    // enough data left
+    size_t offset = 0;
+    auto read = [&](void *dest, uint64_t count, size_t size) -> bool
+    {
+        if (!ok || count * size > data.size() - offset)
+            return ok = false;
+        if (count > 0)
+            memcpy(dest, data.data() + offset, (size_t)(count * size));
+        offset += (size_t)(count * size);
+        return true;
+    };
+
+    std::vector<FileRecord> records;
+    std::vector<uint32_t> name_lengths, value_lengths;
+    if (ok && (uint64_t)header.m_num_files * sizeof(FileRecord) +
+        ((uint64_t)header.m_num_names + header.m_num_values) *
+        sizeof(uint32_t) <= data.size())
+    {
+        records.resize(header.m_num_files);
+        name_lengths.resize(header.m_num_names);
+        value_lengths.resize(header.m_num_values);
+        read(records.data(), records.size(), sizeof(FileRecord));
+        read(name_lengths.data(), name_lengths.size(), sizeof(uint32_t));
+        read(value_lengths.data(), value_lengths.size(), sizeof(uint32_t));
+    }
+    else
+        ok = false;
+
+    std::vector<std::vector<uint32_t> > elements(records.size());
+    for (unsigned int i = 0; i < records.size() && ok; i++)
+    {
+        if (records[i].m_num_elements > data.size())
+        {
+            ok = false;
+            break;
+        }
+        elements[i].resize(records[i].m_num_elements);
+        read(elements[i].data(), elements[i].size(), sizeof(uint32_t));
+    }
+
+    std::vector<wchar_t> chars;
+    for (unsigned int i = 0; i < value_lengths.size() && ok; i++)
+    {
+        if (value_lengths[i] > data.size())
+        {
+            ok = false;
+            break;
+        }
+        chars.resize(value_lengths[i] + 1);
+        if (read(chars.data(), value_lengths[i], sizeof(wchar_t)))
+            m_values.push_back(core::stringw(chars.data(), value_lengths[i]));
+    }
+    for (unsigned int i = 0; i < name_lengths.size() && ok; i++)
+    {
+        if (name_lengths[i] > data.size() - offset)
+        {
+            ok = false;
+            break;
+        }
+        m_names.push_back(std::string(data.data() + offset,
+                                      name_lengths[i]));
+        offset += name_lengths[i];
+    }
+
+    for (unsigned int i = 0; i < records.size() && ok; i++)
+    {
+        size_t pos = 0;
+        if (records[i].m_name >= m_names.size() ||
+            !checkElement(elements[i], &pos, m_names.size(), m_values.size(),
+                          0) ||
+            pos != elements[i].size())
+        {
+            ok = false;
+            break;
+        }
+        CachedFile &file = m_loaded_files[m_names[records[i].m_name]];
+        file.m_stamp.m_mtime = records[i].m_mtime;
+        file.m_stamp.m_size  = records[i].m_size;
+        file.m_stamp.m_valid = true;
+        file.m_elements.swap(elements[i]);
+    }
+
+    if (!ok || offset != data.size())
+    {
+        Log::warn("XMLCache", "Failed to load cache '%s'.",
+                  m_cache_file.c_str());
+        m_names.clear();
+        m_values.clear();
+        m_loaded_files.clear();
+        return false;
+    }
+    return true;
+}   // load
+
+// ----------------------------------------------------------------------------
+/** Writes all files of the cache which are still up to date to the cache
+ *  file, if any file was added since the last call, see
+ *  FileUtils::writeFileAtomically(). If several processes (e.g. servers)
+ *  use the same cache file, the file of the last process to save replaces
+ *  the others: files only cached by another process are dropped,
+ *  and are added again the next time that process parses them.
+ */
+void XMLCache::save()
+{
+    std::lock_guard<std::mutex> lock(m_new_files_lock);
+    if (!m_modified)
+        return;
+
+    std::vector<std::string> names;
+    std::vector<core::stringw> values;
+    StringTables tables(&names, &values);
+    std::vector<FileRecord> records;
+    std::vector<uint32_t> elements;
+    auto add_file = [&](const std::string &filename, const CachedFile &file,
+                        const std::vector<std::string> &file_names,
+                        const std::vector<core::stringw> &file_values)
+    {
+        // Drop files which were changed or removed in the meantime
+        const FileStamp stamp = getFileStamp(filename);
+        if (!stamp.m_valid || stamp.m_mtime != file.m_stamp.m_mtime ||
+            stamp.m_size != file.m_stamp.m_size)
+            return;
+        FileRecord record;
+        record.m_name  = tables.addName(filename);
+        record.m_mtime = stamp.m_mtime;
+        record.m_size  = stamp.m_size;
+        const size_t start = elements.size();
+        copyElements(file.m_elements.data(), file_names, file_values, &tables,
+                     &elements);
+        record.m_num_elements = (uint32_t)(elements.size() - start);
+        records.push_back(record);
+    };
+
+    for (auto &it : m_loaded_files)
+    {
+        if (m_new_files.find(it.first) == m_new_files.end())
+            add_file(it.first, it.second, m_names, m_values);
+    }
+    for (auto &it : m_new_files)
+        add_file(it.first, it.second, it.second.m_names, it.second.m_values);
+
+    std::vector<char> data;
+    auto append = [&data](const void *p, size_t size)
+    {
+        data.insert(data.end(), (const char*)p, (const char*)p + size);
+    };
+    append(records.data(), records.size() * sizeof(FileRecord));
+    for (const std::string &name : names)
+    {
+        const uint32_t length = (uint32_t)name.size();
+        append(&length, sizeof(length));
+    }
+    for (const core::stringw &value : values)
+    {
+        const uint32_t length = value.size();
+        append(&length, sizeof(length));
+    }
+    append(elements.data(), elements.size() * sizeof(uint32_t));
+    for (const core::stringw &value : values)
+        append(value.c_str(), value.size() * sizeof(wchar_t));
+    for (const std::string &name : names)
+        append(name.data(), name.size());
+
+    XMLCacheHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.m_magic, "STKXML", 7);
+    header.m_version    = XML_CACHE_VERSION;
+    header.m_endian     = 0x01020304;
+    header.m_wchar_size = sizeof(wchar_t);
+    header.m_num_names  = (uint32_t)names.size();
+    header.m_num_values = (uint32_t)values.size();
+    header.m_num_files  = (uint32_t)records.size();
+    header.m_data_size  = data.size();
+    header.m_data_hash  = FileUtils::hashBytes(data.data(), data.size());
+
+    const bool ok = FileUtils::writeFileAtomically(m_cache_file, [&](FILE *f)
+        {
+            return fwrite(&header, sizeof(header), 1, f) == 1 &&
+                   (data.empty() ||
+                    fwrite(data.data(), data.size(), 1, f) == 1);
+        });
+    if (!ok)
+    {
+        Log::warn("XMLCache", "Failed to write cache '%s'.",
+                  m_cache_file.c_str());
+        return;
+    }
+    m_modified = false;
+}   // save
+
+// ----------------------------------------------------------------------------
+/** Returns the modification time and size of a file, which are marked as
+ *  invalid if the file doesn't exist (e.g. it is in an archive) or must not
+ *  be cached.
+ *  \param filename Name of the XML file.
+ */
+XMLCache::FileStamp XMLCache::getFileStamp(const std::string &filename) const
+{
+    FileStamp stamp;
+    stamp.m_mtime = 0;
+    stamp.m_size  = 0;
+    stamp.m_valid = false;
+    if (!m_excluded_dir.empty() &&
+        filename.compare(0, m_excluded_dir.size(), m_excluded_dir) == 0)
+        return stamp;
+
+    struct stat mystat;
+    if (FileUtils::statU8Path(filename, &mystat) != 0 ||
+        (mystat.st_mode & S_IFMT) != S_IFREG)
+        return stamp;
+    stamp.m_mtime = (int64_t)mystat.st_mtime;
+    stamp.m_size  = (uint64_t)mystat.st_size;
+    stamp.m_valid = true;
+    return stamp;
+}   // getFileStamp
+
+// ----------------------------------------------------------------------------
+/** Creates the tree of a file from the cache. Returns false if the file is
+ *  not cached or was changed since it was cached. Can be called from
+ *  several threads at the same time.
+ *  \param filename Name of the XML file.
+ *  \param stamp The current stamp of the file, see getFileStamp().
+ *  \param node An empty node, which becomes the root of the tree.
+ */
+bool XMLCache::fillNode(const std::string &filename, const FileStamp &stamp,
+                        XMLNode *node)
+{
+    if (!stamp.m_valid)
+        return false;
+
+    auto loaded = m_loaded_files.find(filename);
+    if (loaded != m_loaded_files.end() &&
+        loaded->second.m_stamp.m_mtime == stamp.m_mtime &&
+        loaded->second.m_stamp.m_size  == stamp.m_size)
+    {
+        buildNode(node, loaded->second.m_elements.data(), m_names, m_values);
+        return true;
+    }
+
+    // Files parsed in this run, e.g. the scene of a track raced again
+    std::lock_guard<std::mutex> lock(m_new_files_lock);
+    auto added = m_new_files.find(filename);
+    if (added != m_new_files.end() &&
+        added->second.m_stamp.m_mtime == stamp.m_mtime &&
+        added->second.m_stamp.m_size  == stamp.m_size)
+    {
+        buildNode(node, added->second.m_elements.data(),
+                  added->second.m_names, added->second.m_values);
+        return true;
+    }
+    return false;
+}   // fillNode
+
+// ----------------------------------------------------------------------------
+/** Adds a parsed file to the cache, it is written to disk with the next
+ *  save(). Can be called from several threads at the same time.
+ *  \param filename Name of the XML file.
+ *  \param stamp The stamp of the file before it was parsed.
+ *  \param node The root of the tree of the file.
+ */
+void XMLCache::addFile(const std::string &filename, const FileStamp &stamp,
+                       const XMLNode *node)
+{
+    if (!stamp.m_valid)
+        return;
+    CachedFile file;
+    file.m_stamp = stamp;
+    StringTables tables(&file.m_names, &file.m_values);
+    addElements(node, &tables, &file.m_elements);
+
+    std::lock_guard<std::mutex> lock(m_new_files_lock);
+    m_new_files[filename] = std::move(file);
+    m_modified = true;
+}   // addFile
+
+// ----------------------------------------------------------------------------
+/** Fills a node and all its children from the cached elements. Returns the
+ *  first element after the node.
+ */
+const uint32_t *XMLCache::buildNode(XMLNode *node, const uint32_t *elements,
+                                    const std::vector<std::string> &names,
+                                    const std::vector<core::stringw> &values)
+                                    const
+{
+    node->m_name = names[*elements++];
+    const uint32_t num_attributes = *elements++;
+    for (uint32_t i = 0; i < num_attributes; i++, elements += 2)
+    {
+        // The attributes are stored in the order of the map
+        node->m_attributes.emplace_hint(node->m_attributes.end(),
+                                        names[elements[0]],
+                                        values[elements[1]]);
+    }
+    const uint32_t num_children = *elements++;
+    node->m_nodes.reserve(num_children);
+    for (uint32_t i = 0; i < num_children; i++)
+    {
+        XMLNode *child = new XMLNode();
+        child->m_file_name = node->m_file_name;
+        elements = buildNode(child, elements, names, values);
+        node->m_nodes.push_back(child);
+    }
+    return elements;
+}   // buildNode
+
+// ----------------------------------------------------------------------------
+/** Appends the elements of a node and all its children.
+ */
+void XMLCache::addElements(const XMLNode *node, StringTables *tables,
+                           std::vector<uint32_t> *elements) const
+{
+    elements->push_back(tables->addName(node->m_name));
+    elements->push_back((uint32_t)node->m_attributes.size());
+    for (auto &attribute : node->m_attributes)
+    {
+        elements->push_back(tables->addName(attribute.first));
+        elements->push_back(tables->addValue(attribute.second));
+    }
+    elements->push_back((uint32_t)node->m_nodes.size());
+    for (const XMLNode *child : node->m_nodes)
+        addElements(child, tables, elements);
+}   // addElements
+
+// ----------------------------------------------------------------------------
+/** Appends the elements of a cached node using the indices of different
+ *  string tables. Returns the first element after the node.
+ */
+const uint32_t *XMLCache::copyElements(const uint32_t *elements,
+                                       const std::vector<std::string> &names,
+                                       const std::vector<core::stringw> &values,
+                                       StringTables *tables,
+                                       std::vector<uint32_t> *out) const
+{
+    out->push_back(tables->addName(names[*elements++]));
+    const uint32_t num_attributes = *elements++;
+    out->push_back(num_attributes);
+    for (uint32_t i = 0; i < num_attributes; i++, elements += 2)
+    {
+        out->push_back(tables->addName(names[elements[0]]));
+        out->push_back(tables->addValue(values[elements[1]]));
+    }
+    const uint32_t num_children = *elements++;
+    out->push_back(num_children);
+    for (uint32_t i = 0; i < num_children; i++)
+        elements = copyElements(elements, names, values, tables, out);
+    return elements;
+}   // copyElements
+
+// ----------------------------------------------------------------------------
+/** Returns true if both trees have the same elements and attributes.
+ */
+bool XMLCache::isSameTree(const XMLNode *a, const XMLNode *b)
+{
+    if (a->m_name != b->m_name || a->m_file_name != b->m_file_name ||
+        a->m_attributes != b->m_attributes ||
+        a->m_nodes.size() != b->m_nodes.size())
+        return false;
+    for (unsigned int i = 0; i < a->m_nodes.size(); i++)
+    {
+        if (!isSameTree(a->m_nodes[i], b->m_nodes[i]))
+            return false;
+    }
+    return true;
+}   // isSameTree
+
+// ----------------------------------------------------------------------------
+/** Compares reading the given files (normally all files read at startup)
+ *  with the XML reader, as without a cache or with an outdated cache, with
+ *  creating the trees from a cache that was written before, as at the next
+ *  start. Checks that both give the same trees.
+ */
+void XMLCache::benchmark(const std::vector<std::string> &files)
+{
+    XMLCache *global_cache = xml_cache;
+    xml_cache = NULL;
+    const std::string cache_file = file_manager->getCachedXMLDir() +
+                                   "benchmark.xmlcache";
+    remove(cache_file.c_str());
+
+    uint64_t start = StkTime::getMonoTimeUs();
+    std::vector<XMLNode*> parsed(files.size(), NULL);
+    for (unsigned int i = 0; i < files.size(); i++)
+    {
+        try
+        {
+            parsed[i] = new XMLNode(files[i]);
+        }
+        catch (std::runtime_error&)
+        {
+            parsed[i] = NULL;
+        }
+    }
+    const uint64_t parse_us = StkTime::getMonoTimeUs() - start;
+
+    start = StkTime::getMonoTimeUs();
+    XMLCache cold(cache_file, file_manager->getUserConfigDir());
+    for (unsigned int i = 0; i < files.size(); i++)
+    {
+        if (parsed[i])
+            cold.addFile(files[i], cold.getFileStamp(files[i]), parsed[i]);
+    }
+    cold.save();
+    const uint64_t save_us = StkTime::getMonoTimeUs() - start;
+
+    start = StkTime::getMonoTimeUs();
+    XMLCache warm(cache_file, file_manager->getUserConfigDir());
+    const bool loaded = warm.load();
+    const uint64_t load_us = StkTime::getMonoTimeUs() - start;
+
+    start = StkTime::getMonoTimeUs();
+    std::vector<XMLNode*> cached(files.size(), NULL);
+    for (unsigned int i = 0; i < files.size(); i++)
+    {
+        XMLNode *node = new XMLNode();
+        node->m_file_name = files[i];
+        if (warm.fillNode(files[i], warm.getFileStamp(files[i]), node))
+            cached[i] = node;
+        else
+            delete node;
+    }
+    const uint64_t build_us = StkTime::getMonoTimeUs() - start;
+
+    int mismatches = 0;
+    for (unsigned int i = 0; i < files.size(); i++)
+    {
+        if ((parsed[i] == NULL) != (cached[i] == NULL) ||
+            (parsed[i] && !isSameTree(parsed[i], cached[i])))
+            mismatches++;
+        delete parsed[i];
+        delete cached[i];
+    }
+
+    struct stat mystat;
+    const int size_kb = FileUtils::statU8Path(cache_file, &mystat) == 0
+                      ? (int)(mystat.st_size / 1024) : 0;
+    Log::info("Benchmark", "%d XML files: XML reader %.2f ms, cache %s "
+        "in %.2f ms and trees built in %.2f ms, writing cache %.2f ms, "
+        "cache size %d KB, %d mismatching files.",
+        (int)files.size(), parse_us / 1000.0f,
+        loaded ? "loaded" : "NOT loaded",
+        load_us / 1000.0f, build_us / 1000.0f, save_us / 1000.0f, size_kb,
+        mismatches);
+
+    remove(cache_file.c_str());
+    xml_cache = global_cache;
+}   // benchmark
@@ -0,0 +1,137 @@
+//
+//  SuperTuxKart - a fun racing game with go-kart
+//  Copyright (C) 2019 SuperTuxKart-Team
+//
+//  This program is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU General Public License
+//  as published by the Free Software Foundation; either version 3
+//  of the License, or (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+
+
+#ifndef HEADER_XML_CACHE_HPP
+#define HEADER_XML_CACHE_HPP
+
+#include "utils/no_copy.hpp"
+
+#include <irrString.h>
+using namespace irr;
+
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+class XMLNode;
+
+/**
+  * \brief A binary cache of parsed XML files.
+  * All cached files are stored in one file: the names of elements, attributes
+  * and files and all attribute values are interned in two string tables, and
+  * each element is a short sequence of indices into these tables. Creating
+  * an XMLNode tree from the cache avoids reading and parsing the XML file
+  * with irrlicht's XML reader and converting all strings. A cached file is
+  * only used if its modification time and size are unchanged.
+  * The cache is loaded once at startup and is read-only afterwards, so that
+  * XML files can be parsed in parallel (see FileManager::preloadXMLTrees).
+  * Files which are parsed while the game is running are added to a separate
+  * list and are written to disk with the next call to save().
+  * \ingroup io
+  */
+class XMLCache : public NoCopy
+{
+public:
+    /** Identifies the version of a file on disk. */
+    struct FileStamp
+    {
+        int64_t  m_mtime;
+        uint64_t m_size;
+        bool     m_valid;
+    };   // FileStamp
+
+private:
+    /** The elements of one cached file. An element is stored as its name
+     *  index, the number of attributes, a name and value index for each
+     *  attribute, the number of children, followed by all children. */
+    struct CachedFile
+    {
+        FileStamp             m_stamp;
+        std::vector<uint32_t> m_elements;
+        /** The string tables of files which were parsed in this run, the
+         *  files loaded from the cache use m_names and m_values. */
+        std::vector<std::string>   m_names;
+        std::vector<core::stringw> m_values;
+    };   // CachedFile
+
+    /** Name of the cache file. */
+    std::string m_cache_file;
+
+    /** Files in this directory (the user config dir) are not cached, since
+     *  they change all the time. */
+    std::string m_excluded_dir;
+
+    /** The interned strings of the files loaded from the cache. */
+    std::vector<std::string>   m_names;
+    std::vector<core::stringw> m_values;
+
+    /** The files loaded from the cache, read-only after load(). */
+    std::unordered_map<std::string, CachedFile> m_loaded_files;
+
+    /** Files which were parsed in this run, protected by m_new_files_lock. */
+    std::map<std::string, CachedFile> m_new_files;
+
+    /** Protects m_new_files and m_modified. */
+    std::mutex m_new_files_lock;
+
+    /** True if files were added since the last save(). */
+    bool m_modified;
+
+    struct StringTables;
+
+    // ------------------------------------------------------------------------
+    const uint32_t *buildNode(XMLNode *node, const uint32_t *elements,
+                              const std::vector<std::string> &names,
+                              const std::vector<core::stringw> &values) const;
+    // ------------------------------------------------------------------------
+    void addElements(const XMLNode *node, StringTables *tables,
+                     std::vector<uint32_t> *elements) const;
+    // ------------------------------------------------------------------------
+    const uint32_t *copyElements(const uint32_t *elements,
+                                 const std::vector<std::string> &names,
+                                 const std::vector<core::stringw> &values,
+                                 StringTables *tables,
+                                 std::vector<uint32_t> *out) const;
+    // ------------------------------------------------------------------------
+    static bool isSameTree(const XMLNode *a, const XMLNode *b);
+
+public:
+    XMLCache(const std::string &cache_file, const std::string &excluded_dir);
+    // ------------------------------------------------------------------------
+    bool load();
+    // ------------------------------------------------------------------------
+    void save();
+    // ------------------------------------------------------------------------
+    FileStamp getFileStamp(const std::string &filename) const;
+    // ------------------------------------------------------------------------
+    bool fillNode(const std::string &filename, const FileStamp &stamp,
+                  XMLNode *node);
+    // ------------------------------------------------------------------------
+    void addFile(const std::string &filename, const FileStamp &stamp,
+                 const XMLNode *node);
+    // ------------------------------------------------------------------------
+    static void benchmark(const std::vector<std::string> &files);
+};   // XMLCache
+
+extern XMLCache *xml_cache;
+
+#endif
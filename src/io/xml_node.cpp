@@ -17,6 +17,7 @@
 //  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 
 #include "io/file_manager.hpp"
+#include "io/xml_cache.hpp"
 #include "io/xml_node.hpp"
 #include "utils/interpolation_array.hpp"
 #include "utils/log.hpp"
@@ -41,6 +42,16 @@ XMLNode::XMLNode(const std::string &filename)
 {
     m_file_name = filename;
 
+    // The stamp is taken before reading the file, so that a change while
+    // reading is detected the next time
+    XMLCache::FileStamp stamp = { 0, 0, false };
+    if (xml_cache)
+    {
+        stamp = xml_cache->getFileStamp(filename);
+        if (xml_cache->fillNode(filename, stamp, this))
+            return;
+    }
+
     io::IXMLReader *xml = file_manager->createXMLReader(filename);
     
     if (xml == NULL)
@@ -73,6 +84,9 @@ XMLNode::XMLNode(const std::string &filename)
         }   // switch
     }   // while
     xml->drop();
+
+    if (xml_cache)
+        xml_cache->addFile(filename, stamp, this);
 }   // XMLNode
 
 // ----------------------------------------------------------------------------
@@ -58,6 +58,10 @@ private:
 
     std::string                          m_file_name;
 
+    /** Used by XMLCache to create the nodes of a cached file. */
+    XMLNode() {}
+    friend class XMLCache;
+
 public:
          LEAK_CHECK();
          XMLNode(io::IXMLReader *xml);
@@ -40,128 +40,342 @@
 
 
 // ----------------------------------------------------------------------------
-/** Constructor.
- *  \param type Type of the item.
- *  \param owner If not NULL it is the kart that dropped this item; NULL
- *         indicates an item that's part of the track.
- *  \param id Index of this item in the array of all items.
+/** Resizes the arrays to n slots. New slots are unused.
+ *  \param n The new number of slots.
  */
-ItemState::ItemState(ItemType type, const AbstractKart *owner, int id)
+void ItemStateArrays::resize(unsigned int n)
 {
-    setType(type);
-    m_item_id = id;
-    m_previous_owner = owner;
-    m_used_up_counter = -1;
-     if (owner)
-         setDeactivatedTicks(stk_config->time2Ticks(1.5f));
-    else
-        setDeactivatedTicks(0);
-}   // ItemState(ItemType)
+    unsigned int old_size = size();
+    m_type.resize(n);
+    m_original_type.resize(n);
+    m_ticks_till_return.resize(n);
+    m_deactive_ticks.resize(n);
+    m_used_up_counter.resize(n);
+    m_xyz.resize(n);
+    m_original_rotation.resize(n);
+    m_previous_owner.resize(n);
+    for (unsigned int i = old_size; i < n; i++)
+        clearSlot(i);
+}   // resize
 
-//-----------------------------------------------------------------------------
-/** Constructor to restore item state at current ticks in client for live join
+// ----------------------------------------------------------------------------
+/** Marks slot i as unused.
+ *  \param i The slot to clear.
  */
-ItemState::ItemState(const BareNetworkString& buffer)
+void ItemStateArrays::clearSlot(unsigned int i)
 {
-    m_type = (ItemType)buffer.getUInt8();
-    m_original_type = (ItemType)buffer.getUInt8();
-    m_ticks_till_return = buffer.getUInt32();
-    m_item_id = buffer.getUInt32();
-    m_deactive_ticks = buffer.getUInt32();
-    m_used_up_counter = buffer.getUInt32();
-    m_xyz = buffer.getVec3();
-    m_original_rotation = buffer.getQuat();
-    m_previous_owner = NULL;
-    int8_t kart_id = buffer.getUInt8();
-    if (kart_id != -1)
-        m_previous_owner = World::getWorld()->getKart(kart_id);
-}   // ItemState(const BareNetworkString& buffer)
+    m_type[i]              = ItemState::ITEM_NONE;
+    m_original_type[i]     = ItemState::ITEM_NONE;
+    m_ticks_till_return[i] = 0;
+    m_deactive_ticks[i]    = 0;
+    m_used_up_counter[i]   = -1;
+    m_xyz[i]               = Vec3(0, 0, 0);
+    m_original_rotation[i] = btQuaternion(0, 0, 0, 1);
+    m_previous_owner[i]    = NULL;
+}   // clearSlot
 
-// ------------------------------------------------------------------------
-/** Sets the disappear counter depending on type.  */
-void ItemState::setDisappearCounter()
+// ----------------------------------------------------------------------------
+/** Copies the state of one slot of another (or the same) arrays into slot
+ *  'to' of these arrays.
+ *  \param to The slot to copy to.
+ *  \param from The arrays to copy from.
+ *  \param from_slot The slot to copy from.
+ */
+void ItemStateArrays::copySlot(unsigned int to, const ItemStateArrays &from,
+                               unsigned int from_slot)
+{
+    m_type[to]              = from.m_type[from_slot];
+    m_original_type[to]     = from.m_original_type[from_slot];
+    m_ticks_till_return[to] = from.m_ticks_till_return[from_slot];
+    m_deactive_ticks[to]    = from.m_deactive_ticks[from_slot];
+    m_used_up_counter[to]   = from.m_used_up_counter[from_slot];
+    m_xyz[to]               = from.m_xyz[from_slot];
+    m_original_rotation[to] = from.m_original_rotation[from_slot];
+    m_previous_owner[to]    = from.m_previous_owner[from_slot];
+}   // copySlot
+
+// ----------------------------------------------------------------------------
+/** Sets up slot i for a new item.
+ *  \param i The slot to use.
+ *  \param type Type of the item.
+ *  \param owner If not NULL it is the kart that dropped this item; NULL
+ *         indicates an item that's part of the track.
+ */
+void ItemStateArrays::initSlot(unsigned int i, ItemState::ItemType type,
+                               const AbstractKart *owner)
 {
-    switch (m_type)
+    clearSlot(i);
+    m_type[i]           = type;
+    m_previous_owner[i] = owner;
+    if (owner)
+        m_deactive_ticks[i] = stk_config->time2Ticks(1.5f);
+}   // initSlot
+
+// ----------------------------------------------------------------------------
+/** Sets the disappear counter of slot i depending on type.  */
+void ItemStateArrays::setDisappearCounter(unsigned int i)
+{
+    switch (m_type[i])
     {
-    case ITEM_BUBBLEGUM:
-        m_used_up_counter = stk_config->m_bubblegum_counter; break;
-    case ITEM_EASTER_EGG:
-        m_used_up_counter = -1; break;
+    case ItemState::ITEM_BUBBLEGUM:
+        m_used_up_counter[i] = stk_config->m_bubblegum_counter; break;
+    case ItemState::ITEM_EASTER_EGG:
+        m_used_up_counter[i] = -1; break;
     default:
-        m_used_up_counter = -1;
+        m_used_up_counter[i] = -1;
     }   // switch
 }   // setDisappearCounter
 
 // -----------------------------------------------------------------------
-/** Initialises an item.
+/** Initialises the item in slot i.
+ *  \param i The slot of the item.
  *  \param type Type for this item.
  *  \param xyz The position for this item.
  *  \param normal The normal for this item.
  */
-void ItemState::initItem(ItemType type, const Vec3& xyz, const Vec3& normal)
+void ItemStateArrays::initItem(unsigned int i, ItemState::ItemType type,
+                               const Vec3& xyz, const Vec3& normal)
 {
-    m_xyz               = xyz;
-    m_original_rotation = shortestArcQuat(Vec3(0, 1, 0), normal);
-    m_original_type     = ITEM_NONE;
-    m_ticks_till_return = 0;
-    setDisappearCounter();
+    m_xyz[i]               = xyz;
+    m_original_rotation[i] = shortestArcQuat(Vec3(0, 1, 0), normal);
+    m_original_type[i]     = ItemState::ITEM_NONE;
+    m_ticks_till_return[i] = 0;
+    setDisappearCounter(i);
 }   // initItem
 
 // ----------------------------------------------------------------------------
-/** Update the state of the item, called once per physics frame.
+/** Updates the timers of all items, called once per physics frame. Unused
+ *  slots have no running timers, so no check for them is necessary.
  *  \param ticks Number of ticks to simulate. While this value is 1 when
  *         called during the normal game loop, during a rewind this value
  *         can be (much) larger than 1.
  */
-void ItemState::update(int ticks)
+void ItemStateArrays::update(int ticks)
 {
-    if (m_deactive_ticks > 0) m_deactive_ticks -= ticks;
-    if (m_ticks_till_return>0)
+    const unsigned int n = size();
+    for (unsigned int i = 0; i < n; i++)
     {
-        m_ticks_till_return -= ticks;
-    }   // if collected
-
+        if (m_deactive_ticks[i] > 0) m_deactive_ticks[i] -= ticks;
+        if (m_ticks_till_return[i] > 0) m_ticks_till_return[i] -= ticks;
+    }
 }   // update
 
 // ----------------------------------------------------------------------------
-/** Called when the item is collected.
+/** Called when the item in slot i is collected.
+ *  \param i The slot of the item.
  *  \param kart The kart that collected the item.
  */
-void ItemState::collected(const AbstractKart *kart)
+void ItemStateArrays::collected(unsigned int i, const AbstractKart *kart)
 {
-    if (m_type == ITEM_EASTER_EGG)
+    if (m_type[i] == ItemState::ITEM_EASTER_EGG)
     {
         // They will disappear 'forever'
-        m_ticks_till_return = stk_config->time2Ticks(99999);
+        m_ticks_till_return[i] = stk_config->time2Ticks(99999);
     }
-    else if (m_used_up_counter > 0)
+    else if (m_used_up_counter[i] > 0)
     {
-        m_used_up_counter--;
+        m_used_up_counter[i]--;
         // Deactivates the item for a certain amount of time. It is used to
         // prevent bubble gum from hitting a kart over and over again (in each
         // frame) by giving it time to drive away.
-        m_deactive_ticks = stk_config->time2Ticks(0.5f);
+        m_deactive_ticks[i] = stk_config->time2Ticks(0.5f);
         // Set the time till reappear to -1 seconds --> the item will
         // reappear immediately.
-        m_ticks_till_return = -1;
+        m_ticks_till_return[i] = -1;
     }
     else
     {
-        m_ticks_till_return = stk_config->time2Ticks(2.0f);
+        m_ticks_till_return[i] = stk_config->time2Ticks(2.0f);
     }
 
     if (race_manager->isBattleMode())
     {
-        m_ticks_till_return *= 3;
+        m_ticks_till_return[i] *= 3;
+    }
+}   // collected
+
+// ----------------------------------------------------------------------------
+/** Resets the item in slot i to its start state. */
+void ItemStateArrays::reset(unsigned int i)
+{
+    m_deactive_ticks[i]    = 0;
+    m_ticks_till_return[i] = 0;
+    setDisappearCounter(i);
+    // If the item was switched:
+    if (m_original_type[i] != ItemState::ITEM_NONE)
+    {
+        m_type[i]          = m_original_type[i];
+        m_original_type[i] = ItemState::ITEM_NONE;
     }
+}   // reset
+
+// ----------------------------------------------------------------------------
+/** Switches the item in slot i to be of a different type. Used for the
+ *  switch powerup.
+ *  \param i The slot of the item.
+ *  \param type New type for this item.
+ */
+void ItemStateArrays::switchTo(unsigned int i, ItemState::ItemType type)
+{
+    // triggers and easter eggs should not be switched
+    if (m_type[i] == ItemState::ITEM_EASTER_EGG) return;
+    m_original_type[i] = m_type[i];
+    m_type[i]          = type;
+}   // switchTo
+
+// ----------------------------------------------------------------------------
+/** Switches the item in slot i back to its original type. Returns true if
+ *  this item was not actually switched (e.g. trigger etc).
+ */
+bool ItemStateArrays::switchBack(unsigned int i)
+{
+    // If the item is not switched, do nothing. This can happen if a bubble
+    // gum is dropped while items are switched - when switching back, this
+    // bubble gum has no original type.
+    if (m_original_type[i] == ItemState::ITEM_NONE)
+        return true;
+    m_type[i]          = m_original_type[i];
+    m_original_type[i] = ItemState::ITEM_NONE;
+    return false;
+}   // switchBack
+
+//-----------------------------------------------------------------------------
+/** Save the state of the item in slot i at current ticks in server for live
+ *  join.
+ *  \param i The slot of the item.
+ *  \param item_id The id of the item, which is sent with its state.
+ */
+void ItemStateArrays::saveCompleteState(unsigned int i, int item_id,
+                                        BareNetworkString* buffer) const
+{
+    buffer->addUInt8((uint8_t)m_type[i])
+        .addUInt8((uint8_t)m_original_type[i])
+        .addUInt32(m_ticks_till_return[i]).addUInt32(item_id)
+        .addUInt32(m_deactive_ticks[i]).addUInt32(m_used_up_counter[i])
+        .add(m_xyz[i]).add(m_original_rotation[i])
+        .addUInt8(m_previous_owner[i] ?
+            (int8_t)m_previous_owner[i]->getWorldKartId() : (int8_t)-1);
+}   // saveCompleteState
+
+//-----------------------------------------------------------------------------
+/** Restore the state of the item in slot i at current ticks in client for
+ *  live join. The item id in the buffer must have been read already.
+ */
+void ItemStateArrays::restoreCompleteState(unsigned int i,
+                                           const BareNetworkString& buffer)
+{
+    m_type[i]              = (ItemState::ItemType)buffer.getUInt8();
+    m_original_type[i]     = (ItemState::ItemType)buffer.getUInt8();
+    m_ticks_till_return[i] = buffer.getUInt32();
+    buffer.getUInt32();    // item id
+    m_deactive_ticks[i]    = buffer.getUInt32();
+    m_used_up_counter[i]   = buffer.getUInt32();
+    m_xyz[i]               = buffer.getVec3();
+    m_original_rotation[i] = buffer.getQuat();
+    m_previous_owner[i]    = NULL;
+    int8_t kart_id = buffer.getUInt8();
+    if (kart_id != -1)
+        m_previous_owner[i] = World::getWorld()->getKart(kart_id);
+}   // restoreCompleteState
+
+// ============================================================================
+/** Constructor. The state is kept in its own arrays till the item is moved
+ *  into the arrays of the item manager with moveTo().
+ *  \param type Type of the item.
+ *  \param owner If not NULL it is the kart that dropped this item; NULL
+ *         indicates an item that's part of the track.
+ *  \param id Index of this item in the array of all items.
+ */
+ItemState::ItemState(ItemType type, const AbstractKart *owner, int id)
+         : m_own_states(new ItemStateArrays())
+{
+    m_states  = m_own_states.get();
+    m_slot    = 0;
+    m_item_id = id;
+    m_states->resize(1);
+    m_states->initSlot(m_slot, type, owner);
+}   // ItemState(ItemType)
+
+// ----------------------------------------------------------------------------
+ItemState::~ItemState()
+{
+}   // ~ItemState
+
+// ----------------------------------------------------------------------------
+/** Moves the state of this item into a slot of the given arrays, which from
+ *  then on contain the state of this item.
+ *  \param states The arrays to move the state to.
+ *  \param slot The slot in states to use.
+ */
+void ItemState::moveTo(ItemStateArrays *states, unsigned int slot)
+{
+    if (states == m_states && slot == m_slot)
+        return;
+    states->copySlot(slot, *m_states, m_slot);
+    m_states = states;
+    m_slot   = slot;
+    m_own_states.reset();
+}   // moveTo
+
+// ------------------------------------------------------------------------
+/** Sets the disappear counter depending on type.  */
+void ItemState::setDisappearCounter()
+{
+    m_states->setDisappearCounter(m_slot);
+}   // setDisappearCounter
+
+// -----------------------------------------------------------------------
+/** Initialises an item.
+ *  \param type Type for this item.
+ *  \param xyz The position for this item.
+ *  \param normal The normal for this item.
+ */
+void ItemState::initItem(ItemType type, const Vec3& xyz, const Vec3& normal)
+{
+    m_states->initItem(m_slot, type, xyz, normal);
+}   // initItem
+
+// ----------------------------------------------------------------------------
+/** Called when the item is collected.
+ *  \param kart The kart that collected the item.
+ */
+void ItemState::collected(const AbstractKart *kart)
+{
+    m_states->collected(m_slot, kart);
 }   // collected
 
+// ----------------------------------------------------------------------------
+/** Resets an item to its start state. */
+void ItemState::reset()
+{
+    m_states->reset(m_slot);
+}   // reset
+
+// ----------------------------------------------------------------------------
+/** Switches an item to be of a different type. Used for the switch
+ *  powerup.
+ *  \param type New type for this item.
+ */
+void ItemState::switchTo(ItemType type)
+{
+    m_states->switchTo(m_slot, type);
+}   // switchTo
+
+// ----------------------------------------------------------------------------
+/** Returns true if this item was not actually switched (e.g. trigger etc)
+ */
+bool ItemState::switchBack()
+{
+    return m_states->switchBack(m_slot);
+}   // switchBack
+
 // ----------------------------------------------------------------------------
 /** Returns the graphical type of this item should be using (takes nolok into
  *  account). */
 Item::ItemType ItemState::getGrahpicalType() const
 {
-    return m_previous_owner && m_previous_owner->getIdent() == "nolok" &&
+    const AbstractKart *owner = getPreviousOwner();
+    return owner && owner->getIdent() == "nolok" &&
         getType() == ITEM_BUBBLEGUM ?
         ITEM_BUBBLEGUM_NOLOK : getType();
 }   // getGrahpicalType
@@ -171,12 +385,7 @@ Item::ItemType ItemState::getGrahpicalType() const
  */
 void ItemState::saveCompleteState(BareNetworkString* buffer) const
 {
-    buffer->addUInt8((uint8_t)m_type).addUInt8((uint8_t)m_original_type)
-        .addUInt32(m_ticks_till_return).addUInt32(m_item_id)
-        .addUInt32(m_deactive_ticks).addUInt32(m_used_up_counter)
-        .add(m_xyz).add(m_original_rotation)
-        .addUInt8(m_previous_owner ?
-            (int8_t)m_previous_owner->getWorldKartId() : (int8_t)-1);
+    m_states->saveCompleteState(m_slot, m_item_id, buffer);
 }   // saveCompleteState
 
 // ============================================================================
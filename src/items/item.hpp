@@ -32,6 +32,9 @@
 
 #include <line3d.h>
 
+#include <memory>
+#include <vector>
+
 class BareNetworkString;
 class AbstractKart;
 class LODNode;
@@ -42,14 +45,19 @@ namespace irr
 }
 using namespace irr;
 
+class ItemStateArrays;
+
 // ============================================================================
 /** \ingroup items
  *  Contains the state information of an item, i.e. all non-visual information
  *  only, which also can change (e.g. position and AI information is constant
  *  and therefore not stored here). This class is used as a base class for
- *  item and for networking to save item states.
+ *  item. The state itself is stored in one slot of an ItemStateArrays, so
+ *  that the item manager can update and copy the states of all items at
+ *  once. A new item state has its own ItemStateArrays with one slot, till
+ *  it is moved into the arrays of the item manager with moveTo().
  */
-class ItemState
+class ItemState : public NoCopy
 {
     LEAK_CHECK();
 public:
@@ -76,54 +84,28 @@ public:
     };
 
 private:
-    /** Item type. */
-    ItemType m_type;
+    /** The arrays which contain the state of this item. */
+    ItemStateArrays *m_states;
 
-    /** If the item is switched, this contains the original type.
-    *  It is ITEM_NONE if the item is not switched. */
-    ItemType m_original_type;
+    /** The index of this item in m_states. */
+    unsigned int m_slot;
 
-    /** Time till a collected item reappears. When this value is <=0 this
-     *  means that the item is availabe to be collected. When the value is
-     *  > 0 it means that the item is not available. */
-    int m_ticks_till_return;
+    /** The arrays used for the state of this item till it is moved to the
+     *  arrays of the item manager, NULL afterwards. */
+    std::unique_ptr<ItemStateArrays> m_own_states;
 
     /** Index in item_manager field. This field can also take on a negative
      *  value when used in the NetworkItemManager. */
     int  m_item_id;
 
-    /** Optionally if item was placed by a kart, a timer can be used to
-    *  temporarly deactivate collision so a kart is not hit by its own item */
-    int m_deactive_ticks;
-
-    /** Counts how often an item is used before it disappears. Used for
-     *  bubble gum to make them disappear after a while. A value >0
-     *  indicates that the item still exists, =0 that the item can be
-     *  deleted, and <0 that the item will never be deleted, i.e. it 
-     *  will always reappear after a while. */
-    int m_used_up_counter;
-
-    /** The position of this ItemState. */
-    Vec3 m_xyz;
-
-    /** The original rotation of the item. While this is technically a visual
-     *  only value (atm, it could be used for collision detection), it is
-     *  required to make sure a client can display items with the right normal
-     *  (in case that a client would get a different (or no) normal from a
-     *  raycast).
-     */
-    btQuaternion m_original_rotation;
-
-    /** The 'owner' of the item, i.e. the kart that dropped this item.
-    *  Is NULL if the item is part of the track. */
-    const AbstractKart *m_previous_owner;
-
 protected:
 
     friend class ItemManager;
     friend class NetworkItemManager;
     // ------------------------------------------------------------------------
-    virtual void setType(ItemType type) { m_type = type; }
+    void setType(ItemType type);
+    // ------------------------------------------------------------------------
+    void moveTo(ItemStateArrays *states, unsigned int slot);
     // ------------------------------------------------------------------------
     // Some convenient functions for the AI only
     friend class SkiddingAI;
@@ -146,15 +128,12 @@ protected:
 public:
     // ------------------------------------------------------------------------
          ItemState(ItemType type, const AbstractKart *owner=NULL, int id = -1);
-    // ------------------------------------------------------------------------
-         ItemState(const BareNetworkString& buffer);
     // ------------------------------------------------------------------------
     void initItem(ItemType type, const Vec3& xyz, const Vec3& normal);
-    void update(int ticks);
     void setDisappearCounter();
-    virtual void collected(const AbstractKart *kart);
+    void collected(const AbstractKart *kart);
     // ------------------------------------------------------------------------
-    virtual ~ItemState() {}
+    virtual ~ItemState();
          
     // -----------------------------------------------------------------------
     /** Dummy implementation, causing an abort if it should be called to
@@ -184,7 +163,7 @@ public:
     {
         Log::fatal("ItemState", "getAvoidancePoint() called for ItemState.");
         // Return doesn't matter, fatal aborts
-        return &m_xyz;
+        return &getXYZ();
     }   // getAvoidancePoint
 
     // -----------------------------------------------------------------------
@@ -196,80 +175,32 @@ public:
     }   // getDistanceFromCentre
 
     // -----------------------------------------------------------------------
-    /** Resets an item to its start state. */
-    virtual void reset()
-    {
-        m_deactive_ticks    = 0;
-        m_ticks_till_return = 0;
-        setDisappearCounter();
-        // If the item was switched:
-        if (m_original_type != ITEM_NONE)
-        {
-            setType(m_original_type);
-            m_original_type = ITEM_NONE;
-        }
-    }   // reset
-
-    // -----------------------------------------------------------------------
-    /** Switches an item to be of a different type. Used for the switch
-     *  powerup.
-     *  \param type New type for this item.
-     */
-    virtual void switchTo(ItemType type)
-    {
-        // triggers and easter eggs should not be switched
-        if (m_type == ITEM_EASTER_EGG) return;
-        m_original_type = m_type;
-        setType(type);
-        return;
-    }   // switchTo
-
+    virtual void reset();
     // ------------------------------------------------------------------------
-    /** Returns true if this item was not actually switched (e.g. trigger etc)
-     */
-    virtual bool switchBack()
-    {
-        // If the item is not switched, do nothing. This can happen if a bubble
-        // gum is dropped while items are switched - when switching back, this
-        // bubble gum has no original type.
-        if (m_original_type == ITEM_NONE)
-            return true;
-        setType(m_original_type);
-        m_original_type = ITEM_NONE;
-        return false;
-    }   // switchBack
-
+    void switchTo(ItemType type);
+    // ------------------------------------------------------------------------
+    bool switchBack();
     // ------------------------------------------------------------------------
     /** Returns if this item is negative, i.e. a banana or bubblegum. */
     bool isNegativeItem() const
     {
-        return m_type == ITEM_BANANA || m_type == ITEM_BUBBLEGUM ||
-               m_type == ITEM_BUBBLEGUM_NOLOK;
+        const ItemType type = getType();
+        return type == ITEM_BANANA || type == ITEM_BUBBLEGUM ||
+               type == ITEM_BUBBLEGUM_NOLOK;
     }
     // ------------------------------------------------------------------------
-    /** Sets how long an item should be disabled. While item itself sets
-     *  a default, this time is too short in case that a kart that has a bomb
-     *  hits a banana: by the time the explosion animation is ended and the
-     *  kart is back at its original position, the banana would be back again
-     *  and therefore hit the kart again. See Attachment::hitBanana for more
-     *  details.
-     *  \param f Time till the item can be used again.
-     */
-    void setTicksTillReturn(int t) { m_ticks_till_return = t; }
+    void setTicksTillReturn(int t);
     // ------------------------------------------------------------------------
-    /** Returns the time the item is disabled for. */
-    int getTicksTillReturn() const { return m_ticks_till_return; }
+    int getTicksTillReturn() const;
     // ------------------------------------------------------------------------
     /** Returns true if this item is currently collected. */
-    bool isAvailable() const { return m_ticks_till_return <= 0; }
+    bool isAvailable() const { return getTicksTillReturn() <= 0; }
     // ------------------------------------------------------------------------
-    /** Returns the type of this item. */
-    ItemType getType() const { return m_type; }
+    ItemType getType() const;
     // ------------------------------------------------------------------------
     ItemType getGrahpicalType() const;
     // ------------------------------------------------------------------------
-    /** Returns the original type of this item. */
-    ItemType getOriginalType() const { return m_original_type; }
+    ItemType getOriginalType() const;
     // ------------------------------------------------------------------------
     /** Sets the index of this item in the item manager list. */
     void setItemId(unsigned int n) { m_item_id = n; }
@@ -277,50 +208,215 @@ public:
     /** Returns the index of this item in the item manager list. */
     unsigned int getItemId() const { return m_item_id; }
     // ------------------------------------------------------------------------
-    /** Returns true if this item is used up and can be removed. */
-    bool isUsedUp() const { return m_used_up_counter == 0; }
+    bool isUsedUp() const;
     // ------------------------------------------------------------------------
-    /** Returns true if this item can be used up, and therefore needs to
-     *  be removed when the game is reset. */
-    bool canBeUsedUp()  const { return m_used_up_counter>-1; }
+    bool canBeUsedUp() const;
     // ------------------------------------------------------------------------
-    /** Returns the number of ticks during which the item is deactivated (i.e.
-     *  it was collected). */
-    int getDeactivatedTicks() const { return m_deactive_ticks; }
+    int getDeactivatedTicks() const;
     // ------------------------------------------------------------------------
-    /** Sets the number of ticks during which the item is deactivated (i.e.
-     *  it was collected). */
-    void setDeactivatedTicks(int ticks) { m_deactive_ticks = ticks; }
+    void setDeactivatedTicks(int ticks);
     // ------------------------------------------------------------------------
-    /** Returns the kart that dropped this item (or NULL if the item was not
-     *  dropped by a kart. */
-    const AbstractKart *getPreviousOwner() const { return m_previous_owner; }
+    const AbstractKart *getPreviousOwner() const;
     // ------------------------------------------------------------------------
-    void setXYZ(const Vec3& xyz) { m_xyz = xyz; }
+    void setXYZ(const Vec3& xyz);
     // ------------------------------------------------------------------------
-    /** Returns the XYZ position of the item. */
-    const Vec3& getXYZ() const { return m_xyz; }
+    const Vec3& getXYZ() const;
     // ------------------------------------------------------------------------
-    /** Returns the normal of the ItemState. */
-    const Vec3 getNormal() const
-    {
-        return quatRotate(m_original_rotation, Vec3(0.0f, 1.0f, 0.0f));
-    }
+    const Vec3 getNormal() const;
     // ------------------------------------------------------------------------
-    /** Returns the original rotation of the item. */
-    const btQuaternion& getOriginalRotation() const
-    {
-        return m_original_rotation;
-    }
+    const btQuaternion& getOriginalRotation() const;
     // ------------------------------------------------------------------------
     void saveCompleteState(BareNetworkString* buffer) const;
 };   // class ItemState
 
+// ============================================================================
+/** \ingroup items
+ *  The states of a number of items as a structure of arrays: all values of
+ *  one kind are stored in one array, and a slot (the same index in all
+ *  arrays) holds the state of one item. This way the item manager can
+ *  update the timers of all items in one linear pass, and the network item
+ *  manager can take and restore a copy of the states of all items by
+ *  copying the arrays. Unused slots have the type ITEM_NONE and no running
+ *  timers.
+ */
+class ItemStateArrays
+{
+public:
+    /** Item type. */
+    std::vector<ItemState::ItemType> m_type;
+
+    /** If the item is switched, this contains the original type.
+     *  It is ITEM_NONE if the item is not switched. */
+    std::vector<ItemState::ItemType> m_original_type;
+
+    /** Time till a collected item reappears. When this value is <=0 this
+     *  means that the item is availabe to be collected. When the value is
+     *  > 0 it means that the item is not available. */
+    std::vector<int> m_ticks_till_return;
+
+    /** Optionally if item was placed by a kart, a timer can be used to
+     *  temporarly deactivate collision so a kart is not hit by its own
+     *  item. */
+    std::vector<int> m_deactive_ticks;
+
+    /** Counts how often an item is used before it disappears. Used for
+     *  bubble gum to make them disappear after a while. A value >0
+     *  indicates that the item still exists, =0 that the item can be
+     *  deleted, and <0 that the item will never be deleted, i.e. it
+     *  will always reappear after a while. */
+    std::vector<int> m_used_up_counter;
+
+    /** The position of the item. */
+    std::vector<Vec3> m_xyz;
+
+    /** The original rotation of the item. While this is technically a
+     *  visual only value (atm, it could be used for collision detection),
+     *  it is required to make sure a client can display items with the
+     *  right normal (in case that a client would get a different (or no)
+     *  normal from a raycast). */
+    std::vector<btQuaternion> m_original_rotation;
+
+    /** The 'owner' of the item, i.e. the kart that dropped this item.
+     *  Is NULL if the item is part of the track. */
+    std::vector<const AbstractKart*> m_previous_owner;
+
+    // ------------------------------------------------------------------------
+    void resize(unsigned int n);
+    void clearSlot(unsigned int i);
+    void copySlot(unsigned int to, const ItemStateArrays &from,
+                  unsigned int from_slot);
+    void initSlot(unsigned int i, ItemState::ItemType type,
+                  const AbstractKart *owner);
+    void initItem(unsigned int i, ItemState::ItemType type, const Vec3 &xyz,
+                  const Vec3 &normal);
+    void update(int ticks);
+    void setDisappearCounter(unsigned int i);
+    void collected(unsigned int i, const AbstractKart *kart);
+    void reset(unsigned int i);
+    void switchTo(unsigned int i, ItemState::ItemType type);
+    bool switchBack(unsigned int i);
+    void saveCompleteState(unsigned int i, int item_id,
+                           BareNetworkString *buffer) const;
+    void restoreCompleteState(unsigned int i,
+                              const BareNetworkString &buffer);
+    // ------------------------------------------------------------------------
+    /** Returns the number of slots. */
+    unsigned int size() const { return (unsigned int)m_type.size(); }
+    // ------------------------------------------------------------------------
+    /** Returns true if slot i contains an item. */
+    bool isUsed(unsigned int i) const
+    {
+        return m_type[i] != ItemState::ITEM_NONE;
+    }   // isUsed
+    // ------------------------------------------------------------------------
+    /** Returns the normal of the item in slot i. */
+    Vec3 getNormal(unsigned int i) const
+    {
+        return quatRotate(m_original_rotation[i], Vec3(0.0f, 1.0f, 0.0f));
+    }   // getNormal
+};   // class ItemStateArrays
+
+// ============================================================================
+// The accessors of ItemState, which need the definition of ItemStateArrays.
+// ----------------------------------------------------------------------------
+inline void ItemState::setType(ItemType type)
+{
+    m_states->m_type[m_slot] = type;
+}   // setType
+// ----------------------------------------------------------------------------
+/** Sets how long an item should be disabled. While item itself sets
+ *  a default, this time is too short in case that a kart that has a bomb
+ *  hits a banana: by the time the explosion animation is ended and the
+ *  kart is back at its original position, the banana would be back again
+ *  and therefore hit the kart again. See Attachment::hitBanana for more
+ *  details.
+ *  \param f Time till the item can be used again.
+ */
+inline void ItemState::setTicksTillReturn(int t)
+{
+    m_states->m_ticks_till_return[m_slot] = t;
+}   // setTicksTillReturn
+// ----------------------------------------------------------------------------
+/** Returns the time the item is disabled for. */
+inline int ItemState::getTicksTillReturn() const
+{
+    return m_states->m_ticks_till_return[m_slot];
+}   // getTicksTillReturn
+// ----------------------------------------------------------------------------
+/** Returns the type of this item. */
+inline ItemState::ItemType ItemState::getType() const
+{
+    return m_states->m_type[m_slot];
+}   // getType
+// ----------------------------------------------------------------------------
+/** Returns the original type of this item. */
+inline ItemState::ItemType ItemState::getOriginalType() const
+{
+    return m_states->m_original_type[m_slot];
+}   // getOriginalType
+// ----------------------------------------------------------------------------
+/** Returns true if this item is used up and can be removed. */
+inline bool ItemState::isUsedUp() const
+{
+    return m_states->m_used_up_counter[m_slot] == 0;
+}   // isUsedUp
+// ----------------------------------------------------------------------------
+/** Returns true if this item can be used up, and therefore needs to
+ *  be removed when the game is reset. */
+inline bool ItemState::canBeUsedUp() const
+{
+    return m_states->m_used_up_counter[m_slot] > -1;
+}   // canBeUsedUp
+// ----------------------------------------------------------------------------
+/** Returns the number of ticks during which the item is deactivated (i.e.
+ *  it was collected). */
+inline int ItemState::getDeactivatedTicks() const
+{
+    return m_states->m_deactive_ticks[m_slot];
+}   // getDeactivatedTicks
+// ----------------------------------------------------------------------------
+/** Sets the number of ticks during which the item is deactivated (i.e.
+ *  it was collected). */
+inline void ItemState::setDeactivatedTicks(int ticks)
+{
+    m_states->m_deactive_ticks[m_slot] = ticks;
+}   // setDeactivatedTicks
+// ----------------------------------------------------------------------------
+/** Returns the kart that dropped this item (or NULL if the item was not
+ *  dropped by a kart. */
+inline const AbstractKart *ItemState::getPreviousOwner() const
+{
+    return m_states->m_previous_owner[m_slot];
+}   // getPreviousOwner
+// ----------------------------------------------------------------------------
+inline void ItemState::setXYZ(const Vec3& xyz)
+{
+    m_states->m_xyz[m_slot] = xyz;
+}   // setXYZ
+// ----------------------------------------------------------------------------
+/** Returns the XYZ position of the item. */
+inline const Vec3& ItemState::getXYZ() const
+{
+    return m_states->m_xyz[m_slot];
+}   // getXYZ
+// ----------------------------------------------------------------------------
+/** Returns the normal of the ItemState. */
+inline const Vec3 ItemState::getNormal() const
+{
+    return m_states->getNormal(m_slot);
+}   // getNormal
+// ----------------------------------------------------------------------------
+/** Returns the original rotation of the item. */
+inline const btQuaternion& ItemState::getOriginalRotation() const
+{
+    return m_states->m_original_rotation[m_slot];
+}   // getOriginalRotation
+
 // ============================================================================
 /**
   * \ingroup items
   */
-class Item : public ItemState, public NoCopy
+class Item : public ItemState
 {
 
 private:
@@ -360,27 +456,6 @@ public:
     virtual void  updateGraphics(float dt) OVERRIDE;
     virtual void  reset() OVERRIDE;
 
-    //-------------------------------------------------------------------------
-    /** Is called when the item is hit by a kart.  It sets the flag that the
-     *  item has been collected, and the time to return to the parameter.
-     *  \param kart The kart that collected the item.
-     */
-    virtual void collected(const AbstractKart *kart)  OVERRIDE
-    {
-        ItemState::collected(kart);
-    }   // isCollected
-    //-------------------------------------------------------------------------
-    /** Switch backs to the original item. Returns true if the item was not
-     *  actually switched (e.g. trigger, or bubblegum dropped during switch
-     *  time). The return value is not actually used, but necessary in order
-     *  to overwrite ItemState::switchBack()
-     */
-    virtual bool switchBack() OVERRIDE
-    {
-        if (ItemState::switchBack())
-            return true;
-        return false;
-    }   // switchBack
     // ------------------------------------------------------------------------
     /** Returns true if the Kart is close enough to hit this item, the item is
      *  not deactivated anymore, and it wasn't placed by this kart (this is
@@ -400,6 +475,10 @@ public:
         return lc.length2() < m_distance_2;
     }   // hitKart
     // ------------------------------------------------------------------------
+    /** Returns the largest distance of a kart which can still hit this item
+     *  (see hitKart(), which allows twice the distance along the normal). */
+    float getHitRadius() const          { return 2.0f * sqrtf(m_distance_2); }
+    // ------------------------------------------------------------------------
     bool rotating() const               { return getType() != ITEM_BUBBLEGUM; }
 
 public:
@@ -0,0 +1,261 @@
+//
+//  SuperTuxKart - a fun racing game with go-kart
+//  Copyright (C) 2019 SuperTuxKart-Team
+//
+//  This program is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU General Public License
+//  as published by the Free Software Foundation; either version 3
+//  of the License, or (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+
+#include "items/item_grid.hpp"
+
+#include "items/item.hpp"
+#include "utils/log.hpp"
+#include "utils/time.hpp"
+#include "utils/vec3.hpp"
+
+#include <algorithm>
+#include <assert.h>
+#include <cmath>
+#include <cstdint>
+#include <random>
+
+// ----------------------------------------------------------------------------
+/** Creates an empty grid.
+ *  \param cell_size Size of a cell in x and z direction, should be about the
+ *         diameter in which a kart can hit an item.
+ *  \param num_buckets Number of buckets the cells are mapped to, must be a
+ *         power of 2.
+ */
+ItemGrid::ItemGrid(float cell_size, unsigned num_buckets)
+{
+    assert(num_buckets > 0 && (num_buckets & (num_buckets - 1)) == 0);
+    m_cell_size = cell_size;
+    m_buckets.resize(num_buckets);
+}   // ItemGrid
+
+// ----------------------------------------------------------------------------
+/** Returns the cell index for a x or z coordinate.
+ */
+int ItemGrid::getCell(float f) const
+{
+    const float cell = floorf(f / m_cell_size);
+    // Avoid undefined behaviour for positions far outside of any track
+    if (!(cell > -1048576.0f))
+        return -1048576;
+    if (cell > 1048576.0f)
+        return 1048576;
+    return (int)cell;
+}   // getCell
+
+// ----------------------------------------------------------------------------
+/** Returns the bucket index of a cell.
+ */
+unsigned ItemGrid::getBucket(int x, int z) const
+{
+    return ((unsigned)x * 73856093u ^ (unsigned)z * 19349663u) &
+        ((unsigned)m_buckets.size() - 1);
+}   // getBucket
+
+// ----------------------------------------------------------------------------
+/** Adds an item at its current position.
+ */
+void ItemGrid::insert(ItemState* item)
+{
+    const Vec3& xyz = item->getXYZ();
+    m_buckets[getBucket(getCell(xyz.getX()), getCell(xyz.getZ()))]
+        .push_back(item);
+}   // insert
+
+// ----------------------------------------------------------------------------
+/** Removes an item, which must be at the same position as when it was
+ *  inserted.
+ */
+void ItemGrid::remove(ItemState* item)
+{
+    const Vec3& xyz = item->getXYZ();
+    std::vector<ItemState*>& bucket =
+        m_buckets[getBucket(getCell(xyz.getX()), getCell(xyz.getZ()))];
+    auto it = std::find(bucket.begin(), bucket.end(), item);
+    assert(it != bucket.end());
+    if (it == bucket.end())
+        return;
+    // The order in a bucket doesn't matter, findItems() sorts the result
+    *it = bucket.back();
+    bucket.pop_back();
+}   // remove
+
+// ----------------------------------------------------------------------------
+/** Removes all items.
+ */
+void ItemGrid::clear()
+{
+    for (std::vector<ItemState*>& bucket : m_buckets)
+        bucket.clear();
+}   // clear
+
+// ----------------------------------------------------------------------------
+/** Returns all items in the cells which overlap the square of size 2*radius
+ *  around xyz (in the x-z plane), sorted by item id, so that the result
+ *  doesn't depend on the order of insertion.
+ *  \param xyz The position to search at.
+ *  \param radius The maximum distance of an item that must be found.
+ *  \param items On return the items close to xyz.
+ */
+void ItemGrid::findItems(const Vec3& xyz, float radius,
+                         std::vector<ItemState*>* items) const
+{
+    items->clear();
+    const int x0 = getCell(xyz.getX() - radius);
+    const int x1 = getCell(xyz.getX() + radius);
+    const int z0 = getCell(xyz.getZ() - radius);
+    const int z1 = getCell(xyz.getZ() + radius);
+
+    auto add_items = [&](const std::vector<ItemState*>& bucket)
+    {
+        for (ItemState* item : bucket)
+        {
+            // Skip items of other cells mapped to the same bucket
+            const int x = getCell(item->getXYZ().getX());
+            const int z = getCell(item->getXYZ().getZ());
+            if (x >= x0 && x <= x1 && z >= z0 && z <= z1)
+                items->push_back(item);
+        }
+    };
+
+    if ((int64_t)(x1 - x0 + 1) * (z1 - z0 + 1) >= (int64_t)m_buckets.size())
+    {
+        for (const std::vector<ItemState*>& bucket : m_buckets)
+            add_items(bucket);
+    }
+    else
+    {
+        m_visited_buckets.clear();
+        for (int x = x0; x <= x1; x++)
+        {
+            for (int z = z0; z <= z1; z++)
+            {
+                const unsigned b = getBucket(x, z);
+                if (std::find(m_visited_buckets.begin(),
+                    m_visited_buckets.end(), b) != m_visited_buckets.end())
+                    continue;
+                m_visited_buckets.push_back(b);
+                add_items(m_buckets[b]);
+            }
+        }
+    }
+    std::sort(items->begin(), items->end(),
+        [](const ItemState* a, const ItemState* b)
+        {
+            return a->getItemId() < b->getItemId();
+        });
+}   // findItems
+
+// ----------------------------------------------------------------------------
+/** Compares finding the items hit by 64 karts among 2000 items by testing
+ *  all items with finding them in the grid. Some items are removed and added
+ *  at a new position in each time step, similar to dropped bubble gums.
+ */
+void ItemGrid::benchmark()
+{
+    std::mt19937 random(1);
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+    const unsigned num_items = 2000;
+    const unsigned num_karts = 64;
+    const unsigned num_ticks = 1200;
+    const unsigned moved_items_per_tick = 8;
+    const float track_size = 600.0f;
+    // The maximum distance at which an item can be hit (see Item::hitKart)
+    const float radius = 2.0f * sqrtf(1.2f);
+
+    auto random_xyz = [&]()
+    {
+        return Vec3(track_size * unit(random), 2.0f * unit(random),
+                    track_size * unit(random));
+    };
+
+    ItemGrid grid;
+    std::vector<ItemState*> all_items;
+    for (unsigned i = 0; i < num_items; i++)
+    {
+        ItemState* item = new ItemState(ItemState::ITEM_BANANA, NULL, i);
+        item->initItem(ItemState::ITEM_BANANA, random_xyz(), Vec3(0, 1, 0));
+        all_items.push_back(item);
+        grid.insert(item);
+    }
+
+    std::vector<Vec3> karts(num_karts);
+    std::vector<ItemState*> near_items;
+    uint64_t linear_us = 0, grid_us = 0;
+    unsigned linear_hits = 0, grid_hits = 0, mismatches = 0;
+    for (unsigned t = 0; t < num_ticks; t++)
+    {
+        for (unsigned i = 0; i < moved_items_per_tick; i++)
+        {
+            ItemState* item = all_items[random() % num_items];
+            grid.remove(item);
+            item->initItem(ItemState::ITEM_BANANA, random_xyz(),
+                           Vec3(0, 1, 0));
+            grid.insert(item);
+        }
+        // Every second kart is driving close to an item
+        for (unsigned k = 0; k < num_karts; k++)
+        {
+            karts[k] = k % 2 == 0 ? random_xyz() :
+                all_items[random() % num_items]->getXYZ() +
+                Vec3(6.0f * unit(random) - 3.0f, unit(random),
+                     6.0f * unit(random) - 3.0f);
+        }
+
+        uint64_t start = StkTime::getMonoTimeUs();
+        unsigned linear_checksum = 0;
+        for (unsigned k = 0; k < num_karts; k++)
+        {
+            for (ItemState* item : all_items)
+            {
+                if ((karts[k] - item->getXYZ()).length2() < radius * radius)
+                {
+                    linear_hits++;
+                    linear_checksum = linear_checksum * 31 +
+                        item->getItemId();
+                }
+            }
+        }
+        linear_us += StkTime::getMonoTimeUs() - start;
+
+        start = StkTime::getMonoTimeUs();
+        unsigned grid_checksum = 0;
+        for (unsigned k = 0; k < num_karts; k++)
+        {
+            grid.findItems(karts[k], radius, &near_items);
+            for (ItemState* item : near_items)
+            {
+                if ((karts[k] - item->getXYZ()).length2() < radius * radius)
+                {
+                    grid_hits++;
+                    grid_checksum = grid_checksum * 31 + item->getItemId();
+                }
+            }
+        }
+        grid_us += StkTime::getMonoTimeUs() - start;
+        if (linear_checksum != grid_checksum)
+            mismatches++;
+    }
+
+    Log::info("Benchmark", "%u karts, %u items: all items %.2f us per tick, "
+        "grid %.2f us per tick, %u/%u hits, %u mismatching ticks.",
+        num_karts, num_items, (float)linear_us / num_ticks,
+        (float)grid_us / num_ticks, grid_hits, linear_hits, mismatches);
+
+    for (ItemState* item : all_items)
+        delete item;
+}   // benchmark
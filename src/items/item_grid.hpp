@@ -0,0 +1,69 @@
+//
+//  SuperTuxKart - a fun racing game with go-kart
+//  Copyright (C) 2019 SuperTuxKart-Team
+//
+//  This program is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU General Public License
+//  as published by the Free Software Foundation; either version 3
+//  of the License, or (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+
+#ifndef HEADER_ITEM_GRID_HPP
+#define HEADER_ITEM_GRID_HPP
+
+#include "utils/no_copy.hpp"
+
+#include <vector>
+
+class ItemState;
+class Vec3;
+
+/**
+  * \ingroup items
+  * A spatial hash of items in the x-z plane, used to find the items close
+  * to a kart without testing all items of the track. The (unbounded) grid
+  * cells are mapped to a fixed number of buckets, so several far apart
+  * cells can share a bucket, which is filtered out in findItems(). The
+  * position of an item must not change while it is in the grid.
+  */
+class ItemGrid : public NoCopy
+{
+private:
+    /** Size of a grid cell in x and z direction. */
+    float m_cell_size;
+
+    /** The items in each bucket, the number of buckets is a power of 2. */
+    std::vector<std::vector<ItemState*> > m_buckets;
+
+    /** Used by findItems() to avoid visiting a bucket twice. */
+    mutable std::vector<unsigned> m_visited_buckets;
+
+    // ------------------------------------------------------------------------
+    int getCell(float f) const;
+    // ------------------------------------------------------------------------
+    unsigned getBucket(int x, int z) const;
+
+public:
+    ItemGrid(float cell_size = 4.0f, unsigned num_buckets = 1024);
+    // ------------------------------------------------------------------------
+    void insert(ItemState* item);
+    // ------------------------------------------------------------------------
+    void remove(ItemState* item);
+    // ------------------------------------------------------------------------
+    void clear();
+    // ------------------------------------------------------------------------
+    void findItems(const Vec3& xyz, float radius,
+                   std::vector<ItemState*>* items) const;
+    // ------------------------------------------------------------------------
+    static void benchmark();
+};   // ItemGrid
+
+#endif
@@ -38,6 +38,7 @@
 #include <IMesh.h>
 #include <IAnimatedMesh.h>
 
+#include <algorithm>
 #include <assert.h>
 #include <stdexcept>
 #include <sstream>
@@ -165,6 +166,7 @@ void ItemManager::removeTextures()
 ItemManager::ItemManager()
 {
     m_switch_ticks = -1;
+    m_max_hit_radius = 0.0f;
     // The actual loading is done in loadDefaultItems
 
     // Prepare the switch to array, which stores which item should be
@@ -233,11 +235,13 @@ unsigned int ItemManager::insertItem(Item *item)
     {
         index = (int)m_all_items.size();
         m_all_items.push_back(item);
+        m_states.resize(index + 1);
     }
     else
     {
         m_all_items[index] = item;
     }
+    item->moveTo(&m_states, index);
     item->setItemId(index);
     insertItemInQuad(item);
     // Now insert into the appropriate quad list, if there is a quad list
@@ -247,10 +251,13 @@ unsigned int ItemManager::insertItem(Item *item)
 
 //-----------------------------------------------------------------------------
 /** Insert into the appropriate quad list, if there is a quad list
- *  (i.e. race mode has a quad graph).
+ *  (i.e. race mode has a quad graph), and into the grid used for hit
+ *  detection.
  */
 void ItemManager::insertItemInQuad(Item *item)
 {
+    m_item_grid.insert(item);
+    m_max_hit_radius = std::max(m_max_hit_radius, item->getHitRadius());
     if(m_items_in_quads)
     {
         int graph_node = item->getGraphNode();
@@ -380,14 +387,12 @@ void ItemManager::collectedItem(ItemState *item, AbstractKart *kart)
  */
 void  ItemManager::checkItemHit(AbstractKart* kart)
 {
-    // We could use m_items_in_quads to to check for item hits: take the quad
-    // of the graph node of the kart, and only check items in that quad. But
-    // then we also need to check for any adjacent quads (since an item just
-    // on the order of one quad might get hit from an adjacent quad). Then
-    // it is possible that a quad is that short that we need to test adjacent
-    // of adjacent quads. And check for items outside of the track.
-    // Since at this stace item detection is by far not a bottle neck,
-    // the original, simple and stable algorithm is left in place.
+    // Using m_items_in_quads would require to check adjacent quads (an item
+    // on the border of a quad can be hit from the next quad, and quads can be
+    // shorter than the hit distance) and the items outside of the track, so
+    // the items are looked up by position in m_item_grid instead. It returns
+    // the items sorted by index, so they are collected in the same order as
+    // when testing all items.
 
     /** Disable item collection detection for debug purposes. */
     if(m_disable_item_collection) return;
@@ -395,11 +400,13 @@ void  ItemManager::checkItemHit(AbstractKart* kart)
     // Spare tire karts don't collect items
     if ( dynamic_cast<SpareTireAI*>(kart->getController()) ) return;
 
-    for(AllItemTypes::iterator i =m_all_items.begin();
-                               i!=m_all_items.end();  i++)
+    m_item_grid.findItems(kart->getXYZ(), m_max_hit_radius,
+                          &m_items_near_kart);
+    for(AllItemTypes::iterator i =m_items_near_kart.begin();
+                               i!=m_items_near_kart.end();  i++)
     {
         // Ignore items that have been collected or are not available atm
-        if ((!*i) || !(*i)->isAvailable() || (*i)->isUsedUp()) continue;
+        if (!(*i)->isAvailable() || (*i)->isUsedUp()) continue;
 
         // Shielded karts can simply drive over bubble gums without any effect
         if ( kart->isShielded() &&
@@ -416,7 +423,7 @@ void  ItemManager::checkItemHit(AbstractKart* kart)
         {
             collectedItem(*i, kart);
         }   // if hit
-    }   // for m_all_items
+    }   // for m_items_near_kart
 }   // checkItemHit
 
 //-----------------------------------------------------------------------------
@@ -428,11 +435,8 @@ void ItemManager::reset()
     // If items are switched, switch them back first.
     if(m_switch_ticks>=0)
     {
-        for(AllItemTypes::iterator i =m_all_items.begin();
-                                   i!=m_all_items.end(); i++)
-        {
-            if(*i) (*i)->switchBack();
-        }
+        for (unsigned int i = 0; i < m_states.size(); i++)
+            m_states.switchBack(i);
         m_switch_ticks = -1;
 
     }
@@ -476,26 +480,19 @@ void ItemManager::update(int ticks)
         m_switch_ticks -= ticks;
         if(m_switch_ticks<0)
         {
-            for(AllItemTypes::iterator i = m_all_items.begin();
-                                       i!= m_all_items.end();  i++)
-            {
-                if(*i) (*i)->switchBack();
-            }   // for m_all_items
+            // Unused slots are not switched, so no test is necessary
+            for (unsigned int i = 0; i < m_states.size(); i++)
+                m_states.switchBack(i);
         }   // m_switch_ticks < 0
     }   // m_switch_ticks>=0
 
-    for(AllItemTypes::iterator i =m_all_items.begin();
-        i!=m_all_items.end();  i++)
+    m_states.update(ticks);
+
+    for (unsigned int i = 0; i < m_states.size(); i++)
     {
-        if(*i)
-        {
-            (*i)->update(ticks);
-            if( (*i)->isUsedUp())
-            {
-                deleteItem( *i );
-            }   // if usedUp
-        }   // if *i
-    }   // for m_all_items
+        if (m_states.m_used_up_counter[i] == 0 && m_all_items[i])
+            deleteItem(m_all_items[i]);
+    }   // for i < m_states.size()
 }   // update
 
 //-----------------------------------------------------------------------------
@@ -523,15 +520,18 @@ void ItemManager::deleteItem(ItemState *item)
     deleteItemInQuad(item);
     int index = item->getItemId();
     m_all_items[index] = NULL;
+    m_states.clearSlot(index);
     delete item;
 }   // delete item
 
 //-----------------------------------------------------------------------------
-/** Removes an items from the items-in-quad list only
+/** Removes an items from the items-in-quad list and the hit detection grid
+ *  only.
  *  \param The item to delete.
  */
 void ItemManager::deleteItemInQuad(ItemState* item)
 {
+    m_item_grid.remove(item);
     if(m_items_in_quads)
     {
         int sector = item->getGraphNode();
@@ -551,29 +551,29 @@ void ItemManager::deleteItemInQuad(ItemState* item)
  */
 void ItemManager::switchItems()
 {
-    switchItemsInternal(m_all_items);
+    switchItemsInternal(m_states);
 }  // switchItems
 
 //-----------------------------------------------------------------------------
 /** Switches all items: boxes become bananas and vice versa for a certain
  *  amount of time (as defined in stk_config.xml).
+ *  \param states The item states to switch.
  */
-void ItemManager::switchItemsInternal(std::vector<ItemState*> &all_items)
+void ItemManager::switchItemsInternal(ItemStateArrays &states)
 {
-    for(AllItemTypes::iterator i  = all_items.begin();
-                               i != all_items.end();  i++)
+    for (unsigned int i = 0; i < states.size(); i++)
     {
-        if(!*i) continue;
+        if (!states.isUsed(i)) continue;
 
-        ItemState::ItemType new_type = m_switch_to[(*i)->getType()];
+        ItemState::ItemType new_type = m_switch_to[states.m_type[i]];
 
-        if (new_type == (*i)->getType())
+        if (new_type == states.m_type[i])
             continue;
         if(m_switch_ticks<0)
-            (*i)->switchTo(new_type);
+            states.switchTo(i, new_type);
         else
-            (*i)->switchBack();
-    }   // for all_items
+            states.switchBack(i);
+    }   // for i < states.size()
 
     // if the items are already switched (m_switch_ticks >=0)
     // then switch back, and set m_switch_ticks to -1 to indicate
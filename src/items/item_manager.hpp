@@ -22,6 +22,7 @@
 #include "LinearMath/btTransform.h"
 
 #include "items/item.hpp"
+#include "items/item_grid.hpp"
 #include "utils/aligned_array.hpp"
 #include "utils/no_copy.hpp"
 #include "utils/vec3.hpp"
@@ -101,6 +102,11 @@ protected:
     typedef std::vector<ItemState*> AllItemTypes;
     AllItemTypes m_all_items;
 
+    /** The states of all items, the slot of an item is its index in
+     *  m_all_items. The states are kept in separate arrays, so that they
+     *  can be updated and copied for all items at once. */
+    ItemStateArrays m_states;
+
     /** What item this item is switched to. */
     std::vector<ItemState::ItemType> m_switch_to;
 
@@ -110,6 +116,15 @@ private:
      *  field is undefined if no Graph exist, e.g. arena without navmesh. */
     std::vector< AllItemTypes > *m_items_in_quads;
 
+    /** All items by position, used to find the items hit by a kart. */
+    ItemGrid m_item_grid;
+
+    /** The largest distance at which any item can be hit by a kart. */
+    float m_max_hit_radius;
+
+    /** Used by checkItemHit() for the items close to the kart. */
+    AllItemTypes m_items_near_kart;
+
     /** Stores all item models. */
     static std::vector<scene::IMesh *> m_item_mesh;
 
@@ -123,7 +138,7 @@ protected:
 
     void deleteItem(ItemState *item);
     virtual unsigned int insertItem(Item *item);
-    void switchItemsInternal(std::vector < ItemState*> &all_items);
+    void switchItemsInternal(ItemStateArrays &states);
     void setSwitchItems(const std::vector<int> &switch_items);
     void insertItemInQuad(Item *item);
     void deleteItemInQuad(ItemState *item);
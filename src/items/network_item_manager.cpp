@@ -70,10 +70,6 @@ NetworkItemManager::NetworkItemManager()
  */
 NetworkItemManager::~NetworkItemManager()
 {
-    for (ItemState* is : m_confirmed_state)
-    {
-        delete is;
-    }
 }   // ~NetworkItemManager
 
 //-----------------------------------------------------------------------------
@@ -248,6 +244,17 @@ BareNetworkString* NetworkItemManager::saveState(std::vector<std::string>* ru)
     return s;
 }   // saveState
 
+//-----------------------------------------------------------------------------
+/** A client can't predict item events of other karts, but most states have
+ *  no item events at all (the server only sends them until all clients
+ *  confirmed them). So the expected state is an empty one, any state with
+ *  item events will cause a rewind.
+ */
+BareNetworkString* NetworkItemManager::savePredictedState()
+{
+    return new BareNetworkString();
+}   // savePredictedState
+
 //-----------------------------------------------------------------------------
 /** Progresses the time for all item by the given number of ticks. Used
  *  when computing a new state from a confirmed state.
@@ -258,19 +265,24 @@ void NetworkItemManager::forwardTime(int ticks)
     int new_ticks = World::getWorld()->getTicksSinceStart() + ticks;
     World::getWorld()->setTicksForRewind(new_ticks);
 
-    for(auto &i : m_confirmed_state)
-    {
-        if (i) i->update(ticks);
-    }   // for m_all_items
+    m_confirmed_state.update(ticks);
     if(m_switch_ticks>ticks)
         m_switch_ticks -= ticks;
     else if (m_switch_ticks >= 0)
     {
-        switchItemsInternal(m_confirmed_state);
+        switchConfirmedItems();
         m_switch_ticks = -1;
     }
 }   // forwardTime
 
+//-----------------------------------------------------------------------------
+/** Switches all items of the confirmed state (or switches them back).
+ */
+void NetworkItemManager::switchConfirmedItems()
+{
+    switchItemsInternal(m_confirmed_state);
+}   // switchConfirmedItems
+
 //-----------------------------------------------------------------------------
 /** Restores the state of the items to the current world time. It takes the
  *  last saved confirmed state, applies any updates from the server, and
@@ -302,9 +314,9 @@ void NetworkItemManager::restoreState(BareNetworkString *buffer, int count)
     //       only (this state will later be copied to the current items).
     //       It still call collected() in the item, which will update e.g.
     //       the previous owner, use up counter etc. for that item.
-    //    b) When a new item is created, create an ItemState instance for
-    //       this item, and put it in the confirmed state. Make sure the
-    //       same index position is used.
+    //    b) When a new item is created, create an ItemState for this item
+    //       in the confirmed state. Make sure the same index position is
+    //       used.
     //    c) If a switch is used, this will be recorded in
     //       m_confirmed_switch_ticks.
     //
@@ -367,13 +379,14 @@ void NetworkItemManager::restoreState(BareNetworkString *buffer, int count)
         // ------------------------------------
         ItemEventInfo iei(buffer, &count);
         if(m_network_item_debugging)
-            Log::info("NIM", "Rewindto %d current %d iei.index %d iei tick %d iei.coll %d iei.new %d iei.ttr %d confirmed %lx",
+            Log::info("NIM", "Rewindto %d current %d iei.index %d iei tick %d iei.coll %d iei.new %d iei.ttr %d confirmed type %d",
                       rewind_to_time, current_time,
                       iei.getIndex(),
                       iei.getTicks(), iei.isItemCollection(), iei.isNewItem(),
                       iei.getTicksTillReturn(),
                       iei.getIndex() < (int)m_confirmed_state.size() && iei.getIndex() != -1 ?
-                      m_confirmed_state[iei.getIndex()] : NULL);
+                      m_confirmed_state.m_type[iei.getIndex()] :
+                      ItemState::ITEM_NONE);
         // 1.2) If the event needs to be applied, forward
         //      the time to the time of this event:
         // ----------------------------------------------
@@ -393,54 +406,50 @@ void NetworkItemManager::restoreState(BareNetworkString *buffer, int count)
             // An item on the track was collected:
             AbstractKart *kart = world->getKart(iei.getKartId());
 
-            assert(m_confirmed_state[index] != NULL);
-            m_confirmed_state[index]->collected(kart); // Collect item
+            assert(m_confirmed_state.isUsed(index));
+            m_confirmed_state.collected(index, kart); // Collect item
             // Reset till ticks return from state (required for eating banana with bomb)
             int ttr = iei.getTicksTillReturn();
-            m_confirmed_state[index]->setTicksTillReturn(ttr);
+            m_confirmed_state.m_ticks_till_return[index] = ttr;
 
-            if (m_confirmed_state[index]->isUsedUp())
-            {
-                delete m_confirmed_state[index];
-                m_confirmed_state[index] = NULL;
-            }
+            if (m_confirmed_state.m_used_up_counter[index] == 0)
+                m_confirmed_state.clearSlot(index);
         }
         else if(iei.isNewItem())
         {
             AbstractKart *kart = world->getKart(iei.getKartId());
-            ItemState *is = new ItemState(iei.getNewItemType(), kart,
-                                          iei.getIndex()             );
-            is->initItem(iei.getNewItemType(), iei.getXYZ(), iei.getNormal());
-            if (m_switch_ticks >= 0)
-            {
-                ItemState::ItemType new_type = m_switch_to[is->getType()];
-                is->switchTo(new_type);
-            }
+            const unsigned int index = iei.getIndex();
 
             // A new confirmed item must either be inserted at the end of all
             // items, or in an existing unused entry.
-            if (m_confirmed_state.size() <= is->getItemId())
+            if (m_confirmed_state.size() <= index)
             {
                 // In case that the server should send items in the wrong
                 // order, e.g. it sends an item for index n+2, then the item
-                // for index n -> we might need to add NULL item states
+                // for index n -> we might need to add unused item states
                 // into the state array to make sure the indices are correct.
-                while(m_confirmed_state.size()<is->getItemId())
-                    m_confirmed_state.push_back(NULL);
-                m_confirmed_state.push_back(is);
+                m_confirmed_state.resize(index + 1);
             }
             else
             {
                 // If the new item has an already existing index,
                 // the slot in the confirmed state array must be free
-                assert(m_confirmed_state[is->getItemId()] == NULL);
-                m_confirmed_state[is->getItemId()] = is;
+                assert(!m_confirmed_state.isUsed(index));
+            }
+            m_confirmed_state.initSlot(index, iei.getNewItemType(), kart);
+            m_confirmed_state.initItem(index, iei.getNewItemType(),
+                                       iei.getXYZ(), iei.getNormal());
+            if (m_switch_ticks >= 0)
+            {
+                ItemState::ItemType new_type =
+                    m_switch_to[m_confirmed_state.m_type[index]];
+                m_confirmed_state.switchTo(index, new_type);
             }
         }
         else if(iei.isSwitch())
         {
             // Switch all confirmed items:
-            ItemManager::switchItemsInternal(m_confirmed_state);
+            switchConfirmedItems();
         }
         else
         {
@@ -474,33 +483,48 @@ void NetworkItemManager::restoreState(BareNetworkString *buffer, int count)
     // We need to test all items - and confirmed or all_items could
     // be the larger group (confirmed: when a new item was dropped
     // by a remote kart; all_items: if an item is predicted on
-    // the client, but not yet confirmed). So 
-    size_t max_index = std::max(m_confirmed_state.size(),
-                                      m_all_items.size()        );
+    // the client, but not yet confirmed). First make sure that the
+    // items match the confirmed state, then copy the confirmed state
+    // to the states of all items at once. The hit detection grid needs
+    // the position of an item to be unchanged while it is in the grid,
+    // so items whose position changes are removed before the copy, and
+    // inserted again afterwards.
+    const unsigned int max_index = std::max(m_confirmed_state.size(),
+                                            (unsigned int)m_all_items.size());
     m_all_items.resize(max_index, NULL);
+    m_states.resize(max_index);
 
+    std::vector<Item*> reinsert_items;
     for(unsigned int i=0; i<max_index; i++)
     {
-        ItemState *item     = m_all_items[i];
-        const ItemState *is = i < m_confirmed_state.size() 
-                            ? m_confirmed_state[i] : NULL;
-        // For every *(ItemState*)item = *is, all deactivated ticks, item id
-        // ... will be copied from item state to item
+        ItemState *item = m_all_items[i];
+        const bool is   = i < m_confirmed_state.size() &&
+                          m_confirmed_state.isUsed(i);
         if (is && item)
         {
-            *(ItemState*)item = *is;
+            // A predicted item can be replaced by a different confirmed
+            // item with the same index, so update the hit detection grid
+            // if the position changes.
+            if (m_states.m_xyz[i] != m_confirmed_state.m_xyz[i])
+            {
+                deleteItemInQuad(item);
+                reinsert_items.push_back(static_cast<Item*>(item));
+            }
         }
         else if (is && !item)
         {
             // A new item was dropped according to the server that is not
             // yet part of the current state --> create new item
-            Vec3 xyz = is->getXYZ();
-            Vec3 normal = is->getNormal();
-            Item *item_new = dropNewItem(is->getType(), is->getPreviousOwner(),
-                                         &xyz, &normal );
-            *((ItemState*)item_new) = *is;
+            Vec3 xyz = m_confirmed_state.m_xyz[i];
+            Vec3 normal = m_confirmed_state.getNormal(i);
+            Item *item_new =
+                dropNewItem(m_confirmed_state.m_type[i],
+                            m_confirmed_state.m_previous_owner[i],
+                            &xyz, &normal);
+            item_new->moveTo(&m_states, i);
+            item_new->setItemId(i);
             m_all_items[i] = item_new;
-            insertItemInQuad(item_new);
+            reinsert_items.push_back(item_new);
         }
         else if (!is && item)
         {
@@ -509,8 +533,11 @@ void NetworkItemManager::restoreState(BareNetworkString *buffer, int count)
             m_all_items[i] = NULL;
         }
     }   // for i < max_index
-    // Clean up the rest
+    // Clean up the rest, and copy all confirmed states
     m_all_items.resize(m_confirmed_state.size());
+    m_states = m_confirmed_state;
+    for (Item *item : reinsert_items)
+        insertItemInQuad(item);
 
     // Now set the clock back to the 'rewindto' time:
     world->setTicksForRewind(rewind_to_time);
@@ -533,7 +560,7 @@ void NetworkItemManager::saveCompleteState(BareNetworkString* buffer) const
         if (m_all_items[i])
         {
             buffer->addUInt8(1);
-            m_all_items[i]->saveCompleteState(buffer);
+            m_states.saveCompleteState(i, i, buffer);
         }
         else
             buffer->addUInt8(0);
@@ -549,20 +576,13 @@ void NetworkItemManager::restoreCompleteState(const BareNetworkString& buffer)
     m_confirmed_state_time = buffer.getUInt32();
     m_confirmed_switch_ticks = buffer.getUInt32();
     uint32_t all_items = buffer.getUInt32();
-    for (ItemState* is : m_confirmed_state)
-    {
-        delete is;
-    }
-    m_confirmed_state.clear();
+    // Remove all old states, all slots are unused after resizing
+    m_confirmed_state.resize(0);
+    m_confirmed_state.resize(all_items);
     for (unsigned i = 0; i < all_items; i++)
     {
         const bool has_item = buffer.getUInt8() == 1;
         if (has_item)
-        {
-            ItemState* is = new ItemState(buffer);
-            m_confirmed_state.push_back(is);
-        }
-        else
-            m_confirmed_state.push_back(NULL);
+            m_confirmed_state.restoreCompleteState(i, buffer);
     }
 }   // restoreCompleteState
@@ -46,8 +46,10 @@ class NetworkItemManager : public Rewinder, public ItemManager
 private:
 
     /** A client stores a 'confirmed' item event state, which is based on the
-      * server data. This is used in case of rewind. */
-    std::vector<ItemState*> m_confirmed_state;
+      * server data. This is used in case of rewind. It uses the same slots
+      * as the ItemManager states, so it can be copied to them at once.
+      * Unused slots have the type ITEM_NONE. */
+    ItemStateArrays m_confirmed_state;
 
     /** The switch ticks value at the lime of the last confirmed state. */
     int m_confirmed_switch_ticks;
@@ -66,6 +68,8 @@ private:
     Synchronised< std::vector<ItemEventInfo> > m_item_events;
 
     void forwardTime(int ticks);
+    void switchConfirmedItems();
+    // ------------------------------------------------------------------------
 
     NetworkItemManager();
 
@@ -87,6 +91,7 @@ public:
     virtual BareNetworkString* saveState(std::vector<std::string>* ru)
         OVERRIDE;
     virtual void restoreState(BareNetworkString *buffer, int count) OVERRIDE;
+    virtual BareNetworkString* savePredictedState() OVERRIDE;
     // ------------------------------------------------------------------------
     virtual void rewindToEvent(BareNetworkString *bns) OVERRIDE {};
     // ------------------------------------------------------------------------
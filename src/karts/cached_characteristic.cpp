@@ -18,44 +18,15 @@
 
 #include "karts/cached_characteristic.hpp"
 
-#include "utils/interpolation_array.hpp"
+#include "utils/log.hpp"
 
 CachedCharacteristic::CachedCharacteristic(const AbstractCharacteristic *origin) :
-    m_values(CHARACTERISTIC_COUNT),
+    m_float_vector_values(CHARACTERISTIC_COUNT),
+    m_interpolation_array_values(CHARACTERISTIC_COUNT),
     m_origin(origin)
 {
     updateSource();
-}
-
-// ----------------------------------------------------------------------------
-/** Deletes all allocated values. */
-CachedCharacteristic::~CachedCharacteristic()
-{
-    // Delete all not-null values
-    for (int i = 0; i < CHARACTERISTIC_COUNT; i++)
-    {
-        SaveValue &v = m_values[i];
-        if (v.content)
-        {
-            switch (getType(static_cast<CharacteristicType>(i)))
-            {
-            case TYPE_FLOAT:
-                delete static_cast<float*>(v.content);
-                break;
-            case TYPE_FLOAT_VECTOR:
-                delete static_cast<std::vector<float>*>(v.content);
-                break;
-            case TYPE_INTERPOLATION_ARRAY:
-                delete static_cast<InterpolationArray*>(v.content);
-                break;
-            case TYPE_BOOL:
-                delete static_cast<bool*>(v.content);
-                break;
-            }
-            v.content = nullptr;
-        }
-    }
-}   // ~CachedCharacteristic
+}   // CachedCharacteristic
 
 // ----------------------------------------------------------------------------
 /** Recompute the values of all characteristics based on the list of
@@ -65,112 +36,31 @@ void CachedCharacteristic::updateSource()
 {
     for (int i = 0; i < CHARACTERISTIC_COUNT; i++)
     {
-        SaveValue &v = m_values[i];
-        
+        const CharacteristicType type = static_cast<CharacteristicType>(i);
         bool is_set = false;
-        switch (getType(static_cast<CharacteristicType>(i)))
+        // Reset all values, so that a value that is not set anymore
+        // doesn't keep its old content
+        m_float_values[i] = 0.0f;
+        m_bool_values[i] = false;
+        m_float_vector_values[i].clear();
+        m_interpolation_array_values[i].clear();
+        switch (getType(type))
         {
         case TYPE_FLOAT:
-        {
-            float value;
-            float *ptr = static_cast<float*>(v.content);
-            m_origin->process(static_cast<CharacteristicType>(i), &value, &is_set);
-            if (is_set)
-            {
-                if (!ptr)
-                {
-                    float *newPtr = new float();
-                    v.content = newPtr;
-                    ptr = newPtr;
-                }
-                *ptr = value;
-            }
-            else
-            {
-                if (ptr)
-                {
-                    delete ptr;
-                    v.content = nullptr;
-                }
-            }
+            m_origin->process(type, &m_float_values[i], &is_set);
             break;
-        }
         case TYPE_FLOAT_VECTOR:
-        {
-            std::vector<float> value;
-            std::vector<float> *ptr = static_cast<std::vector<float>*>(v.content);
-            m_origin->process(static_cast<CharacteristicType>(i), &value, &is_set);
-            if (is_set)
-            {
-                if (!ptr)
-                {
-                    std::vector<float> *newPtr = new std::vector<float>();
-                    v.content = newPtr;
-                    ptr = newPtr;
-                }
-                *ptr = value;
-            }
-            else
-            {
-                if (ptr)
-                {
-                    delete ptr;
-                    v.content = nullptr;
-                }
-            }
+            m_origin->process(type, &m_float_vector_values[i], &is_set);
             break;
-        }
         case TYPE_INTERPOLATION_ARRAY:
-        {
-            InterpolationArray value;
-            InterpolationArray *ptr = static_cast<InterpolationArray*>(v.content);
-            m_origin->process(static_cast<CharacteristicType>(i), &value, &is_set);
-            if (is_set)
-            {
-                if (!ptr)
-                {
-                    InterpolationArray *newPtr = new InterpolationArray();
-                    v.content = newPtr;
-                    ptr = newPtr;
-                }
-                *ptr = value;
-            }
-            else
-            {
-                if (ptr)
-                {
-                    delete ptr;
-                    v.content = nullptr;
-                }
-            }
+            m_origin->process(type, &m_interpolation_array_values[i],
+                              &is_set);
             break;
-        }
         case TYPE_BOOL:
-        {
-            bool value;
-            bool *ptr = static_cast<bool*>(v.content);
-            m_origin->process(static_cast<CharacteristicType>(i), &value, &is_set);
-            if (is_set)
-            {
-                if (!ptr)
-                {
-                    bool *newPtr = new bool();
-                    v.content = newPtr;
-                    ptr = newPtr;
-                }
-                *ptr = value;
-            }
-            else
-            {
-                if (ptr)
-                {
-                    delete ptr;
-                    v.content = nullptr;
-                }
-            }
+            m_origin->process(type, &m_bool_values[i], &is_set);
             break;
-        }
         }   // switch (type)
+        m_is_set[i] = is_set;
     }   // foreach characteristic
 }   // updateSource
 
@@ -179,25 +69,33 @@ void CachedCharacteristic::updateSource()
 void CachedCharacteristic::process(CharacteristicType type, Value value,
                                    bool *is_set) const
 {
-    void *v = m_values[type].content;
-    if (v)
+    if (!m_is_set[type])
+        return;
+
+    switch (getType(type))
     {
-        switch (getType(type))
-        {
-        case TYPE_FLOAT:
-            *value.f = *static_cast<float*>(v);
-            break;
-        case TYPE_FLOAT_VECTOR:
-            *value.fv = *static_cast<std::vector<float>*>(v);
-            break;
-        case TYPE_INTERPOLATION_ARRAY:
-            *value.ia = *static_cast<InterpolationArray*>(v);
-            break;
-        case TYPE_BOOL:
-            *value.b = *static_cast<bool*>(v);
-            break;
-        }
-        *is_set = true;
+    case TYPE_FLOAT:
+        *value.f = m_float_values[type];
+        break;
+    case TYPE_FLOAT_VECTOR:
+        *value.fv = m_float_vector_values[type];
+        break;
+    case TYPE_INTERPOLATION_ARRAY:
+        *value.ia = m_interpolation_array_values[type];
+        break;
+    case TYPE_BOOL:
+        *value.b = m_bool_values[type];
+        break;
     }
+    *is_set = true;
 }   // process
 
+// ----------------------------------------------------------------------------
+/** Called by getFloat() and getBool() if a value is read that is not set,
+ *  which is handled like in the getters of AbstractCharacteristic.
+ */
+void CachedCharacteristic::notSet(CharacteristicType type) const
+{
+    Log::fatal("AbstractCharacteristic", "Can't get characteristic %s",
+               getName(type).c_str());
+}   // notSet
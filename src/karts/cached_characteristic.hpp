@@ -20,36 +20,71 @@
 #define HEADER_CACHED_CHARACTERISTICS_HPP
 
 #include "karts/abstract_characteristic.hpp"
+#include "utils/interpolation_array.hpp"
 
 #include <assert.h>
 
+/** Stores the resolved values of another characteristic (usually the
+ *  combination of base, difficulty, kart type, handicap and kart
+ *  characteristic of a kart), so that reading a value doesn't walk the
+ *  whole chain again. The float and bool values are kept in flat arrays
+ *  indexed by the characteristic type, which getFloat() and getBool() can
+ *  read without a virtual call. A new cache is created whenever the
+ *  source changes (see KartProperties::combineCharacteristics()).
+ */
 class CachedCharacteristic : public AbstractCharacteristic
 {
 private:
-    /** Used to store a value. */
-    struct SaveValue
-    {
-        void *content;
+    /** The values of all float characteristics. */
+    float m_float_values[CHARACTERISTIC_COUNT];
+
+    /** The values of all bool characteristics. */
+    bool m_bool_values[CHARACTERISTIC_COUNT];
+
+    /** True if a characteristic is set in the source. */
+    bool m_is_set[CHARACTERISTIC_COUNT];
 
-        SaveValue() : content(nullptr) {}
-        SaveValue(void *content) : content(content) {}
-    };
+    /** The values of the float vector characteristics, empty for all
+     *  other types. */
+    std::vector<std::vector<float> > m_float_vector_values;
 
-    /** All values for a characteristic. A nullptr means it is not set. */
-    std::vector<SaveValue> m_values;
+    /** The values of the interpolation array characteristics, empty for
+     *  all other types. */
+    std::vector<InterpolationArray> m_interpolation_array_values;
 
     /** The characteristics that hold the original values. */
     const AbstractCharacteristic *m_origin;
 
+    // ------------------------------------------------------------------------
+    void notSet(CharacteristicType type) const;
+
 public:
     CachedCharacteristic(const AbstractCharacteristic *origin);
     CachedCharacteristic(const CachedCharacteristic &characteristics) = delete;
-    virtual ~CachedCharacteristic();
+    virtual ~CachedCharacteristic() {}
 
     /** Fetches all cached values from the original source. */
     void updateSource();
     virtual void copyFrom(const AbstractCharacteristic *other) { assert(false); }
     virtual void process(CharacteristicType type, Value value, bool *is_set) const;
+    // ------------------------------------------------------------------------
+    /** Returns the value of a float characteristic. */
+    float getFloat(CharacteristicType type) const
+    {
+        assert(getType(type) == TYPE_FLOAT);
+        if (!m_is_set[type])
+            notSet(type);
+        return m_float_values[type];
+    }   // getFloat
+    // ------------------------------------------------------------------------
+    /** Returns the value of a bool characteristic. */
+    bool getBool(CharacteristicType type) const
+    {
+        assert(getType(type) == TYPE_BOOL);
+        if (!m_is_set[type])
+            notSet(type);
+        return m_bool_values[type];
+    }   // getBool
 };
 
 #endif
@@ -62,6 +62,18 @@ public:
     virtual      ~Controller         () {};
     virtual void  reset              () = 0;
     virtual void  update             (int ticks) = 0;
+    // ------------------------------------------------------------------------
+    /** Called for the controllers of all karts before any kart is updated
+     *  in a time step, possibly in parallel for different karts (see
+     *  World::update()). It can precompute the parts of update() that only
+     *  read the world, so it must not modify anything except the state of
+     *  this controller. */
+    virtual void  prepareUpdate      (int ticks) {}
+    // ------------------------------------------------------------------------
+    /** Returns if prepareUpdate() does any work, i.e. if this controller
+     *  has an AI decision step, so that it must be called. */
+    virtual bool  hasPrepareUpdate   () const { return false; }
+    // ------------------------------------------------------------------------
     virtual void  handleZipper       (bool play_sound) = 0;
     virtual void  collectedItem      (const ItemState &item,
                                       float previous_energy=0) = 0;
@@ -47,19 +47,37 @@ NetworkAIController::~NetworkAIController()
     delete m_ai_controls;
 }   // ~NetworkAIController
 
+// ----------------------------------------------------------------------------
+/** Returns if the AI controller is updated in the current time step. */
+bool NetworkAIController::isAIUpdateDue() const
+{
+    return !RewindManager::get()->isRewinding() &&
+        (World::getWorld()->isStartPhase() ||
+         World::getWorld()->getTicksSinceStart() > m_prev_update_ticks);
+}   // isAIUpdateDue
+
+// ----------------------------------------------------------------------------
+void NetworkAIController::prepareUpdate(int ticks)
+{
+    if (isAIUpdateDue())
+        m_ai_controller->prepareUpdate(m_ai_frequency);
+}   // prepareUpdate
+
+// ----------------------------------------------------------------------------
+bool NetworkAIController::hasPrepareUpdate() const
+{
+    return m_ai_controller->hasPrepareUpdate();
+}   // hasPrepareUpdate
+
 // ----------------------------------------------------------------------------
 void NetworkAIController::update(int ticks)
 {
-    if (!RewindManager::get()->isRewinding())
+    if (isAIUpdateDue())
     {
-        if (World::getWorld()->isStartPhase() ||
-            World::getWorld()->getTicksSinceStart() > m_prev_update_ticks)
-        {
-            m_prev_update_ticks = World::getWorld()->getTicksSinceStart() +
-                m_ai_frequency;
-            m_ai_controller->update(m_ai_frequency);
-            convertAIToPlayerActions();
-        }
+        m_prev_update_ticks = World::getWorld()->getTicksSinceStart() +
+            m_ai_frequency;
+        m_ai_controller->update(m_ai_frequency);
+        convertAIToPlayerActions();
     }
     PlayerController::update(ticks);
 }   // update
@@ -32,11 +32,14 @@ private:
     AIBaseController* m_ai_controller;
     KartControl* m_ai_controls;
     void convertAIToPlayerActions();
+    bool isAIUpdateDue() const;
 public:
                  NetworkAIController(AbstractKart *kart, int local_player_id,
                                      AIBaseController* ai);
     virtual     ~NetworkAIController();
     virtual void update(int ticks) OVERRIDE;
+    virtual void prepareUpdate(int ticks) OVERRIDE;
+    virtual bool hasPrepareUpdate() const OVERRIDE;
     virtual void reset() OVERRIDE;
     static void setAIFrequency(int freq) { m_ai_frequency = freq; }
 };   // class NetworkAIController
@@ -176,6 +176,8 @@ void SkiddingAI::reset()
     m_skid_probability_state     = SKID_PROBAB_NOT_YET;
     m_last_item_random           = NULL;
     m_burster                    = false;
+    m_prepared                   = false;
+    m_prepared_last_node         = Graph::UNKNOWN_SECTOR;
 
     AIBaseLapController::reset();
     m_track_node               = Graph::UNKNOWN_SECTOR;
@@ -214,6 +216,41 @@ unsigned int SkiddingAI::getNextSector(unsigned int index)
     return m_successor_index[index];
 }   // getNextSector
 
+//-----------------------------------------------------------------------------
+/** Computes the look-ahead information used by update() (nearest karts,
+ *  crashes, track direction and the point to aim at) from the state of the
+ *  world at the start of the time step. This is called for all AIs before
+ *  any kart is updated, possibly in parallel, so it only modifies the state
+ *  of this AI. The random generators and anything that changes the world
+ *  (e.g. using items) are only used in update().
+ */
+void SkiddingAI::prepareUpdate(int ticks)
+{
+    m_prepared = false;
+#ifdef AI_DEBUG
+    // The debug curves and spheres must only be changed in the main thread
+    return;
+#endif
+
+    // Same tests as in update(), which doesn't need the information then
+    if(m_kart->getKartAnimation() || isStuck() || m_world->isStartPhase())
+        return;
+
+    computeNearestKarts();
+    checkCrashes(m_kart->getXYZ());
+    determineTrackDirection();
+    switch(m_point_selection_algorithm)
+    {
+    case PSA_NEW:    findNonCrashingPointNew(&m_prepared_aim_point,
+                                             &m_prepared_last_node);
+                     break;
+    case PSA_DEFAULT:findNonCrashingPoint(&m_prepared_aim_point,
+                                          &m_prepared_last_node);
+                     break;
+    }
+    m_prepared = true;
+}   // prepareUpdate
+
 //-----------------------------------------------------------------------------
 /** This is the main entry point for the AI.
  *  It is called once per frame for each AI and determines the behaviour of
@@ -222,6 +259,9 @@ unsigned int SkiddingAI::getNextSector(unsigned int index)
 void SkiddingAI::update(int ticks)
 {
     float dt = stk_config->ticks2Time(ticks);
+    // The results of prepareUpdate() are only valid for this time step
+    const bool prepared = m_prepared;
+    m_prepared = false;
     m_controls->setRescue(false);
 
     // This is used to enable firing an item backwards.
@@ -313,7 +353,8 @@ void SkiddingAI::update(int ticks)
     }
 
     // Get information that is needed by more than 1 of the handling funcs
-    computeNearestKarts();
+    if(!prepared)
+        computeNearestKarts();
 
     int num_ai = m_world->getNumKarts() - race_manager->getNumPlayers();
     int position_among_ai = m_kart->getPosition() - m_num_players_ahead;
@@ -329,12 +370,15 @@ void SkiddingAI::update(int ticks)
                         speed_cap, /*fade_in_time*/0);
 
     //Detect if we are going to crash with the track and/or kart
-    checkCrashes(m_kart->getXYZ());
-    determineTrackDirection();
+    if(!prepared)
+    {
+        checkCrashes(m_kart->getXYZ());
+        determineTrackDirection();
+    }
 
     /*Response handling functions*/
     handleAccelerationAndBraking(ticks);
-    handleSteering(dt);
+    handleSteering(dt, prepared);
     handleRescue(dt);
 
     // Make sure that not all AI karts use the zipper at the same
@@ -357,8 +401,10 @@ void SkiddingAI::update(int ticks)
  *  avoid item, and potentially adjust the aim-at point, before computing the
  *  steer direction to arrive at the currently aim-at point.
  *  \param dt Time step size.
+ *  \param prepared True if the point to aim at was computed by
+ *         prepareUpdate().
  */
-void SkiddingAI::handleSteering(float dt)
+void SkiddingAI::handleSteering(float dt, bool prepared)
 {
     // Special behaviour if we have a bomb attached: try to hit the kart ahead
     // of us.
@@ -460,12 +506,20 @@ void SkiddingAI::handleSteering(float dt)
         Vec3 aim_point;
         int last_node = Graph::UNKNOWN_SECTOR;
 
-        switch(m_point_selection_algorithm)
+        if(prepared)
+        {
+            aim_point = m_prepared_aim_point;
+            last_node = m_prepared_last_node;
+        }
+        else
         {
-        case PSA_NEW:    findNonCrashingPointNew(&aim_point, &last_node);
-                         break;
-        case PSA_DEFAULT:findNonCrashingPoint(&aim_point, &last_node);
-                         break;
+            switch(m_point_selection_algorithm)
+            {
+            case PSA_NEW:    findNonCrashingPointNew(&aim_point, &last_node);
+                             break;
+            case PSA_DEFAULT:findNonCrashingPoint(&aim_point, &last_node);
+                             break;
+            }
         }
 #ifdef AI_DEBUG
         m_debug_sphere[m_point_selection_algorithm]->setPosition(aim_point.toIrrVector());
@@ -2466,8 +2520,6 @@ void SkiddingAI::checkCrashes(const Vec3& pos )
         m_crashes.m_kart = slip->getSlipstreamTarget()->getWorldKartId();
     }
 
-    const size_t NUM_KARTS = m_world->getNumKarts();
-
     float speed = m_kart->getVelocity().length();
     // If the velocity is zero, no sense in checking for crashes in time
     if(speed==0) return;
@@ -2485,6 +2537,15 @@ void SkiddingAI::checkCrashes(const Vec3& pos )
                   steps, m_kart_length, m_kart->getVelocityLC().getZ());
         steps=1000;
     }
+
+    // Only karts that can get within m_kart_length of the last step
+    // (driving at most at the highest speed of all karts) need to be
+    // tested, the small margin covers rounding errors.
+    std::vector<unsigned> near_karts;
+    const float max_distance = m_kart_length + (steps - 1) *
+        (m_kart_length + m_world->getKartGrid().getMaxSpeed() * dt) + 1.0f;
+    m_world->getKartGrid().findKarts(pos, max_distance, &near_karts);
+
     for(int i = 1; steps > i; ++i)
     {
         Vec3 step_coord = pos + vel_normal* m_kart_length * float(i);
@@ -2494,7 +2555,7 @@ void SkiddingAI::checkCrashes(const Vec3& pos )
          */
         if( m_crashes.m_kart == -1 )
         {
-            for( unsigned int j = 0; j < NUM_KARTS; ++j )
+            for (unsigned int j : near_karts)
             {
                 const AbstractKart* kart = m_world->getKart(j);
                 // Ignore eliminated karts
@@ -234,6 +234,16 @@ private:
     enum {PSA_DEFAULT, PSA_NEW}
           m_point_selection_algorithm;
 
+    /** True if prepareUpdate() has computed the nearest karts, crashes,
+     *  track direction and the point to aim at for the next update(). */
+    bool m_prepared;
+
+    /** The point to aim at as computed by prepareUpdate(). */
+    Vec3 m_prepared_aim_point;
+
+    /** The graph node of m_prepared_aim_point. */
+    int m_prepared_last_node;
+
 #ifdef AI_DEBUG
     /** For skidding debugging: shows the estimated turn shape. */
     ShowCurve **m_curve;
@@ -255,7 +265,7 @@ private:
      */
     void  handleRaceStart();
     void  handleAccelerationAndBraking(int ticks);
-    void  handleSteering(float dt);
+    void  handleSteering(float dt, bool prepared);
     int   computeSkill(SkillType type);
     void  handleItems(const float dt, const Vec3 *aim_point,
                                 int last_node, int item_skill);
@@ -300,6 +310,8 @@ public:
                  SkiddingAI(AbstractKart *kart);
                 ~SkiddingAI();
     virtual void update      (int ticks);
+    virtual void prepareUpdate(int ticks);
+    virtual bool hasPrepareUpdate() const { return true; }
     virtual void reset       ();
     virtual const irr::core::stringw& getNamePostfix() const;
 };
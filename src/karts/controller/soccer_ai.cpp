@@ -22,6 +22,7 @@
 #include "items/powerup.hpp"
 #include "karts/abstract_kart.hpp"
 #include "karts/controller/kart_control.hpp"
+#include "karts/kart_grid.hpp"
 #include "karts/kart_properties.hpp"
 #include "modes/soccer_world.hpp"
 #include "tracks/arena_graph.hpp"
@@ -141,28 +142,43 @@ void SoccerAI::update(int ticks)
 void SoccerAI::findClosestKart(bool consider_difficulty, bool find_sta)
 {
     float distance = 99999.9f;
-    const unsigned int n = m_world->getNumKarts();
     int closest_kart_num = 0;
 
-    for (unsigned int i = 0; i < n; i++)
+    // Search the karts in a growing area around this kart, till the
+    // closest kart found is inside of the area (then no kart outside can
+    // be closer), or all karts were tested.
+    const KartGrid &grid = m_world->getKartGrid();
+    std::vector<unsigned int> near_karts;
+    for (float radius = 20.0f; ; radius *= 2.0f)
     {
-        const AbstractKart* kart = m_world->getKart(i);
-        if (kart->isEliminated()) continue;
+        grid.findKarts(m_kart->getXYZ(), radius, &near_karts);
+        distance = 99999.9f;
+        closest_kart_num = 0;
+        bool found = false;
+        for (unsigned int i : near_karts)
+        {
+            const AbstractKart* kart = m_world->getKart(i);
+            if (kart->isEliminated()) continue;
 
-        if (kart->getWorldKartId() == m_kart->getWorldKartId())
-            continue; // Skip the same kart
+            if (kart->getWorldKartId() == m_kart->getWorldKartId())
+                continue; // Skip the same kart
 
-        if (m_world->getKartTeam(kart
-            ->getWorldKartId()) == m_world->getKartTeam(m_kart
-            ->getWorldKartId()))
-            continue; // Skip the kart with the same team
+            if (m_world->getKartTeam(kart
+                ->getWorldKartId()) == m_world->getKartTeam(m_kart
+                ->getWorldKartId()))
+                continue; // Skip the kart with the same team
 
-        Vec3 d = kart->getXYZ() - m_kart->getXYZ();
-        if (d.length_2d() <= distance)
-        {
-            distance = d.length_2d();
-            closest_kart_num = i;
+            Vec3 d = kart->getXYZ() - m_kart->getXYZ();
+            if (d.length_2d() <= distance)
+            {
+                distance = d.length_2d();
+                closest_kart_num = i;
+                found = true;
+            }
         }
+        if ((found && distance <= radius) ||
+            near_karts.size() >= grid.getNumKarts())
+            break;
     }
 
     m_closest_kart = m_world->getKart(closest_kart_num);
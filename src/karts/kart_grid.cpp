@@ -0,0 +1,264 @@
+//
+//  SuperTuxKart - a fun racing game with go-kart
+//  Copyright (C) 2019 SuperTuxKart-Team
+//
+//  This program is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU General Public License
+//  as published by the Free Software Foundation; either version 3
+//  of the License, or (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+
+#include "karts/kart_grid.hpp"
+
+#include "karts/abstract_kart.hpp"
+#include "karts/kart_properties.hpp"
+#include "utils/log.hpp"
+#include "utils/time.hpp"
+#include "utils/vec3.hpp"
+
+#include <algorithm>
+#include <assert.h>
+#include <cmath>
+#include <cstdint>
+#include <random>
+
+// ----------------------------------------------------------------------------
+/** Creates an empty grid.
+ *  \param cell_size Size of a cell in x and z direction.
+ *  \param num_buckets Number of buckets the cells are mapped to, must be a
+ *         power of 2.
+ */
+KartGrid::KartGrid(float cell_size, unsigned num_buckets)
+{
+    assert(num_buckets > 0 && (num_buckets & (num_buckets - 1)) == 0);
+    m_cell_size            = cell_size;
+    m_max_speed            = 0.0f;
+    m_max_slipstream_reach = 0.0f;
+    m_buckets.resize(num_buckets);
+}   // KartGrid
+
+// ----------------------------------------------------------------------------
+/** Returns the cell index for a x or z coordinate.
+ */
+int KartGrid::getCell(float f) const
+{
+    const float cell = floorf(f / m_cell_size);
+    // Avoid undefined behaviour for positions far outside of any track
+    if (!(cell > -1048576.0f))
+        return -1048576;
+    if (cell > 1048576.0f)
+        return 1048576;
+    return (int)cell;
+}   // getCell
+
+// ----------------------------------------------------------------------------
+/** Returns the bucket index of a cell.
+ */
+unsigned KartGrid::getBucket(int x, int z) const
+{
+    return ((unsigned)x * 73856093u ^ (unsigned)z * 19349663u) &
+        ((unsigned)m_buckets.size() - 1);
+}   // getBucket
+
+// ----------------------------------------------------------------------------
+/** Removes all karts and adds the karts at the given positions, the index
+ *  in xyz is used as the id of a kart.
+ */
+void KartGrid::insertAll(const std::vector<Vec3>& xyz)
+{
+    for (std::vector<unsigned>& bucket : m_buckets)
+        bucket.clear();
+    m_kart_cells.resize(xyz.size());
+    for (unsigned i = 0; i < xyz.size(); i++)
+    {
+        const int x = getCell(xyz[i].getX());
+        const int z = getCell(xyz[i].getZ());
+        m_kart_cells[i] = std::make_pair(x, z);
+        m_buckets[getBucket(x, z)].push_back(i);
+    }
+}   // insertAll
+
+// ----------------------------------------------------------------------------
+/** Rebuilds the grid from the current positions of all karts. Eliminated
+ *  and ghost karts are added, too, the callers skip them as before.
+ *  \param karts All karts of the world, indexed by world kart id.
+ */
+void KartGrid::build(const std::vector<std::shared_ptr<AbstractKart> >& karts)
+{
+    std::vector<Vec3> xyz(karts.size());
+    m_max_speed = 0.0f;
+    m_max_slipstream_reach = 0.0f;
+    for (unsigned i = 0; i < karts.size(); i++)
+    {
+        const AbstractKart* kart = karts[i].get();
+        xyz[i] = kart->getXYZ();
+        m_max_speed = std::max(m_max_speed, kart->getVelocity().length());
+        // Same as the quick distance test in SlipStream::update()
+        const KartProperties* kp = kart->getKartProperties();
+        const float reach = kp->getSlipstreamLength() * 1.1f *
+            fabsf(kart->getSpeed()) / kp->getSlipstreamBaseSpeed() +
+            kart->getKartLength();
+        m_max_slipstream_reach = std::max(m_max_slipstream_reach, reach);
+    }
+    insertAll(xyz);
+}   // build
+
+// ----------------------------------------------------------------------------
+/** Returns the world kart ids of all karts in the cells which overlap the
+ *  square of size 2*radius around xyz (in the x-z plane) when the grid was
+ *  built, sorted by id. This can be called from several threads at the
+ *  same time.
+ *  \param xyz The position to search at.
+ *  \param radius The maximum distance of a kart that must be found.
+ *  \param karts On return the ids of the karts close to xyz.
+ */
+void KartGrid::findKarts(const Vec3& xyz, float radius,
+                         std::vector<unsigned>* karts) const
+{
+    karts->clear();
+    const int x0 = getCell(xyz.getX() - radius);
+    const int x1 = getCell(xyz.getX() + radius);
+    const int z0 = getCell(xyz.getZ() - radius);
+    const int z1 = getCell(xyz.getZ() + radius);
+
+    auto add_karts = [&](const std::vector<unsigned>& bucket)
+    {
+        for (unsigned id : bucket)
+        {
+            // Skip karts of other cells mapped to the same bucket
+            const std::pair<int, int>& cell = m_kart_cells[id];
+            if (cell.first  >= x0 && cell.first  <= x1 &&
+                cell.second >= z0 && cell.second <= z1)
+                karts->push_back(id);
+        }
+    };
+
+    if ((int64_t)(x1 - x0 + 1) * (z1 - z0 + 1) >= (int64_t)m_buckets.size())
+    {
+        for (const std::vector<unsigned>& bucket : m_buckets)
+            add_karts(bucket);
+        std::sort(karts->begin(), karts->end());
+        return;
+    }
+    for (int x = x0; x <= x1; x++)
+    {
+        for (int z = z0; z <= z1; z++)
+            add_karts(m_buckets[getBucket(x, z)]);
+    }
+    // Several cells of the square can share a bucket, which then adds
+    // its karts more than once
+    std::sort(karts->begin(), karts->end());
+    karts->erase(std::unique(karts->begin(), karts->end()), karts->end());
+}   // findKarts
+
+// ----------------------------------------------------------------------------
+/** Compares the kart part of the crash test of the AI (see
+ *  SkiddingAI::checkCrashes()) for 64 karts driving in groups on a track,
+ *  once testing all karts and once only the karts found in the grid.
+ */
+void KartGrid::benchmark()
+{
+    std::mt19937 random(1);
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+    const unsigned num_karts = 64;
+    const unsigned num_ticks = 1200;
+    const float track_size = 600.0f;
+    const float kart_length = 1.5f;
+
+    KartGrid grid;
+    std::vector<Vec3> xyz(num_karts), velocity(num_karts);
+    std::vector<unsigned> near_karts;
+
+    // Returns the kart that kart k would crash with when testing all
+    // karts or only the karts found in the grid, or -1.
+    auto find_crash = [&](unsigned k, float max_speed, bool use_grid)
+    {
+        const float speed = velocity[k].length();
+        const int steps = std::max(int(speed / kart_length), 2) + 5;
+        const float dt = kart_length / speed;
+        const Vec3 vel_normal = velocity[k] / speed;
+        if (use_grid)
+        {
+            const float max_distance = kart_length + (steps - 1) *
+                (kart_length + max_speed * dt) + 1.0f;
+            grid.findKarts(xyz[k], max_distance, &near_karts);
+        }
+        const unsigned n = use_grid ? (unsigned)near_karts.size()
+                                    : num_karts;
+        for (int i = 1; i < steps; i++)
+        {
+            const Vec3 step_coord = xyz[k] + vel_normal * kart_length * i;
+            int crash = -1;
+            for (unsigned m = 0; m < n; m++)
+            {
+                const unsigned j = use_grid ? near_karts[m] : m;
+                if (j == k)
+                    continue;
+                const Vec3 other = xyz[j] + velocity[j] * (i * dt);
+                if ((step_coord - other).length() < kart_length)
+                    crash = j;
+            }
+            if (crash != -1)
+                return crash;
+        }
+        return -1;
+    };
+
+    uint64_t linear_us = 0, build_us = 0, grid_us = 0;
+    unsigned linear_crashes = 0, grid_crashes = 0, mismatches = 0;
+    for (unsigned t = 0; t < num_ticks; t++)
+    {
+        // Every fourth kart leads a group of karts close behind it
+        float max_speed = 0.0f;
+        for (unsigned k = 0; k < num_karts; k++)
+        {
+            xyz[k] = k % 4 == 0
+                   ? Vec3(track_size * unit(random), 2.0f * unit(random),
+                          track_size * unit(random))
+                   : xyz[k - 1] + Vec3(10.0f * unit(random) - 5.0f, 0,
+                                       10.0f * unit(random) - 5.0f);
+            velocity[k] = Vec3(10.0f * unit(random) + 20.0f, 0,
+                               10.0f * unit(random) - 5.0f);
+            max_speed = std::max(max_speed, velocity[k].length());
+        }
+
+        uint64_t start = StkTime::getMonoTimeUs();
+        unsigned linear_checksum = 0;
+        for (unsigned k = 0; k < num_karts; k++)
+        {
+            const int crash = find_crash(k, max_speed, false);
+            linear_crashes += crash != -1;
+            linear_checksum = linear_checksum * 31 + crash;
+        }
+        linear_us += StkTime::getMonoTimeUs() - start;
+
+        start = StkTime::getMonoTimeUs();
+        grid.insertAll(xyz);
+        build_us += StkTime::getMonoTimeUs() - start;
+        start = StkTime::getMonoTimeUs();
+        unsigned grid_checksum = 0;
+        for (unsigned k = 0; k < num_karts; k++)
+        {
+            const int crash = find_crash(k, max_speed, true);
+            grid_crashes += crash != -1;
+            grid_checksum = grid_checksum * 31 + crash;
+        }
+        grid_us += StkTime::getMonoTimeUs() - start;
+        if (linear_checksum != grid_checksum)
+            mismatches++;
+    }
+
+    Log::info("Benchmark", "%u karts: all karts %.2f us per tick, grid build "
+        "%.2f us + crash tests %.2f us per tick, %u/%u crashes, "
+        "%u mismatching ticks.", num_karts, (float)linear_us / num_ticks,
+        (float)build_us / num_ticks, (float)grid_us / num_ticks,
+        grid_crashes, linear_crashes, mismatches);
+}   // benchmark
@@ -0,0 +1,90 @@
+//
+//  SuperTuxKart - a fun racing game with go-kart
+//  Copyright (C) 2019 SuperTuxKart-Team
+//
+//  This program is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU General Public License
+//  as published by the Free Software Foundation; either version 3
+//  of the License, or (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+
+#ifndef HEADER_KART_GRID_HPP
+#define HEADER_KART_GRID_HPP
+
+#include "utils/no_copy.hpp"
+
+#include <memory>
+#include <vector>
+
+class AbstractKart;
+class Vec3;
+
+/**
+  * \ingroup karts
+  * A spatial hash of the karts in the x-z plane, which is built once at the
+  * start of each time step by the world. It is used to find the karts close
+  * to a point without testing all karts, e.g. for the crash tests of the AI
+  * or for slipstreaming. The (unbounded) grid cells are mapped to a fixed
+  * number of buckets, so several far apart cells can share a bucket, which
+  * is filtered out in findKarts(). The grid only stores the positions of
+  * the karts at the time it was built, so callers must test the current
+  * position of the found karts themselves.
+  */
+class KartGrid : public NoCopy
+{
+private:
+    /** Size of a grid cell in x and z direction. */
+    float m_cell_size;
+
+    /** The world kart ids of the karts in each bucket, the number of
+     *  buckets is a power of 2. */
+    std::vector<std::vector<unsigned> > m_buckets;
+
+    /** The x and z cell of each kart when the grid was built. */
+    std::vector<std::pair<int, int> > m_kart_cells;
+
+    /** The highest speed of all karts when the grid was built. */
+    float m_max_speed;
+
+    /** The largest distance from which a kart can get slipstream from
+     *  another kart (not counting the length of the kart getting the
+     *  slipstream), see SlipStream::update(). */
+    float m_max_slipstream_reach;
+
+    // ------------------------------------------------------------------------
+    int getCell(float f) const;
+    // ------------------------------------------------------------------------
+    unsigned getBucket(int x, int z) const;
+    // ------------------------------------------------------------------------
+    void insertAll(const std::vector<Vec3>& xyz);
+
+public:
+    KartGrid(float cell_size = 8.0f, unsigned num_buckets = 256);
+    // ------------------------------------------------------------------------
+    void build(const std::vector<std::shared_ptr<AbstractKart> >& karts);
+    // ------------------------------------------------------------------------
+    void findKarts(const Vec3& xyz, float radius,
+                   std::vector<unsigned>* karts) const;
+    // ------------------------------------------------------------------------
+    static void benchmark();
+    // ------------------------------------------------------------------------
+    /** Returns the number of karts in the grid. */
+    unsigned int getNumKarts() const
+                                 { return (unsigned int)m_kart_cells.size(); }
+    // ------------------------------------------------------------------------
+    /** Returns the highest speed of all karts when the grid was built. */
+    float getMaxSpeed() const { return m_max_speed; }
+    // ------------------------------------------------------------------------
+    /** Returns the largest distance at which a kart can get slipstream. */
+    float getMaxSlipstreamReach() const { return m_max_slipstream_reach; }
+};   // KartGrid
+
+#endif
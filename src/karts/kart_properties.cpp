@@ -39,6 +39,7 @@
 #include "utils/constants.hpp"
 #include "utils/log.hpp"
 #include "utils/string_utils.hpp"
+#include "utils/time.hpp"
 #include "utils/translation.hpp"
 
 #include <iostream>
@@ -184,7 +185,9 @@ void KartProperties::load(const std::string &filename, const std::string &node)
     // Get the default values from STKConfig. This will also allocate any
     // pointers used in KartProperties
 
-    const XMLNode* root = new XMLNode(filename);
+    const XMLNode* root = file_manager->takePreloadedXMLTree(filename);
+    if (!root)
+        root = new XMLNode(filename);
     std::string kart_type;
 
     if (root->get("type", &kart_type))
@@ -618,61 +621,71 @@ core::stringw KartProperties::getName() const
 // ----------------------------------------------------------------------------
 float KartProperties::getSuspensionStiffness() const
 {
-    return m_cached_characteristic->getSuspensionStiffness();
+    return m_cached_characteristic->getFloat(
+        AbstractCharacteristic::SUSPENSION_STIFFNESS);
 }  // getSuspensionStiffness
 
 // ----------------------------------------------------------------------------
 float KartProperties::getSuspensionRest() const
 {
-    return m_cached_characteristic->getSuspensionRest();
+    return m_cached_characteristic->getFloat(
+        AbstractCharacteristic::SUSPENSION_REST);
 }  // getSuspensionRest
 
 // ----------------------------------------------------------------------------
 float KartProperties::getSuspensionTravel() const
 {
-    return m_cached_characteristic->getSuspensionTravel();
+    return m_cached_characteristic->getFloat(
+        AbstractCharacteristic::SUSPENSION_TRAVEL);
 }  // getSuspensionTravel
 
 // ----------------------------------------------------------------------------
 bool KartProperties::getSuspensionExpSpringResponse() const
 {
-    return m_cached_characteristic->getSuspensionExpSpringResponse();
+    return m_cached_characteristic->getBool(
+        AbstractCharacteristic::SUSPENSION_EXP_SPRING_RESPONSE);
 }  // getSuspensionExpSpringResponse
 
 // ----------------------------------------------------------------------------
 float KartProperties::getSuspensionMaxForce() const
 {
-    return m_cached_characteristic->getSuspensionMaxForce();
+    return m_cached_characteristic->getFloat(
+        AbstractCharacteristic::SUSPENSION_MAX_FORCE);
 }  // getSuspensionMaxForce
 
 // ----------------------------------------------------------------------------
 float KartProperties::getStabilityRollInfluence() const
 {
-    return m_cached_characteristic->getStabilityRollInfluence();
+    return m_cached_characteristic->getFloat(
+        AbstractCharacteristic::STABILITY_ROLL_INFLUENCE);
 }  // getStabilityRollInfluence
 
 // ----------------------------------------------------------------------------
 float KartProperties::getStabilityChassisLinearDamping() const
 {
-    return m_cached_characteristic->getStabilityChassisLinearDamping();
+    return m_cached_characteristic->getFloat(
+        AbstractCharacteristic::STABILITY_CHASSIS_LINEAR_DAMPING);
 }  // getStabilityChassisLinearDamping
 
 // ----------------------------------------------------------------------------
 float KartProperties::getStabilityChassisAngularDamping() const
 {
-    return m_cached_characteristic->getStabilityChassisAngularDamping();
+    return m_cached_characteristic->getFloat(
+        AbstractCharacteristic::STABILITY_CHASSIS_ANGULAR_DAMPING);
 }  // getStabilityChassisAngularDamping
 
 // ----------------------------------------------------------------------------
 float KartProperties::getStabilityDownwardImpulseFactor() const
 {
-    return m_cached_characteristic->getStabilityDownwardImpulseFactor();
+    return m_cached_characteristic->getFloat(
+        AbstractCharacteristic::STABILITY_DOWNWARD_IMPULSE_FACTOR);
 }  // getStabilityDownwardImpulseFactor
 
 // ----------------------------------------------------------------------------
 float KartProperties::getStabilityTrackConnectionAccel() const
 {
-    return m_cached_characteristic->getStabilityTrackConnectionAccel();
+    return m_cached_characteristic->getFloat(
+        AbstractCharacteristic::STABILITY_TRACK_CONNECTION_ACCEL);
 }  // getStabilityTrackConnectionAccel
 
 // ----------------------------------------------------------------------------
@@ -684,7 +697,8 @@ std::vector<float> KartProperties::getStabilityAngularFactor() const
 // ----------------------------------------------------------------------------
 float KartProperties::getStabilitySmoothFlyingImpulse() const
 {
-    return m_cached_characteristic->getStabilitySmoothFlyingImpulse();
+    return m_cached_characteristic->getFloat(
+        AbstractCharacteristic::STABILITY_SMOOTH_FLYING_IMPULSE);
 }  // getStabilitySmoothFlyingImpulse
 
 // ----------------------------------------------------------------------------
@@ -696,7 +710,8 @@ InterpolationArray KartProperties::getTurnRadius() const
 // ----------------------------------------------------------------------------
 float KartProperties::getTurnTimeResetSteer() const
 {
-    return m_cached_characteristic->getTurnTimeResetSteer();
+    return m_cached_characteristic->getFloat(
+        AbstractCharacteristic::TURN_TIME_RESET_STEER);
 }  // getTurnTimeResetSteer
 
 // ----------------------------------------------------------------------------
@@ -708,37 +723,43 @@ InterpolationArray KartProperties::getTurnTimeFullSteer() const
 // ----------------------------------------------------------------------------
 float KartProperties::getEnginePower() const
 {
-    return m_cached_characteristic->getEnginePower();
+    return m_cached_characteristic->getFloat(
+        AbstractCharacteristic::ENGINE_POWER);
 }  // getEnginePower
 
 // ----------------------------------------------------------------------------
 float KartProperties::getEngineMaxSpeed() const
 {
-    return m_cached_characteristic->getEngineMaxSpeed();
+    return m_cached_characteristic->getFloat(
+        AbstractCharacteristic::ENGINE_MAX_SPEED);
 }  // getEngineMaxSpeed
 
 // ----------------------------------------------------------------------------
 float KartProperties::getEngineGenericMaxSpeed() const
 {
-    return m_cached_characteristic->getEngineGenericMaxSpeed();
+    return m_cached_characteristic->getFloat(
+        AbstractCharacteristic::ENGINE_GENERIC_MAX_SPEED);
 }  // getEngineMaxSpeed
 
 // ----------------------------------------------------------------------------
 float KartProperties::getEngineBrakeFactor() const
 {
-    return m_cached_characteristic->getEngineBrakeFactor();
+    return m_cached_characteristic->getFloat(
+        AbstractCharacteristic::ENGINE_BRAKE_FACTOR);
 }  // getEngineBrakeFactor
 
 // ----------------------------------------------------------------------------
 float KartProperties::getEngineBrakeTimeIncrease() const
 {
-    return m_cached_characteristic->getEngineBrakeTimeIncrease();
+    return m_cached_characteristic->getFloat(
+        AbstractCharacteristic::ENGINE_BRAKE_TIME_INCREASE);
 }  // getEngineBrakeTimeIncrease
 
 // ----------------------------------------------------------------------------
 float KartProperties::getEngineMaxSpeedReverseRatio() const
 {
-    return m_cached_characteristic->getEngineMaxSpeedReverseRatio();
+    return m_cached_characteristic->getFloat(
+        AbstractCharacteristic::ENGINE_MAX_SPEED_REVERSE_RATIO);
 }  // getEngineMaxSpeedReverseRatio
 
 // ----------------------------------------------------------------------------
@@ -756,79 +777,92 @@ std::vector<float> KartProperties::getGearPowerIncrease() const
 // ----------------------------------------------------------------------------
 float KartProperties::getMass() const
 {
-    return m_cached_characteristic->getMass();
+    return m_cached_characteristic->getFloat(
+        AbstractCharacteristic::MASS);
 }  // getMass
 
 // ----------------------------------------------------------------------------
 float KartProperties::getWheelsDampingRelaxation() const
 {
-    return m_cached_characteristic->getWheelsDampingRelaxation();
+    return m_cached_characteristic->getFloat(
+        AbstractCharacteristic::WHEELS_DAMPING_RELAXATION);
 }  // getWheelsDampingRelaxation
 
 // ----------------------------------------------------------------------------
 float KartProperties::getWheelsDampingCompression() const
 {
-    return m_cached_characteristic->getWheelsDampingCompression();
+    return m_cached_characteristic->getFloat(
+        AbstractCharacteristic::WHEELS_DAMPING_COMPRESSION);
 }  // getWheelsDampingCompression
 
 // ----------------------------------------------------------------------------
 float KartProperties::getCameraDistance() const
 {
-    return m_cached_characteristic->getCameraDistance();
+    return m_cached_characteristic->getFloat(
+        AbstractCharacteristic::CAMERA_DISTANCE);
 }  // getCameraDistance
 
 // ----------------------------------------------------------------------------
 float KartProperties::getCameraForwardUpAngle() const
 {
-    return m_cached_characteristic->getCameraForwardUpAngle();
+    return m_cached_characteristic->getFloat(
+        AbstractCharacteristic::CAMERA_FORWARD_UP_ANGLE);
 }  // getCameraForwardUpAngle
 
 // ----------------------------------------------------------------------------
 float KartProperties::getCameraBackwardUpAngle() const
 {
-    return m_cached_characteristic->getCameraBackwardUpAngle();
+    return m_cached_characteristic->getFloat(
+        AbstractCharacteristic::CAMERA_BACKWARD_UP_ANGLE);
 }  // getCameraBackwardUpAngle
 
 // ----------------------------------------------------------------------------
 float KartProperties::getJumpAnimationTime() const
 {
-    return m_cached_characteristic->getJumpAnimationTime();
+    return m_cached_characteristic->getFloat(
+        AbstractCharacteristic::JUMP_ANIMATION_TIME);
 }  // getJumpAnimationTime
 
 // ----------------------------------------------------------------------------
 float KartProperties::getLeanMax() const
 {
-    return m_cached_characteristic->getLeanMax();
+    return m_cached_characteristic->getFloat(
+        AbstractCharacteristic::LEAN_MAX);
 }  // getLeanMax
 
 // ----------------------------------------------------------------------------
 float KartProperties::getLeanSpeed() const
 {
-    return m_cached_characteristic->getLeanSpeed();
+    return m_cached_characteristic->getFloat(
+        AbstractCharacteristic::LEAN_SPEED);
 }  // getLeanSpeed
 
 // ----------------------------------------------------------------------------
 float KartProperties::getAnvilDuration() const
 {
-    return m_cached_characteristic->getAnvilDuration();
+    return m_cached_characteristic->getFloat(
+        AbstractCharacteristic::ANVIL_DURATION);
 }  // getAnvilDuration
 
 // ----------------------------------------------------------------------------
 float KartProperties::getAnvilWeight() const
 {
-    return m_cached_characteristic->getAnvilWeight();
+    return m_cached_characteristic->getFloat(
+        AbstractCharacteristic::ANVIL_WEIGHT);
 }  // getAnvilWeight
 
 // ----------------------------------------------------------------------------
 float KartProperties::getAnvilSpeedFactor() const
 {
-    return m_cached_characteristic->getAnvilSpeedFactor();
+    return m_cached_characteristic->getFloat(
+        AbstractCharacteristic::ANVIL_SPEED_FACTOR);
 }  // getAnvilSpeedFactor
 
 // ----------------------------------------------------------------------------
 float KartProperties::getParachuteFriction() const
 {
-    return m_cached_characteristic->getParachuteFriction();
+    return m_cached_characteristic->getFloat(
+        AbstractCharacteristic::PARACHUTE_FRICTION);
 }  // getParachuteFriction
 
 // ----------------------------------------------------------------------------
@@ -846,55 +880,64 @@ int KartProperties::getParachuteDurationOther() const
 // ----------------------------------------------------------------------------
 float KartProperties::getParachuteDurationRankMult() const
 {
-    return m_cached_characteristic->getParachuteDurationRankMult();
+    return m_cached_characteristic->getFloat(
+        AbstractCharacteristic::PARACHUTE_DURATION_RANK_MULT);
 }  // getParachuteDurationRankMult
 
 // ----------------------------------------------------------------------------
 float KartProperties::getParachuteDurationSpeedMult() const
 {
-    return m_cached_characteristic->getParachuteDurationSpeedMult();
+    return m_cached_characteristic->getFloat(
+        AbstractCharacteristic::PARACHUTE_DURATION_SPEED_MULT);
 }  // getParachuteDurationSpeedMult
 
 // ----------------------------------------------------------------------------
 float KartProperties::getParachuteLboundFraction() const
 {
-    return m_cached_characteristic->getParachuteLboundFraction();
+    return m_cached_characteristic->getFloat(
+        AbstractCharacteristic::PARACHUTE_LBOUND_FRACTION);
 }  // getParachuteLboundFraction
 
 // ----------------------------------------------------------------------------
 float KartProperties::getParachuteUboundFraction() const
 {
-    return m_cached_characteristic->getParachuteUboundFraction();
+    return m_cached_characteristic->getFloat(
+        AbstractCharacteristic::PARACHUTE_UBOUND_FRACTION);
 }  // getParachuteUboundFraction
 
 // ----------------------------------------------------------------------------
 float KartProperties::getParachuteMaxSpeed() const
 {
-    return m_cached_characteristic->getParachuteMaxSpeed();
+    return m_cached_characteristic->getFloat(
+        AbstractCharacteristic::PARACHUTE_MAX_SPEED);
 }  // getParachuteMaxSpeed
 
 // ----------------------------------------------------------------------------
 float KartProperties::getFrictionKartFriction() const
 {
-    return m_cached_characteristic->getFrictionKartFriction();
+    return m_cached_characteristic->getFloat(
+        AbstractCharacteristic::FRICTION_KART_FRICTION);
 }  // getFrictionKartFriction
 
 // ----------------------------------------------------------------------------
 float KartProperties::getBubblegumDuration() const
 {
-    return m_cached_characteristic->getBubblegumDuration();
+    return m_cached_characteristic->getFloat(
+        AbstractCharacteristic::BUBBLEGUM_DURATION);
 }  // getBubblegumDuration
 
 // ----------------------------------------------------------------------------
 float KartProperties::getBubblegumSpeedFraction() const
 {
-    return m_cached_characteristic->getBubblegumSpeedFraction();
+    return m_cached_characteristic->getFloat(
+        AbstractCharacteristic::BUBBLEGUM_SPEED_FRACTION);
 }  // getBubblegumSpeedFraction
 
 // ----------------------------------------------------------------------------
 float KartProperties::getBubblegumTorque() const
 {
-    return m_cached_characteristic->getBubblegumTorque();
+    return m_cached_characteristic->getFloat(
+        AbstractCharacteristic::BUBBLEGUM_TORQUE);
 }  // getBubblegumTorque
 
 // ----------------------------------------------------------------------------
@@ -907,85 +950,99 @@ int KartProperties::getBubblegumFadeInTicks() const
 // ----------------------------------------------------------------------------
 float KartProperties::getBubblegumShieldDuration() const
 {
-    return m_cached_characteristic->getBubblegumShieldDuration();
+    return m_cached_characteristic->getFloat(
+        AbstractCharacteristic::BUBBLEGUM_SHIELD_DURATION);
 }  // getBubblegumShieldDuration
 
 // ----------------------------------------------------------------------------
 float KartProperties::getZipperDuration() const
 {
-    return m_cached_characteristic->getZipperDuration();
+    return m_cached_characteristic->getFloat(
+        AbstractCharacteristic::ZIPPER_DURATION);
 }  // getZipperDuration
 
 // ----------------------------------------------------------------------------
 float KartProperties::getZipperForce() const
 {
-    return m_cached_characteristic->getZipperForce();
+    return m_cached_characteristic->getFloat(
+        AbstractCharacteristic::ZIPPER_FORCE);
 }  // getZipperForce
 
 // ----------------------------------------------------------------------------
 float KartProperties::getZipperSpeedGain() const
 {
-    return m_cached_characteristic->getZipperSpeedGain();
+    return m_cached_characteristic->getFloat(
+        AbstractCharacteristic::ZIPPER_SPEED_GAIN);
 }  // getZipperSpeedGain
 
 // ----------------------------------------------------------------------------
 float KartProperties::getZipperMaxSpeedIncrease() const
 {
-    return m_cached_characteristic->getZipperMaxSpeedIncrease();
+    return m_cached_characteristic->getFloat(
+        AbstractCharacteristic::ZIPPER_MAX_SPEED_INCREASE);
 }  // getZipperMaxSpeedIncrease
 
 // ----------------------------------------------------------------------------
 float KartProperties::getZipperFadeOutTime() const
 {
-    return m_cached_characteristic->getZipperFadeOutTime();
+    return m_cached_characteristic->getFloat(
+        AbstractCharacteristic::ZIPPER_FADE_OUT_TIME);
 }  // getZipperFadeOutTime
 
 // ----------------------------------------------------------------------------
 float KartProperties::getSwatterDuration() const
 {
-    return m_cached_characteristic->getSwatterDuration();
+    return m_cached_characteristic->getFloat(
+        AbstractCharacteristic::SWATTER_DURATION);
 }  // getSwatterDuration
 
 // ----------------------------------------------------------------------------
 float KartProperties::getSwatterDistance() const
 {
-    return m_cached_characteristic->getSwatterDistance();
+    return m_cached_characteristic->getFloat(
+        AbstractCharacteristic::SWATTER_DISTANCE);
 }  // getSwatterDistance
 
 // ----------------------------------------------------------------------------
 float KartProperties::getSwatterSquashDuration() const
 {
-    return m_cached_characteristic->getSwatterSquashDuration();
+    return m_cached_characteristic->getFloat(
+        AbstractCharacteristic::SWATTER_SQUASH_DURATION);
 }  // getSwatterSquashDuration
 
 // ----------------------------------------------------------------------------
 float KartProperties::getSwatterSquashSlowdown() const
 {
-    return m_cached_characteristic->getSwatterSquashSlowdown();
+    return m_cached_characteristic->getFloat(
+        AbstractCharacteristic::SWATTER_SQUASH_SLOWDOWN);
 }  // getSwatterSquashSlowdown
 
 // ----------------------------------------------------------------------------
 float KartProperties::getPlungerBandMaxLength() const
 {
-    return m_cached_characteristic->getPlungerBandMaxLength();
+    return m_cached_characteristic->getFloat(
+        AbstractCharacteristic::PLUNGER_BAND_MAX_LENGTH);
 }  // getPlungerBandMaxLength
 
 // ----------------------------------------------------------------------------
 float KartProperties::getPlungerBandForce() const
 {
-    return m_cached_characteristic->getPlungerBandForce();
+    return m_cached_characteristic->getFloat(
+        AbstractCharacteristic::PLUNGER_BAND_FORCE);
 }  // getPlungerBandForce
 
 // ----------------------------------------------------------------------------
 float KartProperties::getPlungerBandDuration() const
 {
-    return m_cached_characteristic->getPlungerBandDuration();
+    return m_cached_characteristic->getFloat(
+        AbstractCharacteristic::PLUNGER_BAND_DURATION);
 }  // getPlungerBandDuration
 
 // ----------------------------------------------------------------------------
 float KartProperties::getPlungerBandSpeedIncrease() const
 {
-    return m_cached_characteristic->getPlungerBandSpeedIncrease();
+    return m_cached_characteristic->getFloat(
+        AbstractCharacteristic::PLUNGER_BAND_SPEED_INCREASE);
 }  // getPlungerBandSpeedIncrease
 
 // ----------------------------------------------------------------------------
@@ -998,7 +1055,8 @@ int KartProperties::getPlungerBandFadeOutTicks() const
 // ----------------------------------------------------------------------------
 float KartProperties::getPlungerInFaceTime() const
 {
-    return m_cached_characteristic->getPlungerInFaceTime();
+    return m_cached_characteristic->getFloat(
+        AbstractCharacteristic::PLUNGER_IN_FACE_TIME);
 }  // getPlungerInFaceTime
 
 // ----------------------------------------------------------------------------
@@ -1016,151 +1074,176 @@ std::vector<float> KartProperties::getStartupBoost() const
 // ----------------------------------------------------------------------------
 float KartProperties::getRescueDuration() const
 {
-    return m_cached_characteristic->getRescueDuration();
+    return m_cached_characteristic->getFloat(
+        AbstractCharacteristic::RESCUE_DURATION);
 }  // getRescueDuration
 
 // ----------------------------------------------------------------------------
 float KartProperties::getRescueVertOffset() const
 {
-    return m_cached_characteristic->getRescueVertOffset();
+    return m_cached_characteristic->getFloat(
+        AbstractCharacteristic::RESCUE_VERT_OFFSET);
 }  // getRescueVertOffset
 
 // ----------------------------------------------------------------------------
 float KartProperties::getRescueHeight() const
 {
-    return m_cached_characteristic->getRescueHeight();
+    return m_cached_characteristic->getFloat(
+        AbstractCharacteristic::RESCUE_HEIGHT);
 }  // getRescueHeight
 
 // ----------------------------------------------------------------------------
 float KartProperties::getExplosionDuration() const
 {
-    return m_cached_characteristic->getExplosionDuration();
+    return m_cached_characteristic->getFloat(
+        AbstractCharacteristic::EXPLOSION_DURATION);
 }  // getExplosionDuration
 
 // ----------------------------------------------------------------------------
 float KartProperties::getExplosionRadius() const
 {
-    return m_cached_characteristic->getExplosionRadius();
+    return m_cached_characteristic->getFloat(
+        AbstractCharacteristic::EXPLOSION_RADIUS);
 }  // getExplosionRadius
 
 // ----------------------------------------------------------------------------
 float KartProperties::getExplosionInvulnerabilityTime() const
 {
-    return m_cached_characteristic->getExplosionInvulnerabilityTime();
+    return m_cached_characteristic->getFloat(
+        AbstractCharacteristic::EXPLOSION_INVULNERABILITY_TIME);
 }  // getExplosionInvulnerabilityTime
 
 // ----------------------------------------------------------------------------
 float KartProperties::getNitroDuration() const
 {
-    return m_cached_characteristic->getNitroDuration();
+    return m_cached_characteristic->getFloat(
+        AbstractCharacteristic::NITRO_DURATION);
 }  // getNitroDuration
 
 // ------------------------------------------------------------------------
 float KartProperties::getNitroEngineForce() const
 {
-    return m_cached_characteristic->getNitroEngineForce();
+    return m_cached_characteristic->getFloat(
+        AbstractCharacteristic::NITRO_ENGINE_FORCE);
 }  // getNitroEngineForce
 
 // ----------------------------------------------------------------------------
 float KartProperties::getNitroEngineMult() const
 {
-    return m_cached_characteristic->getNitroEngineMult();
+    return m_cached_characteristic->getFloat(
+        AbstractCharacteristic::NITRO_ENGINE_MULT);
 }  // getNitroEngineMult
 
 // ----------------------------------------------------------------------------
 float KartProperties::getNitroConsumption() const
 {
-    return m_cached_characteristic->getNitroConsumption();
+    return m_cached_characteristic->getFloat(
+        AbstractCharacteristic::NITRO_CONSUMPTION);
 }  // getNitroConsumption
 
 // ----------------------------------------------------------------------------
 float KartProperties::getNitroSmallContainer() const
 {
-    return m_cached_characteristic->getNitroSmallContainer();
+    return m_cached_characteristic->getFloat(
+        AbstractCharacteristic::NITRO_SMALL_CONTAINER);
 }  // getNitroSmallContainer
 
 // ----------------------------------------------------------------------------
 float KartProperties::getNitroBigContainer() const
 {
-    return m_cached_characteristic->getNitroBigContainer();
+    return m_cached_characteristic->getFloat(
+        AbstractCharacteristic::NITRO_BIG_CONTAINER);
 }  // getNitroBigContainer
 
 // ----------------------------------------------------------------------------
 float KartProperties::getNitroMaxSpeedIncrease() const
 {
-    return m_cached_characteristic->getNitroMaxSpeedIncrease();
+    return m_cached_characteristic->getFloat(
+        AbstractCharacteristic::NITRO_MAX_SPEED_INCREASE);
 }  // getNitroMaxSpeedIncrease
 
 // ----------------------------------------------------------------------------
 float KartProperties::getNitroFadeOutTime() const
 {
-    return m_cached_characteristic->getNitroFadeOutTime();
+    return m_cached_characteristic->getFloat(
+        AbstractCharacteristic::NITRO_FADE_OUT_TIME);
 }  // getNitroFadeOutTime
 
 // ----------------------------------------------------------------------------
 float KartProperties::getNitroMax() const
 {
-    return m_cached_characteristic->getNitroMax();
+    return m_cached_characteristic->getFloat(
+        AbstractCharacteristic::NITRO_MAX);
 }  // getNitroMax
 
 // ----------------------------------------------------------------------------
 float KartProperties::getSlipstreamDurationFactor() const
 {
-    return m_cached_characteristic->getSlipstreamDurationFactor();
+    return m_cached_characteristic->getFloat(
+        AbstractCharacteristic::SLIPSTREAM_DURATION_FACTOR);
 }  // getSlipstreamDurationFactor
 
 // ----------------------------------------------------------------------------
 float KartProperties::getSlipstreamBaseSpeed() const
 {
-    return m_cached_characteristic->getSlipstreamBaseSpeed();
+    return m_cached_characteristic->getFloat(
+        AbstractCharacteristic::SLIPSTREAM_BASE_SPEED);
 }  // getSlipstreamBaseSpeed
 
 // ----------------------------------------------------------------------------
 float KartProperties::getSlipstreamLength() const
 {
-    return m_cached_characteristic->getSlipstreamLength();
+    return m_cached_characteristic->getFloat(
+        AbstractCharacteristic::SLIPSTREAM_LENGTH);
 }  // getSlipstreamLength
 
 // ----------------------------------------------------------------------------
 float KartProperties::getSlipstreamWidth() const
 {
-    return m_cached_characteristic->getSlipstreamWidth();
+    return m_cached_characteristic->getFloat(
+        AbstractCharacteristic::SLIPSTREAM_WIDTH);
 }  // getSlipstreamWidth
 
 // ----------------------------------------------------------------------------
 float KartProperties::getSlipstreamInnerFactor() const
 {
-    return m_cached_characteristic->getSlipstreamInnerFactor();
+    return m_cached_characteristic->getFloat(
+        AbstractCharacteristic::SLIPSTREAM_INNER_FACTOR);
 }  // getSlipstreamInnerFactor
 
 // ----------------------------------------------------------------------------
 float KartProperties::getSlipstreamMinCollectTime() const
 {
-    return m_cached_characteristic->getSlipstreamMinCollectTime();
+    return m_cached_characteristic->getFloat(
+        AbstractCharacteristic::SLIPSTREAM_MIN_COLLECT_TIME);
 }  // getSlipstreamMinCollectTime
 
 // ----------------------------------------------------------------------------
 float KartProperties::getSlipstreamMaxCollectTime() const
 {
-    return m_cached_characteristic->getSlipstreamMaxCollectTime();
+    return m_cached_characteristic->getFloat(
+        AbstractCharacteristic::SLIPSTREAM_MAX_COLLECT_TIME);
 }  // getSlipstreamMaxCollectTime
 
 // ----------------------------------------------------------------------------
 float KartProperties::getSlipstreamAddPower() const
 {
-    return m_cached_characteristic->getSlipstreamAddPower();
+    return m_cached_characteristic->getFloat(
+        AbstractCharacteristic::SLIPSTREAM_ADD_POWER);
 }  // getSlipstreamAddPower
 
 // ----------------------------------------------------------------------------
 float KartProperties::getSlipstreamMinSpeed() const
 {
-    return m_cached_characteristic->getSlipstreamMinSpeed();
+    return m_cached_characteristic->getFloat(
+        AbstractCharacteristic::SLIPSTREAM_MIN_SPEED);
 }  // getSlipstreamMinSpeed
 
 // ----------------------------------------------------------------------------
 float KartProperties::getSlipstreamMaxSpeedIncrease() const
 {
-    return m_cached_characteristic->getSlipstreamMaxSpeedIncrease();
+    return m_cached_characteristic->getFloat(
+        AbstractCharacteristic::SLIPSTREAM_MAX_SPEED_INCREASE);
 }  // getSlipstreamMaxSpeedIncrease
 
 // ----------------------------------------------------------------------------
@@ -1173,49 +1256,57 @@ int KartProperties::getSlipstreamFadeOutTicks() const
 // ----------------------------------------------------------------------------
 float KartProperties::getSkidIncrease() const
 {
-    return m_cached_characteristic->getSkidIncrease();
+    return m_cached_characteristic->getFloat(
+        AbstractCharacteristic::SKID_INCREASE);
 }  // getSkidIncrease
 
 // ----------------------------------------------------------------------------
 float KartProperties::getSkidDecrease() const
 {
-    return m_cached_characteristic->getSkidDecrease();
+    return m_cached_characteristic->getFloat(
+        AbstractCharacteristic::SKID_DECREASE);
 }  // getSkidDecrease
 
 // ----------------------------------------------------------------------------
 float KartProperties::getSkidMax() const
 {
-    return m_cached_characteristic->getSkidMax();
+    return m_cached_characteristic->getFloat(
+        AbstractCharacteristic::SKID_MAX);
 }  // getSkidMax
 
 // ----------------------------------------------------------------------------
 float KartProperties::getSkidTimeTillMax() const
 {
-    return m_cached_characteristic->getSkidTimeTillMax();
+    return m_cached_characteristic->getFloat(
+        AbstractCharacteristic::SKID_TIME_TILL_MAX);
 }  // getSkidTimeTillMax
 
 // ----------------------------------------------------------------------------
 float KartProperties::getSkidVisual() const
 {
-    return m_cached_characteristic->getSkidVisual();
+    return m_cached_characteristic->getFloat(
+        AbstractCharacteristic::SKID_VISUAL);
 }  // getSkidVisual
 
 // ----------------------------------------------------------------------------
 float KartProperties::getSkidVisualTime() const
 {
-    return m_cached_characteristic->getSkidVisualTime();
+    return m_cached_characteristic->getFloat(
+        AbstractCharacteristic::SKID_VISUAL_TIME);
 }  // getSkidVisualTime
 
 // ----------------------------------------------------------------------------
 float KartProperties::getSkidRevertVisualTime() const
 {
-    return m_cached_characteristic->getSkidRevertVisualTime();
+    return m_cached_characteristic->getFloat(
+        AbstractCharacteristic::SKID_REVERT_VISUAL_TIME);
 }  // getSkidRevertVisualTime
 
 // ----------------------------------------------------------------------------
 float KartProperties::getSkidMinSpeed() const
 {
-    return m_cached_characteristic->getSkidMinSpeed();
+    return m_cached_characteristic->getFloat(
+        AbstractCharacteristic::SKID_MIN_SPEED);
 }  // getSkidMinSpeed
 
 // ----------------------------------------------------------------------------
@@ -1245,38 +1336,157 @@ std::vector<float> KartProperties::getSkidBonusForce() const
 // ----------------------------------------------------------------------------
 float KartProperties::getSkidPhysicalJumpTime() const
 {
-    return m_cached_characteristic->getSkidPhysicalJumpTime();
+    return m_cached_characteristic->getFloat(
+        AbstractCharacteristic::SKID_PHYSICAL_JUMP_TIME);
 }  // getSkidPhysicalJumpTime
 
 // ----------------------------------------------------------------------------
 float KartProperties::getSkidGraphicalJumpTime() const
 {
-    return m_cached_characteristic->getSkidGraphicalJumpTime();
+    return m_cached_characteristic->getFloat(
+        AbstractCharacteristic::SKID_GRAPHICAL_JUMP_TIME);
 }  // getSkidGraphicalJumpTime
 
 // ----------------------------------------------------------------------------
 float KartProperties::getSkidPostSkidRotateFactor() const
 {
-    return m_cached_characteristic->getSkidPostSkidRotateFactor();
+    return m_cached_characteristic->getFloat(
+        AbstractCharacteristic::SKID_POST_SKID_ROTATE_FACTOR);
 }  // getSkidPostSkidRotateFactor
 
 // ----------------------------------------------------------------------------
 float KartProperties::getSkidReduceTurnMin() const
 {
-    return m_cached_characteristic->getSkidReduceTurnMin();
+    return m_cached_characteristic->getFloat(
+        AbstractCharacteristic::SKID_REDUCE_TURN_MIN);
 }  // getSkidReduceTurnMin
 
 // ----------------------------------------------------------------------------
 float KartProperties::getSkidReduceTurnMax() const
 {
-    return m_cached_characteristic->getSkidReduceTurnMax();
+    return m_cached_characteristic->getFloat(
+        AbstractCharacteristic::SKID_REDUCE_TURN_MAX);
 }  // getSkidReduceTurnMax
 
 // ----------------------------------------------------------------------------
 bool KartProperties::getSkidEnabled() const
 {
-    return m_cached_characteristic->getSkidEnabled();
+    return m_cached_characteristic->getBool(
+        AbstractCharacteristic::SKID_ENABLED);
 }  // getSkidEnabled
 
 /* <characteristics-end kpgetter> */
 
+
+// ----------------------------------------------------------------------------
+/** Compares reading the characteristics that are used in each time step of
+ *  a race for 32 karts through the combined characteristic (walking the
+ *  base, difficulty, kart type, handicap and kart characteristic), through
+ *  the virtual process() of the cache (as the generic getters do) and from
+ *  the flat table of the cache (as the getters of KartProperties do).
+ */
+void KartProperties::benchmark()
+{
+    if (kart_properties_manager->getNumberOfKarts() == 0)
+    {
+        Log::warn("Benchmark", "No karts loaded, skipping.");
+        return;
+    }
+    const unsigned num_karts = 32;
+    const unsigned num_ticks = 1200;
+    // A selection of float characteristics read per kart and time step
+    const AbstractCharacteristic::CharacteristicType types[] =
+    {
+        AbstractCharacteristic::SUSPENSION_STIFFNESS,
+        AbstractCharacteristic::SUSPENSION_REST,
+        AbstractCharacteristic::SUSPENSION_TRAVEL,
+        AbstractCharacteristic::SUSPENSION_MAX_FORCE,
+        AbstractCharacteristic::STABILITY_DOWNWARD_IMPULSE_FACTOR,
+        AbstractCharacteristic::STABILITY_TRACK_CONNECTION_ACCEL,
+        AbstractCharacteristic::STABILITY_SMOOTH_FLYING_IMPULSE,
+        AbstractCharacteristic::TURN_TIME_RESET_STEER,
+        AbstractCharacteristic::ENGINE_POWER,
+        AbstractCharacteristic::ENGINE_MAX_SPEED,
+        AbstractCharacteristic::ENGINE_BRAKE_FACTOR,
+        AbstractCharacteristic::ENGINE_BRAKE_TIME_INCREASE,
+        AbstractCharacteristic::ENGINE_MAX_SPEED_REVERSE_RATIO,
+        AbstractCharacteristic::MASS,
+        AbstractCharacteristic::LEAN_MAX,
+        AbstractCharacteristic::LEAN_SPEED,
+        AbstractCharacteristic::NITRO_ENGINE_FORCE,
+        AbstractCharacteristic::NITRO_CONSUMPTION,
+        AbstractCharacteristic::NITRO_MAX_SPEED_INCREASE,
+        AbstractCharacteristic::SLIPSTREAM_LENGTH,
+        AbstractCharacteristic::SLIPSTREAM_WIDTH,
+        AbstractCharacteristic::SLIPSTREAM_MIN_SPEED,
+        AbstractCharacteristic::SKID_INCREASE,
+        AbstractCharacteristic::SKID_DECREASE,
+        AbstractCharacteristic::SKID_MAX,
+        AbstractCharacteristic::SKID_MIN_SPEED,
+    };
+    const unsigned num_types = sizeof(types) / sizeof(types[0]);
+
+    uint64_t start = StkTime::getMonoTimeUs();
+    std::vector<KartProperties> karts(num_karts);
+    for (unsigned i = 0; i < num_karts; i++)
+    {
+        const KartProperties* kp = kart_properties_manager->getKartById(
+            i % kart_properties_manager->getNumberOfKarts());
+        karts[i].copyForPlayer(kp, i % 4 == 0 ? PLAYER_DIFFICULTY_HANDICAP
+                                              : PLAYER_DIFFICULTY_NORMAL);
+    }
+    const uint64_t build_us = StkTime::getMonoTimeUs() - start;
+
+    // Sum up all values, so that the reads can't be optimised away
+    float combined_sum = 0.0f, cached_sum = 0.0f, flat_sum = 0.0f;
+    start = StkTime::getMonoTimeUs();
+    for (unsigned t = 0; t < num_ticks; t++)
+    {
+        for (const KartProperties& kp : karts)
+        {
+            for (unsigned i = 0; i < num_types; i++)
+            {
+                float f;
+                bool is_set = false;
+                kp.m_combined_characteristic->process(types[i], &f, &is_set);
+                combined_sum += f;
+            }
+        }
+    }
+    const uint64_t combined_us = StkTime::getMonoTimeUs() - start;
+
+    start = StkTime::getMonoTimeUs();
+    for (unsigned t = 0; t < num_ticks; t++)
+    {
+        for (const KartProperties& kp : karts)
+        {
+            for (unsigned i = 0; i < num_types; i++)
+            {
+                float f;
+                bool is_set = false;
+                kp.m_cached_characteristic->process(types[i], &f, &is_set);
+                cached_sum += f;
+            }
+        }
+    }
+    const uint64_t cached_us = StkTime::getMonoTimeUs() - start;
+
+    start = StkTime::getMonoTimeUs();
+    for (unsigned t = 0; t < num_ticks; t++)
+    {
+        for (const KartProperties& kp : karts)
+        {
+            for (unsigned i = 0; i < num_types; i++)
+                flat_sum += kp.m_cached_characteristic->getFloat(types[i]);
+        }
+    }
+    const uint64_t flat_us = StkTime::getMonoTimeUs() - start;
+
+    Log::info("Benchmark", "%u karts, %u values each: building tables %d us, "
+        "per tick combined %.2f us, cached %.2f us, flat table %.2f us%s.",
+        num_karts, num_types, (int)build_us,
+        (float)combined_us / num_ticks, (float)cached_us / num_ticks,
+        (float)flat_us / num_ticks,
+        combined_sum == cached_sum && cached_sum == flat_sum
+        ? "" : " (values differ!)");
+}   // benchmark
@@ -223,6 +223,7 @@ public:
     void  checkAllSet       (const std::string &filename);
     bool  isInGroup         (const std::string &group) const;
     bool operator<(const KartProperties &other) const;
+    static void benchmark();
 
     // ------------------------------------------------------------------------
     /** Returns the characteristics for this kart. */
@@ -79,6 +79,7 @@ void KartPropertiesManager::addKartSearchDir(const std::string &s)
 void KartPropertiesManager::unloadAllKarts()
 {
     m_karts_properties.clearAndDeleteAll();
+    m_kart_ident_index.clear();
     m_selected_karts.clear();
     m_kart_available.clear();
     m_groups_2_indices.clear();
@@ -97,6 +98,7 @@ void KartPropertiesManager::removeKart(const std::string &ident)
     m_karts_properties.remove(index);
     m_all_kart_dirs.erase(m_all_kart_dirs.begin()+index);
     m_kart_available.erase(m_kart_available.begin()+index);
+    rebuildIdentIndex();
 
     // Remove the just removed kart from the 'group-name to kart property
     // index' mapping. If a group is now empty (i.e. the removed kart was
@@ -148,6 +150,20 @@ void KartPropertiesManager::removeKart(const std::string &ident)
     m_selected_karts.clear();
 }   // removeKart
 
+//-----------------------------------------------------------------------------
+/** Recomputes the index of all kart identifiers, used after a kart was
+ *  removed, which moves all following karts down.
+ */
+void KartPropertiesManager::rebuildIdentIndex()
+{
+    m_kart_ident_index.clear();
+    for (unsigned int i=0; i<m_karts_properties.size(); i++)
+    {
+        m_kart_ident_index.insert(std::make_pair(
+            m_karts_properties[i].getIdent(), (int)i));
+    }
+}   // rebuildIdentIndex
+
 //-----------------------------------------------------------------------------
 /** Loads all kart properties and models.
  */
@@ -181,6 +197,47 @@ void KartPropertiesManager::loadAllKarts(bool loading_icon)
     }   // for i
 }   // loadAllKarts
 
+//-----------------------------------------------------------------------------
+/** Appends the XML files read by loadAllKarts() to the given list, so that
+ *  they can be parsed in advance (see FileManager::preloadXMLTrees()). This
+ *  uses the same directories and file names as loadAllKarts() and
+ *  KartProperties::load().
+ *  \param files On return the kart.xml and materials.xml files of all karts
+ *         are appended.
+ */
+void KartPropertiesManager::getAllKartsXMLFiles(std::vector<std::string> *files) const
+{
+    std::vector<std::string>::const_iterator dir;
+    for(dir = m_kart_search_path.begin(); dir!=m_kart_search_path.end(); dir++)
+    {
+        std::vector<std::string> kart_dirs;
+        if(file_manager->fileExists(*dir + "/kart.xml"))
+        {
+            kart_dirs.push_back(*dir);
+        }
+        else
+        {
+            std::set<std::string> result;
+            file_manager->listFiles(result, *dir);
+            for(std::set<std::string>::const_iterator subdir=result.begin();
+                subdir!=result.end(); subdir++)
+                kart_dirs.push_back(*dir+*subdir);
+        }
+
+        for(unsigned int i=0; i<kart_dirs.size(); i++)
+        {
+            const std::string config_filename = kart_dirs[i] + "/kart.xml";
+            if(!file_manager->fileExists(config_filename))
+                continue;
+            files->push_back(config_filename);
+            const std::string materials_file =
+                StringUtils::getPath(config_filename) + "/materials.xml";
+            if(file_manager->fileExists(materials_file))
+                files->push_back(materials_file);
+        }
+    }   // for dir
+}   // getAllKartsXMLFiles
+
 //-----------------------------------------------------------------------------
 /** Loads the characteristics from the characteristics config file.
  *  \param root The xml node where the characteristics are stored.
@@ -274,6 +331,10 @@ bool KartPropertiesManager::loadKart(const std::string &dir)
 
     m_karts_properties.push_back(kart_properties);
     m_kart_available.push_back(true);
+    // Does not replace an existing entry, the first kart with an
+    // identifier is found
+    m_kart_ident_index.insert(std::make_pair(kart_properties->getIdent(),
+                                    (int)m_karts_properties.size() - 1));
     const std::vector<std::string>& groups=kart_properties->getGroups();
     for(unsigned int g=0; g<groups.size(); g++)
     {
@@ -344,16 +405,16 @@ const AbstractCharacteristic* KartPropertiesManager::getPlayerCharacteristic(con
 }   // getPlayerCharacteristic
 
 //-----------------------------------------------------------------------------
-/** Returns index of the kart properties with the given ident.
+/** Returns index of the kart properties with the given ident. This is
+ *  used for each kart selected in the network lobby and for live joins,
+ *  so it uses a hash map instead of comparing all identifiers.
  *  \return Index of kart (between 0 and number of karts - 1).
  */
 const int KartPropertiesManager::getKartId(const std::string &ident) const
 {
-    for (unsigned int i=0; i<m_karts_properties.size(); i++)
-    {
-        if (m_karts_properties[i].getIdent() == ident)
-            return i;
-    }
+    auto it = m_kart_ident_index.find(ident);
+    if (it != m_kart_ident_index.end())
+        return it->second;
 
     std::ostringstream msg;
     msg << "KartPropertiesManager: Couldn't find kart: '" << ident << "'";
@@ -364,13 +425,10 @@ const int KartPropertiesManager::getKartId(const std::string &ident) const
 const KartProperties* KartPropertiesManager::getKart(
                                                 const std::string &ident) const
 {
-    for (const KartProperties* kp : m_karts_properties)
-    {
-        if (kp->getIdent() == ident)
-            return kp;
-    }
-
-    return NULL;
+    auto it = m_kart_ident_index.find(ident);
+    if (it == m_kart_ident_index.end())
+        return NULL;
+    return m_karts_properties.get(it->second);
 }   // getKart
 
 //-----------------------------------------------------------------------------
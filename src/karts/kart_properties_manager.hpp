@@ -23,6 +23,7 @@
 #include "utils/ptr_vector.hpp"
 #include <map>
 #include <memory>
+#include <unordered_map>
 
 #include "network/remote_kart_info.hpp"
 #include "utils/no_copy.hpp"
@@ -64,11 +65,17 @@ private:
      *  all clients or not. */
     std::vector<bool>        m_kart_available;
 
+    /** Maps the identifier of a kart to its index in m_karts_properties.
+     *  If several karts have the same identifier, the first one is used. */
+    std::unordered_map<std::string, int> m_kart_ident_index;
+
     std::unique_ptr<AbstractCharacteristic>                         m_base_characteristic;
     std::map<std::string, std::unique_ptr<AbstractCharacteristic> > m_difficulty_characteristics;
     std::map<std::string, std::unique_ptr<AbstractCharacteristic> > m_kart_type_characteristics;
     std::map<std::string, std::unique_ptr<AbstractCharacteristic> > m_player_characteristics;
 
+    void                     rebuildIdentIndex();
+
 protected:
 
     typedef PtrVector<KartProperties> KartPropertiesVector;
@@ -89,6 +96,7 @@ public:
     void                     loadCharacteristics    (const XMLNode *root);
     bool                     loadKart               (const std::string &dir);
     void                     loadAllKarts           (bool loading_icon = true);
+    void                     getAllKartsXMLFiles(std::vector<std::string> *files) const;
     void                     unloadAllKarts         ();
     void                     removeKart(const std::string &id);
     const std::vector<int>   getKartsInGroup        (const std::string& g);
@@ -161,6 +161,28 @@ BareNetworkString* KartRewinder::saveState(std::vector<std::string>* ru)
         return nullptr;
 
     ru->push_back(getUniqueIdentity());
+    return saveKartState(/*round_body*/true);
+}   // saveState
+
+// ----------------------------------------------------------------------------
+/** Saves the same state as saveState without rounding the physics values of
+ *  the kart, which is done by client in Kart::update at the same ticks
+ *  anyway.
+ */
+BareNetworkString* KartRewinder::savePredictedState()
+{
+    if (m_eliminated)
+        return nullptr;
+    return saveKartState(/*round_body*/false);
+}   // savePredictedState
+
+// ----------------------------------------------------------------------------
+/** Writes the state of this kart.
+ *  \param round_body If the physics values of the kart are rounded to the
+ *         saved values.
+ */
+BareNetworkString* KartRewinder::saveKartState(bool round_body)
+{
     const int MEMSIZE = 17*sizeof(float) + 9+3;
 
     BareNetworkString *buffer = new BareNetworkString(MEMSIZE);
@@ -222,8 +244,13 @@ BareNetworkString* KartRewinder::saveState(std::vector<std::string>* ru)
     }
     else
     {
-        CompressNetworkBody::compress(
-            m_body.get(), m_motion_state.get(), buffer);
+        if (round_body)
+        {
+            CompressNetworkBody::compress(
+                m_body.get(), m_motion_state.get(), buffer);
+        }
+        else
+            CompressNetworkBody::save(m_body.get(), buffer);
 
         if (m_vehicle->getTimedRotationTicks() > 0)
         {
@@ -257,7 +284,7 @@ BareNetworkString* KartRewinder::saveState(std::vector<std::string>* ru)
     m_skidding->saveState(buffer);
 
     return buffer;
-}   // saveState
+}   // saveKartState
 
 // ----------------------------------------------------------------------------
 /** Actually rewind to the specified state. 
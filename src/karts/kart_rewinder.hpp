@@ -32,6 +32,8 @@ private:
     float m_prev_steering, m_steering_smoothing_dt, m_steering_smoothing_time;
 
     bool m_has_server_state;
+
+    BareNetworkString* saveKartState(bool round_body);
 public:
     KartRewinder(const std::string& ident, unsigned int world_kart_id,
                  int position, const btTransform& init_transform,
@@ -42,6 +44,7 @@ public:
     virtual void computeError() OVERRIDE;
     virtual BareNetworkString* saveState(std::vector<std::string>* ru)
         OVERRIDE;
+    virtual BareNetworkString* savePredictedState() OVERRIDE;
     void reset() OVERRIDE;
     virtual void restoreState(BareNetworkString *p, int count) OVERRIDE;
     virtual void rewindToEvent(BareNetworkString *p) OVERRIDE {}
@@ -167,6 +167,9 @@
 #include <sstream>
 #include <algorithm>
 #include <limits>
+#include <thread>
+#include <utility>
+#include <vector>
 
 #include <IEventReceiver.h>
 
@@ -201,7 +204,9 @@
 #include "input/keyboard_device.hpp"
 #include "input/wiimote_manager.hpp"
 #include "io/file_manager.hpp"
+#include "io/xml_cache.hpp"
 #include "items/attachment_manager.hpp"
+#include "items/item_grid.hpp"
 #include "items/item_manager.hpp"
 #include "items/network_item_manager.hpp"
 #include "items/powerup_manager.hpp"
@@ -210,16 +215,22 @@
 #include "karts/controller/ai_base_controller.hpp"
 #include "karts/controller/network_ai_controller.hpp"
 #include "karts/kart_model.hpp"
+#include "karts/kart_grid.hpp"
 #include "karts/kart_properties.hpp"
 #include "karts/kart_properties_manager.hpp"
 #include "modes/cutscene_world.hpp"
 #include "modes/demo_world.hpp"
+#include "modes/linear_world.hpp"
 #include "modes/profile_world.hpp"
 #include "network/protocols/connect_to_server.hpp"
 #include "network/protocols/client_lobby.hpp"
 #include "network/protocols/server_lobby.hpp"
+#include "network/delta_network_state.hpp"
+#include "network/event_queue.hpp"
 #include "network/network_config.hpp"
 #include "network/network_string.hpp"
+#include "network/network_waiter.hpp"
+#include "network/rewind_benchmark.hpp"
 #include "network/rewind_manager.hpp"
 #include "network/rewind_queue.hpp"
 #include "network/server.hpp"
@@ -229,6 +240,9 @@
 #include "network/stk_peer.hpp"
 #include "online/profile_manager.hpp"
 #include "online/request_manager.hpp"
+#include "physics/btKartRaycast.hpp"
+#include "physics/stk_dynamics_world.hpp"
+#include "physics/triangle_mesh.hpp"
 #include "race/grand_prix_manager.hpp"
 #include "race/highscore_manager.hpp"
 #include "race/history.hpp"
@@ -254,11 +268,13 @@
 #include "utils/profiler.hpp"
 #include "utils/separate_process.hpp"
 #include "utils/string_utils.hpp"
+#include "utils/time.hpp"
 #include "utils/translation.hpp"
 
 static void cleanSuperTuxKart();
 static void cleanUserConfig();
 void runUnitTests();
+void runBenchmarks();
 
 // ============================================================================
 //                        gamepad visualisation screen
@@ -590,6 +606,16 @@ void cmdLineHelp()
     "       --unlock-all       Permanently unlock all karts and tracks for testing.\n"
     "       --no-unlock-all    Disable unlock-all (i.e. base unlocking on player achievement).\n"
     "       --no-graphics      Do not display the actual race.\n"
+    "       --rewind-benchmark Replay history.dat and rewind to each state, which\n"
+    "                          is received after a latency. Use with --no-graphics.\n"
+    "       --rewind-latency=n Latency of states in rewind benchmark in ms (default 100).\n"
+    "       --rewind-loss=n    Percentage of states lost in rewind benchmark.\n"
+    "       --no-raycast-packets Cast the suspension rays of a kart one by one.\n"
+    "       --check-raycasts   Compare each suspension raycast of a packet with a\n"
+    "                          single raycast.\n"
+    "       --startup-profile  Print the time needed by each phase of the startup.\n"
+    "       --no-xml-cache     Always read XML files instead of using the cache of\n"
+    "                          parsed XML files.\n"
     "       --sp-shader-debug  Enables debug in sp shader, it will print all unavailable uniforms.\n"
     "       --demo-mode=t      Enables demo mode after t seconds of idle time in "
                                "main menu.\n"
@@ -771,6 +797,11 @@ int handleCmdLinePreliminary()
         UserConfigParams::m_verbosity |= UserConfigParams::LOG_ALL;
     if(CommandLine::has("--online"))
         History::m_online_history_replay = true;
+    // Needed before initRest(), which is already profiled
+    if(CommandLine::has("--startup-profile"))
+        UserConfigParams::m_startup_profile = true;
+    if(CommandLine::has("--no-xml-cache"))
+        UserConfigParams::m_xml_cache = false;
 #if !(defined(SERVER_ONLY) || defined(ANDROID))
     if(CommandLine::has("--apitrace"))
     {
@@ -960,6 +991,12 @@ int handleCmdLine(bool has_server_config, bool has_parent_process)
 
     if (CommandLine::has("--unit-testing"))
         UserConfigParams::m_unit_testing = true;
+    if (CommandLine::has("--benchmark"))
+        UserConfigParams::m_benchmark = true;
+    if (CommandLine::has("--no-raycast-packets"))
+        UserConfigParams::m_raycast_packets = false;
+    if (CommandLine::has("--check-raycasts"))
+        UserConfigParams::m_check_raycasts = true;
     if (CommandLine::has("--gamepad-debug"))
         UserConfigParams::m_gamepad_debug=true;
     if (CommandLine::has("--keyboard-debug"))
@@ -1660,6 +1697,21 @@ int handleCmdLine(bool has_server_config, bool has_parent_process)
             UserConfigParams::m_no_start_screen = true;
     }   // --history
 
+    if (CommandLine::has("--rewind-benchmark"))
+    {
+        int latency = 100, loss = 0;
+        CommandLine::has("--rewind-latency", &latency);
+        CommandLine::has("--rewind-loss", &loss);
+        if (History::m_online_history_replay)
+        {
+            Log::error("main", "Rewind benchmark needs a local history.");
+            return 0;
+        }
+        history->setReplayHistory(true);
+        UserConfigParams::m_no_start_screen = true;
+        RewindBenchmark::create(latency, loss);
+    }   // --rewind-benchmark
+
     // Demo mode
     if(CommandLine::has("--demo-mode", &s))
     {
@@ -1755,9 +1807,98 @@ void clearGlobalVariables()
     GUIEngine::resetGlobalVariables();
 }   // clearGlobalVariables
 
+//=============================================================================
+/** End time of the last startup phase, and the name and wall time of all
+ *  startup phases so far, printed with --startup-profile. */
+static uint64_t g_startup_phase_end = 0;
+static std::vector<std::pair<std::string, uint64_t> > g_startup_phases;
+
+// ----------------------------------------------------------------------------
+/** Records the wall time since the end of the previous startup phase (or
+ *  since the program was started) as the time of the given phase.
+ *  \param name Name of the phase that was just finished.
+ */
+static void startupPhaseDone(const std::string &name)
+{
+    const uint64_t now = StkTime::getMonoTimeUs();
+    g_startup_phases.emplace_back(name, now - g_startup_phase_end);
+    g_startup_phase_end = now;
+}   // startupPhaseDone
+
+// ----------------------------------------------------------------------------
+/** Prints the time of all startup phases if --startup-profile was given.
+ */
+static void printStartupProfile()
+{
+    if (!UserConfigParams::m_startup_profile)
+        return;
+    uint64_t total = 0;
+    for (unsigned int i = 0; i < g_startup_phases.size(); i++)
+    {
+        Log::info("StartupProfile", "%-28s %9.2f ms",
+                  g_startup_phases[i].first.c_str(),
+                  g_startup_phases[i].second / 1000.0f);
+        total += g_startup_phases[i].second;
+    }
+    Log::info("StartupProfile", "%-28s %9.2f ms", "Total", total / 1000.0f);
+}   // printStartupProfile
+
+// ----------------------------------------------------------------------------
+/** Returns the XML files of all tracks and karts and the shared materials,
+ *  which are read at startup.
+ *  \param files On return contains the names of the files.
+ */
+static void getStartupXMLFiles(std::vector<std::string> *files)
+{
+    // See MaterialManager::loadMaterial()
+    const std::string materials =
+        file_manager->getAssetChecked(FileManager::TEXTURE, "materials.xml");
+    if (!materials.empty())
+        files->push_back(materials);
+    const std::string deprecated =
+        file_manager->getAssetChecked(FileManager::TEXTURE,
+                                      "deprecated/materials.xml");
+    if (!deprecated.empty())
+        files->push_back(deprecated);
+    const std::string model_materials =
+        file_manager->getAsset(FileManager::MODEL, "materials.xml");
+    if (file_manager->fileExists(model_materials))
+        files->push_back(model_materials);
+
+    track_manager->getTrackListXMLFiles(files);
+    kart_properties_manager->getAllKartsXMLFiles(files);
+}   // getStartupXMLFiles
+
+// ----------------------------------------------------------------------------
+/** Parses the XML files of all tracks and karts and the shared materials in
+ *  parallel, before the managers read them one after another on the main
+ *  thread (see FileManager::preloadXMLTrees()). Everything which depends on
+ *  the graphics driver (textures, meshes) is still loaded by the managers.
+ *  The trees which were not used are freed at the end of the startup.
+ */
+static void preloadXMLFiles()
+{
+    std::vector<std::string> files;
+    getStartupXMLFiles(&files);
+
+    // Parsing is mostly limited by file access, more than a few threads
+    // don't help
+    unsigned int num_threads = std::min(std::thread::hardware_concurrency(),
+                                        8u);
+    if (num_threads > 0)
+        num_threads--;
+    file_manager->preloadXMLTrees(files, num_threads);
+    if (UserConfigParams::m_startup_profile)
+    {
+        Log::info("StartupProfile", "Parsed %d XML files with %u threads.",
+                  (int)files.size(), num_threads + 1);
+    }
+}   // preloadXMLFiles
+
 //=============================================================================
 void initRest()
 {
+    startupPhaseDone("STK and server config");
     SP::setMaxTextureSize();
     irr_driver = new IrrDriver();
 
@@ -1770,6 +1911,7 @@ void initRest()
 
     // Now create the actual non-null device in the irrlicht driver
     irr_driver->initDevice();
+    startupPhaseDone("Graphics device");
 
     // Init GUI
     IrrlichtDevice* device = irr_driver->getDevice();
@@ -1788,6 +1930,7 @@ void initRest()
     font_manager->loadFonts();
     delete tmp_skin;
     GUIEngine::setSkin(NULL);
+    startupPhaseDone("Fonts");
 
     GUIEngine::init(device, driver, StateManager::get());
 
@@ -1851,9 +1994,14 @@ void initRest()
         XMLNode characteristicsNode(file_manager->getAsset("kart_characteristics.xml"));
         kart_properties_manager->loadCharacteristics(&characteristicsNode);
     }
+    startupPhaseDone("GUI and managers");
+
+    preloadXMLFiles();
+    startupPhaseDone("XML preload");
 
     track_manager->loadTrackList();
     music_manager->addMusicToTracks();
+    startupPhaseDone("Tracks");
 
     GUIEngine::addLoadingIcon(irr_driver->getTexture(FileManager::GUI_ICON,
                                                      "notes.png"      ) );
@@ -2021,6 +2169,16 @@ int main(int argc, char *argv[])
 
         handleCmdLinePreliminary();
 
+        startupPhaseDone("Config and file manager");
+        if (UserConfigParams::m_xml_cache)
+        {
+            xml_cache = new XMLCache(file_manager->getCachedXMLDir() +
+                                     "xml.cache",
+                                     file_manager->getUserConfigDir());
+            xml_cache->load();
+        }
+        startupPhaseDone("XML cache");
+
         // ServerConfig will use stk_config for server version testing
         stk_config->load(file_manager->getAsset("stk_config.xml"));
         bool no_graphics = !CommandLine::has("--graphical-server");
@@ -2085,7 +2243,9 @@ int main(int argc, char *argv[])
         }
         else
             main_loop = new MainLoop(0/*parent_pid*/);
+        startupPhaseDone("Grand prix and race setup");
         material_manager->loadMaterial();
+        startupPhaseDone("Materials");
 
         // Preload the explosion effects (explode.png)
         ParticleKindManager::get()->getParticles("explosion.xml");
@@ -2098,6 +2258,7 @@ int main(int argc, char *argv[])
         kart_properties_manager -> loadAllKarts    ();
         handleXmasMode();
         handleEasterEarMode();
+        startupPhaseDone("Karts");
 
         // Needs the kart and track directories to load potential challenges
         // in those dirs, so it can only be created after reading tracks
@@ -2109,6 +2270,7 @@ int main(int argc, char *argv[])
         // initialise the game slots of all players and the AchievementsManager
         // to initialise the AchievementsStatus, so it is done only now.
         PlayerManager::get()->initRemainingData();
+        startupPhaseDone("Players and achievements");
 
         GUIEngine::addLoadingIcon( irr_driver->getTexture(FileManager::GUI_ICON,
                                                           "gui_lock.png"  ) );
@@ -2138,6 +2300,14 @@ int main(int argc, char *argv[])
 
         attachment_manager->loadModels();
         file_manager->popTextureSearchPath();
+        file_manager->clearPreloadedXMLTrees();
+        startupPhaseDone("Items and attachments");
+        // Write the startup files now, in case that STK is not shut down
+        // properly (e.g. a server which is killed)
+        if (xml_cache)
+            xml_cache->save();
+        startupPhaseDone("Saving XML cache");
+        printStartupProfile();
 
         GUIEngine::addLoadingIcon( irr_driver->getTexture(FileManager::GUI_ICON,
                                                           "banana.png")    );
@@ -2179,6 +2349,12 @@ int main(int argc, char *argv[])
             exit(0);
         }
 
+        if (UserConfigParams::m_benchmark)
+        {
+            runBenchmarks();
+            exit(0);
+        }
+
 #ifndef SERVER_ONLY
         if (!ProfileWorld::isNoGraphics())
         {
@@ -2333,7 +2509,14 @@ int main(int argc, char *argv[])
                 race_manager->setupPlayerKartInfo();
                 race_manager->startNew(false);
                 main_loop->run();
-                // The run() function will only return if the user aborts.
+                // The run() function will only return if the user aborts,
+                // or the rewind benchmark is finished.
+                if (RewindBenchmark::isEnabled())
+                {
+                    RewindBenchmark::get()->report();
+                    Log::flushBuffers();
+                    exit(0);
+                }
                 Log::flushBuffers();
                 exit(-3);
             }   // if !online
@@ -2458,6 +2641,7 @@ static void cleanSuperTuxKart()
     if(track_manager)           delete track_manager;
     if(material_manager)        delete material_manager;
     if(history)                 delete history;
+    RewindBenchmark::destroy();
     ReplayPlay::destroy();
     ReplayRecorder::destroy();
     delete ParticleKindManager::get();
@@ -2536,6 +2720,12 @@ static void cleanUserConfig()
 {
     if(stk_config)              delete stk_config;
     if(translations)            delete translations;
+    if (xml_cache)
+    {
+        xml_cache->save();
+        delete xml_cache;
+        xml_cache = NULL;
+    }
     if (user_config)
     {
         // In case that abort is triggered before user_config exists
@@ -2609,7 +2799,62 @@ void runUnitTests()
     Log::info("UnitTest", "RewindQueue");
     RewindQueue::unitTesting();
 
+    Log::info("UnitTest", "DeltaNetworkState");
+    DeltaNetworkState::unitTesting();
+
+    Log::info("UnitTest", "EventQueue");
+    EventQueue::unitTesting();
+
+    Log::info("UnitTest", "LinearWorld race positions");
+    LinearWorld::unitTesting();
+
     Log::info("UnitTest", "=====================");
     Log::info("UnitTest", "Testing successful   ");
     Log::info("UnitTest", "=====================");
 }   // runUnitTests
+
+//=============================================================================
+/** Runs the benchmarks of performance critical code and prints the timings,
+ *  enabled with --benchmark.
+ */
+void runBenchmarks()
+{
+    Log::info("Benchmark", "Starting benchmarks");
+    Log::info("Benchmark", "=====================");
+    Log::info("Benchmark", "STKHost broadcast encryption");
+    STKHost::benchmark();
+    Log::info("Benchmark", "Delta network states");
+    DeltaNetworkState::benchmark();
+    Log::info("Benchmark", "RewindQueue");
+    RewindQueue::benchmark();
+    Log::info("Benchmark", "EventQueue");
+    EventQueue::benchmark();
+    Log::info("Benchmark", "NetworkWaiter");
+    NetworkWaiter::benchmark();
+    Log::info("Benchmark", "Graph sector search");
+    Graph::benchmark();
+    Log::info("Benchmark", "Item hit detection");
+    ItemGrid::benchmark();
+    Log::info("Benchmark", "Kart characteristics");
+    KartProperties::benchmark();
+    Log::info("Benchmark", "Kart proximity");
+    KartGrid::benchmark();
+    Log::info("Benchmark", "Suspension raycasts");
+    btKartRaycaster::benchmark();
+    Log::info("Benchmark", "Track bvh cache");
+    TriangleMesh::benchmark();
+    Log::info("Benchmark", "Physics islands");
+    STKDynamicsWorld::benchmark();
+    Log::info("Benchmark", "XML cache");
+    std::vector<std::string> xml_files;
+    getStartupXMLFiles(&xml_files);
+    XMLCache::benchmark(xml_files);
+    Log::info("Benchmark", "Material lookup");
+    MaterialManager::benchmark();
+    Log::info("Benchmark", "Track physics loading");
+    Track::benchmark();
+
+    Log::info("Benchmark", "=====================");
+    Log::info("Benchmark", "Benchmarks finished  ");
+    Log::info("Benchmark", "=====================");
+}   // runBenchmarks
@@ -38,6 +38,7 @@
 #include "network/protocols/game_protocol.hpp"
 #include "network/protocol_manager.hpp"
 #include "network/race_event_manager.hpp"
+#include "network/rewind_benchmark.hpp"
 #include "network/rewind_manager.hpp"
 #include "network/stk_host.hpp"
 #include "online/request_manager.hpp"
@@ -142,8 +143,10 @@ float MainLoop::getLimitedDt()
 #endif
     float dt = 0;
 
-    // In profile mode without graphics, run with a fixed dt of 1/60
-    if ((ProfileWorld::isProfileMode() && ProfileWorld::isNoGraphics()) ||
+    // In profile mode or rewind benchmark without graphics, run with a
+    // fixed dt of 1/60
+    if (((ProfileWorld::isProfileMode() || RewindBenchmark::isEnabled()) &&
+         ProfileWorld::isNoGraphics()) ||
         UserConfigParams::m_arena_ai_stats)
     {
         return 1.0f/60.0f;
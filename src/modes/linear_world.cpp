@@ -50,8 +50,10 @@
 #include "utils/string_utils.hpp"
 #include "utils/translation.hpp"
 
+#include <algorithm>
 #include <climits>
 #include <iostream>
+#include <random>
 
 //-----------------------------------------------------------------------------
 /** Constructs the linear world. Note that here no functions can be called
@@ -843,9 +845,12 @@ btTransform LinearWorld::getRescueTransform(unsigned int index) const
 }   // getRescueTransform
 
 //-----------------------------------------------------------------------------
-/** Find the position (rank) of every kart. ATM it uses a stable O(n^2)
- *  algorithm by counting for each kart how many other karts are ahead of
- *  it.
+/** Find the position (rank) of every kart. A racing kart is behind all
+ *  karts that have finished the race, and behind all racing karts that
+ *  have covered a larger overall distance (or the same distance, but
+ *  started ahead). The karts are kept sorted in this order in
+ *  m_race_order, which only needs to be repaired in each time step (see
+ *  sortRaceOrder()), so this is O(n) as long as no positions change.
  */
 void LinearWorld::updateRacePosition()
 {
@@ -857,8 +862,31 @@ void LinearWorld::updateRacePosition()
     bool rank_changed = false;
 #endif
 
-    // NOTE: if you do any changes to this loop, the next loop (see
-    // DEBUG_KART_RANK below) needs to have the same changes applied
+    std::vector<RaceOrderKey> keys(kart_amount);
+    for (unsigned int i=0; i<kart_amount; i++)
+    {
+        AbstractKart* kart = m_karts[i].get();
+        keys[i].m_state            = kart->isEliminated()    ? 2
+                                   : kart->hasFinishedRace() ? 0 : 1;
+        keys[i].m_distance         = m_kart_info[i].m_overall_distance;
+        keys[i].m_initial_position = kart->getInitialPosition();
+    }
+    if (m_race_order.size() != kart_amount)
+    {
+        m_race_order.resize(kart_amount);
+        for (unsigned int i=0; i<kart_amount; i++)
+            m_race_order[i] = i;
+    }
+    sortRaceOrder(keys, &m_race_order);
+
+    // All karts that have finished the race are at the start of the
+    // order, so the position of a racing kart is its index + 1.
+    std::vector<int> position(kart_amount);
+    for (unsigned int i=0; i<kart_amount; i++)
+        position[m_race_order[i]] = i + 1;
+
+    // NOTE: if you do any changes to the order, the debug loop below (see
+    // DEBUG_KART_RANK) needs to have the same changes applied
     // so that debug output is still correct!!!!!!!!!!!
     for (unsigned int i=0; i<kart_amount; i++)
     {
@@ -877,33 +905,7 @@ void LinearWorld::updateRacePosition()
         }
         KartInfo& kart_info = m_kart_info[i];
 
-        int p = 1 ;
-
-        const unsigned int my_id = kart->getWorldKartId();
-        const float my_distance  = m_kart_info[my_id].m_overall_distance;
-
-        // Count karts ahead of the current kart, i.e. kart that are
-        // already finished or have covered a larger overall distance.
-        for (unsigned int j = 0 ; j < kart_amount ; j++)
-        {
-            // don't compare a kart with itself and ignore eliminated karts
-            if(j == my_id || m_karts[j]->isEliminated())
-                continue;
-
-            // If the other kart has:
-            // - finished the race (but this kart hasn't)
-            // - or is ahead
-            // - or has the same distance (very unlikely) but started earlier
-            // it is ahead --> increase position
-            if((!kart->hasFinishedRace() && m_karts[j]->hasFinishedRace()) ||
-                m_kart_info[j].m_overall_distance > my_distance            ||
-               (m_kart_info[j].m_overall_distance == my_distance &&
-                m_karts[j]->getInitialPosition()<kart->getInitialPosition() ) )
-            {
-                p++;
-            }
-
-        } //next kart
+        const int p = position[i];
 
 #ifndef DEBUG
         setKartPosition(i, p);
@@ -1023,6 +1025,127 @@ void LinearWorld::updateRacePosition()
     endSetKartPositions();
 }   // updateRacePosition
 
+//-----------------------------------------------------------------------------
+/** Sorts the karts by race position (see updateRacePosition()) with an
+ *  insertion sort, which is O(n) for an order that is already sorted, and
+ *  only needs a few more steps for each kart overtaking another one.
+ *  \param keys The data deciding the race position for each kart.
+ *  \param order The world kart ids in the order of the last call, on
+ *         return sorted by race position.
+ */
+void LinearWorld::sortRaceOrder(const std::vector<RaceOrderKey>& keys,
+                                std::vector<unsigned int>* order)
+{
+    // Returns true if kart a is ahead of kart b.
+    auto is_ahead = [&keys](unsigned int a, unsigned int b)
+    {
+        const RaceOrderKey& ka = keys[a];
+        const RaceOrderKey& kb = keys[b];
+        if (ka.m_state != kb.m_state)
+            return ka.m_state < kb.m_state;
+        // Only the order of racing karts matters, the others keep their
+        // position, so just order them by start position
+        if (ka.m_state == 1 && ka.m_distance != kb.m_distance)
+            return ka.m_distance > kb.m_distance;
+        return ka.m_initial_position < kb.m_initial_position;
+    };
+
+    std::vector<unsigned int>& o = *order;
+    for (unsigned int i = 1; i < o.size(); i++)
+    {
+        const unsigned int kart_id = o[i];
+        unsigned int j = i;
+        while (j > 0 && is_ahead(kart_id, o[j - 1]))
+        {
+            o[j] = o[j - 1];
+            j--;
+        }
+        o[j] = kart_id;
+    }
+}   // sortRaceOrder
+
+//-----------------------------------------------------------------------------
+/** Simulates random races (overtaking, karts with the same distance,
+ *  finishing and eliminated karts) and tests that the incrementally sorted
+ *  race order gives the same position for each racing kart as counting the
+ *  karts ahead of it (the algorithm used before).
+ */
+void LinearWorld::unitTesting()
+{
+    std::mt19937 random(42);
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+    for (unsigned int race = 0; race < 200; race++)
+    {
+        const unsigned int kart_amount = 1 + random() % 64;
+        std::vector<RaceOrderKey> keys(kart_amount);
+        std::vector<int> start(kart_amount);
+        for (unsigned int i = 0; i < kart_amount; i++)
+            start[i] = i + 1;
+        std::shuffle(start.begin(), start.end(), random);
+        for (unsigned int i = 0; i < kart_amount; i++)
+        {
+            keys[i].m_state            = 1;
+            keys[i].m_distance         = -2.0f * start[i];
+            keys[i].m_initial_position = start[i];
+        }
+        std::vector<unsigned int> order(kart_amount);
+        for (unsigned int i = 0; i < kart_amount; i++)
+            order[i] = i;
+
+        for (unsigned int tick = 0; tick < 1000; tick++)
+        {
+            for (unsigned int i = 0; i < kart_amount; i++)
+            {
+                RaceOrderKey& key = keys[i];
+                if (key.m_state != 1)
+                    continue;
+                // Drive with some random speed, a few karts are rescued
+                // and drive backwards, some take the same distance as
+                // another kart.
+                const float r = unit(random);
+                if (r < 0.01f)
+                    key.m_distance -= 20.0f * unit(random);
+                else if (r < 0.02f)
+                    key.m_distance = keys[random() % kart_amount].m_distance;
+                else
+                    key.m_distance += 0.5f + unit(random);
+                if (r > 0.999f)
+                    key.m_state = 0;
+                else if (r > 0.998f)
+                    key.m_state = 2;
+            }
+            sortRaceOrder(keys, &order);
+
+            for (unsigned int k = 0; k < kart_amount; k++)
+            {
+                const unsigned int i = order[k];
+                if (keys[i].m_state != 1)
+                    continue;
+                int p = 1;
+                for (unsigned int j = 0; j < kart_amount; j++)
+                {
+                    if (j == i || keys[j].m_state == 2)
+                        continue;
+                    if (keys[j].m_state == 0                      ||
+                        keys[j].m_distance > keys[i].m_distance   ||
+                        (keys[j].m_distance == keys[i].m_distance &&
+                         keys[j].m_initial_position <
+                         keys[i].m_initial_position                 ))
+                        p++;
+                }
+                if (p != (int)k + 1)
+                {
+                    Log::error("LinearWorld", "Race %u tick %u: kart %u has "
+                               "position %u instead of %d.", race, tick, i,
+                               k + 1, p);
+                    assert(false);
+                    return;
+                }
+            }
+        }   // for tick
+    }   // for race
+}   // unitTesting
+
 //-----------------------------------------------------------------------------
 /** Checks if a kart is going in the wrong direction. This is done only for
  *  player karts to display a message to the player.
@@ -71,6 +71,28 @@ private:
     /* if set then the game will auto end after this time for networking */
     float       m_finish_timeout;
 
+    /** The data that determines the race position of a kart. */
+    struct RaceOrderKey
+    {
+        /** 0 if the kart has finished the race, 1 if it is still racing,
+         *  2 if it is eliminated. */
+        int   m_state;
+        /** The overall distance of the kart. */
+        float m_distance;
+        /** The start position, which decides between the same distance. */
+        int   m_initial_position;
+    };   // RaceOrderKey
+
+    /** The world kart ids sorted by race position: first the karts that
+     *  have finished the race, then the racing karts by overall distance,
+     *  then the eliminated karts. Since the positions rarely change between
+     *  two time steps, this is kept from the last call and only repaired
+     *  in updateRacePosition(). */
+    std::vector<unsigned int> m_race_order;
+
+    static void sortRaceOrder(const std::vector<RaceOrderKey>& keys,
+                              std::vector<unsigned int>* order);
+
     /** This calculate the time difference between the second kart in the race
      *  (there must be at least two) and the first kart in the race
      *  (who must be a ghost).
@@ -149,6 +171,7 @@ public:
                                             bool account_for_checklines) const;
     void          updateTrackSectors();
     void          updateRacePosition();
+    static void   unitTesting();
     float         getDistanceToCenterForKart(const int kart_id) const;
     float         getEstimatedFinishTime(const int kart_id) const;
     int           getLapForKart(const int kart_id) const;
@@ -55,6 +55,7 @@
 #include "modes/profile_world.hpp"
 #include "network/protocols/client_lobby.hpp"
 #include "network/network_config.hpp"
+#include "network/rewind_benchmark.hpp"
 #include "network/rewind_manager.hpp"
 #include "physics/btKart.hpp"
 #include "physics/physics.hpp"
@@ -80,12 +81,14 @@
 #include "utils/profiler.hpp"
 #include "utils/translation.hpp"
 #include "utils/string_utils.hpp"
+#include "utils/thread_pool.hpp"
 
 #include <algorithm>
 #include <assert.h>
 #include <ctime>
 #include <sstream>
 #include <stdexcept>
+#include <thread>
 
 
 World* World::m_world = NULL;
@@ -126,7 +129,8 @@ World* World::m_world = NULL;
  */
 World::World() : WorldStatus()
 {
-    RewindManager::setEnable(NetworkConfig::get()->isNetworking());
+    RewindManager::setEnable(NetworkConfig::get()->isNetworking() ||
+                             RewindBenchmark::isEnabled());
 #ifdef DEBUG
     m_magic_number = 0xB01D6543;
 #endif
@@ -142,6 +146,16 @@ World::World() : WorldStatus()
 
     m_stop_music_when_dialog_open = true;
 
+    int ai_threads = UserConfigParams::m_ai_threads;
+    if (ai_threads < 0)
+    {
+        ai_threads = std::min((int)std::thread::hardware_concurrency(), 4)
+                   - 1;
+    }
+    // The karts of a server are never driven by a local AI
+    if (ai_threads > 0 && !NetworkConfig::get()->isServer())
+        m_ai_pool.reset(new ThreadPool(ai_threads, "KartAI"));
+
     WorldStatus::setClockMode(CLOCK_CHRONO);
 
 }   // World
@@ -1107,16 +1121,47 @@ void World::update(int ticks)
 
     PROFILER_PUSH_CPU_MARKER("World::update (Kart::upate)", 0x40, 0x7F, 0x00);
 
+    // Store the positions of all karts (after physics and any rewind), so
+    // that the AI and slipstreaming only need to test the karts close by
+    m_kart_grid.build(m_karts);
+
+    // First let the AI controllers compute their decisions from the state
+    // of the world at the start of this time step. Each controller only
+    // changes its own state there, so this can be done in parallel, and
+    // the result is the same for any number of threads.
+    const int kart_amount = (int)m_karts.size();
+    std::vector<Controller*> controllers;
+    std::vector<bool> update_kart(kart_amount);
+    for (int i = 0 ; i < kart_amount; ++i)
+    {
+        Controller* controller = m_karts[i]->getController();
+        SpareTireAI* sta = dynamic_cast<SpareTireAI*>(controller);
+        update_kart[i] = !m_karts[i]->isEliminated() ||
+                         (sta && sta->isMoving());
+        if (update_kart[i] && controller->hasPrepareUpdate())
+            controllers.push_back(controller);
+    }
+    if (m_ai_pool && controllers.size() > 1)
+    {
+        m_ai_pool->parallelFor((unsigned)controllers.size(),
+            [&controllers, ticks](unsigned i)
+            {
+                controllers[i]->prepareUpdate(ticks);
+            });
+    }
+    else
+    {
+        for (Controller* controller : controllers)
+            controller->prepareUpdate(ticks);
+    }
+
     // Update all the karts. This in turn will also update the controller,
     // which causes all AI steering commands set. So in the following 
     // physics update the new steering is taken into account.
-    const int kart_amount = (int)m_karts.size();
     for (int i = 0 ; i < kart_amount; ++i)
     {
-        SpareTireAI* sta =
-            dynamic_cast<SpareTireAI*>(m_karts[i]->getController());
         // Update all karts that are not eliminated
-        if(!m_karts[i]->isEliminated() || (sta && sta->isMoving()))
+        if (update_kart[i])
             m_karts[i]->update(ticks);
         if (isStartPhase())
             m_karts[i]->makeKartRest();
@@ -32,6 +32,7 @@
 #include <stdexcept>
 
 #include "graphics/weather.hpp"
+#include "karts/kart_grid.hpp"
 #include "modes/world_status.hpp"
 #include "race/highscores.hpp"
 #include "states_screens/race_gui_base.hpp"
@@ -47,6 +48,7 @@ class Controller;
 class ItemState;
 class PhysicalObject;
 class STKPeer;
+class ThreadPool;
 
 namespace Scripting
 {
@@ -113,6 +115,14 @@ protected:
     KartList                  m_karts;
     RandomGenerator           m_random;
 
+    /** Used to call Controller::prepareUpdate() of the karts in parallel,
+     *  NULL if no extra thread is used. */
+    std::unique_ptr<ThreadPool> m_ai_pool;
+
+    /** The positions of all karts at the start of the current time step,
+     *  used to find the karts close to a point. */
+    KartGrid m_kart_grid;
+
     AbstractKart* m_fastest_kart;
     /** Number of eliminated karts. */
     int         m_eliminated_karts;
@@ -320,6 +330,10 @@ public:
     /** Returns all karts. */
     const KartList & getKarts() const { return m_karts; }
     // ------------------------------------------------------------------------
+    /** Returns the grid of the kart positions at the start of this time
+     *  step. */
+    const KartGrid& getKartGrid() const { return m_kart_grid; }
+    // ------------------------------------------------------------------------
     /** Returns the number of currently active (i.e.non-elikminated) karts. */
     unsigned int    getCurrentNumKarts() const { return (int)m_karts.size() -
                                                          m_eliminated_karts; }
@@ -84,6 +84,22 @@ namespace CompressNetworkBody
             .addUInt16(avx).addUInt16(avy).addUInt16(avz);
     }   // compress
     // ------------------------------------------------------------------------
+    /** Writes the same data as compress to bns, without changing the bullet
+     *  object. Used by client to predict the state sent by server.
+     */
+    inline void save(const btRigidBody* body, BareNetworkString* bns)
+    {
+        const btTransform& trans = body->getWorldTransform();
+        bns->addFloat(trans.getOrigin().x()).addFloat(trans.getOrigin().y())
+            .addFloat(trans.getOrigin().z())
+            .addUInt32(compressQuaternion(trans.getRotation()));
+        const btVector3& lv = body->getLinearVelocity();
+        const btVector3& av = body->getAngularVelocity();
+        bns->addUInt16(toFloat16(lv.x())).addUInt16(toFloat16(lv.y()))
+            .addUInt16(toFloat16(lv.z())).addUInt16(toFloat16(av.x()))
+            .addUInt16(toFloat16(av.y())).addUInt16(toFloat16(av.z()));
+    }   // save
+    // ------------------------------------------------------------------------
     /* Called during rewind when restoring data from game state. */
     inline void decompress(const BareNetworkString* bns,
                            btRigidBody* body, btMotionState* ms)
@@ -0,0 +1,379 @@
+//
+//  SuperTuxKart - a fun racing game with go-kart
+//  Copyright (C) 2019 SuperTuxKart-Team
+//
+//  This program is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU General Public License
+//  as published by the Free Software Foundation; either version 3
+//  of the License, or (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+
+#ifdef ENABLE_SQLITE3
+
+#include "network/database_worker.hpp"
+
+#include "network/server_config.hpp"
+#include "utils/log.hpp"
+#include "utils/string_utils.hpp"
+#include "utils/time.hpp"
+#include "utils/vs.hpp"
+
+#include <chrono>
+
+/** Time in milliseconds after which the bans are reloaded. */
+static const uint64_t BAN_REFRESH_TIME = 60000;
+
+/** Maximum number of cached statements, queries with values in the text
+ *  would fill the cache otherwise. */
+static const unsigned MAX_STATEMENTS = 64;
+
+// ----------------------------------------------------------------------------
+DatabaseWorker::DatabaseWorker()
+{
+    m_db = NULL;
+    m_refresh_bans = false;
+    m_exit = false;
+}   // DatabaseWorker
+
+// ----------------------------------------------------------------------------
+/** Writes all queued queries and stops the database thread.
+ */
+DatabaseWorker::~DatabaseWorker()
+{
+    if (m_thread.joinable())
+    {
+        std::unique_lock<std::mutex> ul(m_queries_mutex);
+        m_exit = true;
+        ul.unlock();
+        m_queries_cv.notify_one();
+        m_thread.join();
+    }
+    clearStatements();
+    if (m_db)
+        sqlite3_close(m_db);
+}   // ~DatabaseWorker
+
+// ----------------------------------------------------------------------------
+/** Opens the connection of the database thread, loads the bans and starts
+ *  the thread.
+ *  \param file The database file.
+ *  \param ip_ban_table Name of the ip ban table, or empty if not used.
+ *  \param online_id_ban_table Name of the online id ban table, or empty if
+ *         not used.
+ *  \return False if the database can't be opened.
+ */
+bool DatabaseWorker::init(const std::string& file,
+                          const std::string& ip_ban_table,
+                          const std::string& online_id_ban_table)
+{
+    // Not a shared cache connection, so the busy handler is used when the
+    // lobby reads with its own connection at the same time
+    int ret = sqlite3_open_v2(file.c_str(), &m_db,
+        SQLITE_OPEN_NOMUTEX | SQLITE_OPEN_READWRITE, NULL);
+    if (ret != SQLITE_OK)
+    {
+        Log::error("DatabaseWorker", "Cannot open database: %s.",
+            sqlite3_errmsg(m_db));
+        sqlite3_close(m_db);
+        m_db = NULL;
+        return false;
+    }
+    sqlite3_busy_handler(m_db, [](void* data, int retry)
+        {
+            int retry_count = ServerConfig::m_database_timeout / 100;
+            if (retry < retry_count)
+            {
+                sqlite3_sleep(100);
+                // Return non-zero to let caller retry again
+                return 1;
+            }
+            // Return zero to let caller return SQLITE_BUSY immediately
+            return 0;
+        }, NULL);
+
+    m_ip_ban_table = ip_ban_table;
+    m_online_id_ban_table = online_id_ban_table;
+    // Load the bans now, so the first peers are tested too
+    loadBans();
+    m_thread = std::thread([this]()
+        {
+            VS::setThreadName("DatabaseWorker");
+            mainLoop();
+        });
+    return true;
+}   // init
+
+// ----------------------------------------------------------------------------
+/** Queues a query for the database thread, it's run after all queries
+ *  queued before.
+ *  \param query The query, use parameters for changing values so the
+ *         prepared statement can be reused.
+ *  \param bind_function Binds the parameters, called in the database thread
+ *         so it must not use objects which can be deleted in the meantime.
+ *  \param done_function Called in the database thread with true if the
+ *         query was written.
+ */
+void DatabaseWorker::addQuery(const std::string& query,
+                     std::function<void(sqlite3_stmt* stmt)> bind_function,
+                     std::function<void(bool)> done_function)
+{
+    std::unique_lock<std::mutex> ul(m_queries_mutex);
+    m_queries.push_back({ query, bind_function, done_function });
+    ul.unlock();
+    m_queries_cv.notify_one();
+}   // addQuery
+
+// ----------------------------------------------------------------------------
+/** Reloads the bans after the queries queued so far are written (e.g. after
+ *  adding a ban).
+ */
+void DatabaseWorker::refreshBans()
+{
+    std::unique_lock<std::mutex> ul(m_queries_mutex);
+    m_refresh_bans = true;
+    ul.unlock();
+    m_queries_cv.notify_one();
+}   // refreshBans
+
+// ----------------------------------------------------------------------------
+void DatabaseWorker::mainLoop()
+{
+    uint64_t next_refresh = StkTime::getMonoTimeMs() + BAN_REFRESH_TIME;
+    std::vector<Query> queries;
+    while (true)
+    {
+        std::unique_lock<std::mutex> ul(m_queries_mutex);
+        const uint64_t now = StkTime::getMonoTimeMs();
+        if (now < next_refresh)
+        {
+            m_queries_cv.wait_for(ul,
+                std::chrono::milliseconds(next_refresh - now), [this]()
+                {
+                    return m_exit || m_refresh_bans || !m_queries.empty();
+                });
+        }
+        std::swap(queries, m_queries);
+        const bool refresh = m_refresh_bans ||
+            StkTime::getMonoTimeMs() >= next_refresh;
+        m_refresh_bans = false;
+        const bool exit = m_exit;
+        ul.unlock();
+
+        if (!queries.empty())
+            runQueries(queries);
+        queries.clear();
+        if (exit)
+            break;
+        if (refresh)
+        {
+            loadBans();
+            next_refresh = StkTime::getMonoTimeMs() + BAN_REFRESH_TIME;
+        }
+    }
+}   // mainLoop
+
+// ----------------------------------------------------------------------------
+/** Runs the queries in one transaction, so sqlite writes (and locks) the
+ *  database only once.
+ */
+void DatabaseWorker::runQueries(std::vector<Query>& queries)
+{
+    const bool transaction = queries.size() > 1 &&
+        sqlite3_exec(m_db, "BEGIN;", NULL, NULL, NULL) == SQLITE_OK;
+    std::vector<bool> results;
+    for (Query& q : queries)
+    {
+        bool result = false;
+        sqlite3_stmt* stmt = getStatement(q.m_query);
+        if (stmt)
+        {
+            if (q.m_bind_function)
+                q.m_bind_function(stmt);
+            int ret = sqlite3_step(stmt);
+            result = ret == SQLITE_DONE || ret == SQLITE_ROW;
+            if (!result)
+            {
+                Log::error("DatabaseWorker",
+                    "Error running database query %s: %s",
+                    q.m_query.c_str(), sqlite3_errmsg(m_db));
+            }
+            sqlite3_reset(stmt);
+            sqlite3_clear_bindings(stmt);
+        }
+        results.push_back(result);
+    }
+    if (transaction &&
+        sqlite3_exec(m_db, "COMMIT;", NULL, NULL, NULL) != SQLITE_OK)
+    {
+        Log::error("DatabaseWorker", "Error committing %d queries: %s",
+            (int)queries.size(), sqlite3_errmsg(m_db));
+        sqlite3_exec(m_db, "ROLLBACK;", NULL, NULL, NULL);
+        results.assign(queries.size(), false);
+    }
+    for (unsigned i = 0; i < queries.size(); i++)
+    {
+        if (queries[i].m_done_function)
+            queries[i].m_done_function(results[i]);
+    }
+}   // runQueries
+
+// ----------------------------------------------------------------------------
+/** Returns the cached prepared statement for a query, or prepares it.
+ *  \return The statement, or NULL if the query is invalid.
+ */
+sqlite3_stmt* DatabaseWorker::getStatement(const std::string& query)
+{
+    auto it = m_statements.find(query);
+    if (it != m_statements.end())
+        return it->second;
+
+    if (m_statements.size() >= MAX_STATEMENTS)
+        clearStatements();
+    sqlite3_stmt* stmt = NULL;
+    int ret = sqlite3_prepare_v2(m_db, query.c_str(), -1, &stmt, 0);
+    if (ret != SQLITE_OK)
+    {
+        Log::error("DatabaseWorker",
+            "Error preparing database for query %s: %s",
+            query.c_str(), sqlite3_errmsg(m_db));
+        sqlite3_finalize(stmt);
+        return NULL;
+    }
+    m_statements[query] = stmt;
+    return stmt;
+}   // getStatement
+
+// ----------------------------------------------------------------------------
+void DatabaseWorker::clearStatements()
+{
+    for (auto& p : m_statements)
+        sqlite3_finalize(p.second);
+    m_statements.clear();
+}   // clearStatements
+
+// ----------------------------------------------------------------------------
+/** Reads the active bans from the ban tables into memory.
+ */
+void DatabaseWorker::loadBans()
+{
+    const char* active =
+        "datetime('now') > datetime(starting_time) AND "
+        "(expired_days is NULL OR datetime"
+        "(starting_time, '+'||expired_days||' days') > datetime('now'))";
+
+    std::vector<BanInfo> ip_bans;
+    if (!m_ip_ban_table.empty())
+    {
+        std::string query = StringUtils::insertValues(
+            "SELECT rowid, ip_start, ip_end, reason, description FROM %s "
+            "WHERE %s;", m_ip_ban_table.c_str(), active);
+        sqlite3_stmt* stmt = getStatement(query);
+        if (!stmt)
+            return;
+        int ret;
+        while ((ret = sqlite3_step(stmt)) == SQLITE_ROW)
+        {
+            BanInfo ban;
+            ban.m_row_id = sqlite3_column_int(stmt, 0);
+            ban.m_ip_start = (unsigned)sqlite3_column_int64(stmt, 1);
+            ban.m_ip_end = (unsigned)sqlite3_column_int64(stmt, 2);
+            const char* reason = (char*)sqlite3_column_text(stmt, 3);
+            const char* desc = (char*)sqlite3_column_text(stmt, 4);
+            ban.m_reason = reason ? reason : "";
+            ban.m_description = desc ? desc : "";
+            ip_bans.push_back(ban);
+        }
+        sqlite3_reset(stmt);
+        // Keep the old bans if the database is busy
+        if (ret != SQLITE_DONE)
+        {
+            Log::error("DatabaseWorker", "Error reading ip bans: %s",
+                sqlite3_errmsg(m_db));
+            return;
+        }
+    }
+
+    std::map<uint32_t, BanInfo> online_id_bans;
+    if (!m_online_id_ban_table.empty())
+    {
+        std::string query = StringUtils::insertValues(
+            "SELECT rowid, online_id, reason, description FROM %s "
+            "WHERE %s;", m_online_id_ban_table.c_str(), active);
+        sqlite3_stmt* stmt = getStatement(query);
+        if (!stmt)
+            return;
+        int ret;
+        while ((ret = sqlite3_step(stmt)) == SQLITE_ROW)
+        {
+            const uint32_t online_id =
+                (uint32_t)sqlite3_column_int64(stmt, 1);
+            // Keep the first one like the query with LIMIT 1 did
+            if (online_id_bans.find(online_id) != online_id_bans.end())
+                continue;
+            BanInfo& ban = online_id_bans[online_id];
+            ban.m_row_id = sqlite3_column_int(stmt, 0);
+            ban.m_ip_start = ban.m_ip_end = 0;
+            const char* reason = (char*)sqlite3_column_text(stmt, 2);
+            const char* desc = (char*)sqlite3_column_text(stmt, 3);
+            ban.m_reason = reason ? reason : "";
+            ban.m_description = desc ? desc : "";
+        }
+        sqlite3_reset(stmt);
+        if (ret != SQLITE_DONE)
+        {
+            Log::error("DatabaseWorker", "Error reading online id bans: %s",
+                sqlite3_errmsg(m_db));
+            return;
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(m_bans_mutex);
+    std::swap(m_ip_bans, ip_bans);
+    std::swap(m_online_id_bans, online_id_bans);
+}   // loadBans
+
+// ----------------------------------------------------------------------------
+/** Finds an active ban for an ip, can be called by any thread.
+ *  \param ip The ip to test.
+ *  \param ban Set to the ban if found.
+ *  \return True if the ip is banned.
+ */
+bool DatabaseWorker::findIPBan(uint32_t ip, BanInfo* ban)
+{
+    std::lock_guard<std::mutex> lock(m_bans_mutex);
+    for (const BanInfo& b : m_ip_bans)
+    {
+        if (b.m_ip_start <= ip && b.m_ip_end >= ip)
+        {
+            *ban = b;
+            return true;
+        }
+    }
+    return false;
+}   // findIPBan
+
+// ----------------------------------------------------------------------------
+/** Finds an active ban for an online id, can be called by any thread.
+ *  \param online_id The online id to test.
+ *  \param ban Set to the ban if found.
+ *  \return True if the online id is banned.
+ */
+bool DatabaseWorker::findOnlineIdBan(uint32_t online_id, BanInfo* ban)
+{
+    std::lock_guard<std::mutex> lock(m_bans_mutex);
+    auto it = m_online_id_bans.find(online_id);
+    if (it == m_online_id_bans.end())
+        return false;
+    *ban = it->second;
+    return true;
+}   // findOnlineIdBan
+
+#endif   // ENABLE_SQLITE3
@@ -0,0 +1,143 @@
+//
+//  SuperTuxKart - a fun racing game with go-kart
+//  Copyright (C) 2019 SuperTuxKart-Team
+//
+//  This program is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU General Public License
+//  as published by the Free Software Foundation; either version 3
+//  of the License, or (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+
+#ifdef ENABLE_SQLITE3
+
+#ifndef HEADER_DATABASE_WORKER_HPP
+#define HEADER_DATABASE_WORKER_HPP
+
+#include "utils/no_copy.hpp"
+#include "utils/types.hpp"
+
+#include <condition_variable>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <sqlite3.h>
+
+/** \ingroup network
+ *  Runs the database writes of the server in a separate thread with its own
+ *  database connection, so the lobby never waits for sqlite (which can sleep
+ *  up to database-timeout in the busy handler if the database is shared by
+ *  several servers). All queries queued since the last run are written in
+ *  one transaction, and prepared statements are cached by query text, so
+ *  queries should use bound parameters instead of values in the text.
+ *  The active bans of the ip and online id ban tables are kept in memory and
+ *  reloaded every minute (or after refreshBans()), so testing a connecting
+ *  peer doesn't need a query either.
+ */
+class DatabaseWorker : public NoCopy
+{
+public:
+    /** An active ban from the ip or online id ban table. */
+    struct BanInfo
+    {
+        int m_row_id;
+        uint32_t m_ip_start;
+        uint32_t m_ip_end;
+        std::string m_reason;
+        std::string m_description;
+    };
+
+private:
+    struct Query
+    {
+        std::string m_query;
+        /** Binds the parameters of the statement, can be empty. */
+        std::function<void(sqlite3_stmt* stmt)> m_bind_function;
+        /** Called in the database thread with true if the query succeeded,
+         *  can be empty. */
+        std::function<void(bool)> m_done_function;
+    };
+
+    /** The connection used by the database thread only. */
+    sqlite3* m_db;
+
+    std::thread m_thread;
+
+    std::mutex m_queries_mutex;
+
+    std::condition_variable m_queries_cv;
+
+    /** Queries waiting for the database thread, protected by
+     *  m_queries_mutex. */
+    std::vector<Query> m_queries;
+
+    /** Set to reload the bans in the next run, protected by
+     *  m_queries_mutex. */
+    bool m_refresh_bans;
+
+    /** Set to stop the thread after all queued queries are written,
+     *  protected by m_queries_mutex. */
+    bool m_exit;
+
+    /** Prepared statements by query text, only used by the database
+     *  thread. */
+    std::map<std::string, sqlite3_stmt*> m_statements;
+
+    /** Ban table names, empty if the table doesn't exist. */
+    std::string m_ip_ban_table;
+
+    std::string m_online_id_ban_table;
+
+    std::mutex m_bans_mutex;
+
+    /** Active ip bans, protected by m_bans_mutex. */
+    std::vector<BanInfo> m_ip_bans;
+
+    /** Active online id bans, protected by m_bans_mutex. */
+    std::map<uint32_t, BanInfo> m_online_id_bans;
+
+    // ------------------------------------------------------------------------
+    void mainLoop();
+    // ------------------------------------------------------------------------
+    void runQueries(std::vector<Query>& queries);
+    // ------------------------------------------------------------------------
+    sqlite3_stmt* getStatement(const std::string& query);
+    // ------------------------------------------------------------------------
+    void clearStatements();
+    // ------------------------------------------------------------------------
+    void loadBans();
+
+public:
+    DatabaseWorker();
+    // ------------------------------------------------------------------------
+    ~DatabaseWorker();
+    // ------------------------------------------------------------------------
+    bool init(const std::string& file, const std::string& ip_ban_table,
+              const std::string& online_id_ban_table);
+    // ------------------------------------------------------------------------
+    void addQuery(const std::string& query,
+                  std::function<void(sqlite3_stmt* stmt)> bind_function =
+                  nullptr,
+                  std::function<void(bool)> done_function = nullptr);
+    // ------------------------------------------------------------------------
+    void refreshBans();
+    // ------------------------------------------------------------------------
+    bool findIPBan(uint32_t ip, BanInfo* ban);
+    // ------------------------------------------------------------------------
+    bool findOnlineIdBan(uint32_t online_id, BanInfo* ban);
+};   // DatabaseWorker
+
+#endif
+
+#endif   // ENABLE_SQLITE3
@@ -0,0 +1,316 @@
+//
+//  SuperTuxKart - a fun racing game with go-kart
+//  Copyright (C) 2019 SuperTuxKart-Team
+//
+//  This program is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU General Public License
+//  as published by the Free Software Foundation; either version 3
+//  of the License, or (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+
+#include "network/delta_network_state.hpp"
+
+#include "network/network_string.hpp"
+#include "utils/log.hpp"
+#include "utils/mini_glm.hpp"
+#include "utils/string_utils.hpp"
+
+#include <cassert>
+#include <cmath>
+#include <random>
+#include <stdexcept>
+
+namespace DeltaNetworkState
+{
+    /** How the data of a rewinder is encoded. */
+    enum BlockType : uint8_t
+    {
+        BT_UNCHANGED = 0,   //!< Same as in base state.
+        BT_DELTA     = 1,   //!< Bit mask of changed bytes + changed bytes.
+        BT_FULL      = 2    //!< Not in base state or different size.
+    };
+
+    // ------------------------------------------------------------------------
+    /** Returns the saved data of a rewinder, or NULL if it is not in this
+     *  state.
+     *  \param name Unique identity of the rewinder.
+     *  \param hint Index to be checked first, rewinders are usually saved in
+     *         the same order in each state.
+     */
+    const std::vector<uint8_t>* State::find(const std::string& name,
+                                            unsigned hint) const
+    {
+        if (hint < m_rewinder_using.size() && m_rewinder_using[hint] == name)
+            return &m_data[hint];
+        for (unsigned i = 0; i < m_rewinder_using.size(); i++)
+        {
+            if (m_rewinder_using[i] == name)
+                return &m_data[i];
+        }
+        return NULL;
+    }   // find
+
+    // ------------------------------------------------------------------------
+    /** Writes the data of all rewinders in the same way as a full state sent
+     *  by the server (size followed by data), so it can be restored by
+     *  RewindInfoState.
+     */
+    void State::save(BareNetworkString* bns) const
+    {
+        for (const std::vector<uint8_t>& data : m_data)
+        {
+            bns->addUInt16((uint16_t)data.size());
+            bns->getBuffer().insert(bns->getBuffer().end(), data.begin(),
+                data.end());
+        }
+    }   // save
+
+    // ------------------------------------------------------------------------
+    /** Encodes a state as difference to a base state.
+     *  \param base The state the receiver already has.
+     *  \param state The state to encode.
+     *  \param bns The network string to append the encoded data to.
+     */
+    void encode(const State& base, const State& state, BareNetworkString* bns)
+    {
+        assert(state.m_rewinder_using.size() == state.m_data.size());
+        bns->addUInt8((uint8_t)state.m_rewinder_using.size());
+        std::vector<uint8_t> mask, changed;
+        for (unsigned i = 0; i < state.m_rewinder_using.size(); i++)
+        {
+            const std::string& name = state.m_rewinder_using[i];
+            const std::vector<uint8_t>& data = state.m_data[i];
+            bns->encodeString(name);
+            const std::vector<uint8_t>* old = base.find(name, i);
+            if (old && *old == data)
+            {
+                bns->addUInt8(BT_UNCHANGED);
+                continue;
+            }
+            if (!old || old->size() != data.size())
+            {
+                bns->addUInt8(BT_FULL).addUInt16((uint16_t)data.size());
+                bns->getBuffer().insert(bns->getBuffer().end(), data.begin(),
+                    data.end());
+                continue;
+            }
+            mask.assign((data.size() + 7) / 8, 0);
+            changed.clear();
+            for (unsigned j = 0; j < data.size(); j++)
+            {
+                if (data[j] != (*old)[j])
+                {
+                    mask[j / 8] |= (uint8_t)(1 << (j % 8));
+                    changed.push_back(data[j]);
+                }
+            }
+            // Use the full data if the mask makes it larger
+            if (mask.size() + changed.size() >= data.size())
+            {
+                bns->addUInt8(BT_FULL).addUInt16((uint16_t)data.size());
+                bns->getBuffer().insert(bns->getBuffer().end(), data.begin(),
+                    data.end());
+                continue;
+            }
+            bns->addUInt8(BT_DELTA).addUInt16((uint16_t)data.size());
+            bns->getBuffer().insert(bns->getBuffer().end(), mask.begin(),
+                mask.end());
+            bns->getBuffer().insert(bns->getBuffer().end(), changed.begin(),
+                changed.end());
+        }
+    }   // encode
+
+    // ------------------------------------------------------------------------
+    /** Decodes a state encoded by encode().
+     *  \param base The same state which was used as base for encoding.
+     *  \param bns The encoded data.
+     *  \param state The decoded state, its ticks are not changed.
+     *  \throw std::out_of_range or std::runtime_error if the data is invalid.
+     */
+    void decode(const State& base, BareNetworkString* bns, State* state)
+    {
+        const unsigned count = bns->getUInt8();
+        state->m_rewinder_using.resize(count);
+        state->m_data.resize(count);
+        for (unsigned i = 0; i < count; i++)
+        {
+            std::string& name = state->m_rewinder_using[i];
+            std::vector<uint8_t>& data = state->m_data[i];
+            bns->decodeString(&name);
+            const std::vector<uint8_t>* old = base.find(name, i);
+            const uint8_t type = bns->getUInt8();
+            const uint16_t size = type == BT_UNCHANGED ? 0 : bns->getUInt16();
+            switch (type)
+            {
+            case BT_UNCHANGED:
+                if (!old)
+                    throw std::runtime_error("Missing base rewinder data");
+                data = *old;
+                break;
+            case BT_FULL:
+                if ((unsigned)bns->size() < size)
+                    throw std::out_of_range("Full rewinder data too short");
+                data.assign(bns->getCurrentData(),
+                    bns->getCurrentData() + size);
+                bns->skip(size);
+                break;
+            case BT_DELTA:
+            {
+                if (!old || old->size() != size)
+                    throw std::runtime_error("Wrong base rewinder data");
+                const unsigned mask_size = (size + 7) / 8;
+                if ((unsigned)bns->size() < mask_size)
+                    throw std::out_of_range("Delta mask too short");
+                std::vector<uint8_t> mask(bns->getCurrentData(),
+                    bns->getCurrentData() + mask_size);
+                bns->skip(mask_size);
+                data = *old;
+                for (unsigned j = 0; j < size; j++)
+                {
+                    if ((mask[j / 8] >> (j % 8)) & 1)
+                        data[j] = bns->getUInt8();
+                }
+                break;
+            }
+            default:
+                throw std::runtime_error("Unknown rewinder data type");
+            }
+        }
+    }   // decode
+
+    // ------------------------------------------------------------------------
+    /** Creates a state looking like the states saved in a race: each kart
+     *  saves controls, flags and a compressed body (see CompressNetworkBody)
+     *  which changes a bit every state. Used by unit testing and benchmark.
+     */
+    static void createTestState(int ticks, unsigned num_karts,
+                                std::mt19937& g, State* state)
+    {
+        state->m_ticks = ticks;
+        state->m_rewinder_using.clear();
+        state->m_data.clear();
+        const float t = ticks / 120.0f;
+        for (unsigned i = 0; i < num_karts; i++)
+        {
+            BareNetworkString bns;
+            // Controls, controller and flags
+            bns.addUInt16((uint16_t)(g() % 3 == 0 ? g() : 0)).addUInt8(1)
+                .addUInt8(0).addUInt8(0).addUInt16(0);
+            // Body: slowly moving position, rotation and velocities
+            const float angle = t * 0.3f + i;
+            bns.addFloat(30.0f * std::cos(angle)).addFloat(0.5f + i * 0.01f)
+                .addFloat(30.0f * std::sin(angle));
+            bns.addUInt32(MiniGLM::compressQuaternion(
+                btQuaternion(btVector3(0, 1, 0), -angle)));
+            bns.addUInt16(MiniGLM::toFloat16(-9.0f * std::sin(angle)))
+                .addUInt16(0)
+                .addUInt16(MiniGLM::toFloat16(9.0f * std::cos(angle)))
+                .addUInt16(0).addUInt16(MiniGLM::toFloat16(0.3f))
+                .addUInt16(0);
+            // Skidding, speed, powerup, attachment and others
+            bns.addUInt8(0).addFloat(20.0f + std::sin(t)).addUInt8(0)
+                .addUInt8(0).addUInt16((uint16_t)(ticks / 600)).addUInt32(0);
+            state->m_rewinder_using.push_back(
+                std::string("Kart") + StringUtils::toString(i));
+            state->m_data.push_back(bns.getBuffer());
+        }
+        // Items and world
+        BareNetworkString items;
+        for (unsigned i = 0; i < 64; i++)
+            items.addUInt16(0);
+        items.addUInt32(ticks / 1200);
+        state->m_rewinder_using.push_back("N");
+        state->m_data.push_back(items.getBuffer());
+    }   // createTestState
+
+    // ------------------------------------------------------------------------
+    void unitTesting()
+    {
+        std::mt19937 g(42);
+        State base, state, decoded;
+        createTestState(120, 8, g, &base);
+        createTestState(132, 8, g, &state);
+        // A new rewinder, a removed one and one with different size
+        state.m_rewinder_using.push_back("B0");
+        state.m_data.push_back(std::vector<uint8_t>(20, 3));
+        state.m_rewinder_using.erase(state.m_rewinder_using.begin() + 2);
+        state.m_data.erase(state.m_data.begin() + 2);
+        state.m_data[0].push_back(7);
+
+        BareNetworkString bns;
+        encode(base, state, &bns);
+        decode(base, &bns, &decoded);
+        assert(bns.size() == 0);
+        assert(decoded.m_rewinder_using == state.m_rewinder_using);
+        assert(decoded.m_data == state.m_data);
+
+        // Same state should be only names and types
+        BareNetworkString same;
+        encode(base, base, &same);
+        decode(base, &same, &decoded);
+        assert(decoded.m_data == base.m_data);
+
+        // Decoding with a wrong base must not be accepted silently
+        BareNetworkString wrong;
+        State empty;
+        encode(base, state, &wrong);
+        try
+        {
+            decode(empty, &wrong, &decoded);
+            assert(false);
+        }
+        catch (std::exception&)
+        {
+        }
+    }   // unitTesting
+
+    // ------------------------------------------------------------------------
+    /** Reports the bytes per second each client receives for a 16 and 32
+     *  karts race, with full states and with states encoded against the
+     *  state 2 states before (what a client with about 150ms ping has
+     *  confirmed at the default state frequency of 10 per second).
+     */
+    void benchmark()
+    {
+        const int state_frequency = 10;
+        const int ticks_per_state = 120 / state_frequency;
+        for (unsigned num_karts : { 16u, 32u })
+        {
+            std::mt19937 g(1);
+            std::vector<State> states(60 * state_frequency);
+            for (unsigned i = 0; i < states.size(); i++)
+            {
+                createTestState(i * ticks_per_state, num_karts, g,
+                    &states[i]);
+            }
+            uint64_t full_size = 0, delta_size = 0;
+            for (unsigned i = 2; i < states.size(); i++)
+            {
+                BareNetworkString full;
+                states[i].save(&full);
+                for (const std::string& name : states[i].m_rewinder_using)
+                    full.encodeString(name);
+                full_size += full.getTotalSize();
+
+                BareNetworkString delta;
+                encode(states[i - 2], states[i], &delta);
+                // Base ticks saved in GameProtocol too
+                delta_size += delta.getTotalSize() + 4;
+            }
+            const double seconds =
+                (double)(states.size() - 2) / state_frequency;
+            Log::info("Benchmark", "%2d karts: %8.0f bytes/s full states, "
+                "%8.0f bytes/s delta states per client.", num_karts,
+                full_size / seconds, delta_size / seconds);
+        }
+    }   // benchmark
+
+}   // namespace DeltaNetworkState
@@ -0,0 +1,64 @@
+//
+//  SuperTuxKart - a fun racing game with go-kart
+//  Copyright (C) 2019 SuperTuxKart-Team
+//
+//  This program is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU General Public License
+//  as published by the Free Software Foundation; either version 3
+//  of the License, or (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+
+#ifndef HEADER_DELTA_NETWORK_STATE_HPP
+#define HEADER_DELTA_NETWORK_STATE_HPP
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+class BareNetworkString;
+
+/** Encodes a game state as the difference to an older state which the
+ *  receiver already has (usually the last state a client confirmed). The
+ *  saved data of each rewinder is compared byte by byte with the data of the
+ *  same rewinder in the old state: unchanged rewinders cost 1 byte, changed
+ *  ones a bit mask of the changed bytes plus those bytes only. This works
+ *  for any rewinder without knowing its format, most of the saved values
+ *  (controls, flags, timers, upper bytes of positions) rarely change between
+ *  two states.
+ */
+namespace DeltaNetworkState
+{
+    /** The data of all rewinders in a state, in the order of saving. */
+    struct State
+    {
+        /** World ticks of this state. */
+        int m_ticks;
+        /** Unique identity of each rewinder. */
+        std::vector<std::string> m_rewinder_using;
+        /** Saved data of each rewinder, same order as m_rewinder_using. */
+        std::vector<std::vector<uint8_t> > m_data;
+        // --------------------------------------------------------------------
+        State() : m_ticks(-1) {}
+        // --------------------------------------------------------------------
+        const std::vector<uint8_t>* find(const std::string& name,
+                                         unsigned hint) const;
+        // --------------------------------------------------------------------
+        void save(BareNetworkString* bns) const;
+    };   // State
+
+    void encode(const State& base, const State& state,
+                BareNetworkString* bns);
+    void decode(const State& base, BareNetworkString* bns, State* state);
+    void unitTesting();
+    void benchmark();
+};   // namespace DeltaNetworkState
+
+#endif // HEADER_DELTA_NETWORK_STATE_HPP
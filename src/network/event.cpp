@@ -21,9 +21,11 @@
 #include "network/crypto.hpp"
 #include "network/protocols/client_lobby.hpp"
 #include "network/stk_peer.hpp"
+#include "utils/block_pool.hpp"
 #include "utils/log.hpp"
 #include "utils/time.hpp"
 
+#include <cassert>
 #include <string.h>
 
 /** \brief Constructor
@@ -38,6 +40,33 @@ constexpr bool isConnectionRequestPacket(unsigned char* data, size_t length)
         (uint8_t)data[1] == LobbyProtocol::LE_CONNECTION_REQUESTED;
 }   // isConnectionRequestPacket
 
+// ============================================================================
+namespace
+{
+    typedef BlockPool<sizeof(Event)> EventPool;
+    // ------------------------------------------------------------------------
+    /** Never deleted, so events can be freed during exit too. */
+    EventPool* getPool()
+    {
+        static EventPool* pool = new EventPool();
+        return pool;
+    }   // getPool
+}
+
+// ----------------------------------------------------------------------------
+void* Event::operator new(size_t size)
+{
+    assert(EventPool::fits(size));
+    return getPool()->allocate();
+}   // operator new
+
+// ----------------------------------------------------------------------------
+void Event::operator delete(void* ptr, size_t size)
+{
+    if (ptr)
+        getPool()->free(ptr);
+}   // operator delete
+
 // ============================================================================
 Event::Event(ENetEvent* event, std::shared_ptr<STKPeer> peer)
 {
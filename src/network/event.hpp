@@ -68,6 +68,8 @@ enum PeerDisconnectInfo : unsigned int;
  * Indeed, when packets are logged, the state of the peer cannot be stored at
  * all times, and then the user of this class can rely only on the address/port
  * of the peer, and not on values that might change over time.
+ * An event is created for each received packet, so they are allocated from
+ * a pool.
  */
 class Event
 {
@@ -92,6 +94,10 @@ private:
 public:
          Event(ENetEvent* event, std::shared_ptr<STKPeer> peer);
         ~Event();
+    // ------------------------------------------------------------------------
+    static void* operator new(size_t size);
+    // ------------------------------------------------------------------------
+    static void  operator delete(void* ptr, size_t size);
 
     // ------------------------------------------------------------------------
     /** Returns the type of this event. */
@@ -0,0 +1,313 @@
+//
+//  SuperTuxKart - a fun racing game with go-kart
+//  Copyright (C) 2019 SuperTuxKart-Team
+//
+//  This program is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU General Public License
+//  as published by the Free Software Foundation; either version 3
+//  of the License, or (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+
+#include "network/event_queue.hpp"
+
+#include "network/event.hpp"
+#include "utils/log.hpp"
+#include "utils/time.hpp"
+
+#include <cassert>
+#include <chrono>
+#include <cstdint>
+#include <list>
+#include <thread>
+
+// ----------------------------------------------------------------------------
+/** Creates the queue.
+ *  \param capacity Maximum number of events in the queue, must be a power
+ *         of 2.
+ */
+EventQueue::EventQueue(unsigned capacity)
+          : m_slots(new Slot[capacity]), m_mask(capacity - 1)
+{
+    assert(capacity > 0 && (capacity & m_mask) == 0);
+    for (unsigned i = 0; i < capacity; i++)
+    {
+        m_slots[i].m_sequence.store(i, std::memory_order_relaxed);
+        m_slots[i].m_event = NULL;
+    }
+    m_write_position.store(0, std::memory_order_relaxed);
+    m_read_position = 0;
+    m_waiting.store(false);
+    m_overflowing.store(false);
+    m_next_overflow_warning = 0;
+}   // EventQueue
+
+// ----------------------------------------------------------------------------
+/** Deletes all events which were not read. No other thread must use the
+ *  queue anymore.
+ */
+EventQueue::~EventQueue()
+{
+    std::vector<Event*> events;
+    popAll(&events);
+    for (Event* event : events)
+        delete event;
+}   // ~EventQueue
+
+// ----------------------------------------------------------------------------
+/** Adds an event to the queue, can be called by any thread and never
+ *  blocks. If the consumer is waiting it is woken up.
+ *  \param event The event, the queue (and later the consumer) owns it.
+ */
+void EventQueue::push(Event* event)
+{
+    // Once events overflowed, all events go to the overflow list till the
+    // consumer has read it, so that no event overtakes an earlier one
+    if (m_overflowing.load(std::memory_order_acquire) || !pushToRing(event))
+    {
+        std::lock_guard<std::mutex> lock(m_overflow_mutex);
+        if (!m_overflowing.load(std::memory_order_relaxed))
+        {
+            m_overflowing.store(true, std::memory_order_release);
+            const uint64_t now = StkTime::getMonoTimeMs();
+            if (now >= m_next_overflow_warning)
+            {
+                Log::warn("EventQueue", "All %u slots are used, keeping "
+                    "further events in an overflow list.", m_mask + 1);
+                m_next_overflow_warning = now + 1000;
+            }
+        }
+        m_overflow.push_back(event);
+    }
+
+    // Either this thread sees that the consumer waits, or the consumer sees
+    // the new event before it waits
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (m_waiting.load(std::memory_order_relaxed))
+    {
+        std::lock_guard<std::mutex> lock(m_wait_mutex);
+        m_wait_cv.notify_one();
+    }
+}   // push
+
+// ----------------------------------------------------------------------------
+/** Adds an event to the ring without taking any lock.
+ *  \param event The event to add.
+ *  \return False if the ring is full, the event is not added then.
+ */
+bool EventQueue::pushToRing(Event* event)
+{
+    unsigned position = m_write_position.load(std::memory_order_relaxed);
+    Slot* slot;
+    while (true)
+    {
+        slot = &m_slots[position & m_mask];
+        const unsigned sequence =
+            slot->m_sequence.load(std::memory_order_acquire);
+        const int diff = (int)(sequence - position);
+        if (diff == 0)
+        {
+            if (m_write_position.compare_exchange_weak(position,
+                position + 1, std::memory_order_relaxed))
+                break;
+        }
+        else if (diff < 0)
+        {
+            // The slot has not been read since the last round
+            return false;
+        }
+        else
+            position = m_write_position.load(std::memory_order_relaxed);
+    }
+    slot->m_event = event;
+    slot->m_sequence.store(position + 1, std::memory_order_release);
+    return true;
+}   // pushToRing
+
+// ----------------------------------------------------------------------------
+/** Moves all events which can be read now to the end of the given vector,
+ *  in the order they were added. Must only be called by the consumer.
+ *  \param events The vector to which the events are added.
+ *  \return Number of events added.
+ */
+unsigned EventQueue::popAll(std::vector<Event*>* events)
+{
+    unsigned count = 0;
+    while (!isRingEmpty())
+    {
+        Slot& slot = m_slots[m_read_position & m_mask];
+        events->push_back(slot.m_event);
+        slot.m_event = NULL;
+        // Free for the producer in the next round
+        slot.m_sequence.store(m_read_position + m_mask + 1,
+            std::memory_order_release);
+        m_read_position++;
+        count++;
+    }
+    // The overflow list can only be read once no event is being written
+    // to the ring anymore, all events in the ring were added before it
+    if (m_overflowing.load(std::memory_order_acquire) &&
+        m_write_position.load(std::memory_order_acquire) == m_read_position)
+    {
+        std::lock_guard<std::mutex> lock(m_overflow_mutex);
+        events->insert(events->end(), m_overflow.begin(), m_overflow.end());
+        count += (unsigned)m_overflow.size();
+        m_overflow.clear();
+        m_overflowing.store(false, std::memory_order_release);
+    }
+    return count;
+}   // popAll
+
+// ----------------------------------------------------------------------------
+/** Blocks the consumer until there is at least one event to read.
+ *  \param timeout_ms Maximum time to wait in milliseconds, or -1 to wait
+ *         without timeout.
+ */
+void EventQueue::wait(int timeout_ms)
+{
+    if (!isEmpty())
+        return;
+    std::unique_lock<std::mutex> ul(m_wait_mutex);
+    m_waiting.store(true, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (timeout_ms < 0)
+        m_wait_cv.wait(ul, [this] { return !isEmpty(); });
+    else
+    {
+        m_wait_cv.wait_for(ul, std::chrono::milliseconds(timeout_ms),
+            [this] { return !isEmpty(); });
+    }
+    m_waiting.store(false, std::memory_order_relaxed);
+}   // wait
+
+// ----------------------------------------------------------------------------
+/** The queue never dereferences the events, so fake pointers are used which
+ *  contain the number of the producer and a counter.
+ */
+static Event* fakeEvent(unsigned producer, unsigned n)
+{
+    return (Event*)(uintptr_t)(((uint64_t)producer << 24 | n) + 1);
+}   // fakeEvent
+
+// ----------------------------------------------------------------------------
+void EventQueue::unitTesting()
+{
+    // Single thread: order, full queue and wrap around
+    {
+        EventQueue queue(4);
+        std::vector<Event*> events;
+        assert(queue.isEmpty());
+        assert(queue.popAll(&events) == 0);
+        // Events which don't fit into the ring overflow, in order
+        for (unsigned i = 0; i < 6; i++)
+            queue.push(fakeEvent(0, i));
+        assert(!queue.isEmpty());
+        assert(queue.popAll(&events) == 6);
+        for (unsigned i = 0; i < 6; i++)
+            assert(events[i] == fakeEvent(0, i));
+        assert(queue.isEmpty());
+        for (unsigned round = 0; round < 3; round++)
+        {
+            events.clear();
+            queue.push(fakeEvent(1, round));
+            queue.push(fakeEvent(2, round));
+            assert(queue.popAll(&events) == 2);
+            assert(events[0] == fakeEvent(1, round));
+            assert(events[1] == fakeEvent(2, round));
+        }
+        assert(queue.isEmpty());
+    }
+
+    // Several producers and a waiting consumer: all events arrive exactly
+    // once, and in order for each producer
+    const unsigned producers = 4, count = 20000;
+    EventQueue queue(256);
+    std::vector<std::thread> threads;
+    for (unsigned p = 0; p < producers; p++)
+    {
+        threads.emplace_back([&queue, p, count]()
+            {
+                for (unsigned i = 0; i < count; i++)
+                    queue.push(fakeEvent(p, i));
+            });
+    }
+    std::vector<unsigned> next(producers, 0);
+    std::vector<Event*> events;
+    unsigned received = 0;
+    while (received < producers * count)
+    {
+        queue.wait();
+        events.clear();
+        received += queue.popAll(&events);
+        for (Event* e : events)
+        {
+            const uint64_t v = (uint64_t)(uintptr_t)e - 1;
+            const unsigned p = (unsigned)(v >> 24);
+            assert(p < producers);
+            assert((unsigned)(v & 0xffffff) == next[p]);
+            next[p]++;
+        }
+    }
+    for (std::thread& t : threads)
+        t.join();
+    assert(queue.isEmpty());
+}   // unitTesting
+
+// ----------------------------------------------------------------------------
+/** Compares the queue with the mutex protected list and condition variable
+ *  used before for the controller events in server. One thread (like the
+ *  network thread) adds the events, the consumer waits for them.
+ */
+void EventQueue::benchmark()
+{
+    const unsigned count = 500000;
+
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::list<Event*> list;
+    uint64_t start = StkTime::getMonoTimeUs();
+    std::thread producer([&mutex, &cv, &list, count]()
+        {
+            for (unsigned i = 0; i < count; i++)
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                list.push_back(fakeEvent(0, i));
+                cv.notify_one();
+            }
+        });
+    for (unsigned received = 0; received < count; received++)
+    {
+        std::unique_lock<std::mutex> ul(mutex);
+        cv.wait(ul, [&list] { return !list.empty(); });
+        list.pop_front();
+    }
+    producer.join();
+    const uint64_t list_us = StkTime::getMonoTimeUs() - start;
+
+    EventQueue queue(4096);
+    start = StkTime::getMonoTimeUs();
+    producer = std::thread([&queue, count]()
+        {
+            for (unsigned i = 0; i < count; i++)
+                queue.push(fakeEvent(0, i));
+        });
+    std::vector<Event*> events;
+    for (unsigned received = 0; received < count;)
+    {
+        queue.wait();
+        events.clear();
+        received += queue.popAll(&events);
+    }
+    producer.join();
+    const uint64_t queue_us = StkTime::getMonoTimeUs() - start;
+
+    Log::info("Benchmark", "%u events: list %6.1f ms, queue %6.1f ms.",
+        count, list_us / 1000.0f, queue_us / 1000.0f);
+}   // benchmark
@@ -0,0 +1,130 @@
+//
+//  SuperTuxKart - a fun racing game with go-kart
+//  Copyright (C) 2019 SuperTuxKart-Team
+//
+//  This program is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU General Public License
+//  as published by the Free Software Foundation; either version 3
+//  of the License, or (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+
+#ifndef HEADER_EVENT_QUEUE_HPP
+#define HEADER_EVENT_QUEUE_HPP
+
+#include "utils/no_copy.hpp"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+class Event;
+
+/** \ingroup network
+ *  A bounded lock-free queue of events, which can be filled by any number of
+ *  threads (usually the network thread) and is emptied by one thread (the
+ *  main thread, the ProtocolManager thread or the controller events thread).
+ *  Each slot of the ring has a sequence number which tells if it can be
+ *  written by a producer or read by the consumer, so neither side ever
+ *  takes a lock, and the consumer takes all available events at once.
+ *  The mutex and condition variable are only used if the consumer waits for
+ *  new events with wait().
+ *  A producer never blocks: if the ring is full (e.g. the main thread is
+ *  loading a world), events are added to a mutex protected overflow list
+ *  instead, until the consumer has emptied both. The events of one producer
+ *  are always read in the order they were added.
+ */
+class EventQueue : public NoCopy
+{
+private:
+    struct Slot
+    {
+        /** Equal to the position for a free slot, to position + 1 for a
+         *  slot with an event which can be read. */
+        std::atomic<unsigned> m_sequence;
+        Event* m_event;
+    };
+
+    /** The ring of slots, its size is a power of 2. */
+    std::unique_ptr<Slot[]> m_slots;
+
+    /** Size of the ring - 1, to get the index of a position. */
+    const unsigned m_mask;
+
+    /** Padding so that producers and consumer don't share a cache line. */
+    char m_pad0[64];
+
+    /** Next position to be written by a producer. */
+    std::atomic<unsigned> m_write_position;
+
+    char m_pad1[64];
+
+    /** Next position to be read, only used by the consumer. */
+    unsigned m_read_position;
+
+    /** True while the consumer waits in wait(). */
+    std::atomic<bool> m_waiting;
+
+    std::mutex m_wait_mutex;
+
+    std::condition_variable m_wait_cv;
+
+    /** True while new events are added to m_overflow instead of the ring. */
+    std::atomic<bool> m_overflowing;
+
+    /** Protects m_overflow and m_next_overflow_warning. */
+    std::mutex m_overflow_mutex;
+
+    /** Events which did not fit into the ring, in the order they were
+     *  added. */
+    std::vector<Event*> m_overflow;
+
+    /** Earliest time for the next warning about a full ring, to limit the
+     *  number of warnings during a long burst. */
+    uint64_t m_next_overflow_warning;
+
+    // ------------------------------------------------------------------------
+    bool pushToRing(Event* event);
+    // ------------------------------------------------------------------------
+    /** Returns if there is no event in the ring which can be read now. */
+    bool isRingEmpty() const
+    {
+        const Slot& slot = m_slots[m_read_position & m_mask];
+        return slot.m_sequence.load(std::memory_order_acquire) !=
+            m_read_position + 1;
+    }   // isRingEmpty
+
+public:
+    EventQueue(unsigned capacity);
+    // ------------------------------------------------------------------------
+    ~EventQueue();
+    // ------------------------------------------------------------------------
+    void push(Event* event);
+    // ------------------------------------------------------------------------
+    unsigned popAll(std::vector<Event*>* events);
+    // ------------------------------------------------------------------------
+    void wait(int timeout_ms = -1);
+    // ------------------------------------------------------------------------
+    /** Returns if there is no event which can be read now. Must only be
+     *  called by the consumer. */
+    bool isEmpty() const
+    {
+        return isRingEmpty() && !m_overflowing.load(std::memory_order_acquire);
+    }   // isEmpty
+    // ------------------------------------------------------------------------
+    static void unitTesting();
+    // ------------------------------------------------------------------------
+    static void benchmark();
+};   // EventQueue
+
+#endif
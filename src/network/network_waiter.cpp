@@ -0,0 +1,215 @@
+//
+//  SuperTuxKart - a fun racing game with go-kart
+//  Copyright (C) 2019 SuperTuxKart-Team
+//
+//  This program is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU General Public License
+//  as published by the Free Software Foundation; either version 3
+//  of the License, or (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+
+#include "network/network_waiter.hpp"
+
+#include "utils/log.hpp"
+#include "utils/time.hpp"
+
+#include <algorithm>
+#include <mutex>
+#include <random>
+#include <thread>
+#include <vector>
+
+#ifdef __linux__
+#include <errno.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+#endif
+
+// ----------------------------------------------------------------------------
+NetworkWaiter::NetworkWaiter()
+{
+    m_epoll_fd = -1;
+    m_event_fd = -1;
+    m_signalled.store(false);
+#ifdef __linux__
+    m_epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    m_event_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (m_epoll_fd != -1 && m_event_fd != -1)
+    {
+        struct epoll_event ev = {};
+        ev.events = EPOLLIN;
+        ev.data.fd = m_event_fd;
+        if (epoll_ctl(m_epoll_fd, EPOLL_CTL_ADD, m_event_fd, &ev) == 0)
+            return;
+    }
+    Log::warn("NetworkWaiter", "Can't create epoll or eventfd, "
+        "network thread will poll.");
+    if (m_epoll_fd != -1)
+        close(m_epoll_fd);
+    if (m_event_fd != -1)
+        close(m_event_fd);
+    m_epoll_fd = -1;
+    m_event_fd = -1;
+#endif
+}   // NetworkWaiter
+
+// ----------------------------------------------------------------------------
+NetworkWaiter::~NetworkWaiter()
+{
+#ifdef __linux__
+    if (m_epoll_fd != -1)
+        close(m_epoll_fd);
+    if (m_event_fd != -1)
+        close(m_event_fd);
+#endif
+}   // ~NetworkWaiter
+
+// ----------------------------------------------------------------------------
+/** Adds a socket, wait() returns when a packet can be received on it.
+ *  \return False if the socket can't be added.
+ */
+bool NetworkWaiter::addSocket(ENetSocket socket)
+{
+#ifdef __linux__
+    if (!isValid())
+        return false;
+    struct epoll_event ev = {};
+    ev.events = EPOLLIN;
+    ev.data.fd = socket;
+    // The socket is already added if the listening thread is restarted
+    return epoll_ctl(m_epoll_fd, EPOLL_CTL_ADD, socket, &ev) == 0 ||
+        errno == EEXIST;
+#else
+    return false;
+#endif
+}   // addSocket
+
+// ----------------------------------------------------------------------------
+/** Wakes up the waiting thread, or lets its next wait() return immediately.
+ *  Can be called by any thread.
+ */
+void NetworkWaiter::notify()
+{
+#ifdef __linux__
+    if (m_event_fd == -1 || m_signalled.exchange(true))
+        return;
+    uint64_t one = 1;
+    if (write(m_event_fd, &one, sizeof(one)) != sizeof(one))
+        m_signalled.store(false);
+#endif
+}   // notify
+
+// ----------------------------------------------------------------------------
+/** Waits until a packet is received on any added socket, notify() is called
+ *  or the timeout is over. Notifications which happen during the wait or
+ *  before it are reset, so the caller must check for its work after calling
+ *  this function.
+ *  \param timeout_ms Maximum time to wait in milliseconds.
+ */
+void NetworkWaiter::wait(int timeout_ms)
+{
+#ifdef __linux__
+    if (!isValid())
+    {
+        StkTime::sleep(timeout_ms);
+        return;
+    }
+    struct epoll_event events[4];
+    epoll_wait(m_epoll_fd, events, 4, timeout_ms);
+    // Reset the eventfd (nothing to read if it's not signalled)
+    uint64_t value;
+    ssize_t ret = read(m_event_fd, &value, sizeof(value));
+    (void)ret;
+    m_signalled.store(false);
+#else
+    StkTime::sleep(timeout_ms);
+#endif
+}   // wait
+
+// ----------------------------------------------------------------------------
+/** Measures the time between another thread adding a command (e.g. a packet
+ *  to send) and the network thread handling it, when the network thread
+ *  waits for packets on an idle socket for up to 10ms each time (like
+ *  enet_host_service does) compared to waiting with NetworkWaiter.
+ */
+void NetworkWaiter::benchmark()
+{
+    if (enet_initialize() != 0)
+        return;
+    ENetSocket socket = enet_socket_create(ENET_SOCKET_TYPE_DATAGRAM);
+    ENetAddress address;
+    address.host = 0x0100007f;   // 127.0.0.1 in network byte order
+    address.port = 0;
+    if (socket == ENET_SOCKET_NULL || enet_socket_bind(socket, &address) < 0)
+    {
+        Log::warn("Benchmark", "Can't create socket.");
+        enet_deinitialize();
+        return;
+    }
+
+    const unsigned count = 400;
+    for (int use_waiter = 0; use_waiter < 2; use_waiter++)
+    {
+        NetworkWaiter waiter;
+        if (use_waiter && (!waiter.isValid() || !waiter.addSocket(socket)))
+        {
+            Log::info("Benchmark", "NetworkWaiter is not supported.");
+            break;
+        }
+        std::mutex mutex;
+        std::vector<uint64_t> commands;
+        std::thread producer([&]()
+            {
+                std::mt19937 g(1);
+                for (unsigned i = 0; i < count; i++)
+                {
+                    StkTime::sleep(1 + g() % 5);
+                    std::lock_guard<std::mutex> lock(mutex);
+                    commands.push_back(StkTime::getMonoTimeUs());
+                    if (use_waiter)
+                        waiter.notify();
+                }
+            });
+
+        std::vector<uint64_t> latency;
+        while (latency.size() < count)
+        {
+            if (use_waiter)
+                waiter.wait(10);
+            else
+            {
+                enet_uint32 condition = ENET_SOCKET_WAIT_RECEIVE;
+                enet_socket_wait(socket, &condition, 10);
+            }
+            std::vector<uint64_t> copied;
+            std::unique_lock<std::mutex> lock(mutex);
+            std::swap(copied, commands);
+            lock.unlock();
+            const uint64_t now = StkTime::getMonoTimeUs();
+            for (uint64_t t : copied)
+                latency.push_back(now - t);
+        }
+        producer.join();
+
+        std::sort(latency.begin(), latency.end());
+        uint64_t total = 0;
+        for (uint64_t l : latency)
+            total += l;
+        Log::info("Benchmark", "%s: added latency average %.3f ms, "
+            "p50 %.3f ms, p99 %.3f ms.",
+            use_waiter ? "NetworkWaiter   " : "10ms socket wait",
+            total / 1000.0 / latency.size(), latency[count / 2] / 1000.0,
+            latency[count * 99 / 100] / 1000.0);
+    }
+    enet_socket_destroy(socket);
+    enet_deinitialize();
+}   // benchmark
@@ -0,0 +1,68 @@
+//
+//  SuperTuxKart - a fun racing game with go-kart
+//  Copyright (C) 2019 SuperTuxKart-Team
+//
+//  This program is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU General Public License
+//  as published by the Free Software Foundation; either version 3
+//  of the License, or (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+
+#ifndef HEADER_NETWORK_WAITER_HPP
+#define HEADER_NETWORK_WAITER_HPP
+
+#include "utils/no_copy.hpp"
+
+#include "enet/enet.h"
+
+#include <atomic>
+
+/** \ingroup network
+ *  Lets the network thread sleep until a packet is received on one of its
+ *  sockets, or until another thread has something to send (notify()), or a
+ *  timeout. Without it the network thread can only wait for packets in
+ *  enet_host_service, so packets queued by other threads are sent after
+ *  the timeout of enet_host_service only.
+ *  This uses epoll and eventfd, so it's only available on Linux; isValid()
+ *  returns false on other platforms, and the network thread polls instead.
+ */
+class NetworkWaiter : public NoCopy
+{
+private:
+    /** The epoll instance, or -1 if not available. */
+    int m_epoll_fd;
+
+    /** The eventfd signalled by notify(), or -1 if not available. */
+    int m_event_fd;
+
+    /** True if the eventfd is signalled and not yet reset by wait(), so
+     *  that several notify() calls need only one system call. */
+    std::atomic<bool> m_signalled;
+
+public:
+    NetworkWaiter();
+    // ------------------------------------------------------------------------
+    ~NetworkWaiter();
+    // ------------------------------------------------------------------------
+    bool addSocket(ENetSocket socket);
+    // ------------------------------------------------------------------------
+    void notify();
+    // ------------------------------------------------------------------------
+    void wait(int timeout_ms);
+    // ------------------------------------------------------------------------
+    /** Returns if waiting is supported on this platform. */
+    bool isValid() const              { return m_epoll_fd != -1 &&
+                                               m_event_fd != -1; }
+    // ------------------------------------------------------------------------
+    static void benchmark();
+};   // NetworkWaiter
+
+#endif
@@ -54,7 +54,8 @@ std::shared_ptr<ProtocolManager> ProtocolManager::createInstance()
             {
                 pm->asynchronousUpdate();
                 PROFILER_PUSH_CPU_MARKER("sleep", 0, 255, 255);
-                StkTime::sleep(2);
+                // New events are delivered immediately
+                pm->m_async_events_queue.wait(2);
                 PROFILER_POP_CPU_MARKER();
             }
         });
@@ -63,33 +64,31 @@ std::shared_ptr<ProtocolManager> ProtocolManager::createInstance()
         pm->m_game_protocol_thread = std::thread([pm]()
             {
                 VS::setThreadName("CtrlEvents");
-                while (true)
+                std::vector<Event*> events;
+                bool exit = false;
+                while (!exit)
                 {
-                    std::unique_lock<std::mutex> ul(pm->m_game_protocol_mutex);
-                    pm->m_game_protocol_cv.wait(ul, [&pm]
-                        {
-                            return !pm->m_controller_events_list.empty();
-                        });
-                    Event* event_top = pm->m_controller_events_list.front();
-                    pm->m_controller_events_list.pop_front();
-                    ul.unlock();
-                    if (event_top == NULL)
-                        break;
+                    // Handle all events received since the last wake up
+                    pm->m_controller_events_queue.wait();
+                    events.clear();
+                    pm->m_controller_events_queue.popAll(&events);
+                    bool in_game = true;
                     auto sl = LobbyProtocol::get<ServerLobby>();
                     if (sl)
                     {
                         ServerLobby::ServerState ss = sl->getCurrentState();
-                        if (!(ss >= ServerLobby::WAIT_FOR_WORLD_LOADED &&
-                            ss <= ServerLobby::RACING))
-                        {
-                            delete event_top;
-                            continue;
-                        }
+                        in_game = ss >= ServerLobby::WAIT_FOR_WORLD_LOADED &&
+                            ss <= ServerLobby::RACING;
                     }
                     auto gp = GameProtocol::lock();
-                    if (gp)
-                        gp->notifyEventAsynchronous(event_top);
-                    delete event_top;
+                    for (Event* event : events)
+                    {
+                        if (event == NULL)
+                            exit = true;
+                        else if (in_game && gp && !exit)
+                            gp->notifyEventAsynchronous(event);
+                        delete event;
+                    }
                 }
             });
     }
@@ -99,6 +98,8 @@ std::shared_ptr<ProtocolManager> ProtocolManager::createInstance()
 
 // ----------------------------------------------------------------------------
 ProtocolManager::ProtocolManager()
+               : m_sync_events_queue(4096), m_async_events_queue(4096),
+                 m_controller_events_queue(4096)
 {
     m_exit.store(false);
 }   // ProtocolManager
@@ -112,25 +113,14 @@ ProtocolManager::~ProtocolManager()
         m_all_protocols[i].abort();
     }
 
-    m_sync_events_to_process.lock();
-    for (EventList::iterator i =m_sync_events_to_process.getData().begin();
-                             i!=m_sync_events_to_process.getData().end(); ++i)
-        delete *i;
-    m_sync_events_to_process.getData().clear();
-    m_sync_events_to_process.unlock();
-
-    m_async_events_to_process.lock();
-    for (EventList::iterator i = m_async_events_to_process.getData().begin();
-                             i!= m_async_events_to_process.getData().end(); ++i)
-        delete *i;
-    m_async_events_to_process.getData().clear();
-    m_async_events_to_process.unlock();
-
-    for (EventList::iterator i = m_controller_events_list.begin();
-                             i!= m_controller_events_list.end(); ++i)
-        delete *i;
-    m_controller_events_list.clear();
+    // Events still in the queues are deleted by the queues
+    for (Event* event : m_sync_events_to_process)
+        delete event;
+    m_sync_events_to_process.clear();
 
+    for (Event* event : m_async_events_to_process)
+        delete event;
+    m_async_events_to_process.clear();
 }   // ~ProtocolManager
 
 // ----------------------------------------------------------------------------
@@ -153,10 +143,7 @@ void ProtocolManager::abort()
     m_exit.store(true);
     if (NetworkConfig::get()->isServer())
     {
-        std::unique_lock<std::mutex> ul(m_game_protocol_mutex);
-        m_controller_events_list.push_back(NULL);
-        m_game_protocol_cv.notify_one();
-        ul.unlock();
+        m_controller_events_queue.push(NULL);
         m_game_protocol_thread.join();
     }
     // wait the thread to finish
@@ -175,23 +162,13 @@ void ProtocolManager::propagateEvent(Event* event)
         event->getType() == EVENT_TYPE_MESSAGE &&
         event->data().getProtocolType() == PROTOCOL_CONTROLLER_EVENTS)
     {
-        std::lock_guard<std::mutex> lock(m_game_protocol_mutex);
-        m_controller_events_list.push_back(event);
-        m_game_protocol_cv.notify_one();
+        m_controller_events_queue.push(event);
         return;
     }
     if (event->isSynchronous())
-    {
-        m_sync_events_to_process.lock();
-        m_sync_events_to_process.getData().push_back(event);
-        m_sync_events_to_process.unlock();
-    }
+        m_sync_events_queue.push(event);
     else
-    {
-        m_async_events_to_process.lock();
-        m_async_events_to_process.getData().push_back(event);
-        m_async_events_to_process.unlock();
-    }
+        m_async_events_queue.push(event);
 }   // propagateEvent
 
 // ----------------------------------------------------------------------------
@@ -331,6 +308,47 @@ bool ProtocolManager::sendEvent(Event* event,
                               >= TIME_TO_KEEP_EVENTS;
 }   // sendEvent
 
+// ----------------------------------------------------------------------------
+/** Delivers events to the protocols and deletes them, except the events
+ *  which can not be delivered yet (protocol not started), which are kept in
+ *  the list in the same order.
+ *  \param events The events to deliver.
+ *  \param async If the events are delivered asynchronously (only used for
+ *         the error message).
+ *  \param protocols A copy of all protocols.
+ */
+void ProtocolManager::deliverEvents(std::vector<Event*>* events, bool async,
+                         std::array<OneProtocolType, PROTOCOL_MAX>& protocols)
+{
+    unsigned kept = 0;
+    for (unsigned i = 0; i < events->size(); i++)
+    {
+        Event* event = (*events)[i];
+        bool can_be_deleted = true;
+        try
+        {
+            can_be_deleted = sendEvent(event, protocols);
+        }
+        catch (std::exception& e)
+        {
+            const std::string& name = event->getPeer()->getRealAddress();
+            Log::error("ProtocolManager", "%s event error from %s: %s",
+                async ? "Asynchronous" : "Synchronous", name.c_str(),
+                e.what());
+            Log::error("ProtocolManager", event->data().getLogMessage().c_str());
+        }
+        if (can_be_deleted)
+            delete event;
+        else
+        {
+            // This should only happen if the protocol has not been started
+            // or already terminated (e.g. late ping answer)
+            (*events)[kept++] = event;
+        }
+    }
+    events->resize(kept);
+}   // deliverEvents
+
 // ----------------------------------------------------------------------------
 /** Calls either the synchronous update or asynchronous update function in all
  *  protocols of this type.
@@ -369,37 +387,8 @@ void ProtocolManager::update(int ticks)
     ul.unlock();
 
     // before updating, notify protocols that they have received events
-    m_sync_events_to_process.lock();
-    EventList::iterator i = m_sync_events_to_process.getData().begin();
-
-    while (i != m_sync_events_to_process.getData().end())
-    {
-        m_sync_events_to_process.unlock();
-        bool can_be_deleted = true;
-        try
-        {
-            can_be_deleted = sendEvent(*i, all_protocols);
-        }
-        catch (std::exception& e)
-        {
-            const std::string& name = (*i)->getPeer()->getRealAddress();
-            Log::error("ProtocolManager",
-                "Synchronous event error from %s: %s", name.c_str(), e.what());
-            Log::error("ProtocolManager", (*i)->data().getLogMessage().c_str());
-        }
-        m_sync_events_to_process.lock();
-        if (can_be_deleted)
-        {
-            delete *i;
-            i = m_sync_events_to_process.getData().erase(i);
-        }
-        else
-        {
-            // This should only happen if the protocol has not been started
-            ++i;
-        }
-    }
-    m_sync_events_to_process.unlock();
+    m_sync_events_queue.popAll(&m_sync_events_to_process);
+    deliverEvents(&m_sync_events_to_process, /*async*/false, all_protocols);
 
     // Now update all protocols.
     for (unsigned int i = 0; i < all_protocols.size(); i++)
@@ -428,40 +417,8 @@ void ProtocolManager::asynchronousUpdate()
     auto all_protocols = m_all_protocols;
     ul.unlock();
 
-    m_async_events_to_process.lock();
-    EventList::iterator i = m_async_events_to_process.getData().begin();
-    while (i != m_async_events_to_process.getData().end())
-    {
-        m_async_events_to_process.unlock();
-
-        bool result = true;
-        try
-        {
-            result = sendEvent(*i, all_protocols);
-        }
-        catch (std::exception& e)
-        {
-            const std::string& name = (*i)->getPeer()->getRealAddress();
-            Log::error("ProtocolManager", "Asynchronous event "
-                "error from %s: %s", name.c_str(), e.what());
-            Log::error("ProtocolManager",
-                (*i)->data().getLogMessage().c_str());
-        }
-
-        m_async_events_to_process.lock();
-        if (result)
-        {
-            delete *i;
-            i = m_async_events_to_process.getData().erase(i);
-        }
-        else
-        {
-            // This should only happen if the protocol has not been started
-            // or already terminated (e.g. late ping answer)
-            ++i;
-        }
-    }   // while i != m_events_to_process.end()
-    m_async_events_to_process.unlock();
+    m_async_events_queue.popAll(&m_async_events_to_process);
+    deliverEvents(&m_async_events_to_process, /*async*/true, all_protocols);
 
     PROFILER_POP_CPU_MARKER();
     PROFILER_PUSH_CPU_MARKER("Message delivery", 255, 0, 0);
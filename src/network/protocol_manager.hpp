@@ -23,6 +23,7 @@
 #ifndef PROTOCOL_MANAGER_HPP
 #define PROTOCOL_MANAGER_HPP
 
+#include "network/event_queue.hpp"
 #include "network/network_string.hpp"
 #include "network/protocol.hpp"
 #include "utils/no_copy.hpp"
@@ -146,16 +147,25 @@ private:
      *  empty) list of protocols. */
     std::array<OneProtocolType, PROTOCOL_MAX> m_all_protocols;
 
-    /** A list of network events - messages, disconnect and disconnects. */
-    typedef std::list<Event*> EventList;
+    /** New network events (messages, connects and disconnects) to pass
+     *  synchronously to protocols (i.e. from the main thread). */
+    EventQueue m_sync_events_queue;
 
-    /** Contains the network events to pass synchronously to protocols
-     *  (i.e. from the main thread). */
-    Synchronised<EventList> m_sync_events_to_process;
+    /** New network events to pass asynchronously to protocols (i.e. from
+     *  the separate ProtocolManager thread). */
+    EventQueue m_async_events_queue;
 
-    /** Contains the network events to pass asynchronously to protocols
-    *  (i.e. from the separate ProtocolManager thread). */
-    Synchronised<EventList> m_async_events_to_process;
+    /** Controller events in server, handled by the separate game protocol
+     *  thread. A NULL event tells the thread to exit. */
+    EventQueue m_controller_events_queue;
+
+    /** Synchronous events taken from the queue but not delivered yet, only
+     *  used by the main thread. */
+    std::vector<Event*> m_sync_events_to_process;
+
+    /** Asynchronous events taken from the queue but not delivered yet, only
+     *  used by the ProtocolManager thread. */
+    std::vector<Event*> m_async_events_to_process;
 
     /** When set to true, the main thread will exit. */
     std::atomic_bool m_exit;
@@ -167,11 +177,7 @@ private:
      *  as possible. */
     std::thread m_game_protocol_thread;
 
-    std::condition_variable m_game_protocol_cv;
-
-    std::mutex m_game_protocol_mutex, m_protocols_mutex;
-
-    EventList m_controller_events_list;
+    std::mutex m_protocols_mutex;
 
     /*! Single instance of protocol manager.*/
     static std::weak_ptr<ProtocolManager> m_protocol_manager;
@@ -179,6 +185,9 @@ private:
     bool sendEvent(Event* event,
                    std::array<OneProtocolType, PROTOCOL_MAX>& protocols);
 
+    void deliverEvents(std::vector<Event*>* events, bool async,
+                   std::array<OneProtocolType, PROTOCOL_MAX>& protocols);
+
     void asynchronousUpdate();
 
 public:
@@ -36,6 +36,18 @@
 #include "utils/time.hpp"
 #include "main_loop.hpp"
 
+#include <set>
+
+namespace
+{
+    /** Number of states kept by server and clients as base for delta states,
+     *  with the default state frequency that is 1.6 seconds. */
+    const unsigned STATE_HISTORY_SIZE = 16;
+
+    /** Network capability of clients and servers supporting delta states. */
+    const char* STATE_DELTA_CAPABILITY = "state_delta";
+}
+
 // ============================================================================
 std::weak_ptr<GameProtocol> GameProtocol::m_game_protocol;
 // ============================================================================
@@ -126,6 +138,8 @@ bool GameProtocol::notifyEventAsynchronous(Event* event)
     case GP_CONTROLLER_ACTION: handleControllerAction(event); break;
     case GP_STATE:             handleState(event);            break;
     case GP_ITEM_CONFIRMATION: handleItemEventConfirmation(event); break;
+    case GP_STATE_DELTA:       handleStateDelta(event);       break;
+    case GP_STATE_CONFIRMATION: handleStateConfirmation(event); break;
     case GP_ADJUST_TIME:
     case GP_ITEM_UPDATE:
         break;
@@ -283,6 +297,8 @@ void GameProtocol::startNewState()
     m_data_to_send->clear();
     m_data_to_send->addUInt8(GP_STATE)
         .addUInt32(World::getWorld()->getTicksSinceStart());
+    m_current_state.m_ticks = World::getWorld()->getTicksSinceStart();
+    m_current_state.m_data.clear();
 }   // startNewState
 
 // ----------------------------------------------------------------------------
@@ -295,6 +311,9 @@ void GameProtocol::addState(BareNetworkString *buffer)
     assert(NetworkConfig::get()->isServer());
     m_data_to_send->addUInt16(buffer->size());
     (*m_data_to_send) += *buffer;
+    m_current_state.m_data.emplace_back(
+        buffer->getBuffer().begin() + buffer->getCurrentOffset(),
+        buffer->getBuffer().end());
 }   // addState
 
 // ----------------------------------------------------------------------------
@@ -319,18 +338,144 @@ void GameProtocol::finalizeState(std::vector<std::string>& cur_rewinder)
         names.insert(names.end(), rewinder.begin(), rewinder.end());
     }
     buffer.insert(pos, names.begin(), names.end());
+    m_current_state.m_rewinder_using = cur_rewinder;
 }   // finalizeState
 
 // ----------------------------------------------------------------------------
 /** Called when the last state information has been added and the message
- *  can be sent to the clients.
+ *  can be sent to the clients. Clients which support it get the state
+ *  encoded as difference to the last state they confirmed (if the server
+ *  still has it), all others get the full state. Clients which confirmed
+ *  the same state share the same encoded message.
  */
 void GameProtocol::sendState()
 {
     assert(NetworkConfig::get()->isServer());
-    sendMessageToPeers(m_data_to_send, /*reliable*/false);
+    // Base state ticks of each peer which confirmed a state still in history
+    std::map<STKPeer*, int> bases;
+    std::set<int> all_bases;
+    std::unique_lock<std::mutex> ul(m_confirmed_state_mutex);
+    for (auto& c : m_confirmed_state_ticks)
+    {
+        std::shared_ptr<STKPeer> peer = c.first.lock();
+        if (peer && findStateInHistory(c.second))
+        {
+            bases[peer.get()] = c.second;
+            all_bases.insert(c.second);
+        }
+    }
+    ul.unlock();
+
+    // Returns the ticks of the base state for a peer, or -1 if the full
+    // state needs to be sent
+    auto get_base = [&bases](STKPeer* peer)->int
+        {
+            auto it = bases.find(peer);
+            return it == bases.end() ? -1 : it->second;
+        };
+
+    STKHost::get()->sendPacketToAllPeersWith([&get_base](STKPeer* peer)
+        {
+            return !peer->isWaitingForGame() && get_base(peer) == -1;
+        }, m_data_to_send, /*reliable*/false);
+
+    for (int base_ticks : all_bases)
+    {
+        NetworkString* delta = getNetworkString();
+        delta->addUInt8(GP_STATE_DELTA).addUInt32(m_current_state.m_ticks)
+            .addUInt32(base_ticks);
+        DeltaNetworkState::encode(*findStateInHistory(base_ticks),
+            m_current_state, delta);
+        STKHost::get()->sendPacketToAllPeersWith(
+            [&get_base, base_ticks](STKPeer* peer)
+            {
+                return !peer->isWaitingForGame() &&
+                    get_base(peer) == base_ticks;
+            }, delta, /*reliable*/false);
+        delete delta;
+    }
+    addStateToHistory(m_current_state);
 }   // sendState
 
+// ----------------------------------------------------------------------------
+/** Adds a state sent by server or received by client to the history, so it
+ *  can be used as base for delta states later.
+ */
+void GameProtocol::addStateToHistory(const DeltaNetworkState::State& state)
+{
+    m_state_history.push_back(state);
+    if (m_state_history.size() > STATE_HISTORY_SIZE)
+        m_state_history.pop_front();
+}   // addStateToHistory
+
+// ----------------------------------------------------------------------------
+/** Returns the state of the given ticks in history, or NULL if it's not
+ *  there (anymore).
+ */
+const DeltaNetworkState::State*
+                           GameProtocol::findStateInHistory(int ticks) const
+{
+    for (const DeltaNetworkState::State& state : m_state_history)
+    {
+        if (state.m_ticks == ticks)
+            return &state;
+    }
+    return NULL;
+}   // findStateInHistory
+
+// ----------------------------------------------------------------------------
+/** Sends a confirmation to the server that the state at 'ticks' has been
+ *  received, so that the server can send later states as delta to it.
+ *  \param ticks Time in ticks of the received state.
+ */
+void GameProtocol::sendStateConfirmation(int ticks)
+{
+    assert(NetworkConfig::get()->isClient());
+    NetworkString *ns = getNetworkString(5);
+    ns->addUInt8(GP_STATE_CONFIRMATION).addUInt32(ticks);
+    // Like item confirmation, a lost confirmation only means that the server
+    // uses an older state as base
+    sendToServer(ns, /*reliable*/false);
+    delete ns;
+}   // sendStateConfirmation
+
+// ----------------------------------------------------------------------------
+/** Handles a state confirmation from a client.
+ *  \param event The data from the client.
+ */
+void GameProtocol::handleStateConfirmation(Event *event)
+{
+    if (!NetworkConfig::get()->isServer() || !checkDataSize(event, 4))
+        return;
+    const int ticks = event->data().getUInt32();
+    std::lock_guard<std::mutex> lock(m_confirmed_state_mutex);
+    for (auto it = m_confirmed_state_ticks.begin();
+         it != m_confirmed_state_ticks.end();)
+    {
+        if (it->first.expired())
+            it = m_confirmed_state_ticks.erase(it);
+        else
+            it++;
+    }
+    std::weak_ptr<STKPeer> peer = event->getPeerSP();
+    auto it = m_confirmed_state_ticks.find(peer);
+    if (it == m_confirmed_state_ticks.end())
+        m_confirmed_state_ticks[peer] = ticks;
+    else if (ticks > it->second)
+        it->second = ticks;
+}   // handleStateConfirmation
+
+// ----------------------------------------------------------------------------
+/** Forgets the confirmed state of a peer, called by server when the peer
+ *  (live) joins a game or goes back to lobby, so it will get a full state
+ *  next.
+ */
+void GameProtocol::resetStateConfirmation(std::weak_ptr<STKPeer> peer)
+{
+    std::lock_guard<std::mutex> lock(m_confirmed_state_mutex);
+    m_confirmed_state_ticks.erase(peer);
+}   // resetStateConfirmation
+
 // ----------------------------------------------------------------------------
 /** Called when a new full state is received form the server.
  */
@@ -351,12 +496,88 @@ void GameProtocol::handleState(Event *event)
         rewinder_using.push_back(name);
     }
 
+    const bool use_delta = NetworkConfig::get()->getServerCapabilities()
+        .count(STATE_DELTA_CAPABILITY) != 0;
+    if (use_delta)
+    {
+        DeltaNetworkState::State state;
+        state.m_ticks = ticks;
+        state.m_rewinder_using = rewinder_using;
+        const int offset = data.getCurrentOffset();
+        try
+        {
+            for (unsigned i = 0; i < rewinder_size; i++)
+            {
+                const uint16_t size = data.getUInt16();
+                if (data.size() < size)
+                    throw std::out_of_range("Rewinder data too short");
+                state.m_data.emplace_back(data.getCurrentData(),
+                    data.getCurrentData() + size);
+                data.skip(size);
+            }
+            addStateToHistory(state);
+        }
+        catch (std::exception& e)
+        {
+            Log::error("GameProtocol", "Invalid state: %s", e.what());
+        }
+        data.reset();
+        data.skip(offset);
+    }
+
     // The memory for bns will be handled in the RewindInfoState object
     RewindInfoState* ris = new RewindInfoState(ticks, data.getCurrentOffset(),
         rewinder_using, data.getBuffer());
     RewindManager::get()->addNetworkRewindInfo(ris);
+    if (use_delta)
+        sendStateConfirmation(ticks);
 }   // handleState
 
+// ----------------------------------------------------------------------------
+/** Called when a state encoded as difference to an older state is received
+ *  from the server. It is decoded to a full state, which is then handled
+ *  the same way as in handleState.
+ */
+void GameProtocol::handleStateDelta(Event *event)
+{
+    if (!NetworkConfig::get()->isClient() || !checkDataSize(event, 8))
+        return;
+    NetworkString &data = event->data();
+    const int ticks      = data.getUInt32();
+    const int base_ticks = data.getUInt32();
+    const DeltaNetworkState::State* base = findStateInHistory(base_ticks);
+    if (!base)
+    {
+        // Can happen after live join, the server will send a full state
+        // when our base state expires
+        Log::debug("GameProtocol", "Missing base state %d for state %d.",
+            base_ticks, ticks);
+        return;
+    }
+
+    DeltaNetworkState::State state;
+    state.m_ticks = ticks;
+    try
+    {
+        DeltaNetworkState::decode(*base, &data, &state);
+    }
+    catch (std::exception& e)
+    {
+        Log::error("GameProtocol", "Invalid delta state: %s", e.what());
+        return;
+    }
+    addStateToHistory(state);
+
+    BareNetworkString bns;
+    state.save(&bns);
+    std::vector<std::string> rewinder_using = state.m_rewinder_using;
+    // The memory for bns will be handled in the RewindInfoState object
+    RewindInfoState* ris = new RewindInfoState(ticks, 0, rewinder_using,
+        bns.getBuffer());
+    RewindManager::get()->addNetworkRewindInfo(ris);
+    sendStateConfirmation(ticks);
+}   // handleStateDelta
+
 // ----------------------------------------------------------------------------
 /** Called from the RewindManager when rolling back.
  *  \param buffer Pointer to the saved state information.
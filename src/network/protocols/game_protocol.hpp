@@ -19,6 +19,7 @@
 #ifndef GAME_PROTOCOL_HPP
 #define GAME_PROTOCOL_HPP
 
+#include "network/delta_network_state.hpp"
 #include "network/event_rewinder.hpp"
 #include "network/protocol.hpp"
 
@@ -27,6 +28,9 @@
 #include "utils/singleton.hpp"
 
 #include <cstdlib>
+#include <deque>
+#include <map>
+#include <memory>
 #include <mutex>
 #include <vector>
 #include <tuple>
@@ -48,7 +52,9 @@ private:
            GP_STATE,
            GP_ITEM_UPDATE,
            GP_ITEM_CONFIRMATION,
-           GP_ADJUST_TIME
+           GP_ADJUST_TIME,
+           GP_STATE_DELTA,
+           GP_STATE_CONFIRMATION
     };
 
     /** A network string that collects all information from the server to be sent
@@ -73,10 +79,31 @@ private:
     // List of all kart actions to send to the server
     std::vector<Action> m_all_actions;
 
+    /** The state currently being saved by the server. */
+    DeltaNetworkState::State m_current_state;
+
+    /** The last states sent by the server or received by a client, which
+     *  can be used as base for delta states. */
+    std::deque<DeltaNetworkState::State> m_state_history;
+
+    /** Latest state confirmed by each client which supports delta states
+     *  (server only). */
+    std::map<std::weak_ptr<STKPeer>, int,
+        std::owner_less<std::weak_ptr<STKPeer> > > m_confirmed_state_ticks;
+
+    /** Protects \ref m_confirmed_state_ticks, which is updated in the
+     *  protocol manager thread. */
+    std::mutex m_confirmed_state_mutex;
+
     void handleControllerAction(Event *event);
     void handleState(Event *event);
     void handleAdjustTime(Event *event);
     void handleItemEventConfirmation(Event *event);
+    void handleStateDelta(Event *event);
+    void handleStateConfirmation(Event *event);
+    void addStateToHistory(const DeltaNetworkState::State& state);
+    const DeltaNetworkState::State* findStateInHistory(int ticks) const;
+    void sendStateConfirmation(int ticks);
     static std::weak_ptr<GameProtocol> m_game_protocol;
     // Maximum value of values are only 32768
     std::tuple<uint8_t, uint16_t, uint16_t, uint16_t>
@@ -114,6 +141,7 @@ public:
     void sendState();
     void finalizeState(std::vector<std::string>& cur_rewinder);
     void sendItemEventConfirmation(int ticks);
+    void resetStateConfirmation(std::weak_ptr<STKPeer> peer);
 
     virtual void undo(BareNetworkString *buffer) OVERRIDE;
     virtual void rewind(BareNetworkString *buffer) OVERRIDE;
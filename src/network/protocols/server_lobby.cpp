@@ -28,6 +28,7 @@
 #include "modes/capture_the_flag.hpp"
 #include "modes/linear_world.hpp"
 #include "network/crypto.hpp"
+#include "network/database_worker.hpp"
 #include "network/event.hpp"
 #include "network/game_setup.hpp"
 #include "network/network_config.hpp"
@@ -210,6 +211,18 @@ void ServerLobby::initDatabase()
         m_player_reports_table_exists);
     checkTableExists(ServerConfig::m_ip_geolocation_table,
         m_ip_geolocation_table_exists);
+
+    m_db_worker.reset(new DatabaseWorker());
+    if (!m_db_worker->init(ServerConfig::m_database_file,
+        m_ip_ban_table_exists ?
+        ServerConfig::m_ip_ban_table.c_str() : "",
+        m_online_id_ban_table_exists ?
+        ServerConfig::m_online_id_ban_table.c_str() : ""))
+    {
+        m_db_worker.reset();
+        sqlite3_close(m_db);
+        m_db = NULL;
+    }
 #endif
 }   // initDatabase
 
@@ -428,6 +441,8 @@ void ServerLobby::destroyDatabase()
     auto peers = STKHost::get()->getPeers();
     for (auto& peer : peers)
         writeDisconnectInfoTable(peer.get());
+    // Writes all queued queries
+    m_db_worker.reset();
     if (m_db != NULL)
         sqlite3_close(m_db);
 #endif
@@ -440,10 +455,19 @@ void ServerLobby::writeDisconnectInfoTable(STKPeer* peer)
     if (m_server_stats_table.empty())
         return;
     std::string query = StringUtils::insertValues(
-        "UPDATE %s SET disconnected_time = datetime('now'), ping = %d "
-        "WHERE host_id = %u;", m_server_stats_table.c_str(),
-        peer->getAveragePing(), peer->getHostId());
-    easySQLQuery(query);
+        "UPDATE %s SET disconnected_time = datetime('now'), ping = ? "
+        "WHERE host_id = ?;", m_server_stats_table.c_str());
+    const int ping = peer->getAveragePing();
+    const uint32_t host_id = peer->getHostId();
+    easySQLQuery(query, [ping, host_id](sqlite3_stmt* stmt)
+        {
+            if (sqlite3_bind_int(stmt, 1, ping) != SQLITE_OK ||
+                sqlite3_bind_int64(stmt, 2, host_id) != SQLITE_OK)
+            {
+                Log::error("easySQLQuery", "Failed to bind %d, %u.",
+                    ping, host_id);
+            }
+        });
 #endif
 }   // writeDisconnectInfoTable
 
@@ -798,38 +822,20 @@ void ServerLobby::cleanupDatabase()
 }   // cleanupDatabase
 
 //-----------------------------------------------------------------------------
-/** Run simple query with write lock waiting and optional function, this
- *  function has no callback for the return (if any) by the query.
- *  Return true if no error occurs
+/** Queue a simple query with optional bind function to the database thread,
+ *  this function has no callback for the return (if any) by the query.
+ *  The bind and done functions are called in the database thread later, so
+ *  they must copy the values they need instead of using peers.
+ *  Return true if the query is queued, use done_function to know if it is
+ *  written.
  */
 bool ServerLobby::easySQLQuery(const std::string& query,
-                   std::function<void(sqlite3_stmt* stmt)> bind_function) const
+                   std::function<void(sqlite3_stmt* stmt)> bind_function,
+                   std::function<void(bool)> done_function) const
 {
-    if (!m_db)
-        return false;
-    sqlite3_stmt* stmt = NULL;
-    int ret = sqlite3_prepare_v2(m_db, query.c_str(), -1, &stmt, 0);
-    if (ret == SQLITE_OK)
-    {
-        if (bind_function)
-            bind_function(stmt);
-        ret = sqlite3_step(stmt);
-        ret = sqlite3_finalize(stmt);
-        if (ret != SQLITE_OK)
-        {
-            Log::error("ServerLobby",
-                "Error finalize database for easy query %s: %s",
-                query.c_str(), sqlite3_errmsg(m_db));
-            return false;
-        }
-    }
-    else
-    {
-        Log::error("ServerLobby",
-            "Error preparing database for easy query %s: %s",
-            query.c_str(), sqlite3_errmsg(m_db));
+    if (!m_db_worker)
         return false;
-    }
+    m_db_worker->addQuery(query, bind_function, done_function);
     return true;
 }   // easySQLQuery
 
@@ -967,8 +973,15 @@ void ServerLobby::writePlayerReport(Event* event)
             reporter->getAddress().getIP(), reporter_npp->getOnlineId(),
             reporting_peer->getAddress().getIP(), reporting_npp->getOnlineId());
     }
-    bool written = easySQLQuery(query,
-        [reporter_npp, reporting_npp, info](sqlite3_stmt* stmt)
+    const std::string reporter_name =
+        StringUtils::wideToUtf8(reporter_npp->getName());
+    const std::string info_utf8 = StringUtils::wideToUtf8(info);
+    const core::stringw reporting_name = reporting_npp->getName();
+    const std::string reporting_name_utf8 =
+        StringUtils::wideToUtf8(reporting_name);
+    std::shared_ptr<STKPeer> reporter_peer = event->getPeerSP();
+    easySQLQuery(query,
+        [reporter_name, info_utf8, reporting_name_utf8](sqlite3_stmt* stmt)
         {
             // SQLITE_TRANSIENT to copy string
             if (sqlite3_bind_text(stmt, 1, ServerConfig::m_server_uid.c_str(),
@@ -977,37 +990,37 @@ void ServerLobby::writePlayerReport(Event* event)
                 Log::error("easySQLQuery", "Failed to bind %s.",
                     ServerConfig::m_server_uid.c_str());
             }
-            if (sqlite3_bind_text(stmt, 2,
-                StringUtils::wideToUtf8(reporter_npp->getName()).c_str(),
+            if (sqlite3_bind_text(stmt, 2, reporter_name.c_str(),
                 -1, SQLITE_TRANSIENT) != SQLITE_OK)
             {
                 Log::error("easySQLQuery", "Failed to bind %s.",
-                    StringUtils::wideToUtf8(reporter_npp->getName()).c_str());
+                    reporter_name.c_str());
             }
-            if (sqlite3_bind_text(stmt, 3,
-                StringUtils::wideToUtf8(info).c_str(),
+            if (sqlite3_bind_text(stmt, 3, info_utf8.c_str(),
                 -1, SQLITE_TRANSIENT) != SQLITE_OK)
             {
                 Log::error("easySQLQuery", "Failed to bind %s.",
-                    StringUtils::wideToUtf8(info).c_str());
+                    info_utf8.c_str());
             }
-            if (sqlite3_bind_text(stmt, 4,
-                StringUtils::wideToUtf8(reporting_npp->getName()).c_str(),
+            if (sqlite3_bind_text(stmt, 4, reporting_name_utf8.c_str(),
                 -1, SQLITE_TRANSIENT) != SQLITE_OK)
             {
                 Log::error("easySQLQuery", "Failed to bind %s.",
-                    StringUtils::wideToUtf8(reporting_npp->getName()).c_str());
+                    reporting_name_utf8.c_str());
             }
+        },
+        [this, reporter_peer, reporting_name](bool written)
+        {
+            // Called in the database thread, sendPacket is thread-safe
+            if (!written)
+                return;
+            NetworkString* success = getNetworkString();
+            success->setSynchronous(true);
+            success->addUInt8(LE_REPORT_PLAYER).addUInt8(1)
+                .encodeString(reporting_name);
+            reporter_peer->sendPacket(success, true/*reliable*/);
+            delete success;
         });
-    if (written)
-    {
-        NetworkString* success = getNetworkString();
-        success->setSynchronous(true);
-        success->addUInt8(LE_REPORT_PLAYER).addUInt8(1)
-            .encodeString(reporting_npp->getName());
-        event->getPeer()->sendPacket(success, true/*reliable*/);
-        delete success;
-    }
 #endif
 }   // writePlayerReport
 
@@ -1622,6 +1635,8 @@ void ServerLobby::finishedLoadingLiveJoinClient(Event* event)
     assert(nim);
     nim->saveCompleteState(ns);
     nim->addLiveJoinPeer(peer);
+    if (auto gp = GameProtocol::lock())
+        gp->resetStateConfirmation(peer);
 
     w->saveCompleteState(ns, peer.get());
     if (race_manager->supportsLiveJoining())
@@ -2723,14 +2738,16 @@ void ServerLobby::kickPlayerWithReason(STKPeer* peer, const char* reason) const
 void ServerLobby::saveIPBanTable(const TransportAddress& addr)
 {
 #ifdef ENABLE_SQLITE3
-    if (!m_db || !m_ip_ban_table_exists)
+    if (!m_db_worker || !m_ip_ban_table_exists)
         return;
 
     std::string query = StringUtils::insertValues(
         "INSERT INTO %s (ip_start, ip_end) "
         "VALUES (%u, %u);",
         ServerConfig::m_ip_ban_table.c_str(), addr.getIP(), addr.getIP());
-    easySQLQuery(query);
+    // Reloaded after the insert, so the ban is used immediately
+    if (easySQLQuery(query))
+        m_db_worker->refreshBans();
 #endif
 }   // saveIPBanTable
 
@@ -3117,17 +3134,18 @@ void ServerLobby::handleUnencryptedConnection(std::shared_ptr<STKPeer> peer,
     if (m_server_stats_table.empty() || peer->isAIPeer())
         return;
     std::string query;
-    if (ServerConfig::m_ipv6_server && !peer->getIPV6Address().empty())
+    // All values are bound so the prepared statement is reused
+    const bool save_ipv6 =
+        ServerConfig::m_ipv6_server && !peer->getIPV6Address().empty();
+    if (save_ipv6)
     {
         // We don't save the internally mapped IPv4 (0.x.x.x)
         query = StringUtils::insertValues(
             "INSERT INTO %s "
             "(host_id, ip, ipv6 ,port, online_id, username, player_num, "
             "country_code, version, ping) "
-            "VALUES (%u, 0, \"%s\" ,%u, %u, ?, %u, ?, ?, %u);",
-            m_server_stats_table.c_str(), peer->getHostId(),
-            peer->getIPV6Address(), peer->getAddress().getPort(), online_id,
-            player_count, peer->getAveragePing());
+            "VALUES (?, 0, ?, ?, ?, ?, ?, ?, ?, ?);",
+            m_server_stats_table.c_str());
     }
     else
     {
@@ -3135,24 +3153,53 @@ void ServerLobby::handleUnencryptedConnection(std::shared_ptr<STKPeer> peer,
             "INSERT INTO %s "
             "(host_id, ip, port, online_id, username, player_num, "
             "country_code, version, ping) "
-            "VALUES (%u, %u, %u, %u, ?, %u, ?, ?, %u);",
-            m_server_stats_table.c_str(), peer->getHostId(),
-            peer->getAddress().getIP(), peer->getAddress().getPort(),
-            online_id, player_count, peer->getAveragePing());
+            "VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?);",
+            m_server_stats_table.c_str());
     }
-    easySQLQuery(query, [peer, country_code](sqlite3_stmt* stmt)
+    const uint32_t host_id = peer->getHostId();
+    const std::string address = save_ipv6 ? peer->getIPV6Address() : "";
+    const uint32_t ip = peer->getAddress().getIP();
+    const uint16_t port = peer->getAddress().getPort();
+    const int ping = peer->getAveragePing();
+    const std::string username = StringUtils::wideToUtf8(
+        peer->getPlayerProfiles()[0]->getName());
+    const std::string version = peer->getUserVersion();
+    easySQLQuery(query, [save_ipv6, host_id, address, ip, port, online_id,
+        username, player_count, country_code, version, ping]
+        (sqlite3_stmt* stmt)
         {
-            if (sqlite3_bind_text(stmt, 1, StringUtils::wideToUtf8(
-                peer->getPlayerProfiles()[0]->getName()).c_str(),
+            // Parameters after the address are shifted by one if the ip
+            // is given in text
+            int idx = 1;
+            bool ok = sqlite3_bind_int64(stmt, idx++, host_id) == SQLITE_OK;
+            if (save_ipv6)
+            {
+                ok &= sqlite3_bind_text(stmt, idx++, address.c_str(), -1,
+                    SQLITE_TRANSIENT) == SQLITE_OK;
+            }
+            else
+                ok &= sqlite3_bind_int64(stmt, idx++, ip) == SQLITE_OK;
+            ok &= sqlite3_bind_int(stmt, idx++, port) == SQLITE_OK;
+            ok &= sqlite3_bind_int64(stmt, idx++, online_id) == SQLITE_OK;
+            if (!ok)
+            {
+                Log::error("easySQLQuery", "Failed to bind address for "
+                    "host id %u.", host_id);
+            }
+            if (sqlite3_bind_text(stmt, idx++, username.c_str(),
                 -1, SQLITE_TRANSIENT) != SQLITE_OK)
             {
                 Log::error("easySQLQuery", "Failed to bind %s.",
-                    StringUtils::wideToUtf8(
-                    peer->getPlayerProfiles()[0]->getName()).c_str());
+                    username.c_str());
+            }
+            if (sqlite3_bind_int(stmt, idx++, player_count) != SQLITE_OK)
+            {
+                Log::error("easySQLQuery", "Failed to bind %u players.",
+                    player_count);
             }
             if (country_code.empty())
             {
-                if (sqlite3_bind_null(stmt, 2) != SQLITE_OK)
+                if (sqlite3_bind_null(stmt, idx++) != SQLITE_OK)
                 {
                     Log::error("easySQLQuery",
                         "Failed to bind NULL for country code.");
@@ -3160,19 +3207,21 @@ void ServerLobby::handleUnencryptedConnection(std::shared_ptr<STKPeer> peer,
             }
             else
             {
-                if (sqlite3_bind_text(stmt, 2, country_code.c_str(),
+                if (sqlite3_bind_text(stmt, idx++, country_code.c_str(),
                     -1, SQLITE_TRANSIENT) != SQLITE_OK)
                 {
                     Log::error("easySQLQuery", "Failed to bind country: %s.",
                         country_code.c_str());
                 }
             }
-            if (sqlite3_bind_text(stmt, 3, peer->getUserVersion().c_str(),
+            if (sqlite3_bind_text(stmt, idx++, version.c_str(),
                 -1, SQLITE_TRANSIENT) != SQLITE_OK)
             {
                 Log::error("easySQLQuery", "Failed to bind %s.",
-                    peer->getUserVersion().c_str());
+                    version.c_str());
             }
+            if (sqlite3_bind_int(stmt, idx++, ping) != SQLITE_OK)
+                Log::error("easySQLQuery", "Failed to bind ping %d.", ping);
         }
     );
 #endif
@@ -3977,66 +4026,39 @@ void ServerLobby::resetServer()
 void ServerLobby::testBannedForIP(STKPeer* peer) const
 {
 #ifdef ENABLE_SQLITE3
-    if (!m_db || !m_ip_ban_table_exists)
+    if (!m_db_worker || !m_ip_ban_table_exists)
         return;
 
     // We only test for IPv4 atm
     if (!peer->getIPV6Address().empty())
         return;
 
-    int row_id = -1;
-    unsigned ip_start = 0;
-    unsigned ip_end = 0;
-    std::string query = StringUtils::insertValues(
-        "SELECT rowid, ip_start, ip_end, reason, description FROM %s "
-        "WHERE ip_start <= %u AND ip_end >= %u "
-        "AND datetime('now') > datetime(starting_time) AND "
-        "(expired_days is NULL OR datetime"
-        "(starting_time, '+'||expired_days||' days') > datetime('now')) "
-        "LIMIT 1;",
-        ServerConfig::m_ip_ban_table.c_str(),
-        peer->getAddress().getIP(), peer->getAddress().getIP());
+    // Active bans are cached by the database thread
+    DatabaseWorker::BanInfo ban;
+    if (!m_db_worker->findIPBan(peer->getAddress().getIP(), &ban))
+        return;
+    Log::info("ServerLobby", "%s banned by IP: %s "
+        "(rowid: %d, description: %s).",
+        peer->getRealAddress().c_str(), ban.m_reason.c_str(), ban.m_row_id,
+        ban.m_description.c_str());
+    kickPlayerWithReason(peer, ban.m_reason.c_str());
 
-    sqlite3_stmt* stmt = NULL;
-    int ret = sqlite3_prepare_v2(m_db, query.c_str(), -1, &stmt, 0);
-    if (ret == SQLITE_OK)
-    {
-        ret = sqlite3_step(stmt);
-        if (ret == SQLITE_ROW)
-        {
-            row_id = sqlite3_column_int(stmt, 0);
-            ip_start = (unsigned)sqlite3_column_int64(stmt, 1);
-            ip_end = (unsigned)sqlite3_column_int64(stmt, 2);
-            const char* reason = (char*)sqlite3_column_text(stmt, 3);
-            const char* desc = (char*)sqlite3_column_text(stmt, 4);
-            Log::info("ServerLobby", "%s banned by IP: %s "
-                "(rowid: %d, description: %s).",
-                peer->getRealAddress().c_str(), reason, row_id, desc);
-            kickPlayerWithReason(peer, reason);
-        }
-        ret = sqlite3_finalize(stmt);
-        if (ret != SQLITE_OK)
+    std::string query = StringUtils::insertValues(
+        "UPDATE %s SET trigger_count = trigger_count + 1, "
+        "last_trigger = datetime('now') "
+        "WHERE ip_start = ? AND ip_end = ?;",
+        ServerConfig::m_ip_ban_table.c_str());
+    const uint32_t ip_start = ban.m_ip_start;
+    const uint32_t ip_end = ban.m_ip_end;
+    easySQLQuery(query, [ip_start, ip_end](sqlite3_stmt* stmt)
         {
-            Log::error("ServerLobby",
-                "Error finalize database for query %s: %s",
-                query.c_str(), sqlite3_errmsg(m_db));
-        }
-    }
-    else
-    {
-        Log::error("ServerLobby", "Error preparing database for query %s: %s",
-            query.c_str(), sqlite3_errmsg(m_db));
-        return;
-    }
-    if (row_id != -1)
-    {
-        query = StringUtils::insertValues(
-            "UPDATE %s SET trigger_count = trigger_count + 1, "
-            "last_trigger = datetime('now') "
-            "WHERE ip_start = %u AND ip_end = %u;",
-            ServerConfig::m_ip_ban_table.c_str(), ip_start, ip_end);
-        easySQLQuery(query);
-    }
+            if (sqlite3_bind_int64(stmt, 1, ip_start) != SQLITE_OK ||
+                sqlite3_bind_int64(stmt, 2, ip_end) != SQLITE_OK)
+            {
+                Log::error("easySQLQuery", "Failed to bind %u, %u.",
+                    ip_start, ip_end);
+            }
+        });
 #endif
 }   // testBannedForIP
 
@@ -4045,57 +4067,28 @@ void ServerLobby::testBannedForOnlineId(STKPeer* peer,
                                         uint32_t online_id) const
 {
 #ifdef ENABLE_SQLITE3
-    if (!m_db || !m_online_id_ban_table_exists)
+    if (!m_db_worker || !m_online_id_ban_table_exists)
         return;
 
-    int row_id = -1;
-    std::string query = StringUtils::insertValues(
-        "SELECT rowid, reason, description FROM %s "
-        "WHERE online_id = %u "
-        "AND datetime('now') > datetime(starting_time) AND "
-        "(expired_days is NULL OR datetime"
-        "(starting_time, '+'||expired_days||' days') > datetime('now')) "
-        "LIMIT 1;",
-        ServerConfig::m_online_id_ban_table.c_str(), online_id);
+    DatabaseWorker::BanInfo ban;
+    if (!m_db_worker->findOnlineIdBan(online_id, &ban))
+        return;
+    Log::info("ServerLobby", "%s banned by online id: %s "
+        "(online id: %u rowid: %d, description: %s).",
+        peer->getRealAddress().c_str(), ban.m_reason.c_str(), online_id,
+        ban.m_row_id, ban.m_description.c_str());
+    kickPlayerWithReason(peer, ban.m_reason.c_str());
 
-    sqlite3_stmt* stmt = NULL;
-    int ret = sqlite3_prepare_v2(m_db, query.c_str(), -1, &stmt, 0);
-    if (ret == SQLITE_OK)
-    {
-        ret = sqlite3_step(stmt);
-        if (ret == SQLITE_ROW)
-        {
-            row_id = sqlite3_column_int(stmt, 0);
-            const char* reason = (char*)sqlite3_column_text(stmt, 1);
-            const char* desc = (char*)sqlite3_column_text(stmt, 2);
-            Log::info("ServerLobby", "%s banned by online id: %s "
-                "(online id: %u rowid: %d, description: %s).",
-                peer->getRealAddress().c_str(), reason, online_id,
-                row_id, desc);
-            kickPlayerWithReason(peer, reason);
-        }
-        ret = sqlite3_finalize(stmt);
-        if (ret != SQLITE_OK)
+    std::string query = StringUtils::insertValues(
+        "UPDATE %s SET trigger_count = trigger_count + 1, "
+        "last_trigger = datetime('now') "
+        "WHERE online_id = ?;",
+        ServerConfig::m_online_id_ban_table.c_str());
+    easySQLQuery(query, [online_id](sqlite3_stmt* stmt)
         {
-            Log::error("ServerLobby", "Error finalize database: %s",
-                sqlite3_errmsg(m_db));
-        }
-    }
-    else
-    {
-        Log::error("ServerLobby", "Error preparing database: %s",
-            sqlite3_errmsg(m_db));
-        return;
-    }
-    if (row_id != -1)
-    {
-        query = StringUtils::insertValues(
-            "UPDATE %s SET trigger_count = trigger_count + 1, "
-            "last_trigger = datetime('now') "
-            "WHERE online_id = %u;",
-            ServerConfig::m_online_id_ban_table.c_str(), online_id);
-        easySQLQuery(query);
-    }
+            if (sqlite3_bind_int64(stmt, 1, online_id) != SQLITE_OK)
+                Log::error("easySQLQuery", "Failed to bind %u.", online_id);
+        });
 #endif
 }   // testBannedForOnlineId
 
@@ -4496,6 +4489,8 @@ void ServerLobby::clientInGameWantsToBackLobby(Event* event)
         dynamic_cast<NetworkItemManager*>(ItemManager::get());
     assert(nim);
     nim->erasePeerInGame(peer);
+    if (auto gp = GameProtocol::lock())
+        gp->resetStateConfirmation(peer);
     m_peers_ready.erase(peer);
     peer->setWaitingForGame(true);
     peer->setSpectator(false);
@@ -39,6 +39,9 @@
 #endif
 
 class BareNetworkString;
+#ifdef ENABLE_SQLITE3
+class DatabaseWorker;
+#endif
 class NetworkString;
 class NetworkPlayerProfile;
 class STKPeer;
@@ -74,8 +77,12 @@ private:
     bool m_player_reports_table_exists;
 
 #ifdef ENABLE_SQLITE3
+    /** Used for reading only after the server stats table is created, all
+     *  writes are done by m_db_worker. */
     sqlite3* m_db;
 
+    std::unique_ptr<DatabaseWorker> m_db_worker;
+
     std::string m_server_stats_table;
 
     bool m_ip_ban_table_exists;
@@ -89,7 +96,8 @@ private:
     void cleanupDatabase();
 
     bool easySQLQuery(const std::string& query,
-        std::function<void(sqlite3_stmt* stmt)> bind_function = nullptr) const;
+        std::function<void(sqlite3_stmt* stmt)> bind_function = nullptr,
+        std::function<void(bool)> done_function = nullptr) const;
 
     void checkTableExists(const std::string& table, bool& result);
 
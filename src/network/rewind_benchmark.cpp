@@ -0,0 +1,132 @@
+//
+//  SuperTuxKart - a fun racing game with go-kart
+//  Copyright (C) 2019 SuperTuxKart-Team
+//
+//  This program is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU General Public License
+//  as published by the Free Software Foundation; either version 3
+//  of the License, or (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+
+#include "network/rewind_benchmark.hpp"
+
+#include "config/stk_config.hpp"
+#include "network/rewind_info.hpp"
+#include "network/rewind_manager.hpp"
+#include "utils/log.hpp"
+
+#include <algorithm>
+#include <cassert>
+
+RewindBenchmark* RewindBenchmark::m_rewind_benchmark = NULL;
+
+// ----------------------------------------------------------------------------
+/** Enables the rewind benchmark.
+ *  \param latency_ms Time in milliseconds after which a saved state is
+ *         received as confirmed state.
+ *  \param loss_percent Percentage of states which are never received.
+ */
+void RewindBenchmark::create(int latency_ms, int loss_percent)
+{
+    assert(!m_rewind_benchmark);
+    m_rewind_benchmark = new RewindBenchmark(latency_ms, loss_percent);
+}   // create
+
+// ----------------------------------------------------------------------------
+void RewindBenchmark::destroy()
+{
+    delete m_rewind_benchmark;
+    m_rewind_benchmark = NULL;
+}   // destroy
+
+// ----------------------------------------------------------------------------
+RewindBenchmark::RewindBenchmark(int latency_ms, int loss_percent)
+{
+    m_latency_ms        = std::max(latency_ms, 0);
+    m_loss_percent      = std::min(std::max(loss_percent, 0), 100);
+    m_num_states        = 0;
+    m_num_lost_states   = 0;
+    m_resimulated_ticks = 0;
+}   // RewindBenchmark
+
+// ----------------------------------------------------------------------------
+RewindBenchmark::~RewindBenchmark()
+{
+    for (auto& p : m_pending_states)
+        delete p.second;
+}   // ~RewindBenchmark
+
+// ----------------------------------------------------------------------------
+/** Called by the rewind manager with the state saved at the given time, in
+ *  the same format as a state sent by a server. The state will be received
+ *  after the latency, unless it is lost.
+ *  \param ticks Time of the state.
+ *  \param rewinder_using Unique identity of each rewinder in the state, will
+ *         be moved into the state.
+ *  \param buffer The saved data, will be moved into the state.
+ */
+void RewindBenchmark::addState(int ticks,
+                               std::vector<std::string>& rewinder_using,
+                               std::vector<uint8_t>& buffer)
+{
+    m_num_states++;
+    if ((int)(m_random() % 100) < m_loss_percent)
+    {
+        m_num_lost_states++;
+        return;
+    }
+    const int receive_ticks =
+        ticks + stk_config->time2Ticks(m_latency_ms / 1000.0f);
+    m_pending_states.emplace_back(receive_ticks,
+        new RewindInfoState(ticks, 0, rewinder_using, buffer));
+}   // addState
+
+// ----------------------------------------------------------------------------
+/** Adds all states which are received up to the given time to the rewind
+ *  manager, exactly like GameProtocol does with a state from the server.
+ *  \param world_ticks Current world time.
+ */
+void RewindBenchmark::receiveStates(int world_ticks)
+{
+    while (!m_pending_states.empty() &&
+           m_pending_states.front().first <= world_ticks)
+    {
+        RewindManager::get()->addNetworkRewindInfo(
+            m_pending_states.front().second);
+        m_pending_states.pop_front();
+    }
+}   // receiveStates
+
+// ----------------------------------------------------------------------------
+/** Prints the results of the benchmark.
+ */
+void RewindBenchmark::report()
+{
+    Log::info("RewindBenchmark", "Latency %d ms, loss %d%%: %u states, "
+        "%u lost, %u rewinds, %llu re-simulated ticks.", m_latency_ms,
+        m_loss_percent, m_num_states, m_num_lost_states,
+        (unsigned)m_rewind_time.size(),
+        (unsigned long long)m_resimulated_ticks);
+    if (m_rewind_time.empty())
+        return;
+
+    std::sort(m_rewind_time.begin(), m_rewind_time.end());
+    uint64_t total = 0;
+    for (uint64_t t : m_rewind_time)
+        total += t;
+    const size_t n = m_rewind_time.size();
+    Log::info("RewindBenchmark", "Rewind time: p50 %.3f ms, p99 %.3f ms, "
+        "max %.3f ms, %.3f ms per re-simulated tick.",
+        m_rewind_time[n / 2] / 1000.0,
+        m_rewind_time[std::min(n - 1, n * 99 / 100)] / 1000.0,
+        m_rewind_time.back() / 1000.0,
+        m_resimulated_ticks > 0 ? total / 1000.0 / m_resimulated_ticks : 0.0);
+}   // report
@@ -0,0 +1,108 @@
+//
+//  SuperTuxKart - a fun racing game with go-kart
+//  Copyright (C) 2019 SuperTuxKart-Team
+//
+//  This program is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU General Public License
+//  as published by the Free Software Foundation; either version 3
+//  of the License, or (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+
+#ifndef HEADER_REWIND_BENCHMARK_HPP
+#define HEADER_REWIND_BENCHMARK_HPP
+
+#include "utils/no_copy.hpp"
+
+#include <cstdint>
+#include <deque>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+class RewindInfoState;
+
+/** \ingroup network
+ *  Measures the cost of rewinding without any network (--rewind-benchmark).
+ *  A recorded history is replayed with the rewind manager enabled, and each
+ *  state saved locally is handed back to the rewind manager as a confirmed
+ *  state from a server, after a configurable latency and with a configurable
+ *  loss rate. Each received state triggers a rewind, which is timed. The
+ *  results (number of rewinds, re-simulated ticks and rewind time
+ *  percentiles) are printed when the history replay is finished.
+ */
+class RewindBenchmark : public NoCopy
+{
+private:
+    /** The singleton, only used in a local race. */
+    static RewindBenchmark* m_rewind_benchmark;
+
+    /** Latency of the confirmed states in milliseconds. */
+    int m_latency_ms;
+
+    /** Percentage of confirmed states which are lost. */
+    int m_loss_percent;
+
+    /** Random number generator to determine lost states, with a fixed seed
+     *  so that each run loses the same states. */
+    std::mt19937 m_random;
+
+    /** States which are not yet received, with the ticks at which they are
+     *  received. */
+    std::deque<std::pair<int, RewindInfoState*> > m_pending_states;
+
+    /** Time of each rewind in microseconds. */
+    std::vector<uint64_t> m_rewind_time;
+
+    /** Number of states saved. */
+    unsigned m_num_states;
+
+    /** Number of states lost. */
+    unsigned m_num_lost_states;
+
+    /** Number of ticks simulated again in all rewinds. */
+    uint64_t m_resimulated_ticks;
+
+    // ------------------------------------------------------------------------
+    RewindBenchmark(int latency_ms, int loss_percent);
+    // ------------------------------------------------------------------------
+    ~RewindBenchmark();
+
+public:
+    // ------------------------------------------------------------------------
+    static void create(int latency_ms, int loss_percent);
+    // ------------------------------------------------------------------------
+    static void destroy();
+    // ------------------------------------------------------------------------
+    /** Returns if the rewind benchmark is running. */
+    static bool isEnabled()           { return m_rewind_benchmark != NULL; }
+    // ------------------------------------------------------------------------
+    /** Returns the singleton, only valid if isEnabled() is true. */
+    static RewindBenchmark* get()                { return m_rewind_benchmark; }
+    // ------------------------------------------------------------------------
+    void addState(int ticks, std::vector<std::string>& rewinder_using,
+                  std::vector<uint8_t>& buffer);
+    // ------------------------------------------------------------------------
+    void receiveStates(int world_ticks);
+    // ------------------------------------------------------------------------
+    /** Called after each rewind.
+     *  \param ticks Number of ticks simulated again.
+     *  \param time_us Time needed for the rewind in microseconds. */
+    void addRewind(int ticks, uint64_t time_us)
+    {
+        m_resimulated_ticks += ticks;
+        m_rewind_time.push_back(time_us);
+    }   // addRewind
+    // ------------------------------------------------------------------------
+    void report();
+};   // RewindBenchmark
+
+#endif
@@ -22,8 +22,44 @@
 #include "network/rewinder.hpp"
 #include "network/rewind_manager.hpp"
 #include "items/projectile_manager.hpp"
+#include "utils/block_pool.hpp"
 #include "utils/log.hpp"
 
+namespace
+{
+    /** Clients create and delete many small RewindInfo every tick (one event
+     *  for each kart action, states). 64 bytes are enough for
+     *  RewindInfoEvent and RewindInfoState. */
+    typedef BlockPool<64> RewindInfoPool;
+    // ------------------------------------------------------------------------
+    /** Never deleted, so RewindInfo can be freed during exit too. */
+    RewindInfoPool* getPool()
+    {
+        static RewindInfoPool* pool = new RewindInfoPool();
+        return pool;
+    }   // getPool
+}
+
+// ----------------------------------------------------------------------------
+/** Allocates RewindInfo from the pool if they fit into its blocks. */
+void* RewindInfo::operator new(size_t size)
+{
+    if (!RewindInfoPool::fits(size))
+        return ::operator new(size);
+    return getPool()->allocate();
+}   // operator new
+
+// ----------------------------------------------------------------------------
+void RewindInfo::operator delete(void* ptr, size_t size)
+{
+    if (!ptr)
+        return;
+    if (!RewindInfoPool::fits(size))
+        ::operator delete(ptr);
+    else
+        getPool()->free(ptr);
+}   // operator delete
+
 /** Constructor for a state: it only takes the size, and allocates a buffer
  *  for all state info.
  *  \param size Necessary buffer size for a state.
@@ -39,6 +39,8 @@
  *  and might be released (to save memory) differently: A state can be
  *  reproduced from a previous state by replaying the simulation taking
  *  all events into account.
+ *  Small RewindInfo objects are allocated from a pool, since many of them
+ *  are created and deleted each tick.
  */
 
 class RewindInfo
@@ -57,6 +59,9 @@ private:
 public:
     RewindInfo(int ticks, bool is_confirmed);
 
+    static void* operator new(size_t size);
+    static void  operator delete(void* ptr, size_t size);
+
     void setTicks(int ticks);
 
     /** Called when going back in time to undo any rewind information. */
@@ -114,6 +119,13 @@ public:
     /** Returns a pointer to the state buffer. */
     BareNetworkString *getBuffer() const { return m_buffer; }
     // ------------------------------------------------------------------------
+    /** Returns the unique identity of all rewinders in this state. */
+    const std::vector<std::string>& getRewinderUsing() const
+                                                   { return m_rewinder_using; }
+    // ------------------------------------------------------------------------
+    /** Returns the offset of the first rewinder data in the buffer. */
+    int getStartOffset() const                       { return m_start_offset; }
+    // ------------------------------------------------------------------------
     virtual bool isState() const { return true; }
     // ------------------------------------------------------------------------
     /** Called when going back in time to undo any rewind information.
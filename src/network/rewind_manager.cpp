@@ -23,6 +23,7 @@
 #include "network/network_config.hpp"
 #include "network/network_string.hpp"
 #include "network/protocols/game_protocol.hpp"
+#include "network/rewind_benchmark.hpp"
 #include "network/rewinder.hpp"
 #include "network/rewind_info.hpp"
 #include "network/smooth_network_body.hpp"
@@ -33,8 +34,10 @@
 #include "tracks/track_object_manager.hpp"
 #include "utils/log.hpp"
 #include "utils/profiler.hpp"
+#include "utils/time.hpp"
 
 #include <algorithm>
+#include <cstring>
 
 RewindManager* RewindManager::m_rewind_manager = NULL;
 bool           RewindManager::m_enable_rewind_manager = false;
@@ -86,6 +89,7 @@ void RewindManager::reset()
     m_state_frequency = stk_config->getPhysicsFPS() /
         NetworkConfig::get()->getStateFrequency();
 
+    m_predicted_state.clear();
     if (!m_enable_rewind_manager) return;
 
     clearExpiredRewinder();
@@ -199,12 +203,15 @@ void RewindManager::update(int ticks_not_used)
     clearExpiredRewinder();
     if (NetworkConfig::get()->isClient())
     {
+        if (RewindBenchmark::isEnabled())
+            saveBenchmarkState(ticks);
         auto& ret = m_local_state[ticks];
         for (auto& p : m_all_rewinder)
         {
             if (auto r = p.second.lock())
                 ret.push_back(r->getLocalStateRestoreFunction());
         }
+        savePredictedState(ticks);
     }
     else
     {
@@ -228,14 +235,31 @@ void RewindManager::playEventsTill(int world_ticks, bool fast_forward)
     // possible rewind, some RewindInfoEventFunction can be created during
     // rewind
     mergeRewindInfoEventFunction();
+    if (RewindBenchmark::isEnabled())
+        RewindBenchmark::get()->receiveStates(world_ticks);
     bool needs_rewind;
-    int rewind_ticks;
+    int rewind_ticks, past_event_ticks;
 
     // Merge in all network events that have happened at the current
     // time step.
     // merge and that have happened before the current time (which will
     // be getTime()+dt - world time has not been updated yet).
-    m_rewind_queue.mergeNetworkData(world_ticks, &needs_rewind, &rewind_ticks);
+    m_rewind_queue.mergeNetworkData(world_ticks, &needs_rewind, &rewind_ticks,
+                                    &past_event_ticks);
+
+    // Nothing to correct if the confirmed state is the same as the one
+    // predicted, unless events received now happened after that state (they
+    // are not part of the current simulation yet). Events up to the state
+    // time are part of the confirmed state, so any effect of them will be
+    // detected by the comparison. The benchmark always rewinds, a local
+    // replay is always predicted correctly.
+    if (needs_rewind && past_event_ticks <= rewind_ticks &&
+        !RewindBenchmark::isEnabled() &&
+        isPredictionCorrect(rewind_ticks))
+    {
+        needs_rewind = false;
+        clearSavedStates(rewind_ticks);
+    }
 
     if (needs_rewind)
     {
@@ -290,8 +314,12 @@ void RewindManager::rewindTo(int rewind_ticks, int now_ticks,
                              bool fast_forward)
 {
     assert(!m_is_rewinding);
+    const uint64_t start_time = StkTime::getMonoTimeUs();
     bool is_history = history->replayHistory();
     history->setReplayHistory(false);
+    // In the benchmark the inputs of the replayed history are not in the
+    // rewind queue, so they must be replayed from the history again.
+    const bool replay_history = is_history && RewindBenchmark::isEnabled();
 
     // First save all current transforms so that the error
     // can be computed between the transforms before and after
@@ -334,19 +362,19 @@ void RewindManager::rewindTo(int rewind_ticks, int now_ticks,
             if (restore_local_state)
                 restore_local_state();
         }
-        for (auto it = m_local_state.begin(); it != m_local_state.end();)
-        {
-            if (it->first <= exact_rewind_ticks)
-                it = m_local_state.erase(it);
-            else
-                break;
-        }
     }
     else if (!fast_forward)
     {
         Log::warn("RewindManager", "Missing local state at ticks %d",
             exact_rewind_ticks);
     }
+    clearSavedStates(exact_rewind_ticks);
+    if (replay_history)
+        history->rewindTo(exact_rewind_ticks);
+    // The predicted states after the rewind time are from the simulation
+    // before this rewind, they are saved again when replaying below.
+    if (fast_forward)
+        m_predicted_state.clear();
 
     // A loop in case that we should split states into several smaller ones:
     while (current && current->getTicks() == exact_rewind_ticks && 
@@ -372,7 +400,12 @@ void RewindManager::rewindTo(int rewind_ticks, int now_ticks,
     // Now go forward through the list of rewind infos till we reach 'now':
     while (world->getTicksSinceStart() < now_ticks)
     { 
-        m_rewind_queue.replayAllEvents(world->getTicksSinceStart());
+        const int ticks = world->getTicksSinceStart();
+        if (replay_history)
+            history->updateReplay(ticks);
+        m_rewind_queue.replayAllEvents(ticks);
+        if (!fast_forward && shouldSaveState(ticks))
+            savePredictedState(ticks);
 
         // Now simulate the next time step
         if (!fast_forward)
@@ -385,6 +418,10 @@ void RewindManager::rewindTo(int rewind_ticks, int now_ticks,
 
     }   // while (world->getTicks() < current_ticks)
 
+    // The inputs at the current time were replayed before the rewind
+    if (replay_history)
+        history->updateReplay(now_ticks);
+
     // Now compute the errors which need to be visually smoothed
     for (auto& p : m_all_rewinder)
     {
@@ -395,8 +432,127 @@ void RewindManager::rewindTo(int rewind_ticks, int now_ticks,
     history->setReplayHistory(is_history);
     m_is_rewinding = false;
     mergeRewindInfoEventFunction();
+    if (RewindBenchmark::isEnabled())
+    {
+        RewindBenchmark::get()->addRewind(now_ticks - exact_rewind_ticks,
+            StkTime::getMonoTimeUs() - start_time);
+    }
 }   // rewindTo
 
+// ----------------------------------------------------------------------------
+/** Saves the state which a server would send at the given time and passes
+ *  it to the rewind benchmark, which adds it later as confirmed state.
+ *  Saving the state also rounds the physics values, the same way a client
+ *  does at each state time.
+ *  \param ticks Current world time.
+ */
+void RewindManager::saveBenchmarkState(int ticks)
+{
+    std::vector<std::string> rewinder_using;
+    BareNetworkString state;
+    for (auto& p : m_all_rewinder)
+    {
+        auto r = p.second.lock();
+        BareNetworkString* buffer = r ? r->saveState(&rewinder_using) : NULL;
+        if (!buffer)
+            continue;
+        state.addUInt16(buffer->size());
+        state += *buffer;
+        delete buffer;
+    }
+    RewindBenchmark::get()->addState(ticks, rewinder_using,
+        state.getBuffer());
+}   // saveBenchmarkState
+
+// ----------------------------------------------------------------------------
+/** Saves the state predicted by each rewinder (if it supports it) at the
+ *  given time, which is then compared with the confirmed state from the
+ *  server in isPredictionCorrect. Only used on clients.
+ *  \param ticks Current world time.
+ */
+void RewindManager::savePredictedState(int ticks)
+{
+    std::map<std::string, std::vector<uint8_t> >& predicted =
+        m_predicted_state[ticks];
+    predicted.clear();
+    for (auto& p : m_all_rewinder)
+    {
+        auto r = p.second.lock();
+        if (!r)
+            continue;
+        BareNetworkString* buffer = r->savePredictedState();
+        if (!buffer)
+            continue;
+        std::swap(predicted[p.first], buffer->getBuffer());
+        delete buffer;
+    }
+}   // savePredictedState
+
+// ----------------------------------------------------------------------------
+/** Returns true if the latest confirmed state at the given time is identical
+ *  to the state predicted at the same time, i.e. the same rewinders with the
+ *  same data. Physics values are compared after rounding (which both server
+ *  and client do at each state time), which is the allowed tolerance. In
+ *  this case a rewind to this state would only reproduce the current state.
+ *  \param ticks Time of the confirmed state.
+ */
+bool RewindManager::isPredictionCorrect(int ticks)
+{
+    auto it = m_predicted_state.find(ticks);
+    if (it == m_predicted_state.end())
+        return false;
+    RewindInfoState* state = m_rewind_queue.getConfirmedState(ticks);
+    if (!state || !state->getBuffer())
+        return false;
+
+    const std::map<std::string, std::vector<uint8_t> >& predicted =
+        it->second;
+    const std::vector<std::string>& rewinder_using =
+        state->getRewinderUsing();
+    if (rewinder_using.size() != predicted.size())
+        return false;
+
+    BareNetworkString* buffer = state->getBuffer();
+    buffer->reset();
+    buffer->skip(state->getStartOffset());
+    try
+    {
+        for (const std::string& name : rewinder_using)
+        {
+            auto data = predicted.find(name);
+            if (data == predicted.end())
+                return false;
+            const uint16_t data_size = buffer->getUInt16();
+            if (data_size != data->second.size() ||
+                buffer->size() < data_size)
+                return false;
+            if (data_size > 0 && memcmp(buffer->getCurrentData(),
+                data->second.data(), data_size) != 0)
+                return false;
+            buffer->skip(data_size);
+        }
+    }
+    catch (std::exception&)
+    {
+        return false;
+    }
+    return true;
+}   // isPredictionCorrect
+
+// ----------------------------------------------------------------------------
+/** Deletes all locally saved and predicted states up to and including the
+ *  given time, they are not needed anymore once a confirmed state at this
+ *  time has been handled.
+ *  \param ticks Time of the confirmed state.
+ */
+void RewindManager::clearSavedStates(int ticks)
+{
+    m_local_state.erase(m_local_state.begin(),
+        m_local_state.upper_bound(ticks));
+    m_predicted_state.erase(m_predicted_state.begin(),
+        m_predicted_state.upper_bound(ticks));
+}   // clearSavedStates
+
 // ----------------------------------------------------------------------------
 bool RewindManager::useLocalEvent() const
 {
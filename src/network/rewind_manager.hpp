@@ -94,6 +94,11 @@ private:
 
     std::map<int, std::vector<std::function<void()> > > m_local_state;
 
+    /** The states predicted by a client (see Rewinder::savePredictedState)
+     *  for each state time, with the data of each rewinder. */
+    std::map<int, std::map<std::string, std::vector<uint8_t> > >
+        m_predicted_state;
+
     /** A list of all objects that can be rewound. */
     std::map<std::string, std::weak_ptr<Rewinder> > m_all_rewinder;
 
@@ -133,6 +138,14 @@ private:
     }
     // ------------------------------------------------------------------------
     void mergeRewindInfoEventFunction();
+    // ------------------------------------------------------------------------
+    void savePredictedState(int ticks);
+    // ------------------------------------------------------------------------
+    bool isPredictionCorrect(int ticks);
+    // ------------------------------------------------------------------------
+    void clearSavedStates(int ticks);
+    // ------------------------------------------------------------------------
+    void saveBenchmarkState(int ticks);
 
 public:
     // First static functions to manage rewinding.
@@ -22,12 +22,13 @@
 #include "utils/synchronised.hpp"
 
 #include <assert.h>
-#include <list>
+#include <limits>
 #include <vector>
 
 class BareNetworkString;
 class EventRewinder;
 class RewindInfo;
+class RewindInfoState;
 class TimeStepInfo;
 
 /** \ingroup network
@@ -36,10 +37,22 @@ class TimeStepInfo;
 class RewindQueue
 {
 private:
+    /** All RewindInfo of one tick: states first (the latest added state
+     *  being first), then events in the order they were added. */
+    typedef std::vector<RewindInfo*> TickRewindInfo;
 
-    typedef std::list<RewindInfo*> AllRewindInfo;
+    /** Ring buffer with one entry for each tick between m_first_ticks
+     *  (inclusive) and m_end_ticks (exclusive), indexed by ticks modulo the
+     *  size (which is always a power of 2). Entries outside of this range
+     *  are empty, and keep their allocated memory for the next ticks. */
+    std::vector<TickRewindInfo> m_ring;
 
-    AllRewindInfo m_all_rewind_info;
+    /** Oldest tick stored in m_ring. */
+    int m_first_ticks;
+
+    /** One more than the latest tick stored in m_ring. If equal to
+     *  m_first_ticks the ring is empty. */
+    int m_end_ticks;
 
     /** The list of all events received from the network. They are stored
      *  in a separate thread (so this data structure is thread-save), and
@@ -49,17 +62,35 @@ private:
     typedef std::vector<RewindInfo*> AllNetworkRewindInfo;
     Synchronised<AllNetworkRewindInfo> m_network_events;
 
-    /** Iterator to the curren time step info to be handled. */
-    AllRewindInfo::iterator m_current;
+    /** Ticks and index in the ticks of the current RewindInfo to be
+     *  handled. m_current_ticks is END_TICKS if all RewindInfo were
+     *  handled. */
+    int m_current_ticks;
+    unsigned m_current_index;
 
     /** Time at which the latest confirmed state is at. */
     int m_latest_confirmed_state_time;
 
+    static const int END_TICKS = std::numeric_limits<int>::max();
 
     void cleanupOldRewindInfo(int ticks);
+    void reserveTicks(int first_ticks, int end_ticks);
+    void skipEmptyTicks();
+    // ------------------------------------------------------------------------
+    /** Returns all RewindInfo at the given ticks. */
+    TickRewindInfo& getTickRewindInfo(int ticks)
+    {
+        return m_ring[(unsigned)ticks & (unsigned)(m_ring.size() - 1)];
+    }   // getTickRewindInfo
+    // ------------------------------------------------------------------------
+    const TickRewindInfo& getTickRewindInfo(int ticks) const
+    {
+        return m_ring[(unsigned)ticks & (unsigned)(m_ring.size() - 1)];
+    }   // getTickRewindInfo
 
 public:
         static void unitTesting();
+        static void benchmark();
 
          RewindQueue();
         ~RewindQueue();
@@ -77,7 +108,8 @@ public:
         m_network_events.unlock();
     }
     void mergeNetworkData(int world_ticks,  bool *needs_rewind, 
-                          int *rewind_ticks);
+                          int *rewind_ticks, int *past_event_ticks = NULL);
+    RewindInfoState* getConfirmedState(int ticks);
     void replayAllEvents(int ticks);
     bool isEmpty() const;
     bool hasMoreRewindInfo() const;
@@ -95,8 +127,9 @@ public:
      *  RewindInfo element. */
     void next()
     {
-        assert(m_current != m_all_rewind_info.end());
-        m_current++;
+        assert(m_current_ticks != END_TICKS);
+        m_current_index++;
+        skipEmptyTicks();
         return;
     }   // operator++
 
@@ -105,7 +138,8 @@ public:
      *  least one more RewindInfo (see hasMoreRewindInfo()). */
     RewindInfo* getCurrent()
     {
-        return (m_current != m_all_rewind_info.end() ) ? *m_current : NULL;
+        return m_current_ticks != END_TICKS ?
+            getTickRewindInfo(m_current_ticks)[m_current_index] : NULL;
     }   // getNext
 
 };   // RewindQueue
@@ -106,6 +106,14 @@ public:
     virtual std::function<void()> getLocalStateRestoreFunction()
                                                              { return nullptr; }
     // -------------------------------------------------------------------------
+    /** Called on a client when a state is saved locally. Returns the state
+     *  which the server is expected to send for this rewinder at this time
+     *  (in the same format as saveState), so that a rewind can be skipped if
+     *  the confirmed state is identical. It must not change the rewinder.
+     *  The default NULL means the state can't be predicted, so any confirmed
+     *  state including this rewinder will cause a rewind. */
+    virtual BareNetworkString* savePredictedState()             { return NULL; }
+    // -------------------------------------------------------------------------
     const std::string& getUniqueIdentity() const
     {
         assert(!m_unique_identity.empty() && m_unique_identity.size() < 255);
@@ -327,6 +327,14 @@ namespace ServerConfig
         "more rewind, which clients with slow device may have problem playing "
         "this server, use the default value is recommended."));
 
+    SERVER_CFG_PREFIX IntServerConfigParam m_encryption_threads
+        SERVER_CFG_DEFAULT(IntServerConfigParam(0,
+        "encryption-threads",
+        "Number of extra threads used to encrypt game states and events sent "
+        "to all players in parallel, 0 to encrypt them in the thread sending "
+        "them. Increase this for servers with many players on a multi-core "
+        "cpu."));
+
     SERVER_CFG_PREFIX BoolServerConfigParam m_sql_management
         SERVER_CFG_DEFAULT(BoolServerConfigParam(false,
         "sql-management",
@@ -391,6 +399,12 @@ namespace ServerConfig
         "network-ai=x, which will kick N - 1 bot(s) where N is the number "
         "of human players. Only use this for non-GP racing server."));
 
+    SERVER_CFG_PREFIX BoolServerConfigParam m_cache_track_bvh
+        SERVER_CFG_DEFAULT(BoolServerConfigParam(true, "cache-track-bvh",
+        "Cache the collision tree of each played track on disk, which makes "
+        "loading the track again faster. It needs up to tens of MB of disk "
+        "space for each track, one file per track."));
+
     // ========================================================================
     /** Server version, will be advanced if there are protocol changes. */
     static const uint32_t m_server_version = 6;
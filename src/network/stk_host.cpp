@@ -22,6 +22,7 @@
 #include "config/user_config.hpp"
 #include "io/file_manager.hpp"
 #include "network/event.hpp"
+#include "network/crypto.hpp"
 #include "network/game_setup.hpp"
 #include "network/network_config.hpp"
 #include "network/network_console.hpp"
@@ -39,6 +40,7 @@
 #include "utils/log.hpp"
 #include "utils/separate_process.hpp"
 #include "utils/string_utils.hpp"
+#include "utils/thread_pool.hpp"
 #include "utils/time.hpp"
 #include "utils/vs.hpp"
 
@@ -273,6 +275,11 @@ STKHost::STKHost(bool server)
         m_network = new Network(peer_count,
             /*channel_limit*/EVENT_CHANNEL_COUNT, /*max_in_bandwidth*/0,
             /*max_out_bandwidth*/ 0, &addr, true/*change_port_if_bound*/);
+        if (ServerConfig::m_encryption_threads > 0)
+        {
+            m_encryption_pool.reset(new ThreadPool(
+                ServerConfig::m_encryption_threads, "EncryptPackets"));
+        }
     }
     else
     {
@@ -856,6 +863,7 @@ void STKHost::stopListening()
 {
     if (m_exit_timeout.load() == std::numeric_limits<uint64_t>::max())
         m_exit_timeout.store(0);
+    m_network_waiter.notify();
     if (m_listening_thread.joinable())
         m_listening_thread.join();
 }   // stopListening
@@ -898,6 +906,13 @@ void STKHost::mainLoop()
         }
     }
 
+    // If possible wait for packets and enet commands with the network
+    // waiter, so commands are executed immediately. Otherwise only
+    // enet_host_service can wait (for packets only).
+    const bool use_waiter = m_network_waiter.addSocket(host->socket) &&
+        (!direct_socket || m_network_waiter
+        .addSocket(direct_socket->getENetHost()->socket));
+
     uint64_t last_ping_time = StkTime::getMonoTimeMs();
     uint64_t last_update_speed_time = StkTime::getMonoTimeMs();
     uint64_t last_ping_time_update_for_client = StkTime::getMonoTimeMs();
@@ -1120,7 +1135,7 @@ void STKHost::mainLoop()
         }
 
         bool need_ping_update = false;
-        while (enet_host_service(host, &event, 10) != 0)
+        while (enet_host_service(host, &event, use_waiter ? 0 : 10) != 0)
         {
             auto lp = LobbyProtocol::get<LobbyProtocol>();
             if (!is_server &&
@@ -1288,6 +1303,17 @@ void STKHost::mainLoop()
             else
                 delete stk_event;
         }   // while enet_host_service
+
+        // A server without peers only needs to wake up for new packets
+        if (use_waiter)
+        {
+            bool no_peers;
+            {
+                std::lock_guard<std::mutex> lock(m_peers_mutex);
+                no_peers = m_peers.empty();
+            }
+            m_network_waiter.wait(is_server && no_peers ? 100 : 10);
+        }
     }   // while m_exit_timeout.load() > StkTime::getMonoTimeMs()
     delete direct_socket;
     Log::info("STKHost", "Listening has been stopped.");
@@ -1423,6 +1449,93 @@ bool STKHost::isConnectedTo(const TransportAddress& peer)
     return false;
 }   // isConnectedTo
 
+//-----------------------------------------------------------------------------
+/** Sends the same data to a list of peers. The data is only read, so if
+ *  \ref m_encryption_pool exists the packets of all peers are encrypted in
+ *  parallel. The packets are queued in the order of the peers after all are
+ *  created, so that the order of packets to each peer is unchanged.
+ *  \param peers Peers to send data to.
+ *  \param data Data to sent.
+ *  \param reliable If the data should be sent reliable or now.
+ */
+void STKHost::sendPacketToPeers(const std::vector<STKPeer*>& peers,
+                                NetworkString *data, bool reliable)
+{
+    if (!m_encryption_pool || peers.size() < 2)
+    {
+        for (STKPeer* peer : peers)
+            peer->sendPacket(data, reliable);
+        return;
+    }
+
+    std::vector<ENetPacket*> packets(peers.size(), NULL);
+    m_encryption_pool->parallelFor((unsigned)peers.size(),
+        [&peers, &packets, data, reliable](unsigned i)
+        {
+            packets[i] = peers[i]->createPacket(data, reliable,
+                /*encrypted*/true);
+        });
+    for (unsigned i = 0; i < peers.size(); i++)
+    {
+        if (packets[i])
+            peers[i]->queuePacket(packets[i], /*encrypted*/true);
+    }
+}   // sendPacketToPeers
+
+//-----------------------------------------------------------------------------
+/** Measures the time spent by the sending thread to encrypt one game state
+ *  for 1 to 64 peers, with and without \ref m_encryption_pool.
+ */
+void STKHost::benchmark()
+{
+    const unsigned threads =
+        std::max(2u, std::thread::hardware_concurrency()) - 1;
+    ThreadPool pool(threads, "EncryptPackets");
+    std::mt19937 g(1);
+    // A typical state of a race with 16 karts
+    NetworkString state(PROTOCOL_CONTROLLER_EVENTS, 1200);
+    for (unsigned i = 0; i < 1200; i++)
+        state.addUInt8((uint8_t)g());
+
+    const unsigned repeat = 200;
+    for (unsigned peers = 1; peers <= 64; peers *= 2)
+    {
+        std::vector<std::unique_ptr<Crypto> > cryptos;
+        for (unsigned i = 0; i < peers; i++)
+        {
+            std::vector<uint8_t> key(16), iv(12);
+            for (uint8_t& k : key)
+                k = (uint8_t)g();
+            for (uint8_t& v : iv)
+                v = (uint8_t)g();
+            cryptos.emplace_back(new Crypto(key, iv));
+        }
+        std::vector<ENetPacket*> packets(peers, NULL);
+        uint64_t serial_us = 0, pool_us = 0;
+        for (unsigned r = 0; r < repeat; r++)
+        {
+            uint64_t start = StkTime::getMonoTimeUs();
+            for (unsigned i = 0; i < peers; i++)
+                packets[i] = cryptos[i]->encryptSend(state, false);
+            serial_us += StkTime::getMonoTimeUs() - start;
+            for (ENetPacket* p : packets)
+                enet_packet_destroy(p);
+
+            start = StkTime::getMonoTimeUs();
+            pool.parallelFor(peers, [&cryptos, &packets, &state](unsigned i)
+                {
+                    packets[i] = cryptos[i]->encryptSend(state, false);
+                });
+            pool_us += StkTime::getMonoTimeUs() - start;
+            for (ENetPacket* p : packets)
+                enet_packet_destroy(p);
+        }
+        Log::info("Benchmark", "Broadcast to %2d peers: %7.2f us serial, "
+            "%7.2f us with %d encryption threads.", peers,
+            (double)serial_us / repeat, (double)pool_us / repeat, threads);
+    }
+}   // benchmark
+
 //-----------------------------------------------------------------------------
 /** Sends data to all validated peers currently in server
  *  \param data Data to sent.
@@ -1431,11 +1544,13 @@ bool STKHost::isConnectedTo(const TransportAddress& peer)
 void STKHost::sendPacketToAllPeersInServer(NetworkString *data, bool reliable)
 {
     std::lock_guard<std::mutex> lock(m_peers_mutex);
+    std::vector<STKPeer*> peers;
     for (auto p : m_peers)
     {
         if (p.second->isValidated())
-            p.second->sendPacket(data, reliable);
+            peers.push_back(p.second.get());
     }
+    sendPacketToPeers(peers, data, reliable);
 }   // sendPacketToAllPeersInServer
 
 //-----------------------------------------------------------------------------
@@ -1446,11 +1561,13 @@ void STKHost::sendPacketToAllPeersInServer(NetworkString *data, bool reliable)
 void STKHost::sendPacketToAllPeers(NetworkString *data, bool reliable)
 {
     std::lock_guard<std::mutex> lock(m_peers_mutex);
+    std::vector<STKPeer*> peers;
     for (auto p : m_peers)
     {
         if (p.second->isValidated() && !p.second->isWaitingForGame())
-            p.second->sendPacket(data, reliable);
+            peers.push_back(p.second.get());
     }
+    sendPacketToPeers(peers, data, reliable);
 }   // sendPacketToAllPeers
 
 //-----------------------------------------------------------------------------
@@ -1463,15 +1580,17 @@ void STKHost::sendPacketExcept(STKPeer* peer, NetworkString *data,
                                bool reliable)
 {
     std::lock_guard<std::mutex> lock(m_peers_mutex);
+    std::vector<STKPeer*> peers;
     for (auto p : m_peers)
     {
         STKPeer* stk_peer = p.second.get();
         if (!stk_peer->isSamePeer(peer) && p.second->isValidated() &&
             !p.second->isWaitingForGame())
         {
-            stk_peer->sendPacket(data, reliable);
+            peers.push_back(stk_peer);
         }
     }
+    sendPacketToPeers(peers, data, reliable);
 }   // sendPacketExcept
 
 //-----------------------------------------------------------------------------
@@ -1484,14 +1603,16 @@ void STKHost::sendPacketToAllPeersWith(std::function<bool(STKPeer*)> predicate,
                                        NetworkString* data, bool reliable)
 {
     std::lock_guard<std::mutex> lock(m_peers_mutex);
+    std::vector<STKPeer*> peers;
     for (auto p : m_peers)
     {
         STKPeer* stk_peer = p.second.get();
         if (!stk_peer->isValidated())
             continue;
         if (predicate(stk_peer))
-            stk_peer->sendPacket(data, reliable);
+            peers.push_back(stk_peer);
     }
+    sendPacketToPeers(peers, data, reliable);
 }   // sendPacketToAllPeersWith
 
 //-----------------------------------------------------------------------------
@@ -24,6 +24,7 @@
 
 #include "network/network.hpp"
 #include "network/network_string.hpp"
+#include "network/network_waiter.hpp"
 #include "network/transport_address.hpp"
 #include "utils/synchronised.hpp"
 #include "utils/time.hpp"
@@ -54,6 +55,8 @@ class NetworkTimerSynchronizer;
 class Server;
 class ServerLobby;
 class SeparateProcess;
+class STKPeer;
+class ThreadPool;
 
 enum ENetCommandType : unsigned int
 {
@@ -100,6 +103,10 @@ private:
     /** Protect \ref m_enet_cmd from multiple threads usage. */
     std::mutex m_enet_cmd_mutex;
 
+    /** Used by the listening thread to wait for packets and enet commands
+     *  from other threads. */
+    NetworkWaiter m_network_waiter;
+
     /** The list of peers connected to this instance. */
     std::map<ENetPeer*, std::shared_ptr<STKPeer> > m_peers;
 
@@ -159,6 +166,10 @@ private:
 
     std::unique_ptr<NetworkTimerSynchronizer> m_nts;
 
+    /** Worker threads used by server to encrypt packets sent to many peers
+     *  in parallel, NULL if encrypting in the sending thread. */
+    std::unique_ptr<ThreadPool> m_encryption_pool;
+
     // ------------------------------------------------------------------------
     STKHost(bool server);
     // ------------------------------------------------------------------------
@@ -172,6 +183,9 @@ private:
     // ------------------------------------------------------------------------
     void mainLoop();
     // ------------------------------------------------------------------------
+    void sendPacketToPeers(const std::vector<STKPeer*>& peers,
+                           NetworkString *data, bool reliable);
+    // ------------------------------------------------------------------------
     std::string getIPFromStun(int socket, const std::string& stun_address,
                               bool ipv4);
 public:
@@ -200,6 +214,8 @@ public:
     /** Checks if the STKHost has been created. */
     static bool existHost() { return m_stk_host != NULL; }
     // ------------------------------------------------------------------------
+    static void benchmark();
+    // ------------------------------------------------------------------------
     const TransportAddress& getPublicAddress() const
                                                    { return m_public_address; }
     // ------------------------------------------------------------------------
@@ -278,8 +294,10 @@ public:
     void addEnetCommand(ENetPeer* peer, ENetPacket* packet, uint32_t i,
                         ENetCommandType ect)
     {
-        std::lock_guard<std::mutex> lock(m_enet_cmd_mutex);
+        std::unique_lock<std::mutex> lock(m_enet_cmd_mutex);
         m_enet_cmd.emplace_back(peer, packet, i, ect);
+        lock.unlock();
+        m_network_waiter.notify();
     }
     // ------------------------------------------------------------------------
     /** Returns the last error (or "" if no error has happened). */
@@ -107,15 +107,33 @@ void STKPeer::reset()
  *  \param encrypted If the data is sent encrypted or not.
  */
 void STKPeer::sendPacket(NetworkString *data, bool reliable, bool encrypted)
+{
+    ENetPacket* packet = createPacket(data, reliable, encrypted);
+    if (packet)
+        queuePacket(packet, encrypted);
+}   // sendPacket
+
+//-----------------------------------------------------------------------------
+/** Creates the (encrypted if needed) enet packet of some data for this host,
+ *  without sending it. This only reads the data, so it can be called for
+ *  different peers with the same data from different threads, see
+ *  STKHost::sendPacketToPeers.
+ *  \param data The data to send.
+ *  \param reliable If the data is sent reliable or not.
+ *  \param encrypted If the data is sent encrypted or not.
+ *  \return The packet, or NULL if this peer is not connected anymore.
+ */
+ENetPacket* STKPeer::createPacket(NetworkString *data, bool reliable,
+                                  bool encrypted)
 {
     if (m_disconnected.load())
-        return;
+        return NULL;
     TransportAddress a(m_enet_peer->address);
     // Enet will reuse a disconnected peer so we check here to avoid sending
     // to wrong peer
     if (m_enet_peer->state != ENET_PEER_STATE_CONNECTED ||
         a != m_peer_address)
-        return;
+        return NULL;
 
     ENetPacket* packet = NULL;
     if (m_crypto && encrypted)
@@ -130,20 +148,28 @@ void STKPeer::sendPacket(NetworkString *data, bool reliable, bool encrypted)
             (ENET_PACKET_FLAG_UNSEQUENCED |
             ENET_PACKET_FLAG_UNRELIABLE_FRAGMENT)));
     }
+    return packet;
+}   // createPacket
 
-    if (packet)
+//-----------------------------------------------------------------------------
+/** Hands a packet created by createPacket to the listening thread of STKHost
+ *  which will send it.
+ *  \param packet The packet to send, STKHost takes ownership of it.
+ *  \param encrypted If the data was created encrypted or not.
+ */
+void STKPeer::queuePacket(ENetPacket* packet, bool encrypted)
+{
+    if (Network::m_connection_debug)
     {
-        if (Network::m_connection_debug)
-        {
-            Log::verbose("STKPeer", "sending packet of size %d to %s at %lf",
-                packet->dataLength, a.toString().c_str(),
-                StkTime::getRealTime());
-        }
-        m_host->addEnetCommand(m_enet_peer, packet,
-                encrypted ? EVENT_CHANNEL_NORMAL : EVENT_CHANNEL_UNENCRYPTED,
-                ECT_SEND_PACKET);
+        TransportAddress a(m_enet_peer->address);
+        Log::verbose("STKPeer", "sending packet of size %d to %s at %lf",
+            packet->dataLength, a.toString().c_str(),
+            StkTime::getRealTime());
     }
-}   // sendPacket
+    m_host->addEnetCommand(m_enet_peer, packet,
+        encrypted ? EVENT_CHANNEL_NORMAL : EVENT_CHANNEL_UNENCRYPTED,
+        ECT_SEND_PACKET);
+}   // queuePacket
 
 //-----------------------------------------------------------------------------
 /** Returns if the peer is connected or not.
@@ -0,0 +1,56 @@
+//
+//  SuperTuxKart - a fun racing game with go-kart
+//  Copyright (C) 2019 SuperTuxKart-Team
+//
+//  This program is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU General Public License
+//  as published by the Free Software Foundation; either version 3
+//  of the License, or (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+
+#include "physics/benchmark_terrain.hpp"
+
+#include <cmath>
+
+/** Creates the terrain.
+ *  \param size Length of the sides of the terrain.
+ *  \param grid Length of the sides of the quads the terrain is made of.
+ */
+BenchmarkTerrain::BenchmarkTerrain(float size, float grid)
+{
+    const int n = (int)(size / grid);
+    for (int i = 0; i < n; i++)
+    {
+        for (int j = 0; j < n; j++)
+        {
+            const float x0 = i * grid, x1 = x0 + grid;
+            const float z0 = j * grid, z1 = z0 + grid;
+            const btVector3 a(x0, getHeight(x0, z0), z0);
+            const btVector3 b(x1, getHeight(x1, z0), z0);
+            const btVector3 c(x1, getHeight(x1, z1), z1);
+            const btVector3 d(x0, getHeight(x0, z1), z1);
+            m_mesh.addTriangle(a, c, b);
+            m_mesh.addTriangle(a, d, c);
+        }
+    }
+    m_shape.reset(new btBvhTriangleMeshShape(&m_mesh,
+                              false /* useQuantizedAabbCompression */));
+}   // BenchmarkTerrain
+
+// ----------------------------------------------------------------------------
+/** Returns the height of the terrain at the given point: long hills with
+ *  small bumps on them.
+ */
+float BenchmarkTerrain::getHeight(float x, float z)
+{
+    return 3.0f * sinf(x * 0.05f) * cosf(z * 0.07f) +
+           0.3f * sinf(x * 0.9f + z * 0.7f);
+}   // getHeight
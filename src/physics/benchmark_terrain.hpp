@@ -0,0 +1,50 @@
+//
+//  SuperTuxKart - a fun racing game with go-kart
+//  Copyright (C) 2019 SuperTuxKart-Team
+//
+//  This program is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU General Public License
+//  as published by the Free Software Foundation; either version 3
+//  of the License, or (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+
+#ifndef HEADER_BENCHMARK_TERRAIN_HPP
+#define HEADER_BENCHMARK_TERRAIN_HPP
+
+#include "utils/no_copy.hpp"
+
+#include "btBulletDynamicsCommon.h"
+
+#include <memory>
+
+/** A hilly square triangle mesh starting at (0, 0, 0), used as track by the
+ *  physics benchmarks.
+ */
+class BenchmarkTerrain : public NoCopy
+{
+private:
+    btTriangleMesh m_mesh;
+
+    std::unique_ptr<btBvhTriangleMeshShape> m_shape;
+
+public:
+    BenchmarkTerrain(float size, float grid);
+    // ------------------------------------------------------------------------
+    static float getHeight(float x, float z);
+    // ------------------------------------------------------------------------
+    /** Returns the collision shape of the terrain. */
+    btBvhTriangleMeshShape *getShape() { return m_shape.get(); }
+    // ------------------------------------------------------------------------
+    /** Returns the number of triangles of the terrain. */
+    int getNumTriangles() const { return m_mesh.getNumTriangles(); }
+};   // BenchmarkTerrain
+
+#endif
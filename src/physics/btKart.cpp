@@ -42,7 +42,7 @@ btRigidBody& btKart::getFixedBody()
 }
 
 // ============================================================================
-btKart::btKart(btRigidBody* chassis, btVehicleRaycaster* raycaster,
+btKart::btKart(btRigidBody* chassis, btKartRaycaster* raycaster,
                Kart *kart)
       : m_vehicleRaycaster(raycaster)
 {
@@ -228,6 +228,30 @@ void btKart::updateAllWheelTransformsWS()
     // Simulate suspension
     // -------------------
 
+    // Cast the rays of all wheels as one packet. A wheel which doesn't touch
+    // the ground casts a second ray (see below), so the packet box contains
+    // the rays for both fractions used in rayCast().
+    btVector3 packet_min = chassisTrans.getOrigin();
+    btVector3 packet_max = chassisTrans.getOrigin();
+    for (int i=0;i<m_wheelInfo.size();i++)
+    {
+        const btWheelInfo &wheel = m_wheelInfo[i];
+        const btScalar raylen = wheel.getSuspensionRestLength()
+                              + wheel.m_maxSuspensionTravel + 0.5f;
+        const btVector3 rayvector = (chassisTrans.getBasis()
+                                  * wheel.m_wheelDirectionCS) * raylen;
+        for (float fraction : {1.0f, 0.95f})
+        {
+            const btVector3 source =
+                chassisTrans(wheel.m_chassisConnectionPointCS*fraction);
+            packet_min.setMin(source);
+            packet_min.setMin(source + rayvector);
+            packet_max.setMax(source);
+            packet_max.setMax(source + rayvector);
+        }
+    }
+    m_vehicleRaycaster->beginPacket(packet_min, packet_max);
+
     m_num_wheels_on_ground       = 0;
     m_visual_wheels_touch_ground = true;
     for (int i=0;i<m_wheelInfo.size();i++)
@@ -246,6 +270,7 @@ void btKart::updateAllWheelTransformsWS()
                 m_num_wheels_on_ground++;
         }
     }
+    m_vehicleRaycaster->endPacket();
 }   // updateAllWheelTransformsWS
 
 // ----------------------------------------------------------------------------
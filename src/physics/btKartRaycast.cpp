@@ -12,12 +12,319 @@
 #include "LinearMath/btVector3.h"
 #include "btKartRaycast.hpp"
 
+#include "BulletCollision/BroadphaseCollision/btAxisSweep3.h"
+#include "BulletCollision/BroadphaseCollision/btDbvtBroadphase.h"
+#include "BulletCollision/CollisionDispatch/btCollisionDispatcher.h"
 #include "BulletCollision/CollisionDispatch/btCollisionWorld.h"
+#include "BulletCollision/CollisionDispatch/btDefaultCollisionConfiguration.h"
+#include "BulletCollision/CollisionShapes/btBoxShape.h"
+#include "BulletCollision/CollisionShapes/btBvhTriangleMeshShape.h"
+#include "BulletCollision/CollisionShapes/btOptimizedBvh.h"
+#include "BulletCollision/CollisionShapes/btTriangleMesh.h"
+#include "BulletCollision/NarrowPhaseCollision/btRaycastCallback.h"
+#include "BulletDynamics/ConstraintSolver/btSequentialImpulseConstraintSolver.h"
+#include "BulletDynamics/Dynamics/btDiscreteDynamicsWorld.h"
 #include "BulletDynamics/Dynamics/btDynamicsWorld.h"
+#include "LinearMath/btAabbUtil2.h"
 
+#include "config/user_config.hpp"
 #include "modes/world.hpp"
+#include "physics/benchmark_terrain.hpp"
 #include "physics/triangle_mesh.hpp"
 #include "tracks/track.hpp"
+#include "utils/log.hpp"
+#include "utils/time.hpp"
+
+#include <cstring>
+#include <random>
+
+// ----------------------------------------------------------------------------
+/** Prepares casting several rays inside of the given box (usually the
+ *  suspension rays of all wheels of a kart): the broadphase is queried once
+ *  for all objects overlapping the box, and the bvh trees of triangle
+ *  meshes are walked once to collect the triangles in the box. The following
+ *  calls to castRay() with a ray inside of the box only test these objects
+ *  and triangles, in the same order and with the same tests that a single
+ *  raycast would use, so the results are identical. Each kart has its own
+ *  raycaster, so packets of different karts don't share any data.
+ *  \param aabb_min Minimum of the box containing all rays of the packet.
+ *  \param aabb_max Maximum of the box containing all rays of the packet.
+ */
+void btKartRaycaster::beginPacket(const btVector3 &aabb_min,
+                                  const btVector3 &aabb_max)
+{
+    m_packet_active = false;
+    if (!UserConfigParams::m_raycast_packets)
+        return;
+
+    // ========================================================================
+    class ProxyCallback : public btBroadphaseAabbCallback
+    {
+    private:
+        btAlignedObjectArray<const btBroadphaseProxy*> *m_proxies;
+    public:
+        ProxyCallback(btAlignedObjectArray<const btBroadphaseProxy*> *p)
+            : m_proxies(p) {}
+        // --------------------------------------------------------------------
+        virtual bool process(const btBroadphaseProxy* proxy)
+        {
+            m_proxies->push_back(proxy);
+            return true;
+        }
+    };   // ProxyCallback
+    // ========================================================================
+
+    // A ray that just touches the box of an object or triangle can be hit
+    // because of rounding errors, so the objects and triangles are searched
+    // in a slightly bigger box.
+    const btVector3 margin(0.1f, 0.1f, 0.1f);
+    const btVector3 query_min = aabb_min - margin;
+    const btVector3 query_max = aabb_max + margin;
+
+    btBroadphaseInterface *broadphase = m_dynamicsWorld->getBroadphase();
+    m_packet_proxies.resize(0);
+    ProxyCallback callback(&m_packet_proxies);
+    // The tree of btDbvtBroadphase (or the ray accelerator of btAxisSweep3)
+    // is walked in the same order as in btDbvtBroadphase::rayTest()
+    broadphase->aabbTest(query_min, query_max, callback);
+
+    const bool is_dbvt = dynamic_cast<btDbvtBroadphase*>(broadphase) != NULL;
+    m_packet_objects.resize(0);
+    m_packet_triangles.resize(0);
+    for (int i = 0; i < m_packet_proxies.size(); i++)
+    {
+        const btBroadphaseProxy *proxy = m_packet_proxies[i];
+        btCollisionObject *object = (btCollisionObject*)proxy->m_clientObject;
+        // A btAxisSweep3 without ray accelerator tests all objects in each
+        // raycast, which can't be done with a packet.
+        if (proxy == object->getBroadphaseHandle() && !is_dbvt)
+            return;
+        const btDbvtNode *leaf = ((const btDbvtProxy*)proxy)->leaf;
+        PacketObject &po = m_packet_objects.expandNonInitializing();
+        po.m_object         = object;
+        po.m_bounds[0]      = leaf->volume.Mins();
+        po.m_bounds[1]      = leaf->volume.Maxs();
+        po.m_first_triangle = -1;
+        po.m_last_triangle  = -1;
+        if (object->getCollisionShape()->getShapeType() ==
+            TRIANGLE_MESH_SHAPE_PROXYTYPE)
+            addPacketTriangles(&po, query_min, query_max);
+    }
+    m_packet_min    = aabb_min;
+    m_packet_max    = aabb_max;
+    m_packet_active = true;
+}   // beginPacket
+
+// ----------------------------------------------------------------------------
+/** Adds the triangles of a bvh triangle mesh which are in the given box
+ *  to m_packet_triangles, in the order of btQuantizedBvh::walkStacklessTree.
+ *  Quantized trees are not supported (STK doesn't use them), for those
+ *  each ray in the packet uses the normal raycast.
+ *  \param po The packet object of the triangle mesh.
+ *  \param aabb_min Minimum of the box in world coordinates.
+ *  \param aabb_max Maximum of the box in world coordinates.
+ */
+void btKartRaycaster::addPacketTriangles(PacketObject *po,
+                                         const btVector3 &aabb_min,
+                                         const btVector3 &aabb_max)
+{
+    btBvhTriangleMeshShape *mesh =
+        (btBvhTriangleMeshShape*)po->m_object->getCollisionShape();
+    btOptimizedBvh *bvh = mesh->getOptimizedBvh();
+    if (!bvh || bvh->isQuantized())
+        return;
+
+    btVector3 local_min, local_max;
+    btTransformAabb(aabb_min, aabb_max, 0.0f,
+                    po->m_object->getWorldTransform().inverse(),
+                    local_min, local_max);
+
+    const btStridingMeshInterface *mesh_interface = mesh->getMeshInterface();
+    const btVector3 &scaling = mesh_interface->getScaling();
+    const btAlignedObjectArray<btOptimizedBvhNode> &nodes =
+        bvh->getContiguousNodeArray();
+    po->m_first_triangle = m_packet_triangles.size();
+    int index = 0;
+    while (index < bvh->getNumContiguousNodes())
+    {
+        const btOptimizedBvhNode &node = nodes[index];
+        const bool overlap = TestAabbAgainstAabb2(local_min, local_max,
+                                                  node.m_aabbMinOrg,
+                                                  node.m_aabbMaxOrg);
+        const bool is_leaf = node.m_escapeIndex == -1;
+        if (is_leaf && overlap)
+        {
+            // Same as btBvhTriangleMeshShape::performRaycast()
+            const unsigned char *vertex_base, *index_base;
+            int num_verts, stride, index_stride, num_faces;
+            PHY_ScalarType type, index_type;
+            mesh_interface->getLockedReadOnlyVertexIndexBase(&vertex_base,
+                num_verts, type, stride, &index_base, index_stride,
+                num_faces, index_type, node.m_subPart);
+            const unsigned int *gfx_base = (const unsigned int*)
+                (index_base + node.m_triangleIndex*index_stride);
+
+            PacketTriangle &pt = m_packet_triangles.expandNonInitializing();
+            for (int j = 2; j >= 0; j--)
+            {
+                const int vertex = index_type == PHY_SHORT
+                                 ? ((const unsigned short*)gfx_base)[j]
+                                 : gfx_base[j];
+                if (type == PHY_FLOAT)
+                {
+                    const float *v = (const float*)(vertex_base+vertex*stride);
+                    pt.m_vertices[j] = btVector3(v[0]*scaling.getX(),
+                                                 v[1]*scaling.getY(),
+                                                 v[2]*scaling.getZ());
+                }
+                else
+                {
+                    const double *v =
+                        (const double*)(vertex_base+vertex*stride);
+                    pt.m_vertices[j] =
+                        btVector3(btScalar(v[0])*scaling.getX(),
+                                  btScalar(v[1])*scaling.getY(),
+                                  btScalar(v[2])*scaling.getZ());
+                }
+            }
+            pt.m_bounds[0] = node.m_aabbMinOrg;
+            pt.m_bounds[1] = node.m_aabbMaxOrg;
+            pt.m_part      = node.m_subPart;
+            pt.m_index     = node.m_triangleIndex;
+            mesh_interface->unLockReadOnlyVertexBase(node.m_subPart);
+        }
+        index += overlap || is_leaf ? 1 : node.m_escapeIndex;
+    }
+    po->m_last_triangle = m_packet_triangles.size();
+}   // addPacketTriangles
+
+// ----------------------------------------------------------------------------
+/** Casts a ray against the objects and triangles of the current packet.
+ *  This does the same as btCollisionWorld::rayTest(), except that the
+ *  broadphase and bvh trees are not walked again.
+ *  \param from Start of the ray, must be inside of the packet box.
+ *  \param to End of the ray, must be inside of the packet box.
+ *  \param callback The callback receiving the hits.
+ */
+void btKartRaycaster::castPacketRay(const btVector3 &from, const btVector3 &to,
+                          btCollisionWorld::RayResultCallback &callback) const
+{
+    // ========================================================================
+    /** Same as BridgeTriangleRaycastCallback in rayTestSingle(). */
+    class TriangleCallback : public btTriangleRaycastCallback
+    {
+    private:
+        btCollisionWorld::RayResultCallback *m_result_callback;
+        btCollisionObject                   *m_object;
+        btTransform                          m_object_transform;
+    public:
+        TriangleCallback(const btVector3 &from, const btVector3 &to,
+                         btCollisionWorld::RayResultCallback *callback,
+                         btCollisionObject *object)
+            : btTriangleRaycastCallback(from, to, callback->m_flags),
+              m_result_callback(callback), m_object(object),
+              m_object_transform(object->getWorldTransform())
+        {
+        }   // TriangleCallback
+        // --------------------------------------------------------------------
+        virtual btScalar reportHit(const btVector3 &hit_normal_local,
+                                   btScalar hit_fraction, int part_id,
+                                   int triangle_index)
+        {
+            btCollisionWorld::LocalShapeInfo shape_info;
+            shape_info.m_shapePart     = part_id;
+            shape_info.m_triangleIndex = triangle_index;
+            btVector3 hit_normal_world =
+                m_object_transform.getBasis() * hit_normal_local;
+            btCollisionWorld::LocalRayResult ray_result(m_object, &shape_info,
+                                                        hit_normal_world,
+                                                        hit_fraction);
+            return m_result_callback->addSingleResult(ray_result, true);
+        }   // reportHit
+    };   // TriangleCallback
+    // ========================================================================
+
+    // Computes the values used by btRayAabb2, as in btSingleRayCallback
+    auto ray_setup = [](const btVector3 &from, const btVector3 &to,
+                        btVector3 *inverse, unsigned int signs[3])
+    {
+        btVector3 dir = to - from;
+        dir.normalize();
+        for (int i = 0; i < 3; i++)
+        {
+            (*inverse)[i] = dir[i] == btScalar(0.0) ? btScalar(BT_LARGE_FLOAT)
+                                                    : btScalar(1.0) / dir[i];
+            signs[i] = (*inverse)[i] < 0.0;
+        }
+        return dir.dot(to - from);
+    };
+
+    btTransform from_trans, to_trans;
+    from_trans.setIdentity();
+    from_trans.setOrigin(from);
+    to_trans.setIdentity();
+    to_trans.setOrigin(to);
+    btVector3 inverse;
+    unsigned int signs[3];
+    const btScalar lambda_max = ray_setup(from, to, &inverse, signs);
+
+    for (int i = 0; i < m_packet_objects.size(); i++)
+    {
+        const PacketObject &po = m_packet_objects[i];
+        // Skip the objects which btDbvt::rayTestInternal() would not report
+        btScalar tmin = 1.0f;
+        if (!btRayAabb2(from, inverse, signs, po.m_bounds, tmin, 0.0f,
+                        lambda_max))
+            continue;
+        // Filters of btSingleRayCallback::process()
+        if (callback.m_closestHitFraction == btScalar(0.f))
+            return;
+        if (!callback.needsCollision(po.m_object->getBroadphaseHandle()))
+            continue;
+        if (po.m_first_triangle < 0)
+        {
+            btCollisionWorld::rayTestSingle(from_trans, to_trans, po.m_object,
+                                            po.m_object->getCollisionShape(),
+                                            po.m_object->getWorldTransform(),
+                                            callback);
+            continue;
+        }
+
+        // Same as rayTestSingle() for a btBvhTriangleMeshShape, and the
+        // leaf node tests of btQuantizedBvh::walkStacklessTreeAgainstRay()
+        const btTransform world_to_object =
+            po.m_object->getWorldTransform().inverse();
+        const btVector3 from_local = world_to_object * from;
+        const btVector3 to_local   = world_to_object * to;
+        TriangleCallback triangle_callback(from_local, to_local, &callback,
+                                           po.m_object);
+        triangle_callback.m_hitFraction = callback.m_closestHitFraction;
+
+        btVector3 ray_min = from_local, ray_max = from_local;
+        ray_min.setMin(to_local);
+        ray_max.setMax(to_local);
+        btVector3 inverse_local;
+        unsigned int signs_local[3];
+        const btScalar lambda_max_local =
+            ray_setup(from_local, to_local, &inverse_local, signs_local);
+        for (int j = po.m_first_triangle; j < po.m_last_triangle; j++)
+        {
+            const PacketTriangle &pt = m_packet_triangles[j];
+            btScalar param = 1.0f;
+            if (!TestAabbAgainstAabb2(ray_min, ray_max, pt.m_bounds[0],
+                                      pt.m_bounds[1]) ||
+                !btRayAabb2(from_local, inverse_local, signs_local,
+                            pt.m_bounds, param, 0.0f, lambda_max_local))
+                continue;
+            btVector3 triangle[3] = { pt.m_vertices[0], pt.m_vertices[1],
+                                      pt.m_vertices[2] };
+            triangle_callback.processTriangle(triangle, pt.m_part,
+                                              pt.m_index);
+        }
+    }
+}   // castPacketRay
+
+// ----------------------------------------------------------------------------
 
 void* btKartRaycaster::castRay(const btVector3& from, const btVector3& to,
                                btVehicleRaycasterResult& result)
@@ -59,7 +366,48 @@ void* btKartRaycaster::castRay(const btVector3& from, const btVector3& to,
 
     ClosestWithNormal rayCallback(from,to);
 
-    m_dynamicsWorld->rayTest(from, to, rayCallback);
+    if (m_packet_active &&
+        from.getX() >= m_packet_min.getX() && to.getX() >= m_packet_min.getX() &&
+        from.getY() >= m_packet_min.getY() && to.getY() >= m_packet_min.getY() &&
+        from.getZ() >= m_packet_min.getZ() && to.getZ() >= m_packet_min.getZ() &&
+        from.getX() <= m_packet_max.getX() && to.getX() <= m_packet_max.getX() &&
+        from.getY() <= m_packet_max.getY() && to.getY() <= m_packet_max.getY() &&
+        from.getZ() <= m_packet_max.getZ() && to.getZ() <= m_packet_max.getZ())
+    {
+        castPacketRay(from, to, rayCallback);
+        if (UserConfigParams::m_check_raycasts)
+        {
+            ClosestWithNormal single(from, to);
+            m_dynamicsWorld->rayTest(from, to, single);
+            auto same = [](const btScalar *a, const btScalar *b, int n)
+            {
+                return memcmp(a, b, n * sizeof(btScalar)) == 0;
+            };
+            if (rayCallback.m_collisionObject != single.m_collisionObject ||
+                rayCallback.getTriangleIndex() != single.getTriangleIndex() ||
+                !same(&rayCallback.m_closestHitFraction,
+                      &single.m_closestHitFraction, 1) ||
+                (single.hasHit() &&
+                 (!same(rayCallback.m_hitPointWorld,
+                        single.m_hitPointWorld, 3) ||
+                  !same(rayCallback.m_hitNormalWorld,
+                        single.m_hitNormalWorld, 3)    )  )         )
+            {
+                Log::error("btKartRaycaster",
+                    "Packet raycast from %f %f %f to %f %f %f differs: "
+                    "fraction %.9g instead of %.9g, triangle %d instead "
+                    "of %d.", from.getX(), from.getY(), from.getZ(),
+                    to.getX(), to.getY(), to.getZ(),
+                    rayCallback.m_closestHitFraction,
+                    single.m_closestHitFraction,
+                    rayCallback.getTriangleIndex(),
+                    single.getTriangleIndex());
+                rayCallback = single;
+            }
+        }
+    }
+    else
+        m_dynamicsWorld->rayTest(from, to, rayCallback);
 
     if (rayCallback.hasHit())
     {
@@ -107,3 +455,179 @@ void* btKartRaycaster::castRay(const btVector3& from, const btVector3& to,
     return 0;
 }
 
+
+// ----------------------------------------------------------------------------
+/** Compares casting the suspension rays of 16, 32 and 64 karts on a hilly
+ *  triangle mesh one by one with casting them as one packet per kart, and
+ *  checks that both give bit-identical results. Some karts are in the air,
+ *  so that their wheels cast a second ray (see btKart::rayCast).
+ */
+void btKartRaycaster::benchmark()
+{
+    btDefaultCollisionConfiguration configuration;
+    btCollisionDispatcher dispatcher(&configuration);
+    const float size = 400.0f;
+    const float grid = 1.5f;
+    btAxisSweep3 broadphase(btVector3(-10.0f, -20.0f, -10.0f),
+                            btVector3(size + 10.0f, 20.0f, size + 10.0f));
+    btSequentialImpulseConstraintSolver solver;
+    btDiscreteDynamicsWorld world(&dispatcher, &broadphase, &solver,
+                                  &configuration);
+
+    BenchmarkTerrain terrain(size, grid);
+    btRigidBody track(btRigidBody::btRigidBodyConstructionInfo(0.0f, NULL,
+                                                         terrain.getShape()));
+    world.addRigidBody(&track);
+
+    btBoxShape chassis_shape(btVector3(0.6f, 0.3f, 1.0f));
+    const btVector3 wheels[4] = { btVector3( 0.5f, 0.0f,  0.8f),
+                                  btVector3(-0.5f, 0.0f,  0.8f),
+                                  btVector3( 0.5f, 0.0f, -0.8f),
+                                  btVector3(-0.5f, 0.0f, -0.8f) };
+    const float fractions[2] = { 1.0f, 0.95f };
+    const btVector3 direction(0.0f, -1.0f, 0.0f);
+    const float ray_length = 1.0f;
+    const unsigned num_ticks = 500;
+
+    std::mt19937 random(1);
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+    btKartRaycaster raycaster(&world);
+    const bool packets = UserConfigParams::m_raycast_packets;
+    UserConfigParams::m_raycast_packets = true;
+
+    for (unsigned num_karts = 16; num_karts <= 64; num_karts *= 2)
+    {
+        std::vector<btRigidBody*> karts;
+        std::vector<float> heading;
+        for (unsigned k = 0; k < num_karts; k++)
+        {
+            btRigidBody::btRigidBodyConstructionInfo info(1.0f, NULL,
+                                                          &chassis_shape);
+            karts.push_back(new btRigidBody(info));
+            world.addRigidBody(karts.back());
+            heading.push_back(unit(random) * 6.283f);
+        }
+        // Start all karts in a small area, so that they hit each other
+        for (unsigned k = 0; k < num_karts; k++)
+        {
+            btTransform t(btQuaternion(btVector3(0, 1, 0), heading[k]),
+                          btVector3(100.0f + 30.0f * unit(random), 0.0f,
+                                    100.0f + 30.0f * unit(random)));
+            karts[k]->setWorldTransform(t);
+        }
+
+        uint64_t single_us = 0, packet_us = 0;
+        unsigned num_rays = 0, num_hits = 0, mismatches = 0;
+        std::vector<btVehicleRaycasterResult> results[2];
+        std::vector<void*> objects[2];
+        for (unsigned tick = 0; tick < num_ticks; tick++)
+        {
+            for (unsigned k = 0; k < num_karts; k++)
+            {
+                btTransform t = karts[k]->getWorldTransform();
+                btVector3 xyz = t.getOrigin() +
+                    t.getBasis() * btVector3(0.0f, 0.0f, 0.5f);
+                xyz.setX(btFmod(xyz.getX() + size, size - 10.0f));
+                xyz.setZ(btFmod(xyz.getZ() + size, size - 10.0f));
+                // Every 8th kart is jumping
+                const float air = k % 8 == 0 ? 2.0f * unit(random) : 0.0f;
+                xyz.setY(BenchmarkTerrain::getHeight(xyz.getX(), xyz.getZ()) +
+                         0.5f + air);
+                t.setOrigin(xyz);
+                t.setRotation(btQuaternion(btVector3(0, 1, 0), heading[k]) *
+                    btQuaternion(btVector3(1, 0, 0), 0.2f*unit(random)-0.1f));
+                karts[k]->setWorldTransform(t);
+            }
+            world.updateAabbs();
+
+            for (int p = 0; p < 2; p++)
+            {
+                results[p].clear();
+                objects[p].clear();
+                uint64_t start = StkTime::getMonoTimeUs();
+                for (unsigned k = 0; k < num_karts; k++)
+                {
+                    const btTransform &t = karts[k]->getWorldTransform();
+                    const btVector3 ray = (t.getBasis() * direction) *
+                                          ray_length;
+                    btBroadphaseProxy *proxy = karts[k]->getBroadphaseHandle();
+                    const short int old_group = proxy->m_collisionFilterGroup;
+                    proxy->m_collisionFilterGroup = 0;
+                    if (p == 1)
+                    {
+                        btVector3 packet_min = t.getOrigin();
+                        btVector3 packet_max = t.getOrigin();
+                        for (unsigned w = 0; w < 4; w++)
+                        {
+                            for (float fraction : fractions)
+                            {
+                                const btVector3 from = t(wheels[w]*fraction);
+                                packet_min.setMin(from);
+                                packet_min.setMin(from + ray);
+                                packet_max.setMax(from);
+                                packet_max.setMax(from + ray);
+                            }
+                        }
+                        raycaster.beginPacket(packet_min, packet_max);
+                    }
+                    for (unsigned w = 0; w < 4; w++)
+                    {
+                        for (float fraction : fractions)
+                        {
+                            const btVector3 from = t(wheels[w] * fraction);
+                            results[p].push_back(btVehicleRaycasterResult());
+                            objects[p].push_back(raycaster.castRay(from,
+                                from + ray, results[p].back()));
+                            if (objects[p].back())
+                                break;
+                        }
+                    }
+                    if (p == 1)
+                        raycaster.endPacket();
+                    proxy->m_collisionFilterGroup = old_group;
+                }
+                (p == 0 ? single_us : packet_us) +=
+                    StkTime::getMonoTimeUs() - start;
+            }
+
+            num_rays += (unsigned)objects[0].size();
+            if (objects[0].size() != objects[1].size())
+            {
+                mismatches++;
+                continue;
+            }
+            for (unsigned i = 0; i < objects[0].size(); i++)
+            {
+                const btVehicleRaycasterResult &r0 = results[0][i];
+                const btVehicleRaycasterResult &r1 = results[1][i];
+                num_hits += objects[0][i] != NULL;
+                if (objects[0][i] != objects[1][i] ||
+                    (objects[0][i] &&
+                     (r0.m_triangle_index != r1.m_triangle_index ||
+                      memcmp(&r0.m_distFraction, &r1.m_distFraction,
+                             sizeof(btScalar)) != 0 ||
+                      memcmp(&r0.m_hitPointInWorld[0],
+                             &r1.m_hitPointInWorld[0],
+                             3 * sizeof(btScalar)) != 0 ||
+                      memcmp(&r0.m_hitNormalInWorld[0],
+                             &r1.m_hitNormalInWorld[0],
+                             3 * sizeof(btScalar)) != 0)))
+                    mismatches++;
+            }
+        }
+
+        Log::info("Benchmark", "%u karts, %d triangles: single raycasts "
+            "%.2f us per tick, packets %.2f us per tick, %u rays, %u hits, "
+            "%u mismatches.", num_karts, terrain.getNumTriangles(),
+            (float)single_us / num_ticks, (float)packet_us / num_ticks,
+            num_rays, num_hits, mismatches);
+
+        for (btRigidBody *kart : karts)
+        {
+            world.removeRigidBody(kart);
+            delete kart;
+        }
+    }
+    world.removeRigidBody(&track);
+    UserConfigParams::m_raycast_packets = packets;
+}   // benchmark
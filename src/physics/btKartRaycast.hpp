@@ -18,24 +18,80 @@ class btDynamicsWorld;
 #include "LinearMath/btAlignedObjectArray.h"
 #include "BulletDynamics/Vehicle/btWheelInfo.h"
 #include "BulletDynamics/Dynamics/btActionInterface.h"
+#include "BulletCollision/CollisionDispatch/btCollisionWorld.h"
 
 
 class btKartRaycaster : public btVehicleRaycaster
 {
 private:
+    /** An object that can be hit by a ray of the current packet. */
+    struct PacketObject
+    {
+        /** The volume of the object in the ray test tree of the broadphase,
+         *  which decides if a single raycast tests this object. */
+        btVector3          m_bounds[2];
+        btCollisionObject *m_object;
+        /** For a bvh triangle mesh the first and one past the last index of
+         *  its triangles in m_packet_triangles, otherwise -1. */
+        int                m_first_triangle;
+        int                m_last_triangle;
+    };   // PacketObject
+
+    // ------------------------------------------------------------------------
+    /** A triangle of a triangle mesh close to the rays of the packet. */
+    struct PacketTriangle
+    {
+        btVector3 m_vertices[3];
+        /** The bounding box of the bvh leaf node of this triangle. */
+        btVector3 m_bounds[2];
+        int       m_part;
+        int       m_index;
+    };   // PacketTriangle
+
+    // ------------------------------------------------------------------------
     btDynamicsWorld*    m_dynamicsWorld;
     /** True if the normals should be smoothed. Not all tracks support this,
     *  so this flag is set depending on track when constructing this object. */
     bool                m_smooth_normals;
+
+    /** True between beginPacket() and endPacket() if the packet could be
+     *  prepared. */
+    bool                m_packet_active;
+
+    /** Rays inside of this box are cast against the packet. */
+    btVector3           m_packet_min;
+    btVector3           m_packet_max;
+
+    /** The objects overlapping the packet, in the order in which a single
+     *  raycast would test them. */
+    btAlignedObjectArray<PacketObject>   m_packet_objects;
+
+    /** The triangles of all triangle meshes in m_packet_objects, in the
+     *  order of their bvh trees. */
+    btAlignedObjectArray<PacketTriangle> m_packet_triangles;
+
+    /** Used by beginPacket() to collect the broadphase proxies. */
+    btAlignedObjectArray<const btBroadphaseProxy*> m_packet_proxies;
+
+    void addPacketTriangles(PacketObject *po, const btVector3 &aabb_min,
+                            const btVector3 &aabb_max);
+    void castPacketRay(const btVector3 &from, const btVector3 &to,
+                       btCollisionWorld::RayResultCallback &callback) const;
 public:
     btKartRaycaster(btDynamicsWorld* world, bool smooth_normals=false)
-        :m_dynamicsWorld(world), m_smooth_normals(smooth_normals)
+        :m_dynamicsWorld(world), m_smooth_normals(smooth_normals),
+         m_packet_active(false)
     {
     }
 
     virtual void* castRay(const btVector3& from,const btVector3& to,
                           btVehicleRaycasterResult& result);
-
+    void beginPacket(const btVector3 &aabb_min, const btVector3 &aabb_max);
+    // ------------------------------------------------------------------------
+    /** Ends a packet, following raycasts are done one by one again. */
+    void endPacket() { m_packet_active = false; }
+    // ------------------------------------------------------------------------
+    static void benchmark();
 };
 
 
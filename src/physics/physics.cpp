@@ -36,6 +36,7 @@
 #include "physics/btKart.hpp"
 #include "physics/irr_debug_drawer.hpp"
 #include "physics/physical_object.hpp"
+#include "physics/stk_collision_dispatcher.hpp"
 #include "physics/stk_dynamics_world.hpp"
 #include "physics/triangle_mesh.hpp"
 #include "race/race_manager.hpp"
@@ -43,6 +44,7 @@
 #include "tracks/track.hpp"
 #include "tracks/track_object.hpp"
 #include "utils/profiler.hpp"
+#include "utils/thread_pool.hpp"
 
 // ----------------------------------------------------------------------------
 /** Initialise physics.
@@ -51,7 +53,7 @@
 Physics::Physics() : btSequentialImpulseConstraintSolver()
 {
     m_collision_conf      = new btDefaultCollisionConfiguration();
-    m_dispatcher          = new btCollisionDispatcher(m_collision_conf);
+    m_dispatcher          = new STKCollisionDispatcher(m_collision_conf);
 }   // Physics
 
 //-----------------------------------------------------------------------------
@@ -68,6 +70,18 @@ void Physics::init(const Vec3 &world_min, const Vec3 &world_max)
                                                  this,
                                                  m_collision_conf);
     m_karts_to_delete.clear();
+
+    // The result doesn't depend on the number of threads, so this is
+    // only a matter of speed
+    m_thread_pool.reset();
+    if (UserConfigParams::m_physics_threads > 0)
+    {
+        m_thread_pool.reset(new ThreadPool(UserConfigParams::m_physics_threads,
+                                           "Physics"));
+    }
+    m_dispatcher->setThreadPool(m_thread_pool.get());
+    m_dynamics_world->setThreadPool(m_thread_pool.get());
+
     m_dynamics_world->setGravity(
         btVector3(0.0f,
                   -Track::getCurrentTrack()->getGravity(),
@@ -526,7 +540,8 @@ void Physics::KartKartCollision(AbstractKart *kart_a,
 }   // KartKartCollision
 
 //-----------------------------------------------------------------------------
-/** This function is called at each internal bullet timestep. It is used
+/** This function is called at each internal bullet timestep, after all
+ *  simulation islands are solved. It is used
  *  here to do the collision handling: using the contact manifolds after a
  *  physics time step might miss some collisions (when more than one internal
  *  time step was done, and the collision is added and removed). So this
@@ -534,26 +549,13 @@ void Physics::KartKartCollision(AbstractKart *kart_a,
  *  actual physics timestep. This list only stores a collision if it's not
  *  already in the list, so a collisions which is reported more than once is
  *  nevertheless only handled once.
- *  The list of collision
+ *  The islands can be solved by several threads (see STKDynamicsWorld), so
+ *  the manifolds are only checked once here, and not for each solved group.
  *  Parameters: see bullet documentation for details.
  */
-btScalar Physics::solveGroup(btCollisionObject** bodies, int numBodies,
-                             btPersistentManifold** manifold,int numManifolds,
-                             btTypedConstraint** constraints,
-                             int numConstraints,
-                             const btContactSolverInfo& info,
-                             btIDebugDraw* debugDrawer,
-                             btStackAlloc* stackAlloc,
-                             btDispatcher* dispatcher)
+void Physics::allSolved(const btContactSolverInfo& info,
+                        btIDebugDraw* debugDrawer, btStackAlloc* stackAlloc)
 {
-    btScalar returnValue=
-        btSequentialImpulseConstraintSolver::solveGroup(bodies, numBodies,
-                                                        manifold, numManifolds,
-                                                        constraints,
-                                                        numConstraints, info,
-                                                        debugDrawer,
-                                                        stackAlloc,
-                                                        dispatcher);
     int currentNumManifolds = m_dispatcher->getNumManifolds();
     // We can't explode a rocket in a loop, since a rocket might collide with
     // more than one object, and/or more than once with each object (if there
@@ -725,9 +727,7 @@ btScalar Physics::solveGroup(btCollisionObject** bodies, int numBodies,
         else
             assert("Unknown user pointer");           // 4) Should never happen
     }   // for i<numManifolds
-
-    return returnValue;
-}   // solveGroup
+}   // allSolved
 
 // ----------------------------------------------------------------------------
 /** A debug draw function to show the track and all karts.
@@ -24,6 +24,7 @@
   * Contains various physics utilities.
   */
 
+#include <memory>
 #include <set>
 #include <vector>
 
@@ -35,7 +36,9 @@
 #include "utils/singleton.hpp"
 
 class AbstractKart;
+class STKCollisionDispatcher;
 class STKDynamicsWorld;
+class ThreadPool;
 class Vec3;
 
 /**
@@ -144,11 +147,14 @@ private:
     /** Used in physics debugging to draw the physics world. */
     IrrDebugDrawer                  *m_debug_drawer;
 
-    btCollisionDispatcher           *m_dispatcher;
+    STKCollisionDispatcher          *m_dispatcher;
     btBroadphaseInterface           *m_axis_sweep;
     btDefaultCollisionConfiguration *m_collision_conf;
     CollisionList                    m_all_collisions;
 
+    /** The threads used to step the physics, NULL if it's done serially. */
+    std::unique_ptr<ThreadPool>      m_thread_pool;
+
     /** Singleton. */
     static Physics                  *m_physics;
 
@@ -177,12 +183,9 @@ public:
     /** Returns true if the debug drawer is enabled. */
     bool  isDebug() const     {return m_debug_drawer->debugEnabled(); }
     IrrDebugDrawer* getDebugDrawer() { return m_debug_drawer; }
-    virtual btScalar solveGroup(btCollisionObject** bodies, int numBodies,
-                                btPersistentManifold** manifold,int numManifolds,
-                                btTypedConstraint** constraints,int numConstraints,
-                                const btContactSolverInfo& info,
-                                btIDebugDraw* debugDrawer, btStackAlloc* stackAlloc,
-                                btDispatcher* dispatcher);
+    virtual void allSolved(const btContactSolverInfo& info,
+                           btIDebugDraw* debugDrawer,
+                           btStackAlloc* stackAlloc);
 };
 
 #endif // HEADER_PHYSICS_HPP
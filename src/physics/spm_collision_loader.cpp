@@ -0,0 +1,267 @@
+//
+//  SuperTuxKart - a fun racing game with go-kart
+//  Copyright (C) 2019 SuperTuxKart-Team
+//
+//  This program is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU General Public License
+//  as published by the Free Software Foundation; either version 3
+//  of the License, or (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+
+
+#include "physics/spm_collision_loader.hpp"
+
+#include "graphics/material_manager.hpp"
+#include "io/file_manager.hpp"
+#include "utils/constants.hpp"
+#include "utils/log.hpp"
+#include "utils/mini_glm.hpp"
+
+#include <IFileSystem.h>
+#include <IReadFile.h>
+#include <plane3d.h>
+
+#include <cstring>
+
+namespace
+{
+    /** Bounds checked reading of the content of a spm file. */
+    class SPMReader
+    {
+    private:
+        const std::vector<uint8_t> &m_data;
+        size_t m_pos;
+        bool m_ok;
+    public:
+        SPMReader(const std::vector<uint8_t> &data)
+            : m_data(data), m_pos(0), m_ok(true) {}
+        // --------------------------------------------------------------------
+        void read(void *dest, size_t size)
+        {
+            if (!m_ok || m_data.size() - m_pos < size)
+            {
+                m_ok = false;
+                memset(dest, 0, size);
+                return;
+            }
+            memcpy(dest, m_data.data() + m_pos, size);
+            m_pos += size;
+        }   // read
+        // --------------------------------------------------------------------
+        void skip(size_t size)
+        {
+            if (!m_ok || m_data.size() - m_pos < size)
+                m_ok = false;
+            else
+                m_pos += size;
+        }   // skip
+        // --------------------------------------------------------------------
+        std::string readString()
+        {
+            uint8_t size = 0;
+            read(&size, 1);
+            std::string s(size, 0);
+            if (size > 0)
+                read(&s[0], size);
+            return s;
+        }   // readString
+        // --------------------------------------------------------------------
+        bool ok() const { return m_ok; }
+    };   // SPMReader
+
+    // ------------------------------------------------------------------------
+    /** Returns the absolute path of the texture SPMeshLoader and
+     *  STKTexManager would use for a texture name of a spm file (which is
+     *  the name of the texture in the mesh buffer), or an empty string if
+     *  no texture would be found.
+     */
+    std::string getTexturePath(const std::string &base_path,
+                               const std::string &name)
+    {
+        if (name.empty())
+            return "";
+        io::IFileSystem *fs = file_manager->getFileSystem();
+        std::string path = name;
+        const std::string full_path = base_path + "/" + name;
+        if (fs->existFile(full_path.c_str()))
+            path = full_path;
+        if (path.find('/') == std::string::npos)
+        {
+            // See STKTexManager::findTextureInFileSystem
+            path = file_manager->searchTexture(path);
+            if (path.empty())
+                return "";
+        }
+        return fs->getAbsolutePath(path.c_str()).c_str();
+    }   // getTexturePath
+}   // namespace
+
+// ----------------------------------------------------------------------------
+/** Reads the mesh buffers of a spm file. Only static meshes are supported,
+ *  for other files (including animated spm files) false is returned, and
+ *  the file must be loaded as an irrlicht mesh.
+ *  \param filename Full path of the spm file.
+ *  \param buffers On return the mesh buffers of the file.
+ *  \return True if the file was read.
+ */
+bool SPMCollisionLoader::load(const std::string &filename,
+                              std::vector<Buffer> *buffers)
+{
+    buffers->clear();
+    if (!IS_LITTLE_ENDIAN ||
+        !core::hasFileExtension(filename.c_str(), "spm"))
+        return false;
+
+    io::IFileSystem *fs = file_manager->getFileSystem();
+    io::IReadFile *file = fs->createAndOpenFile(filename.c_str());
+    if (!file)
+        return false;
+    std::vector<uint8_t> data(file->getSize());
+    const bool read_all = data.empty() ||
+        file->read(data.data(), (u32)data.size()) == (s32)data.size();
+    const std::string base_path =
+        fs->getFileDir(file->getFileName()).c_str();
+    file->drop();
+    if (!read_all)
+        return false;
+
+    SPMReader spm(data);
+    char header[2] = {};
+    spm.read(header, 2);
+    uint8_t byte = 0;
+    spm.read(&byte, 1);
+    // Version 1 of a normal (not space partitioned, not animated) mesh, see
+    // SPMeshLoader::createMesh
+    if (header[0] != 'S' || header[1] != 'P' || byte >> 3 != 1)
+        return false;
+    byte &= ~0x08;
+    if (byte == 0 || byte == 1)
+        return false;
+    spm.read(&byte, 1);
+    const bool read_normal  = (byte & 0x01) != 0;
+    const bool read_vcolor  = (byte >> 1 & 0x01) != 0;
+    const bool read_tangent = (byte >> 2 & 0x01) != 0;
+    // Bounding box
+    spm.skip(24);
+
+    struct SPMMaterial
+    {
+        const Material *m_material;
+        bool m_uv_one, m_uv_two;
+    };
+    std::vector<SPMMaterial> materials;
+    uint16_t size_num = 0;
+    spm.read(&size_num, 2);
+    for (unsigned i = 0; i < size_num && spm.ok(); i++)
+    {
+        const std::string tex_name_1 = spm.readString();
+        const std::string tex_name_2 = spm.readString();
+        // A mesh buffer without first texture doesn't get a texture at all,
+        // and then uses the default material
+        std::string t1_full_path = getTexturePath(base_path, tex_name_1);
+        std::string t2_full_path = t1_full_path.empty() ? "" :
+            getTexturePath(base_path, tex_name_2);
+        SPMMaterial m;
+        m.m_material = material_manager->getMaterialSPM(t1_full_path,
+                                                        t2_full_path);
+        m.m_uv_one = !tex_name_1.empty();
+        m.m_uv_two = !tex_name_2.empty();
+        materials.push_back(m);
+    }
+
+    spm.read(&size_num, 2);
+    for (unsigned i = 0; i < size_num && spm.ok(); i++)
+    {
+        uint16_t mat_size = 0;
+        spm.read(&mat_size, 2);
+        for (unsigned j = 0; j < mat_size && spm.ok(); j++)
+        {
+            uint32_t vertices_count = 0, indices_count = 0;
+            uint16_t mat_id = 0;
+            spm.read(&vertices_count, 4);
+            spm.read(&indices_count, 4);
+            spm.read(&mat_id, 2);
+            if (vertices_count > 65535 || mat_id >= materials.size())
+                return false;
+            const SPMMaterial &m = materials[mat_id];
+            buffers->push_back(Buffer());
+            Buffer &b = buffers->back();
+            b.m_material = m.m_material;
+            b.m_positions.resize(vertices_count);
+            b.m_normals.resize(vertices_count, core::vector3df(0, 0, 0));
+            for (unsigned v = 0; v < vertices_count; v++)
+            {
+                spm.read(&b.m_positions[v], 12);
+                if (read_normal)
+                {
+                    uint32_t packed = 0;
+                    spm.read(&packed, 4);
+                    b.m_normals[v] = MiniGLM::decompressVector3(packed);
+                }
+                if (read_vcolor)
+                {
+                    uint8_t ci = 0;
+                    spm.read(&ci, 1);
+                    // 128 means white, otherwise r, g, b follow
+                    if (ci != 128)
+                        spm.skip(3);
+                }
+                if (m.m_uv_one)
+                {
+                    spm.skip(m.m_uv_two ? 8 : 4);
+                    if (read_tangent)
+                        spm.skip(4);
+                }
+            }
+            b.m_indices.resize(indices_count);
+            if (vertices_count > 255)
+            {
+                if (indices_count > 0)
+                    spm.read(b.m_indices.data(), indices_count * 2);
+            }
+            else
+            {
+                std::vector<uint8_t> tmp_idx(indices_count);
+                if (indices_count > 0)
+                    spm.read(tmp_idx.data(), indices_count);
+                for (unsigned k = 0; k < indices_count; k++)
+                    b.m_indices[k] = tmp_idx[k];
+            }
+            for (unsigned k = 0; k < indices_count; k++)
+            {
+                if (b.m_indices[k] >= vertices_count)
+                    return false;
+            }
+            if (!read_normal)
+            {
+                // Same as SPMeshLoader::decompress
+                for (unsigned k = 0; k + 2 < indices_count; k += 3)
+                {
+                    core::plane3df p(b.m_positions[b.m_indices[k]],
+                                     b.m_positions[b.m_indices[k + 1]],
+                                     b.m_positions[b.m_indices[k + 2]]);
+                    b.m_normals[b.m_indices[k]] += p.Normal;
+                    b.m_normals[b.m_indices[k + 1]] += p.Normal;
+                    b.m_normals[b.m_indices[k + 2]] += p.Normal;
+                }
+                for (unsigned v = 0; v < vertices_count; v++)
+                    b.m_normals[v].normalize();
+            }
+        }
+    }
+    if (!spm.ok())
+    {
+        Log::warn("SPMCollisionLoader", "File '%s' is truncated.",
+                  filename.c_str());
+        return false;
+    }
+    return true;
+}   // load
@@ -0,0 +1,60 @@
+//
+//  SuperTuxKart - a fun racing game with go-kart
+//  Copyright (C) 2019 SuperTuxKart-Team
+//
+//  This program is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU General Public License
+//  as published by the Free Software Foundation; either version 3
+//  of the License, or (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+
+
+#ifndef HEADER_SPM_COLLISION_LOADER_HPP
+#define HEADER_SPM_COLLISION_LOADER_HPP
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <vector3d.h>
+
+using namespace irr;
+
+class Material;
+
+/**
+  * \ingroup physics
+  * Reads only the collision geometry of a static spm file: the positions,
+  * normals and indices of each mesh buffer together with its material.
+  * Colors, texture coordinates and tangents are skipped, and neither an
+  * irrlicht mesh nor textures are created. The vertex data and the
+  * materials are the same that SPMeshLoader creates without shader based
+  * rendering (i.e. on a server), so that converting them into a
+  * TriangleMesh gives the same triangles as Track::convertTrackToBullet.
+  */
+class SPMCollisionLoader
+{
+public:
+    /** The geometry of one mesh buffer. */
+    struct Buffer
+    {
+        /** The material of this buffer, see MaterialManager::getMaterialSPM. */
+        const Material              *m_material;
+        std::vector<core::vector3df> m_positions;
+        std::vector<core::vector3df> m_normals;
+        std::vector<uint16_t>        m_indices;
+    };   // Buffer
+
+    static bool load(const std::string &filename,
+                     std::vector<Buffer> *buffers);
+};   // SPMCollisionLoader
+
+#endif
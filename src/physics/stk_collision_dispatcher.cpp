@@ -0,0 +1,313 @@
+//
+//  SuperTuxKart - a fun racing game with go-kart
+//  Copyright (C) 2019 SuperTuxKart-Team
+//
+//  This program is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU General Public License
+//  as published by the Free Software Foundation; either version 3
+//  of the License, or (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+
+#include "physics/stk_collision_dispatcher.hpp"
+
+#include "utils/thread_pool.hpp"
+
+#include <algorithm>
+#include <assert.h>
+
+namespace
+{
+    /** The pair which is processed by the current thread, used to record
+     *  the manifold events of this pair. */
+    thread_local int g_current_pair = -1;
+
+    // ------------------------------------------------------------------------
+    /** Collects all overlapping pairs which need collision. */
+    class PairCollector : public btOverlapCallback
+    {
+    private:
+        btCollisionDispatcher          *m_dispatcher;
+        std::vector<btBroadphasePair*> *m_pairs;
+    public:
+        PairCollector(btCollisionDispatcher *dispatcher,
+                      std::vector<btBroadphasePair*> *pairs)
+            : m_dispatcher(dispatcher), m_pairs(pairs)
+        {
+        }
+        // --------------------------------------------------------------------
+        virtual bool processOverlap(btBroadphasePair &pair)
+        {
+            btCollisionObject *object_0 =
+                (btCollisionObject*)pair.m_pProxy0->m_clientObject;
+            btCollisionObject *object_1 =
+                (btCollisionObject*)pair.m_pProxy1->m_clientObject;
+            if (m_dispatcher->needsCollision(object_0, object_1))
+                m_pairs->push_back(&pair);
+            // Keep the pair in the pair cache
+            return false;
+        }   // processOverlap
+    };   // PairCollector
+}   // namespace
+
+// ----------------------------------------------------------------------------
+STKCollisionDispatcher::STKCollisionDispatcher(
+                                      btCollisionConfiguration *configuration)
+                      : btCollisionDispatcher(configuration)
+{
+    m_thread_pool       = NULL;
+    m_parallel          = false;
+    m_num_old_manifolds = 0;
+    m_num_groups        = 0;
+}   // STKCollisionDispatcher
+
+// ----------------------------------------------------------------------------
+/** Returns the set of an object for the union-find of findGroups(), or -1
+ *  for concave objects. bullet's convex-concave algorithm doesn't modify
+ *  the concave object, so the pairs with the track stay independent.
+ */
+int STKCollisionDispatcher::getObjectSet(const btCollisionObject *object)
+{
+    if (object->getCollisionShape()->isConcave())
+        return -1;
+    auto it = m_object_index.find(object);
+    if (it != m_object_index.end())
+        return it->second;
+    const int set = (int)m_parent.size();
+    m_parent.push_back(set);
+    m_object_index[object] = set;
+    return set;
+}   // getObjectSet
+
+// ----------------------------------------------------------------------------
+/** Returns the root of a set in the union-find forest.
+ */
+int STKCollisionDispatcher::findSet(int set)
+{
+    while (m_parent[set] != set)
+    {
+        m_parent[set] = m_parent[m_parent[set]];
+        set = m_parent[set];
+    }
+    return set;
+}   // findSet
+
+// ----------------------------------------------------------------------------
+/** Splits m_pairs into groups of pairs which don't share any object, except
+ *  concave ones. The groups are numbered in the order of their first pair,
+ *  and the pairs of a group keep their order.
+ */
+void STKCollisionDispatcher::findGroups()
+{
+    m_object_index.clear();
+    m_parent.clear();
+    m_pair_set.resize(m_pairs.size());
+    for (unsigned i = 0; i < m_pairs.size(); i++)
+    {
+        int set_0 = getObjectSet(
+            (btCollisionObject*)m_pairs[i]->m_pProxy0->m_clientObject);
+        int set_1 = getObjectSet(
+            (btCollisionObject*)m_pairs[i]->m_pProxy1->m_clientObject);
+        if (set_0 >= 0 && set_1 >= 0)
+        {
+            set_0 = findSet(set_0);
+            set_1 = findSet(set_1);
+            if (set_0 != set_1)
+                m_parent[set_1] = set_0;
+        }
+        m_pair_set[i] = set_0 >= 0 ? set_0 : set_1;
+    }
+
+    m_set_group.assign(m_parent.size(), -1);
+    m_num_groups = 0;
+    for (unsigned i = 0; i < m_pairs.size(); i++)
+    {
+        int group;
+        const int set = m_pair_set[i] >= 0 ? findSet(m_pair_set[i]) : -1;
+        if (set >= 0 && m_set_group[set] >= 0)
+        {
+            group = m_set_group[set];
+        }
+        else
+        {
+            group = m_num_groups++;
+            if (set >= 0)
+                m_set_group[set] = group;
+            if (m_groups.size() < m_num_groups)
+                m_groups.resize(m_num_groups);
+            m_groups[group].clear();
+        }
+        m_groups[group].push_back(i);
+    }
+}   // findGroups
+
+// ----------------------------------------------------------------------------
+/** Runs the narrow phase for all overlapping pairs. If a thread pool is set
+ *  and there is more than one independent group of pairs, the groups are
+ *  processed in parallel. Otherwise this is bullet's serial dispatch.
+ */
+void STKCollisionDispatcher::dispatchAllCollisionPairs(
+                                           btOverlappingPairCache *pair_cache,
+                                           const btDispatcherInfo &info,
+                                           btDispatcher *dispatcher)
+{
+    if (!m_thread_pool ||
+        info.m_dispatchFunc != btDispatcherInfo::DISPATCH_DISCRETE ||
+        getNearCallback() != defaultNearCallback)
+    {
+        btCollisionDispatcher::dispatchAllCollisionPairs(pair_cache, info,
+                                                         dispatcher);
+        return;
+    }
+
+    m_pairs.clear();
+    PairCollector collector(this, &m_pairs);
+    pair_cache->processAllOverlappingPairs(&collector, dispatcher);
+    findGroups();
+    if (m_num_groups < 2)
+    {
+        btCollisionDispatcher::dispatchAllCollisionPairs(pair_cache, info,
+                                                         dispatcher);
+        return;
+    }
+
+    m_parallel = true;
+    m_num_old_manifolds = m_manifoldsPtr.size();
+    m_manifold_events.clear();
+    m_pair_events.assign(m_pairs.size(), 0);
+
+    // Creating the algorithms can create manifolds, which is recorded like
+    // in the parallel part, so do it here to keep the pool allocators out
+    // of most of the parallel work.
+    for (unsigned i = 0; i < m_pairs.size(); i++)
+    {
+        btBroadphasePair *pair = m_pairs[i];
+        if (pair->m_algorithm)
+            continue;
+        g_current_pair = i;
+        pair->m_algorithm = findAlgorithm(
+            (btCollisionObject*)pair->m_pProxy0->m_clientObject,
+            (btCollisionObject*)pair->m_pProxy1->m_clientObject);
+    }
+
+    m_thread_pool->parallelFor(m_num_groups, [this, &info](unsigned group)
+        {
+            for (int i : m_groups[group])
+            {
+                btBroadphasePair *pair = m_pairs[i];
+                if (!pair->m_algorithm)
+                    continue;
+                btCollisionObject *object_0 =
+                    (btCollisionObject*)pair->m_pProxy0->m_clientObject;
+                btCollisionObject *object_1 =
+                    (btCollisionObject*)pair->m_pProxy1->m_clientObject;
+                g_current_pair = i;
+                btManifoldResult result(object_0, object_1);
+                pair->m_algorithm->processCollision(object_0, object_1,
+                                                    info, &result);
+            }
+        });
+    g_current_pair = -1;
+    m_parallel = false;
+    applyManifoldEvents();
+}   // dispatchAllCollisionPairs
+
+// ----------------------------------------------------------------------------
+/** Records a manifold change of the pair processed by this thread. Must be
+ *  called with m_mutex locked.
+ */
+void STKCollisionDispatcher::addManifoldEvent(btPersistentManifold *manifold,
+                                              bool release)
+{
+    assert(g_current_pair >= 0);
+    ManifoldEvent event;
+    event.m_pair     = g_current_pair;
+    event.m_order    = m_pair_events[g_current_pair]++;
+    event.m_manifold = manifold;
+    event.m_release  = release;
+    m_manifold_events.push_back(event);
+}   // addManifoldEvent
+
+// ----------------------------------------------------------------------------
+/** Brings the manifold array into the state of a serial dispatch: while the
+ *  pairs were processed, new manifolds were appended in any order, and
+ *  released manifolds were kept. Now the new manifolds are removed again,
+ *  and all changes are replayed in pair order.
+ */
+void STKCollisionDispatcher::applyManifoldEvents()
+{
+    std::sort(m_manifold_events.begin(), m_manifold_events.end(),
+        [](const ManifoldEvent &a, const ManifoldEvent &b)
+        {
+            return a.m_pair < b.m_pair ||
+                   (a.m_pair == b.m_pair && a.m_order < b.m_order);
+        });
+    m_manifoldsPtr.resize(m_num_old_manifolds);
+    for (const ManifoldEvent &event : m_manifold_events)
+    {
+        if (event.m_release)
+        {
+            btCollisionDispatcher::releaseManifold(event.m_manifold);
+        }
+        else
+        {
+            event.m_manifold->m_index1a = m_manifoldsPtr.size();
+            m_manifoldsPtr.push_back(event.m_manifold);
+        }
+    }
+    m_manifold_events.clear();
+}   // applyManifoldEvents
+
+// ----------------------------------------------------------------------------
+btPersistentManifold* STKCollisionDispatcher::getNewManifold(void *b0,
+                                                             void *b1)
+{
+    if (!m_parallel)
+        return btCollisionDispatcher::getNewManifold(b0, b1);
+    std::lock_guard<std::mutex> lock(m_mutex);
+    btPersistentManifold *manifold =
+        btCollisionDispatcher::getNewManifold(b0, b1);
+    addManifoldEvent(manifold, /*release*/false);
+    return manifold;
+}   // getNewManifold
+
+// ----------------------------------------------------------------------------
+void STKCollisionDispatcher::releaseManifold(btPersistentManifold *manifold)
+{
+    if (!m_parallel)
+    {
+        btCollisionDispatcher::releaseManifold(manifold);
+        return;
+    }
+    // The manifold is released in applyManifoldEvents()
+    std::lock_guard<std::mutex> lock(m_mutex);
+    addManifoldEvent(manifold, /*release*/true);
+}   // releaseManifold
+
+// ----------------------------------------------------------------------------
+void* STKCollisionDispatcher::allocateCollisionAlgorithm(int size)
+{
+    if (!m_parallel)
+        return btCollisionDispatcher::allocateCollisionAlgorithm(size);
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return btCollisionDispatcher::allocateCollisionAlgorithm(size);
+}   // allocateCollisionAlgorithm
+
+// ----------------------------------------------------------------------------
+void STKCollisionDispatcher::freeCollisionAlgorithm(void *ptr)
+{
+    if (!m_parallel)
+    {
+        btCollisionDispatcher::freeCollisionAlgorithm(ptr);
+        return;
+    }
+    std::lock_guard<std::mutex> lock(m_mutex);
+    btCollisionDispatcher::freeCollisionAlgorithm(ptr);
+}   // freeCollisionAlgorithm
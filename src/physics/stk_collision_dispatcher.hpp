@@ -0,0 +1,129 @@
+//
+//  SuperTuxKart - a fun racing game with go-kart
+//  Copyright (C) 2019 SuperTuxKart-Team
+//
+//  This program is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU General Public License
+//  as published by the Free Software Foundation; either version 3
+//  of the License, or (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+
+#ifndef HEADER_STK_COLLISION_DISPATCHER_HPP
+#define HEADER_STK_COLLISION_DISPATCHER_HPP
+
+#include "btBulletCollisionCommon.h"
+
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+class ThreadPool;
+
+/**
+  * \ingroup physics
+  * A collision dispatcher which can run the narrow phase of independent
+  * collision pairs in parallel. Pairs which share an object are put into the
+  * same group, since bullet's algorithms temporarily modify compound objects
+  * while processing them. Concave objects (i.e. the track) are only read, so
+  * they don't connect pairs. The groups are then processed by a thread pool.
+  * Contact manifolds that are created or released while processing the pairs
+  * are recorded and applied afterwards in the order of a serial dispatch, so
+  * the manifold array (and therefore the solver) gives exactly the same
+  * results as without threads.
+  */
+class STKCollisionDispatcher : public btCollisionDispatcher
+{
+private:
+    /** A manifold created or released while processing a pair. */
+    struct ManifoldEvent
+    {
+        /** Index of the pair in m_pairs. */
+        int                   m_pair;
+        /** Index of the event among the events of the same pair. */
+        int                   m_order;
+        btPersistentManifold *m_manifold;
+        bool                  m_release;
+    };   // ManifoldEvent
+
+    /** The thread pool to use, NULL if all pairs are processed serially. */
+    ThreadPool *m_thread_pool;
+
+    /** Set while the pairs are processed in parallel, manifold changes are
+     *  only recorded in this case. */
+    bool m_parallel;
+
+    /** Protects bullet's pool allocators and m_manifold_events while the
+     *  pairs are processed in parallel. */
+    std::mutex m_mutex;
+
+    /** The manifolds created and released in this dispatch. */
+    std::vector<ManifoldEvent> m_manifold_events;
+
+    /** Number of manifold events of each pair in this dispatch. */
+    std::vector<int> m_pair_events;
+
+    /** Number of manifolds before the pairs were processed. */
+    int m_num_old_manifolds;
+
+    /** All overlapping pairs which need collision, in bullet's order. */
+    std::vector<btBroadphasePair*> m_pairs;
+
+    /** Index of each non concave object of a pair in m_parent. */
+    std::unordered_map<const btCollisionObject*, int> m_object_index;
+
+    /** Union-find forest of the objects connected by pairs. */
+    std::vector<int> m_parent;
+
+    /** The set (index in m_parent) of each pair, -1 if it only contains
+     *  concave objects. */
+    std::vector<int> m_pair_set;
+
+    /** The group of each set. */
+    std::vector<int> m_set_group;
+
+    /** Indices of the pairs of each group, sorted. Only the first
+     *  m_num_groups entries are used. */
+    std::vector<std::vector<int> > m_groups;
+
+    /** Number of groups found by findGroups(). */
+    unsigned m_num_groups;
+
+    // ------------------------------------------------------------------------
+    int  getObjectSet(const btCollisionObject *object);
+    // ------------------------------------------------------------------------
+    int  findSet(int set);
+    // ------------------------------------------------------------------------
+    void findGroups();
+    // ------------------------------------------------------------------------
+    void addManifoldEvent(btPersistentManifold *manifold, bool release);
+    // ------------------------------------------------------------------------
+    void applyManifoldEvents();
+
+public:
+    STKCollisionDispatcher(btCollisionConfiguration *configuration);
+    // ------------------------------------------------------------------------
+    virtual void dispatchAllCollisionPairs(btOverlappingPairCache *pair_cache,
+                                           const btDispatcherInfo &info,
+                                           btDispatcher *dispatcher);
+    // ------------------------------------------------------------------------
+    virtual btPersistentManifold* getNewManifold(void *b0, void *b1);
+    // ------------------------------------------------------------------------
+    virtual void releaseManifold(btPersistentManifold *manifold);
+    // ------------------------------------------------------------------------
+    virtual void* allocateCollisionAlgorithm(int size);
+    // ------------------------------------------------------------------------
+    virtual void freeCollisionAlgorithm(void *ptr);
+    // ------------------------------------------------------------------------
+    /** Sets the thread pool used to process pairs, NULL disables it. */
+    void setThreadPool(ThreadPool *pool) { m_thread_pool = pool; }
+};   // STKCollisionDispatcher
+
+#endif
@@ -0,0 +1,418 @@
+//
+//  SuperTuxKart - a fun racing game with go-kart
+//  Copyright (C) 2019 SuperTuxKart-Team
+//
+//  This program is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU General Public License
+//  as published by the Free Software Foundation; either version 3
+//  of the License, or (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+
+#include "physics/stk_dynamics_world.hpp"
+
+#include "physics/benchmark_terrain.hpp"
+#include "physics/stk_collision_dispatcher.hpp"
+#include "utils/log.hpp"
+#include "utils/thread_pool.hpp"
+#include "utils/time.hpp"
+
+#include "BulletCollision/CollisionDispatch/btSimulationIslandManager.h"
+
+#include <algorithm>
+#include <cstring>
+#include <random>
+
+namespace
+{
+    /** Same as btGetConstraintIslandId in btDiscreteDynamicsWorld.cpp. */
+    int getConstraintIslandId(const btTypedConstraint *constraint)
+    {
+        const btCollisionObject &object_0 = constraint->getRigidBodyA();
+        const btCollisionObject &object_1 = constraint->getRigidBodyB();
+        return object_0.getIslandTag() >= 0 ? object_0.getIslandTag()
+                                            : object_1.getIslandTag();
+    }   // getConstraintIslandId
+
+    // ------------------------------------------------------------------------
+    /** Same as btSortConstraintOnIslandPredicate, so that the constraints are
+     *  sorted exactly like in btDiscreteDynamicsWorld::solveConstraints. */
+    class SortConstraintOnIsland
+    {
+    public:
+        bool operator()(const btTypedConstraint *a,
+                        const btTypedConstraint *b) const
+        {
+            return getConstraintIslandId(a) < getConstraintIslandId(b);
+        }
+    };   // SortConstraintOnIsland
+
+    // ------------------------------------------------------------------------
+    /** Records the islands found by the island manager, instead of solving
+     *  them immediately like bullet's InplaceSolverIslandCallback. */
+    class IslandCollector : public btSimulationIslandManager::IslandCallback
+    {
+    public:
+        struct Island
+        {
+            int m_first_body;
+            int m_num_bodies;
+            int m_first_manifold;
+            int m_num_manifolds;
+            int m_first_constraint;
+            int m_num_constraints;
+            /** True if bullet would pass the bodies of this island to
+             *  solveGroup(). */
+            bool m_solve;
+            // ----------------------------------------------------------------
+            int getWork() const { return m_num_manifolds + m_num_constraints; }
+        };   // Island
+
+        btTypedConstraint                         **m_constraints;
+        int                                         m_num_constraints;
+        btAlignedObjectArray<btCollisionObject*>    m_bodies;
+        btAlignedObjectArray<btPersistentManifold*> m_manifolds;
+        std::vector<Island>                         m_islands;
+
+        // --------------------------------------------------------------------
+        IslandCollector(btTypedConstraint **constraints, int num_constraints)
+            : m_constraints(constraints), m_num_constraints(num_constraints)
+        {
+        }
+        // --------------------------------------------------------------------
+        virtual void ProcessIsland(btCollisionObject **bodies, int num_bodies,
+                                   btPersistentManifold **manifolds,
+                                   int num_manifolds, int island_id)
+        {
+            Island island;
+            island.m_first_body     = m_bodies.size();
+            island.m_num_bodies     = num_bodies;
+            island.m_first_manifold = m_manifolds.size();
+            island.m_num_manifolds  = num_manifolds;
+            island.m_solve          = false;
+            for (int i = 0; i < num_bodies; i++)
+                m_bodies.push_back(bodies[i]);
+            for (int i = 0; i < num_manifolds; i++)
+                m_manifolds.push_back(manifolds[i]);
+
+            // Find the constraints of this island the same way bullet does
+            island.m_first_constraint = 0;
+            island.m_num_constraints  = 0;
+            int i;
+            for (i = 0; i < m_num_constraints; i++)
+            {
+                if (getConstraintIslandId(m_constraints[i]) == island_id)
+                {
+                    island.m_first_constraint = i;
+                    break;
+                }
+            }
+            for (; i < m_num_constraints; i++)
+            {
+                if (getConstraintIslandId(m_constraints[i]) == island_id)
+                    island.m_num_constraints++;
+            }
+            m_islands.push_back(island);
+        }   // ProcessIsland
+
+        // --------------------------------------------------------------------
+        /** Marks the islands whose bodies bullet would pass to solveGroup().
+         *  Bullet collects islands until they contain more than
+         *  m_minimumSolverBatchSize manifolds and constraints, and solves
+         *  such a batch only if it contains any. This matters even for
+         *  islands without contacts, since their velocities are written
+         *  back by the solver.
+         */
+        void markSolvedIslands(int batch_size)
+        {
+            if (batch_size <= 1)
+            {
+                for (Island &island : m_islands)
+                    island.m_solve = island.getWork() > 0;
+                return;
+            }
+            unsigned first = 0;
+            int work = 0;
+            for (unsigned i = 0; i < m_islands.size(); i++)
+            {
+                work += m_islands[i].getWork();
+                if (work > batch_size)
+                {
+                    for (unsigned j = first; j <= i; j++)
+                        m_islands[j].m_solve = true;
+                    first = i + 1;
+                    work  = 0;
+                }
+            }
+            if (work > 0)
+            {
+                for (unsigned j = first; j < m_islands.size(); j++)
+                    m_islands[j].m_solve = true;
+            }
+        }   // markSolvedIslands
+    };   // IslandCollector
+}   // namespace
+
+// ----------------------------------------------------------------------------
+/** Solves the contacts and constraints of all simulation islands. Without a
+ *  thread pool this is bullet's implementation. Otherwise the islands are
+ *  split into a few groups with a similar number of contacts, and each group
+ *  is solved by its own solver in parallel. Islands don't share any dynamic
+ *  body, and bullet's sequential impulse solver handles each body and
+ *  contact independently of other islands, so the result is bit-identical
+ *  to solving them serially, as long as the same bodies are passed to a
+ *  solver (see IslandCollector::markSolvedIslands()).
+ */
+void STKDynamicsWorld::solveConstraints(btContactSolverInfo &solver_info)
+{
+    if (!m_thread_pool || !m_islandManager->getSplitIslands() ||
+        (solver_info.m_solverMode & SOLVER_RANDMIZE_ORDER))
+    {
+        btDiscreteDynamicsWorld::solveConstraints(solver_info);
+        return;
+    }
+
+    btAlignedObjectArray<btTypedConstraint*> sorted_constraints;
+    sorted_constraints.resize(m_constraints.size());
+    for (int i = 0; i < m_constraints.size(); i++)
+        sorted_constraints[i] = m_constraints[i];
+    sorted_constraints.quickSort(SortConstraintOnIsland());
+    btTypedConstraint **constraints =
+        sorted_constraints.size() ? &sorted_constraints[0] : NULL;
+
+    IslandCollector collector(constraints, sorted_constraints.size());
+    m_constraintSolver->prepareSolve(getNumCollisionObjects(),
+                                     getDispatcher()->getNumManifolds());
+    m_islandManager->buildAndProcessIslands(getDispatcher(), this,
+                                            &collector);
+    collector.markSolvedIslands(solver_info.m_minimumSolverBatchSize);
+
+    int total_work = 0;
+    for (const IslandCollector::Island &island : collector.m_islands)
+    {
+        if (island.m_solve)
+            total_work += island.getWork();
+    }
+    // A few groups per thread, so that a big island doesn't stall the others
+    const int group_work = std::max(1, total_work /
+                           (4 * ((int)m_thread_pool->getNumThreads() + 1)));
+
+    unsigned num_groups = 0;
+    int work = 0;
+    for (const IslandCollector::Island &island : collector.m_islands)
+    {
+        if (!island.m_solve)
+            continue;
+        // Islands without contacts are added to the previous group: a group
+        // without any contacts would not be solved like bullet does, since
+        // the solver doesn't reset the velocities of its bodies then.
+        if (num_groups == 0 || (work >= group_work && island.getWork() > 0))
+        {
+            if (m_solver_groups.size() <= num_groups)
+                m_solver_groups.emplace_back(new SolverGroup());
+            SolverGroup *group = m_solver_groups[num_groups].get();
+            group->m_bodies.resize(0);
+            group->m_manifolds.resize(0);
+            group->m_constraints.resize(0);
+            num_groups++;
+            work = 0;
+        }
+        SolverGroup *group = m_solver_groups[num_groups - 1].get();
+        for (int i = 0; i < island.m_num_bodies; i++)
+        {
+            group->m_bodies.push_back(
+                collector.m_bodies[island.m_first_body + i]);
+        }
+        for (int i = 0; i < island.m_num_manifolds; i++)
+        {
+            group->m_manifolds.push_back(
+                collector.m_manifolds[island.m_first_manifold + i]);
+        }
+        for (int i = 0; i < island.m_num_constraints; i++)
+        {
+            group->m_constraints.push_back(
+                constraints[island.m_first_constraint + i]);
+        }
+        work += island.getWork();
+    }
+
+    m_thread_pool->parallelFor(num_groups, [this, &solver_info](unsigned n)
+        {
+            SolverGroup *group = m_solver_groups[n].get();
+            group->m_solver.solveGroup(&group->m_bodies[0],
+                group->m_bodies.size(),
+                group->m_manifolds.size() ? &group->m_manifolds[0] : NULL,
+                group->m_manifolds.size(),
+                group->m_constraints.size() ? &group->m_constraints[0] : NULL,
+                group->m_constraints.size(), solver_info, m_debugDrawer,
+                m_stackAlloc, m_dispatcher1);
+        });
+    m_constraintSolver->allSolved(solver_info, m_debugDrawer, m_stackAlloc);
+}   // solveConstraints
+
+// ----------------------------------------------------------------------------
+/** Measures the physics time per tick of 16, 32 and 64 karts on a hilly
+ *  triangle mesh without threads, and with 1 and 3 extra threads. Half of
+ *  the karts start in small clusters, so that they push each other. Checks
+ *  that the karts end up in exactly the same state as without threads.
+ */
+void STKDynamicsWorld::benchmark()
+{
+    const float size = 200.0f;
+    const float grid = 2.0f;
+    BenchmarkTerrain terrain(size, grid);
+
+    // Like a kart: a convex hull inside a compound shape
+    btConvexHullShape hull;
+    for (int i = 0; i < 8; i++)
+    {
+        hull.addPoint(btVector3(i & 1 ? 0.6f : -0.6f, i & 2 ? 0.3f : -0.3f,
+                                i & 4 ? 1.0f : -1.0f));
+    }
+    btCompoundShape chassis_shape;
+    chassis_shape.addChildShape(btTransform(btQuaternion(0, 0, 0, 1),
+                                            btVector3(0, 0.3f, 0)), &hull);
+    btVector3 inertia;
+    const float mass = 225.0f;
+    chassis_shape.calculateLocalInertia(mass, inertia);
+    const unsigned num_ticks = 600;
+
+    struct KartState
+    {
+        btTransform m_transform;
+        btVector3   m_velocity;
+        btVector3   m_angular_velocity;
+    };
+    // Compares bitwise, but ignores the unused 4th component of btVector3
+    auto same = [](const btVector3 &a, const btVector3 &b)
+    {
+        return memcmp(a.m_floats, b.m_floats, 3 * sizeof(btScalar)) == 0;
+    };
+    auto run = [&](unsigned num_karts, unsigned num_threads,
+                   std::vector<KartState> *states)
+    {
+        std::unique_ptr<ThreadPool> pool;
+        if (num_threads > 0)
+            pool.reset(new ThreadPool(num_threads, "Physics"));
+        btDefaultCollisionConfiguration configuration;
+        STKCollisionDispatcher dispatcher(&configuration);
+        dispatcher.setThreadPool(pool.get());
+        btAxisSweep3 broadphase(btVector3(-10.0f, -20.0f, -10.0f),
+                                btVector3(size + 10.0f, 20.0f, size + 10.0f));
+        btSequentialImpulseConstraintSolver solver;
+        STKDynamicsWorld world(&dispatcher, &broadphase, &solver,
+                               &configuration);
+        world.setThreadPool(pool.get());
+        world.setGravity(btVector3(0.0f, -9.80665f, 0.0f));
+        // The default values of stk_config.xml
+        btContactSolverInfo &info = world.getSolverInfo();
+        info.m_numIterations = 4;
+        info.m_splitImpulse  = true;
+        info.m_splitImpulsePenetrationThreshold = -0.00001f;
+
+        btRigidBody track(btRigidBody::btRigidBodyConstructionInfo(0.0f, NULL,
+                                                         terrain.getShape()));
+        world.addRigidBody(&track);
+
+        std::mt19937 random(1);
+        std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+        std::vector<std::unique_ptr<btRigidBody> > karts;
+        for (unsigned k = 0; k < num_karts; k++)
+        {
+            btRigidBody::btRigidBodyConstructionInfo kart_info(mass, NULL,
+                &chassis_shape, inertia);
+            karts.emplace_back(new btRigidBody(kart_info));
+            // Every second kart is in a cluster of 4 karts touching each other
+            float x = 20.0f + (size - 40.0f) * unit(random);
+            float z = 20.0f + (size - 40.0f) * unit(random);
+            if (k % 2 == 1)
+            {
+                const unsigned cluster = k / 8;
+                x = 30.0f + 17.0f * cluster + 1.1f * ((k / 2) % 2);
+                z = 40.0f + 13.0f * cluster + 1.9f * ((k / 4) % 2);
+            }
+            btTransform t(btQuaternion(btVector3(0, 1, 0), 6.283f*unit(random)),
+                          btVector3(x, BenchmarkTerrain::getHeight(x, z) + 0.5f,
+                                    z));
+            karts[k]->setWorldTransform(t);
+            karts[k]->setActivationState(DISABLE_DEACTIVATION);
+            world.addRigidBody(karts[k].get());
+        }
+
+        uint64_t us = 0;
+        for (unsigned tick = 0; tick < num_ticks; tick++)
+        {
+            for (unsigned k = 0; k < num_karts; k++)
+            {
+                const btTransform &t = karts[k]->getWorldTransform();
+                // Drive forward and steer, but push the karts back to the
+                // middle of the track when they get close to the edge
+                btVector3 force = t.getBasis() *
+                    btVector3(0.0f, 0.0f, 3000.0f * unit(random));
+                const btVector3 middle(size * 0.5f, 0.0f, size * 0.5f);
+                btVector3 to_middle = middle - t.getOrigin();
+                to_middle.setY(0.0f);
+                if (to_middle.length2() > 60.0f * 60.0f)
+                    force += to_middle.normalized() * 4000.0f;
+                karts[k]->applyCentralForce(force);
+                karts[k]->applyTorque(btVector3(0.0f,
+                    600.0f * unit(random) - 300.0f, 0.0f));
+            }
+            uint64_t start = StkTime::getMonoTimeUs();
+            world.stepSimulation(1.0f / 120.0f, 1, 1.0f / 120.0f);
+            us += StkTime::getMonoTimeUs() - start;
+        }
+
+        states->clear();
+        for (unsigned k = 0; k < num_karts; k++)
+        {
+            KartState state;
+            state.m_transform        = karts[k]->getWorldTransform();
+            state.m_velocity         = karts[k]->getLinearVelocity();
+            state.m_angular_velocity = karts[k]->getAngularVelocity();
+            states->push_back(state);
+            world.removeRigidBody(karts[k].get());
+        }
+        world.removeRigidBody(&track);
+        return us;
+    };   // run
+
+    for (unsigned num_karts = 16; num_karts <= 64; num_karts *= 2)
+    {
+        std::vector<KartState> serial, threaded;
+        for (unsigned num_threads : { 0u, 1u, 3u })
+        {
+            uint64_t us = run(num_karts, num_threads,
+                              num_threads == 0 ? &serial : &threaded);
+            unsigned mismatches = 0;
+            if (num_threads > 0)
+            {
+                for (unsigned k = 0; k < num_karts; k++)
+                {
+                    const KartState &a = serial[k], &b = threaded[k];
+                    if (!same(a.m_transform.getOrigin(),
+                              b.m_transform.getOrigin())             ||
+                        !same(a.m_transform.getBasis()[0],
+                              b.m_transform.getBasis()[0])           ||
+                        !same(a.m_transform.getBasis()[1],
+                              b.m_transform.getBasis()[1])           ||
+                        !same(a.m_transform.getBasis()[2],
+                              b.m_transform.getBasis()[2])           ||
+                        !same(a.m_velocity, b.m_velocity)            ||
+                        !same(a.m_angular_velocity, b.m_angular_velocity))
+                        mismatches++;
+                }
+            }
+            Log::info("Benchmark", "%u karts, %u threads: %.2f us per tick, "
+                      "%u karts differ from the serial physics.", num_karts,
+                      num_threads, (float)us / num_ticks, mismatches);
+        }
+    }
+}   // benchmark
@@ -21,12 +21,38 @@
 
 #include "btBulletDynamicsCommon.h"
 
+#include <memory>
+#include <vector>
+
+class ThreadPool;
+
 /** A thin wrapper around bullet's btDiscreteDynamicsWorld. Used to
  *  be able to query and set the 'left over' time from a previous
  *  time step, which is needed for more precise rewind/replays.
+ *  If a thread pool is set, the simulation islands are solved in
+ *  parallel, see solveConstraints().
  */
 class STKDynamicsWorld : public btDiscreteDynamicsWorld
 {
+private:
+    /** Islands which are solved together by one thread. */
+    struct SolverGroup
+    {
+        btSequentialImpulseConstraintSolver         m_solver;
+        btAlignedObjectArray<btCollisionObject*>    m_bodies;
+        btAlignedObjectArray<btPersistentManifold*> m_manifolds;
+        btAlignedObjectArray<btTypedConstraint*>    m_constraints;
+    };   // SolverGroup
+
+    /** The thread pool to solve islands with, NULL if it's done serially. */
+    ThreadPool *m_thread_pool;
+
+    /** The groups of the last time step, kept to reuse their memory. */
+    std::vector<std::unique_ptr<SolverGroup> > m_solver_groups;
+
+protected:
+    virtual void solveConstraints(btContactSolverInfo &solver_info);
+
 public:
     /** The standard constructor which just created a btDiscreteDynamicsWorld. */
     STKDynamicsWorld(btDispatcher*             dispatcher,
@@ -38,6 +64,7 @@ public:
                                              constraintSolver,
                                              collisionConfiguration)
     {
+        m_thread_pool = NULL;
     }
 
     /** Resets m_localTime to 0. This allows more precise replay of
@@ -49,6 +76,11 @@ public:
     // ------------------------------------------------------------------------
     /** Gets the local time. */
     float getLocalTime() const { return m_localTime; }
+    // ------------------------------------------------------------------------
+    /** Sets the thread pool used to solve islands, NULL disables it. */
+    void setThreadPool(ThreadPool *pool) { m_thread_pool = pool; }
+    // ------------------------------------------------------------------------
+    static void benchmark();
 };   // STKDynamicsWorld
 #endif
 /* EOF */
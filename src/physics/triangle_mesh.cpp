@@ -19,14 +19,19 @@
 #include "physics/triangle_mesh.hpp"
 
 #include "config/stk_config.hpp"
+#include "io/file_manager.hpp"
 #include "main_loop.hpp"
 #include "physics/physics.hpp"
 #include "utils/constants.hpp"
+#include "utils/file_utils.hpp"
+#include "utils/log.hpp"
 #include "utils/time.hpp"
 
 #include "btBulletDynamicsCommon.h"
 
-#include <fstream>
+#include <cstdio>
+#include <cstring>
+#include <random>
 
 // -----------------------------------------------------------------------------
 /** Constructor: Initialises all data structures with zero.
@@ -44,6 +49,7 @@ TriangleMesh::TriangleMesh(bool can_be_transformed) : m_mesh()
     // (and m_mesh->m_weldingThreshold at m_normals
     m_collision_shape  = NULL;
     m_collision_object = NULL;
+    m_bvh_buffer       = NULL;
     m_user_pointer.set(this);
 }   // TriangleMesh
 
@@ -86,13 +92,167 @@ void TriangleMesh::addTriangle(const btVector3 &t1, const btVector3 &t2,
     m_p1p2p3.push_back(edge1.cross(edge2).length2());
 }   // addTriangle
 
+// -----------------------------------------------------------------------------
+namespace
+{
+    /** Version of the bvh cache files, must be increased if the format of
+     *  the file or the way the bvh is built changes. */
+    const uint32_t BVH_CACHE_VERSION = 1;
+
+    /** The header of a bvh cache file, followed by the serialized bvh. */
+    struct BvhCacheHeader
+    {
+        char     m_magic[8];
+        uint32_t m_version;
+        /** Detects files written on a machine with a different byte order
+         *  or with a different bullet node layout. */
+        uint32_t m_endian;
+        uint32_t m_node_size;
+        uint32_t m_num_triangles;
+        uint64_t m_mesh_hash;
+        uint64_t m_data_size;
+        uint64_t m_data_hash;
+    };   // BvhCacheHeader
+}   // namespace
+
+// -----------------------------------------------------------------------------
+/** Returns a hash of all vertices and indices of the triangle mesh, which
+ *  identifies the mesh a cached bvh was built for.
+ */
+uint64_t TriangleMesh::getMeshHash() const
+{
+    uint64_t hash = FileUtils::HASH_SEED;
+    for (int part = 0; part < m_mesh.getNumSubParts(); part++)
+    {
+        const unsigned char *vertex_base, *index_base;
+        int num_verts, stride, index_stride, num_faces;
+        PHY_ScalarType type, index_type;
+        m_mesh.getLockedReadOnlyVertexIndexBase(&vertex_base, num_verts, type,
+            stride, &index_base, index_stride, num_faces, index_type, part);
+        // Only hash the coordinates, the vertex stride can include padding
+        const size_t vertex_size = type == PHY_FLOAT ? 3 * sizeof(float)
+                                                     : 3 * sizeof(double);
+        for (int i = 0; i < num_verts; i++)
+        {
+            hash = FileUtils::hashBytes(vertex_base + i * stride, vertex_size,
+                                        hash);
+        }
+        const size_t index_size = index_type == PHY_SHORT
+                                ? 3 * sizeof(short) : 3 * sizeof(int);
+        for (int i = 0; i < num_faces; i++)
+        {
+            hash = FileUtils::hashBytes(index_base + i * index_stride,
+                                        index_size, hash);
+        }
+        m_mesh.unLockReadOnlyVertexBase(part);
+    }
+    const btVector3 &scaling = m_mesh.getScaling();
+    return FileUtils::hashBytes(&scaling[0], 3 * sizeof(btScalar), hash);
+}   // getMeshHash
+
+// -----------------------------------------------------------------------------
+/** Loads a bvh from a cache file. Returns NULL if the file does not exist,
+ *  is from a different version, was written for a different mesh or is
+ *  damaged.
+ *  \param file Name of the cache file.
+ *  \param mesh_hash Hash of this mesh, see getMeshHash().
+ */
+btOptimizedBvh *TriangleMesh::loadBvh(const std::string &file,
+                                      uint64_t mesh_hash)
+{
+    FILE *f = fopen(file.c_str(), "rb");
+    if (!f)
+        return NULL;
+
+    BvhCacheHeader header;
+    if (fread(&header, sizeof(header), 1, f) != 1                  ||
+        memcmp(header.m_magic, "STKBVH", 7) != 0                   ||
+        header.m_version       != BVH_CACHE_VERSION                ||
+        header.m_endian        != 0x01020304                       ||
+        header.m_node_size     != sizeof(btOptimizedBvhNode)       ||
+        header.m_num_triangles != m_triangleIndex2Material.size()  ||
+        header.m_mesh_hash     != mesh_hash                        ||
+        header.m_data_size     >  0x7fffffff                          )
+    {
+        fclose(f);
+        Log::info("TriangleMesh", "Cached bvh '%s' is outdated.",
+                  file.c_str());
+        return NULL;
+    }
+
+    void *bytes = btAlignedAlloc((size_t)header.m_data_size, 16);
+    const bool ok =
+        fread(bytes, (size_t)header.m_data_size, 1, f) == 1 &&
+        FileUtils::hashBytes(bytes, (size_t)header.m_data_size) ==
+            header.m_data_hash;
+    fclose(f);
+    // 'deSerializeInPlace' makes the btOptimizedBvh object directly at
+    // this memory location, so the bytes are only freed in removeAll()
+    btOptimizedBvh *bvh = ok ? btOptimizedBvh::deSerializeInPlace(bytes,
+                                   (unsigned)header.m_data_size, false)
+                             : NULL;
+    if (bvh == NULL)
+    {
+        Log::warn("TriangleMesh", "Failed to load cached bvh '%s'.",
+                  file.c_str());
+        btAlignedFree(bytes);
+        return NULL;
+    }
+    m_bvh_buffer = bytes;
+    return bvh;
+}   // loadBvh
+
+// -----------------------------------------------------------------------------
+/** Writes a bvh to a cache file, see FileUtils::writeFileAtomically().
+ *  \param file Name of the cache file.
+ *  \param mesh_hash Hash of this mesh, see getMeshHash().
+ *  \param bvh The bvh to save.
+ */
+void TriangleMesh::saveBvh(const std::string &file, uint64_t mesh_hash,
+                           const btOptimizedBvh *bvh) const
+{
+    const unsigned size = bvh->calculateSerializeBufferSize();
+    void *buffer = btAlignedAlloc(size, 16);
+    if (!bvh->serialize(buffer, size, false))
+    {
+        Log::warn("TriangleMesh", "Failed to serialize bvh.");
+        btAlignedFree(buffer);
+        return;
+    }
+
+    BvhCacheHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.m_magic, "STKBVH", 7);
+    header.m_version       = BVH_CACHE_VERSION;
+    header.m_endian        = 0x01020304;
+    header.m_node_size     = sizeof(btOptimizedBvhNode);
+    header.m_num_triangles = (uint32_t)m_triangleIndex2Material.size();
+    header.m_mesh_hash     = mesh_hash;
+    header.m_data_size     = size;
+    header.m_data_hash     = FileUtils::hashBytes(buffer, size);
+
+    const bool ok = FileUtils::writeFileAtomically(file, [&](FILE *f)
+        {
+            return fwrite(&header, sizeof(header), 1, f) == 1 &&
+                   fwrite(buffer, size, 1, f) == 1;
+        });
+    btAlignedFree(buffer);
+    if (!ok)
+        Log::warn("TriangleMesh", "Failed to write cached bvh '%s'.",
+                  file.c_str());
+}   // saveBvh
+
 // -----------------------------------------------------------------------------
 /** Creates a collision body only, which can be used for raycasting, but
  *  has no physical properties.
- *  @param serialized_bhv if non-null, load the serialized bhv from file instead
- *                        of builing it on the fly
+ *  \param create_collision_object If a collision object should be created.
+ *  \param bvh_cache If not empty, the name of a file in which the bvh is
+ *         cached: if the file contains the bvh for this mesh it is loaded
+ *         instead of building it on the fly, otherwise the built bvh is
+ *         saved in this file.
  */
-void TriangleMesh::createCollisionShape(bool create_collision_object, const char* serialized_bhv)
+void TriangleMesh::createCollisionShape(bool create_collision_object,
+                                        const std::string &bvh_cache)
 {
     if(m_triangleIndex2Material.size()==0)
     {
@@ -105,53 +265,25 @@ void TriangleMesh::createCollisionShape(bool create_collision_object, const char
     // Now convert the triangle mesh into a static rigid body
     btBvhTriangleMeshShape* bhv_triangle_mesh;
 
-    if (serialized_bhv != NULL)
+    uint64_t mesh_hash = 0;
+    btOptimizedBvh* bvh = NULL;
+    if (!bvh_cache.empty())
     {
-        FILE *f = fopen(serialized_bhv, "rb");
-        fseek(f, 0, SEEK_END);
-        long pos = ftell(f);
-        assert(pos != -1L);
-        fseek(f, 0, SEEK_SET);
-
-        void* bytes = btAlignedAlloc(pos, 16);
-        fread(bytes, pos, 1, f);
-        fclose(f);
-
-        btOptimizedBvh* bhv = btOptimizedBvh::deSerializeInPlace(bytes, pos, !IS_LITTLE_ENDIAN);
-        if (bhv == NULL)
-        {
-            Log::warn("TriangleMesh", "Failed to load serialized BHV");
-            bhv_triangle_mesh = new btBvhTriangleMeshShape(&m_mesh, false /* useQuantizedAabbCompression */);
-        }
-        else
-        {
-            bhv_triangle_mesh = new btBvhTriangleMeshShape(&m_mesh, false /* useQuantizedAabbCompression */,
-                                                           false /* buildBvh */);
-            bhv_triangle_mesh->setOptimizedBvh( bhv );
-        }
-        // Do *NOT* free the bytes, 'deSerializeInPlace' makes the btOptimizedBvh object
-        // directly at this memory location
-        //free(bytes);
+        mesh_hash = getMeshHash();
+        bvh = loadBvh(bvh_cache, mesh_hash);
+    }
 
+    if (bvh != NULL)
+    {
+        bhv_triangle_mesh = new btBvhTriangleMeshShape(&m_mesh, false /* useQuantizedAabbCompression */,
+                                                       false /* buildBvh */);
+        bhv_triangle_mesh->setOptimizedBvh(bvh);
     }
     else
     {
         bhv_triangle_mesh = new btBvhTriangleMeshShape(&m_mesh, false /* useQuantizedAabbCompression */);
-
-        /*
-         // code to serialize triangle mesh
-        btOptimizedBvh* bvh = bhv_triangle_mesh->getOptimizedBvh();
-        unsigned int ssize = bvh->calculateSerializeBufferSize();
-        char* buffer = (char*)btAlignedAlloc(ssize, 16);
-        bool success = bvh->serialize(buffer, ssize, !IS_LITTLE_ENDIAN);
-        printf("serialization success = %i\n", success);
-
-        std::ofstream fileout("/tmp/btOptimizedBvh");
-        fileout.write(buffer, ssize);
-        fileout.close();
-
-        btAlignedFree(buffer);
-         */
+        if (!bvh_cache.empty())
+            saveBvh(bvh_cache, mesh_hash, bhv_triangle_mesh->getOptimizedBvh());
     }
 
     m_collision_shape = bhv_triangle_mesh;
@@ -178,16 +310,16 @@ void TriangleMesh::createCollisionShape(bool create_collision_object, const char
  *  for height of terrain detection).
  *  \param friction Friction to be used for this TriangleMesh.
  *  \param flags Additional collision flags (default 0).
- *  \param serializedBhv if non-NULL, the bhv is deserialized instead of
- *                       being calculated on the fly
+ *  \param bvh_cache If not empty, the name of the file in which the bvh is
+ *         cached (see createCollisionShape()).
  */
 void TriangleMesh::createPhysicalBody(float friction,
                                       btCollisionObject::CollisionFlags flags,
-                                      const char* serializedBhv)
+                                      const std::string &bvh_cache)
 {
     // We need the collision shape, but not the collision object (since
     // this will be created when the dynamics body is anyway).
-    createCollisionShape(/*create_collision_object*/false, serializedBhv);
+    createCollisionShape(/*create_collision_object*/false, bvh_cache);
     main_loop->renderGUI(5583);
 
     btTransform startTransform;
@@ -232,6 +364,12 @@ void TriangleMesh::removeAll()
     }
     delete m_collision_shape;
     m_collision_shape = NULL;
+    // The shape does not own a bvh loaded from the cache
+    if (m_bvh_buffer)
+    {
+        btAlignedFree(m_bvh_buffer);
+        m_bvh_buffer = NULL;
+    }
 }   // removeAll
 
 // -----------------------------------------------------------------------------
@@ -407,3 +545,87 @@ bool TriangleMesh::castRay(const btVector3 &from, const btVector3 &to,
     return ray_callback.hasHit();
 
 }   // castRay
+
+// ----------------------------------------------------------------------------
+/** Compares building the bvh of a large track mesh with loading it from the
+ *  cache, checks that raycasts against the loaded bvh give the same results,
+ *  and that the cache is not used for a modified mesh.
+ */
+void TriangleMesh::benchmark()
+{
+    const std::string cache = file_manager->getCachedPhysicsDir() +
+                              "benchmark.bvh";
+    remove(cache.c_str());
+
+    const float size = 600.0f;
+    const int n = 390;
+    auto create_mesh = [&](TriangleMesh *mesh, float dy)
+    {
+        auto xyz = [&](int i, int j)
+        {
+            const float x = i * size / n, z = j * size / n;
+            return btVector3(x, 3.0f * sinf(x * 0.05f) * cosf(z * 0.07f) +
+                                (i == n / 2 && j == n / 2 ? dy : 0.0f), z);
+        };
+        const btVector3 up(0.0f, 1.0f, 0.0f);
+        for (int i = 0; i < n; i++)
+        {
+            for (int j = 0; j < n; j++)
+            {
+                mesh->addTriangle(xyz(i, j), xyz(i + 1, j + 1), xyz(i + 1, j),
+                                  up, up, up, NULL);
+                mesh->addTriangle(xyz(i, j), xyz(i, j + 1), xyz(i + 1, j + 1),
+                                  up, up, up, NULL);
+            }
+        }
+    };
+
+    TriangleMesh built(false), saved(false), loaded(false), modified(false);
+    create_mesh(&built, 0.0f);
+    create_mesh(&saved, 0.0f);
+    create_mesh(&loaded, 0.0f);
+    create_mesh(&modified, 0.1f);
+
+    uint64_t start = StkTime::getMonoTimeUs();
+    built.createCollisionShape();
+    const uint64_t build_us = StkTime::getMonoTimeUs() - start;
+    start = StkTime::getMonoTimeUs();
+    saved.createCollisionShape(true, cache);
+    const uint64_t save_us = StkTime::getMonoTimeUs() - start;
+    start = StkTime::getMonoTimeUs();
+    loaded.createCollisionShape(true, cache);
+    const uint64_t load_us = StkTime::getMonoTimeUs() - start;
+    modified.createCollisionShape(true, cache);
+
+    std::mt19937 random(1);
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+    unsigned hits = 0, mismatches = 0;
+    for (unsigned i = 0; i < 10000; i++)
+    {
+        const btVector3 from(size * unit(random), 5.0f, size * unit(random));
+        const btVector3 to = from + btVector3(unit(random) - 0.5f, -10.0f,
+                                              unit(random) - 0.5f);
+        btVector3 xyz[2], normal[2];
+        const Material *material;
+        const bool hit0 = built.castRay(from, to, &xyz[0], &material,
+                                        &normal[0]);
+        const bool hit1 = loaded.castRay(from, to, &xyz[1], &material,
+                                         &normal[1]);
+        hits += hit0;
+        if (hit0 != hit1 ||
+            (hit0 && (memcmp(&xyz[0][0], &xyz[1][0],
+                             3 * sizeof(btScalar)) != 0 ||
+                      memcmp(&normal[0][0], &normal[1][0],
+                             3 * sizeof(btScalar)) != 0)))
+            mismatches++;
+    }
+
+    Log::info("Benchmark", "%u triangles: building bvh %.2f ms, building "
+        "and saving %.2f ms, loading %.2f ms (%s), %u/10000 hits, %u "
+        "mismatches, modified mesh %s the cache.",
+        (unsigned)built.m_triangleIndex2Material.size(), build_us / 1000.0f,
+        save_us / 1000.0f, load_us / 1000.0f,
+        loaded.m_bvh_buffer ? "cached" : "not cached", hits, mismatches,
+        modified.m_bvh_buffer ? "used" : "did not use");
+    remove(cache.c_str());
+}   // benchmark
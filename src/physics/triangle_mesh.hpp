@@ -19,6 +19,8 @@
 #ifndef HEADER_TRIANGLE_MESH_HPP
 #define HEADER_TRIANGLE_MESH_HPP
 
+#include <cstdint>
+#include <string>
 #include <vector>
 #include "btBulletDynamicsCommon.h"
 
@@ -57,6 +59,15 @@ private:
      *  to the current transform of the body. */
     bool m_can_be_transformed;
 
+    /** If the bvh of the collision shape was loaded from a cache file, the
+     *  memory it was deserialized into, which is freed in removeAll(). */
+    void *m_bvh_buffer;
+
+    uint64_t        getMeshHash() const;
+    btOptimizedBvh *loadBvh(const std::string &file, uint64_t mesh_hash);
+    void            saveBvh(const std::string &file, uint64_t mesh_hash,
+                            const btOptimizedBvh *bvh) const;
+
 public:
     class RigidBodyTriangleMesh : public btRigidBody
     {
@@ -76,11 +87,12 @@ public:
                      const btVector3 &t3, const btVector3 &n1,
                      const btVector3 &n2, const btVector3 &n3,
                      const Material* m);
-    void createCollisionShape(bool create_collision_object=true, const char* serialized_bhv=NULL);
+    void createCollisionShape(bool create_collision_object=true,
+                              const std::string &bvh_cache="");
     void createPhysicalBody(float friction,
                             btCollisionObject::CollisionFlags flags=
                                (btCollisionObject::CollisionFlags)0,
-                            const char* serializedBhv = NULL);
+                            const std::string &bvh_cache="");
     void removeAll();
     void removeCollisionObject();
     btVector3 getInterpolatedNormal(unsigned int index,
@@ -104,6 +116,10 @@ public:
     const Material* getMaterial(int n) const
                                           {return m_triangleIndex2Material[n];}
     // ------------------------------------------------------------------------
+    /** Returns the number of triangles. */
+    unsigned int getNumTriangles() const
+                      { return (unsigned int)m_triangleIndex2Material.size(); }
+    // ------------------------------------------------------------------------
     const btCollisionShape &getCollisionShape() const
                                           { return *m_collision_shape; }
     // ------------------------------------------------------------------------
@@ -146,6 +162,8 @@ public:
         assert(indx < m_p1p2p3.size());
         return m_p1p2p3[indx];
     }
+    // ------------------------------------------------------------------------
+    static void benchmark();
 };
 #endif
 /* EOF */
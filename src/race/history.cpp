@@ -18,13 +18,16 @@
 
 #include "race/history.hpp"
 
+#include <algorithm>
 #include <stdio.h>
 
+#include "main_loop.hpp"
 #include "io/file_manager.hpp"
 #include "modes/world.hpp"
 #include "karts/abstract_kart.hpp"
 #include "karts/controller/controller.hpp"
 #include "network/network_config.hpp"
+#include "network/rewind_benchmark.hpp"
 #include "network/rewind_manager.hpp"
 #include "physics/physics.hpp"
 #include "race/race_manager.hpp"
@@ -111,6 +114,12 @@ void History::updateReplay(int world_ticks)
     // Check if we have reached the end of the buffer
     if(m_event_index >= m_all_input_events.size())
     {
+        // The benchmark prints its results once the main loop is left
+        if (RewindBenchmark::isEnabled())
+        {
+            main_loop->abort();
+            return;
+        }
         Log::info("History", "Replay finished");
         m_event_index= 0;
         // This is useful to use a reproducable rewind problem:
@@ -126,6 +135,22 @@ void History::updateReplay(int world_ticks)
 
 }   // updateReplay
 
+//-----------------------------------------------------------------------------
+/** Sets the replay position after a rewind to the given time, so that all
+ *  input events after this time are replayed again by updateReplay.
+ *  \param world_ticks World time in ticks the world was rewound to.
+ */
+void History::rewindTo(int world_ticks)
+{
+    auto it = std::upper_bound(m_all_input_events.begin(),
+        m_all_input_events.end(), world_ticks,
+        [](int ticks, const InputEvent& ie)
+        {
+            return ticks < ie.m_world_ticks;
+        });
+    m_event_index = (unsigned int)(it - m_all_input_events.begin());
+}   // rewindTo
+
 //-----------------------------------------------------------------------------
 /** Saves the history stored in the internal data structures into a file called
  *  history.dat.
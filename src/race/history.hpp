@@ -68,6 +68,7 @@ public:
     void  Save           ();
     void  Load           ();
     void  updateReplay(int world_ticks);
+    void  rewindTo(int world_ticks);
     void  addEvent(int kart_id, PlayerAction pa, int value);
 
     // -------------------I-----------------------------------------------------
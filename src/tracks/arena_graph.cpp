@@ -25,20 +25,80 @@
 #include "tracks/arena_node.hpp"
 #include "tracks/track.hpp"
 #include "tracks/track_manager.hpp"
+#include "utils/file_utils.hpp"
 #include "utils/log.hpp"
+#include "utils/thread_pool.hpp"
+#include "utils/time.hpp"
+
+#include "LinearMath/btAlignedAllocator.h"
 
 #include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
 #include <queue>
+#include <thread>
+
+namespace
+{
+    /** Version of the path cache files, must be increased if the format of
+     *  the file or the path computation changes. */
+    const uint32_t PATH_CACHE_VERSION = 2;
+
+    /** The header of a path cache file, followed by the distance rows and
+     *  the parent rows (without the padding of the rows). */
+    struct PathCacheHeader
+    {
+        char     m_magic[8];
+        uint32_t m_version;
+        /** Detects files written on a machine with a different byte
+         *  order. */
+        uint32_t m_endian;
+        uint32_t m_num_nodes;
+        uint32_t m_padding;
+        uint64_t m_graph_hash;
+        uint64_t m_data_hash;
+    };   // PathCacheHeader
+}   // namespace
 
 // -----------------------------------------------------------------------------
-ArenaGraph::ArenaGraph(const std::string &navmesh, const XMLNode *node)
+/** Loads an arena graph and computes the shortest paths between all nodes.
+ *  \param navmesh Name of the navmesh file.
+ *  \param node The track's scene node, used to find the goals in soccer mode.
+ *  \param path_cache If not empty, the name of a file in which the shortest
+ *         paths are cached: if the file contains the paths of this graph
+ *         they are loaded, otherwise they are computed and saved in it.
+ */
+ArenaGraph::ArenaGraph(const std::string &navmesh, const XMLNode *node,
+                       const std::string &path_cache)
           : Graph()
 {
+    m_path_buffer = NULL;
     loadNavmesh(navmesh);
+    createSectorGrid();
     buildGraph();
-    // Compute shortest distance from all nodes
-    for (unsigned int i = 0; i < getNumNodes(); i++)
-        computeDijkstra(i);
+
+    uint64_t graph_hash = 0;
+    bool loaded = false;
+    if (!path_cache.empty())
+    {
+        graph_hash = getGraphHash();
+        loaded = loadPaths(path_cache, graph_hash);
+    }
+    if (!loaded)
+    {
+        // Compute shortest distance from all nodes. It's only worth to
+        // start threads for big arenas.
+        unsigned int num_threads = 0;
+        if (getNumNodes() >= 256)
+        {
+            num_threads = std::min(std::thread::hardware_concurrency(), 4u);
+            num_threads = num_threads > 0 ? num_threads - 1 : 0;
+        }
+        computeAllPaths(num_threads);
+        if (!path_cache.empty())
+            savePaths(path_cache, graph_hash);
+    }
 
     setNearbyNodesOfAllNodes();
     if (node && race_manager->getMinorMode() == RaceManager::MINOR_MODE_SOCCER)
@@ -48,6 +108,12 @@ ArenaGraph::ArenaGraph(const std::string &navmesh, const XMLNode *node)
 
 }   // ArenaGraph
 
+// -----------------------------------------------------------------------------
+ArenaGraph::~ArenaGraph()
+{
+    btAlignedFree(m_path_buffer);
+}   // ~ArenaGraph
+
 // -----------------------------------------------------------------------------
 ArenaNode* ArenaGraph::getNode(unsigned int i) const
 {
@@ -175,47 +241,72 @@ void ArenaGraph::loadNavmesh(const std::string &navmesh)
 }   // loadNavmesh
 
 // ----------------------------------------------------------------------------
+/** Collects the edges of the graph, and allocates the rows of the shortest
+ *  paths, which are initialised by initRow().
+ */
 void ArenaGraph::buildGraph()
 {
     const unsigned int n_nodes = getNumNodes();
 
-    m_distance_matrix = std::vector<std::vector<float>>
-        (n_nodes, std::vector<float>(n_nodes, 9999.9f));
+    m_edge_start.clear();
+    m_edge_node.clear();
+    m_edge_length.clear();
     for (unsigned int i = 0; i < n_nodes; i++)
     {
         ArenaNode* cur_node = getNode(i);
+        m_edge_start.push_back((int)m_edge_node.size());
         for (const int& adjacent : cur_node->getAdjacentNodes())
         {
             Vec3 diff = getNode(adjacent)->getCenter() - cur_node->getCenter();
-            float distance = diff.length();
-            m_distance_matrix[i][adjacent] = distance;
+            m_edge_node.push_back(adjacent);
+            m_edge_length.push_back(diff.length());
         }
-        m_distance_matrix[i][i] = 0.0f;
     }
-
-    // Allocate and initialise the previous node data structure:
-    m_parent_node = std::vector<std::vector<int16_t>>
-        (n_nodes, std::vector<int16_t>(n_nodes, Graph::UNKNOWN_SECTOR));
+    m_edge_start.push_back((int)m_edge_node.size());
+
+    // 16 floats are a cache line
+    m_row_size = (n_nodes + 15) & ~15u;
+    const size_t num_entries = (size_t)n_nodes * m_row_size;
+    btAlignedFree(m_path_buffer);
+    m_path_buffer = btAlignedAlloc(num_entries * (sizeof(float) +
+                                                  sizeof(int16_t)), 64);
+    m_distances = (float*)m_path_buffer;
+    m_parents   = (int16_t*)(m_distances + num_entries);
     for (unsigned int i = 0; i < n_nodes; i++)
-    {
-        for (unsigned int j = 0; j < n_nodes; j++)
-        {
-            if (i == j || m_distance_matrix[i][j] >= 9899.9f)
-                m_parent_node[i][j] = -1;
-            else
-                m_parent_node[i][j] = i;
-        }   // for j
-    }   // for i
-
+        initRow(i);
 }   // buildGraph
 
+// ----------------------------------------------------------------------------
+/** Sets the distances and parents of a row to the direct edges of a node.
+ */
+void ArenaGraph::initRow(int source)
+{
+    const unsigned int n_nodes = getNumNodes();
+    float *distance = getDistanceRow(source);
+    int16_t *parent = getParentRow(source);
+    std::fill(distance, distance + n_nodes, 9999.9f);
+    for (int e = m_edge_start[source]; e < m_edge_start[source + 1]; e++)
+        distance[m_edge_node[e]] = m_edge_length[e];
+    distance[source] = 0.0f;
+
+    for (unsigned int j = 0; j < n_nodes; j++)
+    {
+        if (j == (unsigned int)source || distance[j] >= 9899.9f)
+            parent[j] = -1;
+        else
+            parent[j] = source;
+    }   // for j
+}   // initRow
+
 // ----------------------------------------------------------------------------
 /** Dijkstra shortest path computation. It computes the shortest distance from
  *  the specified node 'source' to all other nodes. At the end of the
- *  computation, m_distance_matrix[i][j] stores the shortest path distance from
- *  source to j and m_parent_node[source][j] stores the last vertex visited on
- *  the shortest path from i to j before visiting j. Suppose the shortest path
- *  from i to j is i->......->k->j  then m_parent_node[i][j] = k
+ *  computation, getDistance(source, j) returns the shortest path distance from
+ *  source to j and m_parents[source * m_row_size + j] stores the last vertex
+ *  visited on the shortest path from source to j before visiting j. Suppose
+ *  the shortest path from i to j is i->......->k->j  then the parent is k.
+ *  Only the row of 'source' is written, so the rows of different nodes can
+ *  be computed in parallel.
  */
 void ArenaGraph::computeDijkstra(int source)
 {
@@ -231,6 +322,8 @@ void ArenaGraph::computeDijkstra(int source)
         }
     };
 
+    float *distance = getDistanceRow(source);
+    int16_t *parent = getParentRow(source);
     std::priority_queue<IndDistPair, std::vector<IndDistPair>, Shortest> queue;
     IndDistPair begin(source, 0.0f);
     queue.push(begin);
@@ -246,33 +339,65 @@ void ArenaGraph::computeDijkstra(int source)
         if (visited[cur_index]) continue;
         visited[cur_index] = true;
 
-        for (const int& adjacent : getNode(cur_index)->getAdjacentNodes())
+        for (int e = m_edge_start[cur_index]; e < m_edge_start[cur_index + 1];
+             e++)
         {
+            const int adjacent = m_edge_node[e];
             // Distance already computed, can be ignored
             if (visited[adjacent]) continue;
 
-            float new_dist =
-                current.second + m_distance_matrix[cur_index][adjacent];
-            if (new_dist < m_distance_matrix[source][adjacent])
+            float new_dist = current.second + m_edge_length[e];
+            if (new_dist < distance[adjacent])
+            {
+                distance[adjacent] = new_dist;
+                parent[adjacent] = cur_index;
+            }
+            // A direct edge of the source starts with its final distance
+            // from initRow(), so it must be queued even if it's not shorter
+            if (new_dist <= distance[adjacent])
             {
-                m_distance_matrix[source][adjacent] = new_dist;
-                m_parent_node[source][adjacent] = cur_index;
+                IndDistPair pair(adjacent, new_dist);
+                queue.push(pair);
             }
-            IndDistPair pair(adjacent, new_dist);
-            queue.push(pair);
         }
     }
 }   // computeDijkstra
 
+// ----------------------------------------------------------------------------
+/** Computes the shortest paths from all nodes.
+ *  \param num_threads Number of extra threads to use, 0 to compute all
+ *         rows in this thread.
+ */
+void ArenaGraph::computeAllPaths(unsigned int num_threads)
+{
+    const unsigned int n = getNumNodes();
+    if (num_threads == 0)
+    {
+        for (unsigned int i = 0; i < n; i++)
+            computeDijkstra(i);
+        return;
+    }
+    ThreadPool pool(num_threads, "ArenaGraph");
+    // Each job computes a block of rows, to keep the overhead per job small
+    const unsigned int rows_per_job = 16;
+    pool.parallelFor((n + rows_per_job - 1) / rows_per_job,
+        [this, n, rows_per_job](unsigned int job)
+        {
+            const unsigned int end = std::min(n, (job + 1) * rows_per_job);
+            for (unsigned int i = job * rows_per_job; i < end; i++)
+                computeDijkstra(i);
+        });
+}   // computeAllPaths
+
 // ----------------------------------------------------------------------------
 /** THIS FUNCTION IS ONLY USED FOR UNIT-TESTING, to verify that the new
  *  Dijkstra algorithm gives the same results.
  *  computeFloydWarshall() computes the shortest distance between any two
- *  nodes. At the end of the computation, m_distance_matrix[i][j] stores the
- *  shortest path distance from i to j and m_parent_node[i][j] stores the last
- *  vertex visited on the shortest path from i to j before visiting j. Suppose
- *  the shortest path from i to j is i->......->k->j  then
- *  m_parent_node[i][j] = k
+ *  nodes. At the end of the computation, getDistance(i, j) returns the
+ *  shortest path distance from i to j and m_parents[i * m_row_size + j]
+ *  stores the last vertex visited on the shortest path from i to j before
+ *  visiting j. Suppose the shortest path from i to j is i->......->k->j  then
+ *  the parent is k.
  */
 void ArenaGraph::computeFloydWarshall()
 {
@@ -280,16 +405,18 @@ void ArenaGraph::computeFloydWarshall()
 
     for (unsigned int k = 0; k < n; k++)
     {
+        const float *distance_k = getDistanceRow(k);
+        const int16_t *parent_k = getParentRow(k);
         for (unsigned int i = 0; i < n; i++)
         {
+            float *distance_i = getDistanceRow(i);
+            int16_t *parent_i = getParentRow(i);
             for (unsigned int j = 0; j < n; j++)
             {
-                if ((m_distance_matrix[i][k] + m_distance_matrix[k][j]) <
-                    m_distance_matrix[i][j])
+                if ((distance_i[k] + distance_k[j]) < distance_i[j])
                 {
-                    m_distance_matrix[i][j] =
-                        m_distance_matrix[i][k] + m_distance_matrix[k][j];
-                    m_parent_node[i][j] = m_parent_node[k][j];
+                    distance_i[j] = distance_i[k] + distance_k[j];
+                    parent_i[j] = parent_k[j];
                 }
             }
         }
@@ -297,6 +424,133 @@ void ArenaGraph::computeFloydWarshall()
 
 }   // computeFloydWarshall
 
+// ----------------------------------------------------------------------------
+/** Returns a hash of the node centers and edges, which are all that the
+ *  shortest paths depend on. It identifies the graph a path cache file was
+ *  computed for.
+ */
+uint64_t ArenaGraph::getGraphHash() const
+{
+    uint64_t hash = FileUtils::HASH_SEED;
+    const uint32_t n = getNumNodes();
+    hash = FileUtils::hashBytes(&n, sizeof(n), hash);
+    for (unsigned int i = 0; i < n; i++)
+    {
+        const Vec3 &center = m_all_nodes[i]->getCenter();
+        const float xyz[3] = { center.getX(), center.getY(), center.getZ() };
+        hash = FileUtils::hashBytes(xyz, sizeof(xyz), hash);
+    }
+    hash = FileUtils::hashBytes(m_edge_start.data(),
+                                m_edge_start.size() * sizeof(int), hash);
+    return FileUtils::hashBytes(m_edge_node.data(),
+                                m_edge_node.size() * sizeof(int), hash);
+}   // getGraphHash
+
+// ----------------------------------------------------------------------------
+/** Loads the shortest paths from a cache file. Returns false if the file
+ *  does not exist, is from a different version, was written for a different
+ *  graph or is damaged.
+ *  \param file Name of the cache file.
+ *  \param graph_hash Hash of this graph, see getGraphHash().
+ */
+bool ArenaGraph::loadPaths(const std::string &file, uint64_t graph_hash)
+{
+    FILE *f = fopen(file.c_str(), "rb");
+    if (!f)
+        return false;
+
+    const unsigned int n = getNumNodes();
+    PathCacheHeader header;
+    if (fread(&header, sizeof(header), 1, f) != 1        ||
+        memcmp(header.m_magic, "STKPATH", 8) != 0        ||
+        header.m_version    != PATH_CACHE_VERSION        ||
+        header.m_endian     != 0x01020304                ||
+        header.m_num_nodes  != n                         ||
+        header.m_graph_hash != graph_hash                   )
+    {
+        fclose(f);
+        Log::info("ArenaGraph", "Cached paths '%s' are outdated.",
+                  file.c_str());
+        return false;
+    }
+
+    bool ok = true;
+    uint64_t hash = FileUtils::HASH_SEED;
+    for (unsigned int i = 0; i < n && ok; i++)
+    {
+        ok = fread(getDistanceRow(i), sizeof(float), n, f) == n;
+        hash = FileUtils::hashBytes(getDistanceRow(i), n * sizeof(float),
+                                    hash);
+    }
+    for (unsigned int i = 0; i < n && ok; i++)
+    {
+        ok = fread(getParentRow(i), sizeof(int16_t), n, f) == n;
+        hash = FileUtils::hashBytes(getParentRow(i), n * sizeof(int16_t),
+                                    hash);
+    }
+    fclose(f);
+    if (!ok || hash != header.m_data_hash)
+    {
+        Log::warn("ArenaGraph", "Failed to load cached paths '%s'.",
+                  file.c_str());
+        // Undo partially loaded rows
+        for (unsigned int i = 0; i < n; i++)
+            initRow(i);
+        return false;
+    }
+    return true;
+}   // loadPaths
+
+// ----------------------------------------------------------------------------
+/** Writes the shortest paths to a cache file, see
+ *  FileUtils::writeFileAtomically().
+ *  \param file Name of the cache file.
+ *  \param graph_hash Hash of this graph, see getGraphHash().
+ */
+void ArenaGraph::savePaths(const std::string &file, uint64_t graph_hash) const
+{
+    const unsigned int n = getNumNodes();
+    PathCacheHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.m_magic, "STKPATH", 8);
+    header.m_version    = PATH_CACHE_VERSION;
+    header.m_endian     = 0x01020304;
+    header.m_num_nodes  = n;
+    header.m_graph_hash = graph_hash;
+    header.m_data_hash  = FileUtils::HASH_SEED;
+    for (unsigned int i = 0; i < n; i++)
+    {
+        header.m_data_hash =
+            FileUtils::hashBytes(m_distances + i * m_row_size,
+                                 n * sizeof(float), header.m_data_hash);
+    }
+    for (unsigned int i = 0; i < n; i++)
+    {
+        header.m_data_hash =
+            FileUtils::hashBytes(m_parents + i * m_row_size,
+                                 n * sizeof(int16_t), header.m_data_hash);
+    }
+
+    const bool ok = FileUtils::writeFileAtomically(file, [&](FILE *f)
+        {
+            bool ok = fwrite(&header, sizeof(header), 1, f) == 1;
+            for (unsigned int i = 0; i < n && ok; i++)
+            {
+                ok = fwrite(m_distances + i * m_row_size, sizeof(float), n, f)
+                    == n;
+            }
+            for (unsigned int i = 0; i < n && ok; i++)
+            {
+                ok = fwrite(m_parents + i * m_row_size, sizeof(int16_t), n, f)
+                    == n;
+            }
+            return ok;
+        });
+    if (!ok)
+        Log::warn("ArenaGraph", "Failed to write cached paths '%s'.",
+                  file.c_str());
+}   // savePaths
+
 // -----------------------------------------------------------------------------
 void ArenaGraph::loadGoalNodes(const XMLNode *node)
 {
@@ -341,7 +595,8 @@ void ArenaGraph::setNearbyNodesOfAllNodes()
         // Get the distance to all nodes at i
         ArenaNode* cur_node = getNode(i);
         std::vector<int> nearby_nodes;
-        std::vector<float> dist = m_distance_matrix[i];
+        std::vector<float> dist(getDistanceRow(i),
+                                getDistanceRow(i) + getNumNodes());
 
         // Skip the same node
         dist[i] = 999999.0f;
@@ -363,13 +618,14 @@ void ArenaGraph::setNearbyNodesOfAllNodes()
  *  std::vector (in reverse order). Used only for unit testing.
  */
 std::vector<int16_t> ArenaGraph::getPathFromTo(int from, int to,
-                      const std::vector< std::vector< int16_t > >& parent_node)
+                                               const int16_t *parents,
+                                               unsigned int row_size)
 {
     std::vector<int16_t> path;
     path.push_back(to);
     while(from!=to)
     {
-        to = parent_node[from][to];
+        to = parents[from * row_size + to];
         path.push_back(to);
     }
     return path;
@@ -393,8 +649,43 @@ void ArenaGraph::unitTesting()
     Log::error("Time", "Dijkstra       %lf", e-s);
 
     // Save the Dijkstra results
-    std::vector< std::vector< float > > distance_matrix = ag->m_distance_matrix;
-    std::vector< std::vector< int16_t > > parent_node = ag->m_parent_node;
+    const unsigned int n = ag->getNumNodes();
+    const unsigned int row_size = ag->m_row_size;
+    std::vector<float> distances(ag->m_distances,
+                                 ag->m_distances + n * row_size);
+    std::vector<int16_t> parents(ag->m_parents, ag->m_parents + n * row_size);
+
+    // The rows computed in parallel and the rows loaded from a cache file
+    // must be identical to the rows computed in one thread
+    int error_count = 0;
+    auto compare_rows = [&](const ArenaGraph *other, const char *name)
+    {
+        for (unsigned int i = 0; i < n; i++)
+        {
+            if (memcmp(other->m_distances + i * row_size,
+                       distances.data() + i * row_size, n * sizeof(float)) ||
+                memcmp(other->m_parents + i * row_size,
+                       parents.data() + i * row_size, n * sizeof(int16_t)))
+            {
+                Log::error("ArenaGraph", "Different %s row %d.", name, i);
+                error_count++;
+            }
+        }
+    };
+    ag->buildGraph();
+    ag->computeAllPaths(3);
+    compare_rows(ag, "parallel");
+
+    const std::string cache = file_manager->getCachedPhysicsDir() +
+                              "unit-test.paths";
+    remove(cache.c_str());
+    ArenaGraph *saved = new ArenaGraph(navmesh_file_name, NULL, cache);
+    ArenaGraph *loaded = new ArenaGraph(navmesh_file_name, NULL, cache);
+    compare_rows(loaded, "cached");
+    delete saved;
+    delete loaded;
+    remove(cache.c_str());
+
     ag->buildGraph();
 
     // Now compute results with Floyd-Warshall
@@ -403,16 +694,16 @@ void ArenaGraph::unitTesting()
     e = StkTime::getRealTime();
     Log::error("Time", "Floyd-Warshall %lf", e-s);
 
-    int error_count = 0;
-    for(unsigned int i=0; i<ag->m_distance_matrix.size(); i++)
+    for(unsigned int i=0; i<n; i++)
     {
-        for(unsigned int j=0; j<ag->m_distance_matrix[i].size(); j++)
+        for(unsigned int j=0; j<n; j++)
         {
-            if(ag->m_distance_matrix[i][j] - distance_matrix[i][j] > 0.001f)
+            const float distance = distances[i * row_size + j];
+            if(fabsf(ag->getDistance(i, j) - distance) > 0.001f)
             {
                 Log::error("ArenaGraph",
                            "Incorrect distance %d, %d: Dijkstra: %f F.W.: %f",
-                           i, j, distance_matrix[i][j], ag->m_distance_matrix[i][j]);
+                           i, j, distance, ag->getDistance(i, j));
                 error_count++;
             }    // if distance is too different
 
@@ -424,16 +715,19 @@ void ArenaGraph::unitTesting()
             // debugging in the feature
 #undef TEST_PARENT_POLY_EVEN_THOUGH_MANY_FALSE_POSITIVES
 #ifdef TEST_PARENT_POLY_EVEN_THOUGH_MANY_FALSE_POSITIVES
-            if(ag->m_parent_node[i][j] != parent_node[i][j])
+            if(ag->m_parents[i * row_size + j] != parents[i * row_size + j])
             {
                 error_count++;
-                std::vector<int16_t> dijkstra_path = getPathFromTo(i, j, parent_node);
-                std::vector<int16_t> floyd_path = getPathFromTo(i, j, ag->m_parent_node);
+                std::vector<int16_t> dijkstra_path =
+                    getPathFromTo(i, j, parents.data(), row_size);
+                std::vector<int16_t> floyd_path =
+                    getPathFromTo(i, j, ag->m_parents, row_size);
                 if(dijkstra_path.size()!=floyd_path.size())
                 {
                     Log::error("ArenaGraph",
                                "Incorrect path length %d, %d: Dijkstra: %d F.W.: %d",
-                               i, j, parent_node[i][j], ag->m_parent_node[i][j]);
+                               i, j, parents[i * row_size + j],
+                               ag->m_parents[i * row_size + j]);
                     continue;
                 }
                 Log::error("ArenaGraph", "Path problems from %d to %d:",
@@ -452,5 +746,6 @@ void ArenaGraph::unitTesting()
     }   // for i
 
     delete ag;
+    assert(error_count == 0);
 
 }   // unitTesting
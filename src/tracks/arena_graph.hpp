@@ -34,11 +34,30 @@ class XMLNode;
 class ArenaGraph : public Graph
 {
 private:
-    /** The actual graph data structure, it is an adjacency matrix. */
-    std::vector<std::vector<float>> m_distance_matrix;
+    /** Number of entries of a row of m_distances and m_parents, the number
+     *  of nodes rounded up so that each row starts on a cache line. */
+    unsigned int m_row_size;
 
-    /** The matrix that is used to store computed shortest paths. */
-    std::vector<std::vector<int16_t>> m_parent_node;
+    /** One aligned buffer with the distance rows followed by the parent
+     *  rows, see m_distances and m_parents. */
+    void *m_path_buffer;
+
+    /** The shortest distance between any two nodes: the distance from i to
+     *  j is m_distances[i * m_row_size + j]. */
+    float *m_distances;
+
+    /** The parent nodes of the shortest paths: m_parents[i * m_row_size + j]
+     *  is the node before j on the shortest path from i to j. */
+    int16_t *m_parents;
+
+    /** The adjacent nodes of all nodes: the neighbours of node i are
+     *  m_edge_node[m_edge_start[i]] to m_edge_node[m_edge_start[i+1]-1]. */
+    std::vector<int> m_edge_start;
+
+    std::vector<int> m_edge_node;
+
+    /** The length of each edge in m_edge_node. */
+    std::vector<float> m_edge_length;
 
     /** Used in soccer mode to colorize the goal lines in minimap. */
     std::set<int> m_red_node;
@@ -52,14 +71,29 @@ private:
     // ------------------------------------------------------------------------
     void buildGraph();
     // ------------------------------------------------------------------------
+    void initRow(int source);
+    // ------------------------------------------------------------------------
     void setNearbyNodesOfAllNodes();
     // ------------------------------------------------------------------------
     void computeDijkstra(int n);
     // ------------------------------------------------------------------------
+    void computeAllPaths(unsigned int num_threads);
+    // ------------------------------------------------------------------------
     void computeFloydWarshall();
     // ------------------------------------------------------------------------
+    uint64_t getGraphHash() const;
+    // ------------------------------------------------------------------------
+    bool loadPaths(const std::string &file, uint64_t graph_hash);
+    // ------------------------------------------------------------------------
+    void savePaths(const std::string &file, uint64_t graph_hash) const;
+    // ------------------------------------------------------------------------
     static std::vector<int16_t> getPathFromTo(int from, int to,
-                     const std::vector< std::vector< int16_t > >& parent_node);
+                                              const int16_t *parents,
+                                              unsigned int row_size);
+    // ------------------------------------------------------------------------
+    float* getDistanceRow(int from) { return m_distances + from*m_row_size; }
+    // ------------------------------------------------------------------------
+    int16_t* getParentRow(int from)   { return m_parents + from*m_row_size; }
     // ------------------------------------------------------------------------
     virtual bool hasLapLine() const OVERRIDE                  { return false; }
     // ------------------------------------------------------------------------
@@ -70,21 +104,23 @@ public:
     // ------------------------------------------------------------------------
     static void unitTesting();
     // ------------------------------------------------------------------------
-    ArenaGraph(const std::string &navmesh, const XMLNode *node = NULL);
+    ArenaGraph(const std::string &navmesh, const XMLNode *node = NULL,
+               const std::string &path_cache = "");
     // ------------------------------------------------------------------------
-    virtual ~ArenaGraph() {}
+    virtual ~ArenaGraph();
     // ------------------------------------------------------------------------
     ArenaNode* getNode(unsigned int i) const;
     // ------------------------------------------------------------------------
     /** Returns the next node on the shortest path from i to j.
-     *  Note: m_parent_node[j][i] contains the parent of i on path from j to i,
-     *  which is the next node on the path from i to j (undirected graph)
+     *  Note: m_parents[j * m_row_size + i] contains the parent of i on path
+     *  from j to i, which is the next node on the path from i to j
+     *  (undirected graph)
      */
     int getNextNode(int i, int j) const
     {
         if (i == Graph::UNKNOWN_SECTOR || j == Graph::UNKNOWN_SECTOR)
             return Graph::UNKNOWN_SECTOR;
-        return (int)(m_parent_node[j][i]);
+        return (int)(m_parents[j * m_row_size + i]);
     }
     // ------------------------------------------------------------------------
     /** Returns the distance between any two nodes */
@@ -92,7 +128,7 @@ public:
     {
         if (from == Graph::UNKNOWN_SECTOR || to == Graph::UNKNOWN_SECTOR)
             return 99999.0f;
-        return m_distance_matrix[from][to];
+        return m_distances[from * m_row_size + to];
     }
 
 };   // ArenaGraph
@@ -160,6 +160,7 @@ void DriveGraph::load(const std::string &quad_file_name,
             max_height_testing);
     }
     delete quad;
+    createSectorGrid();
 
     const XMLNode *xml = file_manager->createXMLTree(filename);
 
@@ -25,13 +25,23 @@
 #include "graphics/material_manager.hpp"
 #include "graphics/sp/sp_mesh.hpp"
 #include "graphics/sp/sp_mesh_buffer.hpp"
+#include "io/file_manager.hpp"
 #include "modes/profile_world.hpp"
 #include "race/race_manager.hpp"
+#include "tracks/arena_graph.hpp"
 #include "tracks/arena_node_3d.hpp"
+#include "tracks/drive_graph.hpp"
 #include "tracks/drive_node_2d.hpp"
 #include "tracks/drive_node_3d.hpp"
 #include "tracks/track.hpp"
+#include "tracks/track_manager.hpp"
 #include "utils/log.hpp"
+#include "utils/time.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <random>
 
 const int Graph::UNKNOWN_SECTOR = -1;
 const float Graph::MIN_HEIGHT_TESTING = -1.0f;
@@ -48,6 +58,11 @@ Graph::Graph()
     m_bb_min      = Vec3( 99999,  99999,  99999);
     m_bb_max      = Vec3(-99999, -99999, -99999);
     memset(m_bb_nodes, 0, 4 * sizeof(int));
+    m_grid_min_x     = 0.0f;
+    m_grid_min_z     = 0.0f;
+    m_grid_cell_size = 1.0f;
+    m_grid_width     = 0;
+    m_grid_height    = 0;
 }  // Graph
 
 // -----------------------------------------------------------------------------
@@ -615,10 +630,6 @@ void Graph::findRoadSector(const Vec3& xyz, int *sector,
         return;
     }   // if still on same quad
 
-    // Now we search through all quads, starting with
-    // the current one
-    int indx       = *sector;
-
     // If a current sector is given, and max_lookahead is specify, only test
     // the next max_lookahead quads instead of testing the whole graph.
     // This is necessary for the AI: if the track contains a loop, e.g.:
@@ -628,26 +639,71 @@ void Graph::findRoadSector(const Vec3& xyz, int *sector,
     // and the track is supposed to be driven: ABCDEBF, the AI might find
     // the quad on F, and then keep on going straight ahead instead of
     // using the loop at all.
-    unsigned int max_count  = (*sector!=UNKNOWN_SECTOR && all_sectors!=NULL)
+    if ((*sector != UNKNOWN_SECTOR && all_sectors != NULL) ||
+        m_grid_cell_start.empty())
+    {
+        *sector = findRoadSectorLinear(xyz, *sector, all_sectors,
+                                       ignore_vertical);
+    }
+    else
+        *sector = findRoadSectorInGrid(xyz, *sector, ignore_vertical);
+}   // findRoadSector
+
+//-----------------------------------------------------------------------------
+/** Searches through all quads (or the given ones), starting with the one
+ *  after the current one, and returns the first quad containing the point.
+ */
+int Graph::findRoadSectorLinear(const Vec3& xyz, int curr_sector,
+                                std::vector<int> *all_sectors,
+                                bool ignore_vertical) const
+{
+    int indx = curr_sector;
+    unsigned int max_count  = (curr_sector!=UNKNOWN_SECTOR && all_sectors!=NULL)
                             ? (unsigned int)all_sectors->size()
                             : (unsigned int)m_all_nodes.size();
-    *sector = UNKNOWN_SECTOR;
     for(unsigned int i=0; i<max_count; i++)
     {
-        if(all_sectors)
+        if(all_sectors && curr_sector!=UNKNOWN_SECTOR)
             indx = (*all_sectors)[i];
         else
             indx = indx<(int)m_all_nodes.size()-1 ? indx +1 : 0;
         const Quad* q = getQuad(indx);
         if (q->pointInside(xyz, ignore_vertical))
-        {
-            *sector  = indx;
-            return;
-        }
+            return indx;
     }   // for i<m_all_nodes.size()
 
-    return;
-}   // findRoadSector
+    return UNKNOWN_SECTOR;
+}   // findRoadSectorLinear
+
+//-----------------------------------------------------------------------------
+/** Same as findRoadSectorLinear without a list of sectors, but only tests
+ *  the quads in the grid cell of the point. They are tested in the same
+ *  order (starting after the current quad), so the result is the same if
+ *  quads overlap.
+ */
+int Graph::findRoadSectorInGrid(const Vec3& xyz, int curr_sector,
+                                bool ignore_vertical) const
+{
+    int x, z;
+    getGridCell(xyz, &x, &z);
+    const unsigned cell = z * m_grid_width + x;
+    const int* begin = m_grid_quads.data() + m_grid_cell_start[cell];
+    const int* end   = m_grid_quads.data() + m_grid_cell_start[cell + 1];
+    const int first  = curr_sector < (int)m_all_nodes.size() - 1 ?
+                       curr_sector + 1 : 0;
+    const int* start = std::lower_bound(begin, end, first);
+    for (const int* i = start; i != end; i++)
+    {
+        if (getQuad(*i)->pointInside(xyz, ignore_vertical))
+            return *i;
+    }
+    for (const int* i = begin; i != start; i++)
+    {
+        if (getQuad(*i)->pointInside(xyz, ignore_vertical))
+            return *i;
+    }
+    return UNKNOWN_SECTOR;
+}   // findRoadSectorInGrid
 
 //-----------------------------------------------------------------------------
 /** findOutOfRoadSector finds the sector where XYZ is, but as it name
@@ -680,6 +736,26 @@ void Graph::findRoadSector(const Vec3& xyz, int *sector,
 int Graph::findOutOfRoadSector(const Vec3& xyz, const int curr_sector,
                                std::vector<int> *all_sectors,
                                bool ignore_vertical) const
+{
+    int sector;
+    if (all_sectors || m_grid_cell_start.empty())
+    {
+        sector = findOutOfRoadSectorLinear(xyz, curr_sector, all_sectors,
+                                           ignore_vertical);
+    }
+    else
+        sector = findOutOfRoadSectorInGrid(xyz, curr_sector, ignore_vertical);
+    if (sector != UNKNOWN_SECTOR)
+        return sector;
+
+    Log::warn("Graph", "unknown sector found.");
+    return 0;
+}   // findOutOfRoadSector
+
+//-----------------------------------------------------------------------------
+int Graph::findOutOfRoadSectorLinear(const Vec3& xyz, int curr_sector,
+                                     std::vector<int> *all_sectors,
+                                     bool ignore_vertical) const
 {
     int count = (all_sectors!=NULL) ? (int)all_sectors->size() : getNumNodes();
     int current_sector = 0;
@@ -696,7 +772,8 @@ int Graph::findOutOfRoadSector(const Vec3& xyz, const int curr_sector,
         // shortcuts are tested). If this should become a performance
         // bottleneck, we need to set up a graph of 'next' quads for each
         // quad (similar to what the AI does), and only test the quads
-        // in this graph.
+        // in this graph. The grid is used instead if there are no
+        // sectors given, see findOutOfRoadSectorInGrid.
         const int LIMIT = getNumNodes();
         count           = LIMIT;
         // Start 10 quads before the current quad, so the quads closest
@@ -756,9 +833,205 @@ int Graph::findOutOfRoadSector(const Vec3& xyz, const int curr_sector,
     }   // phase
     
     // We can only reach this point if min_sector==UNKNOWN_SECTOR
-    Log::warn("Graph", "unknown sector found.");
-    return 0;
-}   // findOutOfRoadSector
+    return UNKNOWN_SECTOR;
+}   // findOutOfRoadSectorLinear
+
+//-----------------------------------------------------------------------------
+/** Same as findOutOfRoadSectorLinear without a list of sectors, but only
+ *  tests the quads in the grid cells around the point, in rings of cells
+ *  until no cell left can contain a closer quad. The distance to a quad is
+ *  measured from its centre line, which is inside the 2d bounding box the
+ *  quad is added to the grid with, so the distance of a point to a cell is
+ *  a lower bound for the distance to all quads in it. If several quads have
+ *  the same distance, the one the linear search would find first is used.
+ */
+int Graph::findOutOfRoadSectorInGrid(const Vec3& xyz, int curr_sector,
+                                     bool ignore_vertical) const
+{
+    const int n = (int)m_all_nodes.size();
+    // The linear search starts after this sector
+    int previous = 0;
+    if (curr_sector != UNKNOWN_SECTOR)
+        previous = ((curr_sector - 10) % n + n) % n;
+    const int first = previous + 1 == n ? 0 : previous + 1;
+
+    int cx, cz;
+    getGridCell(xyz, &cx, &cz);
+    for (int phase = 0; phase < 2; phase++)
+    {
+        int   min_sector = UNKNOWN_SECTOR;
+        int   min_order  = n;
+        float min_dist_2 = 999999.0f*999999.0f;
+        for (int r = 0; ; r++)
+        {
+            const int x0 = cx - r, x1 = cx + r, z0 = cz - r, z1 = cz + r;
+            for (int z = std::max(z0, 0); z <= std::min(z1, m_grid_height - 1);
+                 z++)
+            {
+                // Only the cells on the ring, the inner ones are done
+                const bool full_row = z == z0 || z == z1;
+                for (int x = std::max(x0, 0);
+                     x <= std::min(x1, m_grid_width - 1); x++)
+                {
+                    if (!full_row && x != x0 && x != x1)
+                    {
+                        x = x1 - 1;
+                        continue;
+                    }
+                    const unsigned cell = z * m_grid_width + x;
+                    for (unsigned i = m_grid_cell_start[cell];
+                         i < m_grid_cell_start[cell + 1]; i++)
+                    {
+                        const int sector = m_grid_quads[i];
+                        const Quad* q = getQuad(sector);
+                        if (q->isIgnored())
+                            continue;
+                        const float dist_2 = q->getDistance2FromPoint(xyz);
+                        const int order = (sector - first + n) % n;
+                        if (dist_2 > min_dist_2 ||
+                            (dist_2 == min_dist_2 && order >= min_order))
+                            continue;
+                        // See findOutOfRoadSectorLinear for the height test
+                        const float dist = xyz.getY() - q->getMinHeight();
+                        if (phase == 1 || (dist < 5.0f && dist > -1.0f) ||
+                            q->is3DQuad() || ignore_vertical)
+                        {
+                            min_dist_2 = dist_2;
+                            min_sector = sector;
+                            min_order  = order;
+                        }
+                    }   // for i in cell
+                }   // for x
+            }   // for z
+
+            // Minimum distance from the point to any cell not tested yet
+            float min_cell_dist = std::numeric_limits<float>::max();
+            if (x0 > 0)
+            {
+                min_cell_dist = std::min(min_cell_dist, xyz.getX() -
+                    (m_grid_min_x + x0 * m_grid_cell_size));
+            }
+            if (x1 < m_grid_width - 1)
+            {
+                min_cell_dist = std::min(min_cell_dist,
+                    (m_grid_min_x + (x1 + 1) * m_grid_cell_size) - xyz.getX());
+            }
+            if (z0 > 0)
+            {
+                min_cell_dist = std::min(min_cell_dist, xyz.getZ() -
+                    (m_grid_min_z + z0 * m_grid_cell_size));
+            }
+            if (z1 < m_grid_height - 1)
+            {
+                min_cell_dist = std::min(min_cell_dist,
+                    (m_grid_min_z + (z1 + 1) * m_grid_cell_size) - xyz.getZ());
+            }
+            if (min_cell_dist == std::numeric_limits<float>::max())
+                break;
+            // Allow for rounding errors of the cell borders
+            min_cell_dist = std::max(min_cell_dist - 0.01f, 0.0f);
+            if (min_sector != UNKNOWN_SECTOR &&
+                min_cell_dist * min_cell_dist > min_dist_2)
+                break;
+        }   // for r
+        if (min_sector != UNKNOWN_SECTOR)
+            return min_sector;
+    }   // phase
+    return UNKNOWN_SECTOR;
+}   // findOutOfRoadSectorInGrid
+
+//-----------------------------------------------------------------------------
+/** Creates the grid used by findRoadSector and findOutOfRoadSector, must be
+ *  called after all quads are created. Each quad is added to all cells its
+ *  2d bounding box overlaps.
+ */
+void Graph::createSectorGrid()
+{
+    m_grid_cell_start.clear();
+    m_grid_quads.clear();
+    const unsigned n = getNumNodes();
+    if (n == 0)
+        return;
+
+    std::vector<Vec3> quad_min(n), quad_max(n);
+    float min_x =  std::numeric_limits<float>::max(), min_z = min_x;
+    float max_x = -std::numeric_limits<float>::max(), max_z = max_x;
+    for (unsigned i = 0; i < n; i++)
+    {
+        const Quad& q = *m_all_nodes[i];
+        Vec3 q_min = q[0], q_max = q[0];
+        for (int j = 1; j < 4; j++)
+        {
+            q_min.min(q[j]);
+            q_max.max(q[j]);
+        }
+        // The box of 3d quads reaches up to 5 units along the normal (see
+        // BoundingBox3D), a small margin is used for 2d quads against
+        // rounding errors in pointInside
+        const float margin = q.is3DQuad() ? 5.0f : 0.01f;
+        q_min -= Vec3(margin, 0, margin);
+        q_max += Vec3(margin, 0, margin);
+        quad_min[i] = q_min;
+        quad_max[i] = q_max;
+        min_x = std::min(min_x, q_min.getX());
+        min_z = std::min(min_z, q_min.getZ());
+        max_x = std::max(max_x, q_max.getX());
+        max_z = std::max(max_z, q_max.getZ());
+    }
+
+    // About one cell for two quads, smaller cells make the search of
+    // findOutOfRoadSector slower as quads are in more cells
+    const float width = max_x - min_x, height = max_z - min_z;
+    m_grid_cell_size = std::max(sqrtf(width * height / (0.5f * n)), 1.0f);
+    m_grid_cell_size = std::max(m_grid_cell_size,
+                                std::max(width, height) / 1024.0f);
+    m_grid_min_x  = min_x;
+    m_grid_min_z  = min_z;
+    m_grid_width  = (int)(width  / m_grid_cell_size) + 1;
+    m_grid_height = (int)(height / m_grid_cell_size) + 1;
+
+    // Count the quads of each cell first, then fill them in
+    std::vector<std::pair<int, int> > cells_min(n), cells_max(n);
+    m_grid_cell_start.resize(m_grid_width * m_grid_height + 1, 0);
+    for (unsigned i = 0; i < n; i++)
+    {
+        getGridCell(quad_min[i], &cells_min[i].first, &cells_min[i].second);
+        getGridCell(quad_max[i], &cells_max[i].first, &cells_max[i].second);
+        for (int z = cells_min[i].second; z <= cells_max[i].second; z++)
+        {
+            for (int x = cells_min[i].first; x <= cells_max[i].first; x++)
+                m_grid_cell_start[z * m_grid_width + x + 1]++;
+        }
+    }
+    for (unsigned i = 1; i < m_grid_cell_start.size(); i++)
+        m_grid_cell_start[i] += m_grid_cell_start[i - 1];
+    m_grid_quads.resize(m_grid_cell_start.back());
+    std::vector<unsigned> next(m_grid_cell_start.begin(),
+                               m_grid_cell_start.end() - 1);
+    // Quads are added in increasing order, so each cell is sorted
+    for (unsigned i = 0; i < n; i++)
+    {
+        for (int z = cells_min[i].second; z <= cells_max[i].second; z++)
+        {
+            for (int x = cells_min[i].first; x <= cells_max[i].first; x++)
+                m_grid_quads[next[z * m_grid_width + x]++] = i;
+        }
+    }
+}   // createSectorGrid
+
+//-----------------------------------------------------------------------------
+/** Returns the grid cell of a point, points outside of the grid are clamped
+ *  to the closest cell.
+ */
+void Graph::getGridCell(const Vec3& xyz, int* x, int* z) const
+{
+    const float fx = (xyz.getX() - m_grid_min_x) / m_grid_cell_size;
+    const float fz = (xyz.getZ() - m_grid_min_z) / m_grid_cell_size;
+    *x = !(fx > 0.0f) ? 0 : fx >= (float)m_grid_width  ? m_grid_width  - 1
+                                                        : (int)fx;
+    *z = !(fz > 0.0f) ? 0 : fz >= (float)m_grid_height ? m_grid_height - 1
+                                                        : (int)fz;
+}   // getGridCell
 
 //-----------------------------------------------------------------------------
 void Graph::loadBoundingBoxNodes()
@@ -772,3 +1045,114 @@ void Graph::loadBoundingBoxNodes()
     m_bb_nodes[3] = findOutOfRoadSector(Vec3(m_bb_max.x(), 0, m_bb_max.z()),
         -1/*curr_sector*/, NULL/*all_sectors*/, true/*ignore_vertical*/);
 }   // loadBoundingBoxNodes
+
+//-----------------------------------------------------------------------------
+/** Compares the grid search of findRoadSector and findOutOfRoadSector with
+ *  the linear search for random points of all tracks (on the quads and
+ *  around them), and prints the time of both searches for each track.
+ */
+void Graph::benchmark()
+{
+    std::mt19937 random(1);
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+    const unsigned count = 20000;
+    for (unsigned t = 0; t < track_manager->getNumberOfTracks(); t++)
+    {
+        Track* track = track_manager->getTrack(t);
+        Graph* graph = NULL;
+        if (track->hasNavMesh())
+            graph = new ArenaGraph(track->getTrackFile("navmesh.xml"));
+        else if (file_manager->fileExists(track->getTrackFile("quads.xml")))
+        {
+            // The constructor sets the graph
+            new DriveGraph(track->getTrackFile("quads.xml"),
+                track->getTrackFile("graph.xml"), false/*reverse*/);
+            graph = Graph::get();
+        }
+        if (!graph)
+            continue;
+        const unsigned n = graph->getNumNodes();
+
+        // Half of the points are on (or slightly above) random quads, the
+        // others anywhere in and around the bounding box of the graph
+        std::vector<Vec3> points(count);
+        const Vec3 bb_min = graph->m_bb_min - Vec3(20.0f, 5.0f, 20.0f);
+        const Vec3 bb_size = graph->m_bb_max + Vec3(20.0f, 5.0f, 20.0f) -
+            bb_min;
+        for (unsigned i = 0; i < count && n > 0; i++)
+        {
+            if (i % 2 == 0)
+            {
+                const Quad& q = *graph->getQuad(random() % n);
+                points[i] = q[0] + (q[1] - q[0]) * unit(random) +
+                    (q[3] - q[0]) * unit(random) +
+                    Vec3(0, unit(random) * 2.0f, 0);
+            }
+            else
+            {
+                points[i] = bb_min + Vec3(bb_size.getX() * unit(random),
+                    bb_size.getY() * unit(random),
+                    bb_size.getZ() * unit(random));
+            }
+        }
+
+        // The result for the previous point is used as current sector, so
+        // the search order of the linear search is tested too
+        std::vector<int> road_linear(count), road_grid(count);
+        std::vector<int> out_linear(count), out_grid(count);
+        uint64_t start = StkTime::getMonoTimeUs();
+        for (unsigned i = 0; i < count && n > 0; i++)
+        {
+            road_linear[i] = graph->findRoadSectorLinear(points[i],
+                i > 0 ? road_linear[i - 1] : UNKNOWN_SECTOR, NULL, false);
+        }
+        const uint64_t road_linear_us = StkTime::getMonoTimeUs() - start;
+        start = StkTime::getMonoTimeUs();
+        for (unsigned i = 0; i < count && n > 0; i++)
+        {
+            road_grid[i] = graph->findRoadSectorInGrid(points[i],
+                i > 0 ? road_linear[i - 1] : UNKNOWN_SECTOR, false);
+        }
+        const uint64_t road_grid_us = StkTime::getMonoTimeUs() - start;
+        start = StkTime::getMonoTimeUs();
+        for (unsigned i = 0; i < count && n > 0; i++)
+        {
+            out_linear[i] = graph->findOutOfRoadSectorLinear(points[i],
+                i > 0 ? out_linear[i - 1] : UNKNOWN_SECTOR, NULL, false);
+        }
+        const uint64_t out_linear_us = StkTime::getMonoTimeUs() - start;
+        start = StkTime::getMonoTimeUs();
+        for (unsigned i = 0; i < count && n > 0; i++)
+        {
+            out_grid[i] = graph->findOutOfRoadSectorInGrid(points[i],
+                i > 0 ? out_linear[i - 1] : UNKNOWN_SECTOR, false);
+        }
+        const uint64_t out_grid_us = StkTime::getMonoTimeUs() - start;
+
+        unsigned errors = 0;
+        for (unsigned i = 0; i < count && n > 0; i++)
+        {
+            if (road_linear[i] == road_grid[i] && out_linear[i] == out_grid[i])
+                continue;
+            if (errors++ < 5)
+            {
+                Log::error("Benchmark", "%s: point %f %f %f: findRoadSector "
+                    "%d / %d, findOutOfRoadSector %d / %d.",
+                    track->getIdent().c_str(), points[i].getX(),
+                    points[i].getY(), points[i].getZ(), road_linear[i],
+                    road_grid[i], out_linear[i], out_grid[i]);
+            }
+        }
+        Log::info("Benchmark", "%-20s %5u quads: findRoadSector linear "
+            "%8.3f us grid %6.3f us, findOutOfRoadSector linear %8.3f us "
+            "grid %6.3f us, %u errors.", track->getIdent().c_str(), n,
+            (float)road_linear_us / count, (float)road_grid_us / count,
+            (float)out_linear_us / count, (float)out_grid_us / count,
+            errors);
+
+        if (graph == Graph::get())
+            Graph::destroy();
+        else
+            delete graph;
+    }
+}   // benchmark
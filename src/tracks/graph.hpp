@@ -66,6 +66,8 @@ protected:
     // ------------------------------------------------------------------------
     /** Map 4 bounding box points to 4 closest graph nodes. */
     void loadBoundingBoxNodes();
+    // ------------------------------------------------------------------------
+    void createSectorGrid();
 
 private:
     /** The 2d bounding box, used for hashing. */
@@ -75,6 +77,23 @@ private:
     /** The 4 closest graph nodes to the bounding box. */
     int m_bb_nodes[4];
 
+    /** A grid in the x/z plane over all quads, so that finding the quad of
+     *  a point only needs to test the quads overlapping its cell. */
+    float m_grid_min_x, m_grid_min_z;
+
+    /** Size of a grid cell. */
+    float m_grid_cell_size;
+
+    /** Number of cells in x and z direction. */
+    int m_grid_width, m_grid_height;
+
+    /** Index of the first quad of each cell in m_grid_quads, with one more
+     *  entry for the end of the last cell. Empty if there is no grid. */
+    std::vector<unsigned> m_grid_cell_start;
+
+    /** Indices of the quads overlapping each cell, sorted in each cell. */
+    std::vector<int> m_grid_quads;
+
     /** The node of the graph mesh. */
     scene::ISceneNode *m_node;
 
@@ -106,6 +125,22 @@ private:
     virtual bool hasLapLine() const = 0;
     // ------------------------------------------------------------------------
     virtual void differentNodeColor(int n, video::SColor* c) const = 0;
+    // ------------------------------------------------------------------------
+    void getGridCell(const Vec3& xyz, int* x, int* z) const;
+    // ------------------------------------------------------------------------
+    int findRoadSectorInGrid(const Vec3& xyz, int curr_sector,
+                             bool ignore_vertical) const;
+    // ------------------------------------------------------------------------
+    int findRoadSectorLinear(const Vec3& xyz, int curr_sector,
+                             std::vector<int> *all_sectors,
+                             bool ignore_vertical) const;
+    // ------------------------------------------------------------------------
+    int findOutOfRoadSectorInGrid(const Vec3& xyz, int curr_sector,
+                                  bool ignore_vertical) const;
+    // ------------------------------------------------------------------------
+    int findOutOfRoadSectorLinear(const Vec3& xyz, int curr_sector,
+                                  std::vector<int> *all_sectors,
+                                  bool ignore_vertical) const;
 
 public:
     static const int UNKNOWN_SECTOR;
@@ -172,6 +207,8 @@ public:
     const Vec3& getBBMax() const                           { return m_bb_max; }
     // ------------------------------------------------------------------------
     const int* getBBNodes() const                        { return m_bb_nodes; }
+    // ------------------------------------------------------------------------
+    static void benchmark();
 
 };   // Graph
 
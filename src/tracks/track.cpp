@@ -61,6 +61,7 @@
 #include "modes/easter_egg_hunt.hpp"
 #include "modes/profile_world.hpp"
 #include "network/network_config.hpp"
+#include "network/server_config.hpp"
 #include "network/protocols/server_lobby.hpp"
 #include "physics/physical_object.hpp"
 #include "physics/physics.hpp"
@@ -79,6 +80,7 @@
 #include "utils/log.hpp"
 #include "utils/mini_glm.hpp"
 #include "utils/string_utils.hpp"
+#include "utils/time.hpp"
 #include "utils/translation.hpp"
 
 #include <IBillboardTextSceneNode.h>
@@ -89,6 +91,8 @@
 #include <ISceneManager.h>
 #include <SMeshBuffer.h>
 
+#include <cstring>
+#include <fstream>
 #include <iostream>
 #include <stdexcept>
 #include <sstream>
@@ -173,7 +177,7 @@ Track::Track(const std::string &filename)
         btTransform(btQuaternion(0.0f, 0.0f, 0.0f, 1.0f));
     m_default_number_of_laps = 3;
     m_all_nodes.clear();
-    m_static_physics_only_nodes.clear();
+    m_static_physics_only_objects.clear();
     m_all_cached_meshes.clear();
     loadTrackInfo();
 }   // Track
@@ -340,11 +344,12 @@ void Track::cleanup()
     }
     m_all_nodes.clear();
 
-    for (unsigned int i = 0; i < m_static_physics_only_nodes.size(); i++)
+    for (unsigned int i = 0; i < m_static_physics_only_objects.size(); i++)
     {
-        m_static_physics_only_nodes[i]->remove();
+        if (m_static_physics_only_objects[i].m_node)
+            m_static_physics_only_objects[i].m_node->remove();
     }
-    m_static_physics_only_nodes.clear();
+    m_static_physics_only_objects.clear();
 
     m_all_emitters.clearAndDeleteAll();
 
@@ -749,7 +754,10 @@ void Track::loadArenaGraph(const XMLNode &node)
         }
     }
 
-    ArenaGraph* graph = new ArenaGraph(m_root+"navmesh.xml", &node);
+    // The shortest paths between all nodes are cached, since computing them
+    // takes a while for big arenas
+    ArenaGraph* graph = new ArenaGraph(m_root+"navmesh.xml", &node,
+        file_manager->getCachedPhysicsDir() + m_ident + ".paths");
     Graph::setGraph(graph);
 
     if(Graph::get()->getNumNodes()==0)
@@ -864,17 +872,23 @@ void Track::createPhysicsModel(unsigned int main_track_count)
 
     // Now convert all objects that are only used for the physics
     // (like invisible walls).
-    for (unsigned int i = 0; i<m_static_physics_only_nodes.size(); i++)
+    for (unsigned int i = 0; i<m_static_physics_only_objects.size(); i++)
     {
-        main_loop->renderGUI(5550, i, m_static_physics_only_nodes.size());
+        main_loop->renderGUI(5550, i, m_static_physics_only_objects.size());
 
-        convertTrackToBullet(m_static_physics_only_nodes[i]);
+        scene::ISceneNode *node = m_static_physics_only_objects[i].m_node;
+        if (!node)
+        {
+            addModelTriangles(m_static_physics_only_objects[i].m_model);
+            continue;
+        }
+        convertTrackToBullet(node);
         if (UserConfigParams::m_physics_debug &&
-            m_static_physics_only_nodes[i]->getType() == scene::ESNT_MESH)
+            node->getType() == scene::ESNT_MESH)
         {
             const video::SColor color(255, 255, 105, 180);
 
-            scene::IMesh *mesh = ((scene::IMeshSceneNode*)m_static_physics_only_nodes[i])->getMesh();
+            scene::IMesh *mesh = ((scene::IMeshSceneNode*)node)->getMesh();
             scene::IMeshBuffer *mb = mesh->getMeshBuffer(0);
             mb->getMaterial().BackfaceCulling = false;
             video::S3DVertex * const verts = (video::S3DVertex *) mb->getVertices();
@@ -885,15 +899,15 @@ void Track::createPhysicsModel(unsigned int main_track_count)
             }
         }
         else
-            irr_driver->removeNode(m_static_physics_only_nodes[i]);
+            irr_driver->removeNode(node);
     }
     main_loop->renderGUI(5560);
     if (!UserConfigParams::m_physics_debug)
-        m_static_physics_only_nodes.clear();
+        m_static_physics_only_objects.clear();
 
     for (unsigned int i = 0; i<m_object_physics_only_nodes.size(); i++)
     {
-        main_loop->renderGUI(5565, i, m_static_physics_only_nodes.size());
+        main_loop->renderGUI(5565, i, m_static_physics_only_objects.size());
         convertTrackToBullet(m_object_physics_only_nodes[i]);
         m_object_physics_only_nodes[i]->setVisible(false);
         m_object_physics_only_nodes[i]->grab();
@@ -909,7 +923,15 @@ void Track::createPhysicsModel(unsigned int main_track_count)
         uploadNodeVertexBuffer(m_all_nodes[i]);
     }
     main_loop->renderGUI(5580);
-    m_track_mesh->createPhysicalBody(m_friction);
+    // A server loads a new track for each race, so it caches the bvh of
+    // the track to load it faster. Clients don't cache it, since the file
+    // of a big track takes tens of MB of disk space.
+    std::string bvh_cache;
+    if (NetworkConfig::get()->isNetworking() &&
+        NetworkConfig::get()->isServer() && ServerConfig::m_cache_track_bvh)
+        bvh_cache = file_manager->getCachedPhysicsDir() + m_ident + ".bvh";
+    m_track_mesh->createPhysicalBody(m_friction,
+        (btCollisionObject::CollisionFlags)0, bvh_cache);
     main_loop->renderGUI(5585);
     m_gfx_effect_mesh->createCollisionShape();
     main_loop->renderGUI(5590);
@@ -1149,6 +1171,62 @@ void Track::convertTrackToBullet(scene::ISceneNode *node)
 
 }   // convertTrackToBullet
 
+// ----------------------------------------------------------------------------
+/** Returns the absolute transform a scene node at the root of the scene
+ *  would have (see ISceneNode::getRelativeTransformation()).
+ */
+static core::matrix4 getModelTransform(const core::vector3df &xyz,
+                                       const core::vector3df &hpr,
+                                       const core::vector3df &scale)
+{
+    core::matrix4 mat;
+    mat.setRotationDegrees(hpr);
+    mat.setTranslation(xyz);
+    if (scale != core::vector3df(1.0f, 1.0f, 1.0f))
+    {
+        core::matrix4 mat_scale;
+        mat_scale.setScale(scale);
+        mat *= mat_scale;
+    }
+    return mat;
+}   // getModelTransform
+
+// ----------------------------------------------------------------------------
+/** Adds the triangles of a model which was read without a scene node to the
+ *  physics, in the same way as convertTrackToBullet() does for the scene
+ *  node of the model.
+ *  \param model The collision geometry and transform of the model.
+ */
+void Track::addModelTriangles(const CollisionModel &model)
+{
+    Vec3 vertices[3];
+    Vec3 normals[3];
+    for (const SPMCollisionLoader::Buffer &b : model.m_buffers)
+    {
+        TriangleMesh *tmesh = m_track_mesh;
+        if (b.m_material->isSurface())
+            tmesh = m_gfx_effect_mesh;
+        else if (b.m_material->isIgnore())
+            continue;
+
+        for (unsigned int j = 0; j + 2 < b.m_indices.size(); j += 3)
+        {
+            for (unsigned int k = 0; k < 3; k++)
+            {
+                const uint16_t indx = b.m_indices[j + k];
+                core::vector3df v = b.m_positions[indx];
+                model.m_transform.transformVect(v);
+                vertices[k] = v;
+                // Like convertTrackToBullet, the normals are not transformed
+                normals[k] = b.m_normals[indx];
+            }   // for k
+            tmesh->addTriangle(vertices[0], vertices[1], vertices[2],
+                               normals[0], normals[1], normals[2],
+                               b.m_material);
+        }   // for j
+    }
+}   // addModelTriangles
+
 // ----------------------------------------------------------------------------
 
 void Track::loadMinimap()
@@ -1205,71 +1283,124 @@ bool Track::loadMainTrack(const XMLNode &root)
     std::string model_name;
     track_node->get("model", &model_name);
     std::string full_path = m_root+model_name;
-    scene::IMesh *mesh = irr_driver->getMesh(full_path);
-
-    if(!mesh)
-    {
-        Log::fatal("track",
-                   "Main track model '%s' in '%s' not found, aborting.\n",
-                   track_node->getName().c_str(), model_name.c_str());
-    }
 
-    scene::ISceneNode* scene_node = NULL;
-    scene::IMesh* tangent_mesh = NULL;
 #ifdef SERVER_ONLY
-    if (false)
+    // A server only needs the collision triangles of the static models, so
+    // static spm files are read without creating irrlicht meshes, textures
+    // and scene nodes. Other models (e.g. b3d or LOD) still use scene nodes.
+    const bool physics_only = true;
 #else
-    if (m_version < 7 && !CVS->isGLSL() && !ProfileWorld::isNoGraphics())
+    const bool physics_only = false;
 #endif
+    // Converts the scene nodes which were added since the last call, so that
+    // the triangles are added in the same order as the models are listed,
+    // independent of whether they were read with or without scene node.
+    unsigned int converted_nodes = 0;
+    auto convert_nodes = [this, &converted_nodes]()
     {
-        // The mesh as returned does not have all mesh buffers with the same
-        // texture combined. This can result in a _HUGE_ overhead. E.g. instead
-        // of 46 different mesh buffers over 500 (for some tracks even >1000)
-        // were created. This means less effect from hardware support, less
-        // vertices per opengl operation, more overhead on CPU, ...
-        // So till we have a better b3d exporter which can combine the different
-        // meshes which use the same texture when exporting, the meshes are
-        // combined using CBatchingMesh.
-        scene::CBatchingMesh *merged_mesh = new scene::CBatchingMesh();
-        merged_mesh->addMesh(mesh);
-        merged_mesh->finalize();
-        tangent_mesh = merged_mesh;
-        // The reference count of the mesh is 1, since it is in irrlicht's
-        // cache. So we only have to remove it from the cache.
-        irr_driver->removeMeshFromCache(mesh);
+        for (; converted_nodes < m_all_nodes.size(); converted_nodes++)
+        {
+            const unsigned int i = converted_nodes;
+            main_loop->renderGUI(4350, i, m_all_nodes.size());
+            convertTrackToBullet(m_all_nodes[i]);
+            main_loop->renderGUI(4360, i, m_all_nodes.size());
+            uploadNodeVertexBuffer(m_all_nodes[i]);
+            main_loop->renderGUI(4400, i, m_all_nodes.size());
+        }
+    };
+
+    core::vector3df xyz(0,0,0);
+    track_node->getXYZ(&xyz);
+    core::vector3df hpr(0,0,0);
+    track_node->getHPR(&hpr);
+
+    scene::ISceneNode* scene_node = NULL;
+    scene::IMesh* tangent_mesh = NULL;
+    CollisionModel model;
+    if (physics_only &&
+        SPMCollisionLoader::load(full_path, &model.m_buffers))
+    {
+        model.m_transform = getModelTransform(xyz, hpr,
+                                              core::vector3df(1, 1, 1));
+        addModelTriangles(model);
+        // Same as MeshTools::minMax3D for the mesh
+        m_aabb_min = Vec3( 999999.9f);
+        m_aabb_max = Vec3(-999999.9f);
+        for (const SPMCollisionLoader::Buffer &b : model.m_buffers)
+        {
+            for (uint16_t indx : b.m_indices)
+            {
+                const Vec3 c(b.m_positions[indx]);
+                m_aabb_min.min(c);
+                m_aabb_max.max(c);
+            }
+        }
+        main_loop->renderGUI(4000);
     }
     else
     {
-        // SPM does the combine for you
-        tangent_mesh = mesh;
-        tangent_mesh->grab();
-    }
-    // The merged mesh is grabbed by the octtree, so we don't need
-    // to keep a reference to it.
-    scene_node = irr_driver->addMesh(tangent_mesh, "track_main");
-    // We should drop the merged mesh (since it's now referred to in the
-    // scene node), but then we need to grab it since it's in the
-    // m_all_cached_meshes.
-    m_all_cached_meshes.push_back(tangent_mesh);
-    irr_driver->grabAllTextures(tangent_mesh);
-    main_loop->renderGUI(4000);
+        scene::IMesh *mesh = irr_driver->getMesh(full_path);
+
+        if(!mesh)
+        {
+            Log::fatal("track",
+                       "Main track model '%s' in '%s' not found, aborting.\n",
+                       track_node->getName().c_str(), model_name.c_str());
+        }
+
+#ifdef SERVER_ONLY
+        if (false)
+#else
+        if (m_version < 7 && !CVS->isGLSL() && !ProfileWorld::isNoGraphics())
+#endif
+        {
+            // The mesh as returned does not have all mesh buffers with the
+            // same texture combined. This can result in a _HUGE_ overhead.
+            // E.g. instead of 46 different mesh buffers over 500 (for some
+            // tracks even >1000) were created. This means less effect from
+            // hardware support, less vertices per opengl operation, more
+            // overhead on CPU, ...
+            // So till we have a better b3d exporter which can combine the
+            // different meshes which use the same texture when exporting,
+            // the meshes are combined using CBatchingMesh.
+            scene::CBatchingMesh *merged_mesh = new scene::CBatchingMesh();
+            merged_mesh->addMesh(mesh);
+            merged_mesh->finalize();
+            tangent_mesh = merged_mesh;
+            // The reference count of the mesh is 1, since it is in irrlicht's
+            // cache. So we only have to remove it from the cache.
+            irr_driver->removeMeshFromCache(mesh);
+        }
+        else
+        {
+            // SPM does the combine for you
+            tangent_mesh = mesh;
+            tangent_mesh->grab();
+        }
+        // The merged mesh is grabbed by the octtree, so we don't need
+        // to keep a reference to it.
+        scene_node = irr_driver->addMesh(tangent_mesh, "track_main");
+        // We should drop the merged mesh (since it's now referred to in the
+        // scene node), but then we need to grab it since it's in the
+        // m_all_cached_meshes.
+        m_all_cached_meshes.push_back(tangent_mesh);
+        irr_driver->grabAllTextures(tangent_mesh);
+        main_loop->renderGUI(4000);
 
 #ifdef DEBUG
-    std::string debug_name=model_name+" (main track, octtree)";
-    scene_node->setName(debug_name.c_str());
+        std::string debug_name=model_name+" (main track, octtree)";
+        scene_node->setName(debug_name.c_str());
 #endif
-    //merged_mesh->setHardwareMappingHint(scene::EHM_STATIC);
+        //merged_mesh->setHardwareMappingHint(scene::EHM_STATIC);
 
-    core::vector3df xyz(0,0,0);
-    track_node->getXYZ(&xyz);
-    core::vector3df hpr(0,0,0);
-    track_node->getHPR(&hpr);
-    scene_node->setPosition(xyz);
-    scene_node->setRotation(hpr);
-    handleAnimatedTextures(scene_node, *track_node);
-    m_all_nodes.push_back(scene_node);
+        scene_node->setPosition(xyz);
+        scene_node->setRotation(hpr);
+        handleAnimatedTextures(scene_node, *track_node);
+        m_all_nodes.push_back(scene_node);
+
+        MeshTools::minMax3D(tangent_mesh, &m_aabb_min, &m_aabb_max);
+    }   // if physics_only
 
-    MeshTools::minMax3D(tangent_mesh, &m_aabb_min, &m_aabb_max);
     // Increase the maximum height of the track: since items that fly
     // too high explode, e.g. cakes can not be show when being at the
     // top of the track (since they will explode when leaving the AABB
@@ -1351,6 +1482,23 @@ bool Track::loadMainTrack(const XMLNode &root)
                 m_all_nodes.push_back( node );
             }
         }
+        else if (physics_only && challenge.empty() &&
+                 SPMCollisionLoader::load(full_path, &model.m_buffers))
+        {
+            model.m_transform = getModelTransform(xyz, hpr, scale);
+            if (interaction == "physics-only")
+            {
+                PhysicsOnlyObject object;
+                object.m_node  = NULL;
+                object.m_model = model;
+                m_static_physics_only_objects.push_back(object);
+            }
+            else
+            {
+                convert_nodes();
+                addModelTriangles(model);
+            }
+        }
         else
         {
             // TODO: check if mesh is animated or not
@@ -1460,7 +1608,11 @@ bool Track::loadMainTrack(const XMLNode &root)
             else
             {
                 if(interaction=="physics-only")
-                    m_static_physics_only_nodes.push_back(scene_node);
+                {
+                    PhysicsOnlyObject object;
+                    object.m_node = scene_node;
+                    m_static_physics_only_objects.push_back(object);
+                }
                 else
                     m_all_nodes.push_back( scene_node );
             }
@@ -1469,17 +1621,10 @@ bool Track::loadMainTrack(const XMLNode &root)
     }   // for i
 
     // This will (at this stage) only convert the main track model.
-    for(unsigned int i=0; i<m_all_nodes.size(); i++)
-    {
-        main_loop->renderGUI(4350, i, m_all_nodes.size());
-        convertTrackToBullet(m_all_nodes[i]);
-        main_loop->renderGUI(4360, i, m_all_nodes.size());
-        uploadNodeVertexBuffer(m_all_nodes[i]);
-        main_loop->renderGUI(4400, i, m_all_nodes.size());
-    }
+    convert_nodes();
 
     // Free the tangent (track mesh) after converting to physics
-    if (ProfileWorld::isNoGraphics())
+    if (ProfileWorld::isNoGraphics() && tangent_mesh)
         tangent_mesh->freeMeshVertexBuffer();
 
     if (m_track_mesh == NULL)
@@ -1488,8 +1633,11 @@ bool Track::loadMainTrack(const XMLNode &root)
     }
 
     m_gfx_effect_mesh->createCollisionShape();
-    scene_node->setMaterialFlag(video::EMF_LIGHTING, true);
-    scene_node->setMaterialFlag(video::EMF_GOURAUD_SHADING, true);
+    if (scene_node)
+    {
+        scene_node->setMaterialFlag(video::EMF_LIGHTING, true);
+        scene_node->setMaterialFlag(video::EMF_GOURAUD_SHADING, true);
+    }
     main_loop->renderGUI(4500);
 
     return true;
@@ -2858,3 +3006,226 @@ void Track::uploadNodeVertexBuffer(scene::ISceneNode *node)
     }
 #endif
 }   // uploadNodeVertexBuffer
+
+// ----------------------------------------------------------------------------
+/** Returns the main track model and the static objects of the scene file of
+ *  the first mode of this track, as read in loadMainTrack(). LOD instances
+ *  and challenge objects are not included. This reads the scene file, so it
+ *  is only meant for benchmarks.
+ *  \param models On return the static models of this track.
+ */
+void Track::getStaticModels(std::vector<StaticModel> *models) const
+{
+    models->clear();
+    if (m_all_modes.empty())
+        return;
+    XMLNode *root = file_manager->createXMLTree(m_root +
+                                                m_all_modes[0].m_scene);
+    const XMLNode *track_node = root ? root->getNode("track") : NULL;
+    if (!track_node)
+    {
+        delete root;
+        return;
+    }
+    for (unsigned int i = 0; i <= track_node->getNumNodes(); i++)
+    {
+        // The main track model first, then all static objects
+        const XMLNode *n = i == 0 ? track_node : track_node->getNode(i-1);
+        if (i > 0 && n->getName() != "static-object")
+            continue;
+        bool lod_instance = false;
+        n->get("lod_instance", &lod_instance);
+        std::string challenge, model_name;
+        n->get("challenge", &challenge);
+        n->get("model", &model_name);
+        if (lod_instance || !challenge.empty())
+            continue;
+        StaticModel m;
+        m.m_full_path = m_root + model_name;
+        m.m_xyz = m.m_hpr = core::vector3df(0, 0, 0);
+        m.m_scale = core::vector3df(1.0f, 1.0f, 1.0f);
+        n->get("xyz", &m.m_xyz);
+        n->get("hpr", &m.m_hpr);
+        if (i > 0)
+            n->get("scale", &m.m_scale);
+        models->push_back(m);
+    }
+    delete root;
+}   // getStaticModels
+
+// ----------------------------------------------------------------------------
+/** Compares reading the static models of all shipped tracks (the main track
+ *  model and the static objects, as loaded in loadMainTrack()) into the
+ *  physics through irrlicht meshes and scene nodes with reading them
+ *  without scene nodes as done on a server. It prints the time and the
+ *  increase of the peak resident memory of both for each track, and checks
+ *  that both give the same triangles. LOD and challenge objects and models
+ *  which are not static spm files are not included.
+ */
+void Track::benchmark()
+{
+#ifndef SERVER_ONLY
+    if (CVS->isGLSL())
+    {
+        Log::info("Benchmark", "Only available without shader based "
+                  "rendering, e.g. with --no-graphics.");
+        return;
+    }
+#endif
+
+    // The resident memory, and its peak since the last reset in kB
+    auto read_status = [](const std::string &key) -> uint64_t
+    {
+#ifdef __linux__
+        std::ifstream status("/proc/self/status");
+        std::string line;
+        while (std::getline(status, line))
+        {
+            if (line.compare(0, key.size(), key) == 0)
+                return atoll(line.c_str() + key.size());
+        }
+#endif
+        return 0;
+    };
+    auto reset_peak = []()
+    {
+#ifdef __linux__
+        std::ofstream clear_refs("/proc/self/clear_refs");
+        clear_refs << "5";
+#endif
+    };
+    auto checksum = [](const TriangleMesh *tm)
+    {
+        uint64_t h = 14695981039346656037ULL;
+        auto add = [&h](const btVector3 &v)
+        {
+            unsigned char bytes[3 * sizeof(float)];
+            const float f[3] = { v.getX(), v.getY(), v.getZ() };
+            memcpy(bytes, f, sizeof(bytes));
+            for (unsigned char b : bytes)
+                h = (h ^ b) * 1099511628211ULL;
+        };
+        for (unsigned int i = 0; i < tm->getNumTriangles(); i++)
+        {
+            btVector3 p[3], n[3];
+            tm->getTriangle(i, &p[0], &p[1], &p[2]);
+            tm->getNormals(i, &n[0], &n[1], &n[2]);
+            for (unsigned int k = 0; k < 3; k++)
+            {
+                add(p[k]);
+                add(n[k]);
+            }
+            h = (h ^ (uint64_t)(size_t)tm->getMaterial(i)) * 1099511628211ULL;
+        }
+        return h;
+    };
+
+    double total_scene_ms = 0, total_physics_only_ms = 0;
+    unsigned int num_tracks = 0, num_mismatches = 0;
+    for (unsigned int t = 0; t < track_manager->getNumberOfTracks(); t++)
+    {
+        Track *track = track_manager->getTrack(t);
+        if (track->isAddon())
+            continue;
+        std::vector<StaticModel> models;
+        track->getStaticModels(&models);
+        if (models.empty())
+            continue;
+
+        file_manager->pushTextureSearchPath(track->m_root,
+            StringUtils::insertValues("tracks/%s", track->m_ident.c_str()));
+        file_manager->pushModelSearchPath(track->m_root);
+        const std::string materials_file = track->m_root + "materials.xml";
+        const bool has_materials = file_manager->fileExists(materials_file);
+        if (has_materials)
+            material_manager->pushTempMaterial(materials_file);
+
+        // Without scene nodes
+        track->m_track_mesh = new TriangleMesh(/*can_be_transformed*/false);
+        track->m_gfx_effect_mesh = new TriangleMesh(false);
+        uint64_t rss = read_status("VmRSS:");
+        reset_peak();
+        uint64_t start = StkTime::getMonoTimeUs();
+        std::vector<bool> read(models.size(), false);
+        for (unsigned int i = 0; i < models.size(); i++)
+        {
+            CollisionModel model;
+            read[i] = SPMCollisionLoader::load(models[i].m_full_path,
+                                               &model.m_buffers);
+            if (!read[i])
+                continue;
+            model.m_transform = getModelTransform(models[i].m_xyz,
+                models[i].m_hpr, models[i].m_scale);
+            track->addModelTriangles(model);
+        }
+        const double physics_only_ms =
+            (StkTime::getMonoTimeUs() - start) / 1000.0;
+        const uint64_t physics_only_kb = read_status("VmHWM:") - rss;
+        const unsigned int num_triangles =
+            track->m_track_mesh->getNumTriangles() +
+            track->m_gfx_effect_mesh->getNumTriangles();
+        const uint64_t physics_only_hash =
+            checksum(track->m_track_mesh) * 31 +
+            checksum(track->m_gfx_effect_mesh);
+        delete track->m_track_mesh;
+        delete track->m_gfx_effect_mesh;
+
+        // With irrlicht meshes and scene nodes
+        track->m_track_mesh = new TriangleMesh(/*can_be_transformed*/false);
+        track->m_gfx_effect_mesh = new TriangleMesh(false);
+        rss = read_status("VmRSS:");
+        reset_peak();
+        start = StkTime::getMonoTimeUs();
+        std::vector<scene::IMesh*> meshes;
+        for (unsigned int i = 0; i < models.size(); i++)
+        {
+            if (!read[i])
+                continue;
+            scene::IMesh *mesh = irr_driver->getMesh(models[i].m_full_path);
+            if (!mesh)
+                continue;
+            meshes.push_back(mesh);
+            scene::ISceneNode *node = irr_driver->addMesh(mesh, "benchmark");
+            node->setPosition(models[i].m_xyz);
+            node->setRotation(models[i].m_hpr);
+            node->setScale(models[i].m_scale);
+            track->convertTrackToBullet(node);
+            irr_driver->removeNode(node);
+        }
+        for (scene::IMesh *mesh : meshes)
+            irr_driver->removeMeshFromCache(mesh);
+        const double scene_ms = (StkTime::getMonoTimeUs() - start) / 1000.0;
+        const uint64_t scene_kb = read_status("VmHWM:") - rss;
+        const bool same =
+            num_triangles == track->m_track_mesh->getNumTriangles() +
+                             track->m_gfx_effect_mesh->getNumTriangles() &&
+            physics_only_hash == checksum(track->m_track_mesh) * 31 +
+                                 checksum(track->m_gfx_effect_mesh);
+        delete track->m_track_mesh;
+        delete track->m_gfx_effect_mesh;
+        track->m_track_mesh = NULL;
+        track->m_gfx_effect_mesh = NULL;
+
+        if (has_materials)
+            material_manager->popTempMaterial();
+        file_manager->popModelSearchPath();
+        file_manager->popTextureSearchPath();
+
+        const unsigned int num_read =
+            (unsigned int)std::count(read.begin(), read.end(), true);
+        Log::info("Benchmark", "%-20s %3u/%3u models, %7u triangles: "
+            "scene nodes %8.2f ms, +%6.1f MB peak RSS, physics only "
+            "%8.2f ms, +%6.1f MB peak RSS%s", track->m_ident.c_str(),
+            num_read, (unsigned int)models.size(), num_triangles,
+            scene_ms, scene_kb / 1024.0f, physics_only_ms,
+            physics_only_kb / 1024.0f, same ? "" : ", DIFFERENT TRIANGLES");
+        total_scene_ms += scene_ms;
+        total_physics_only_ms += physics_only_ms;
+        num_tracks++;
+        if (!same)
+            num_mismatches++;
+    }
+    Log::info("Benchmark", "%u tracks: scene nodes %.2f ms, physics only "
+              "%.2f ms, %u tracks with different triangles.", num_tracks,
+              total_scene_ms, total_physics_only_ms, num_mismatches);
+}   // benchmark
@@ -36,6 +36,7 @@ using namespace irr;
 
 #include "LinearMath/btTransform.h"
 
+#include "physics/spm_collision_loader.hpp"
 #include "utils/aligned_array.hpp"
 #include "utils/log.hpp"
 #include "utils/vec3.hpp"
@@ -141,9 +142,28 @@ private:
     /** The list of all nodes. */
     std::vector<scene::ISceneNode*> m_all_nodes;
 
-    /** The list of all nodes that are to be converted into physics,
-     *  but not to be drawn (e.g. invisible walls). */
-    std::vector<scene::ISceneNode*> m_static_physics_only_nodes;
+    /** The collision geometry of a static model which was read without
+     *  creating an irrlicht mesh and scene node. */
+    struct CollisionModel
+    {
+        std::vector<SPMCollisionLoader::Buffer> m_buffers;
+        core::matrix4                           m_transform;
+    };
+
+    /** An object that is to be converted into physics, but not to be drawn
+     *  (e.g. an invisible wall). It is either a scene node, or (if m_node
+     *  is NULL) a model which was read without scene node. */
+    struct PhysicsOnlyObject
+    {
+        scene::ISceneNode *m_node;
+        CollisionModel     m_model;
+    };
+
+    /** The list of all static objects that are only used for the physics,
+     *  in the order of the scene file. createPhysicsModel() converts them
+     *  in this order, so the triangle order does not depend on whether an
+     *  object was read with or without scene node. */
+    std::vector<PhysicsOnlyObject> m_static_physics_only_objects;
 
     /** Same concept but for track objects. stored separately due to different
       * memory management.
@@ -395,6 +415,7 @@ private:
     void loadArenaGraph(const XMLNode &node);
     btQuaternion getArenaStartRotation(const Vec3& xyz, float heading);
     bool loadMainTrack(const XMLNode &node);
+    void addModelTriangles(const CollisionModel &model);
     void loadMinimap();
     void createWater(const XMLNode &node);
     void getMusicInformation(std::vector<std::string>&  filenames,
@@ -418,6 +439,16 @@ public:
     /** Static helper function to pre-upload vertex buffer in spm. */
     static void uploadNodeVertexBuffer(scene::ISceneNode *node);
 
+    /** A static model of the scene file, see getStaticModels(). */
+    struct StaticModel
+    {
+        std::string     m_full_path;
+        core::vector3df m_xyz, m_hpr, m_scale;
+    };
+    void getStaticModels(std::vector<StaticModel> *models) const;
+
+    static void benchmark();
+
     static const float NOHIT;
 
                        Track             (const std::string &filename);
@@ -22,6 +22,7 @@
 #include "graphics/irr_driver.hpp"
 #include "io/file_manager.hpp"
 #include "tracks/track.hpp"
+#include "utils/string_utils.hpp"
 
 #include <algorithm>
 #include <iostream>
@@ -83,14 +84,8 @@ int TrackManager::getNumberOfRaceTracks() const
  */
 Track* TrackManager::getTrack(const std::string& ident) const
 {
-    for(Tracks::const_iterator i = m_tracks.begin(); i != m_tracks.end(); ++i)
-    {
-        if ((*i)->getIdent() == ident)
-            return *i;
-    }
-
-    return NULL;
-
+    const int index = getTrackIndexByIdent(ident);
+    return index == -1 ? NULL : m_tracks[index];
 }   // getTrack
 
 //-----------------------------------------------------------------------------
@@ -155,6 +150,7 @@ void TrackManager::loadTrackList()
     for (Track* track : m_tracks)
         delete track;
     m_tracks.clear();
+    m_track_ident_index.clear();
 
     for(unsigned int i=0; i<m_track_search_path.size(); i++)
     {
@@ -177,6 +173,50 @@ void TrackManager::loadTrackList()
     }   // for i <m_track_search_path.size()
 }  // loadTrackList
 
+// ----------------------------------------------------------------------------
+/** Appends the XML files read by loadTrackList() to the given list, so that
+ *  they can be parsed in advance (see FileManager::preloadXMLTrees()). This
+ *  uses the same directories and file names as loadTrackList().
+ *  \param files On return the track.xml and easter_eggs.xml files of all
+ *         tracks are appended.
+ */
+void TrackManager::getTrackListXMLFiles(std::vector<std::string> *files) const
+{
+    for(unsigned int i=0; i<m_track_search_path.size(); i++)
+    {
+        const std::string &dir = m_track_search_path[i];
+        std::vector<std::string> track_dirs;
+        if(file_manager->fileExists(dir+"track.xml"))
+        {
+            track_dirs.push_back(dir);
+        }
+        else
+        {
+            std::set<std::string> dirs;
+            file_manager->listFiles(dirs, dir);
+            for(std::set<std::string>::iterator subdir = dirs.begin();
+                subdir != dirs.end(); subdir++)
+            {
+                if(*subdir=="." || *subdir=="..") continue;
+                track_dirs.push_back(dir+*subdir+"/");
+            }
+        }
+
+        for(unsigned int j=0; j<track_dirs.size(); j++)
+        {
+            const std::string config_file = track_dirs[j]+"track.xml";
+            if(!file_manager->fileExists(config_file))
+                continue;
+            files->push_back(config_file);
+            // See Track::loadTrackInfo()
+            const std::string easter_file =
+                StringUtils::getPath(config_file) + "/easter_eggs.xml";
+            if(file_manager->fileExists(easter_file))
+                files->push_back(easter_file);
+        }
+    }   // for i <m_track_search_path.size()
+}   // getTrackListXMLFiles
+
 // ----------------------------------------------------------------------------
 /** Tries to load a track from a single directory. Returns true if a track was
  *  successfully loaded.
@@ -215,6 +255,10 @@ bool TrackManager::loadTrack(const std::string& dirname)
     }
     m_all_track_dirs.push_back(dirname);
     m_tracks.push_back(track);
+    // Does not replace an existing entry, the first track with an
+    // identifier is found
+    m_track_ident_index.insert(std::make_pair(track->getIdent(),
+                                              (int)m_tracks.size() - 1));
     m_track_avail.push_back(true);
     updateGroups(track);
 
@@ -297,9 +341,24 @@ void TrackManager::removeTrack(const std::string &ident)
     m_tracks.erase(it);
     m_all_track_dirs.erase(m_all_track_dirs.begin()+index);
     m_track_avail.erase(m_track_avail.begin()+index);
+    rebuildIdentIndex();
     delete track;
 }   // removeTrack
 
+// ----------------------------------------------------------------------------
+/** Recomputes the index of all track identifiers, used after a track was
+ *  removed, which moves all following tracks down.
+ */
+void TrackManager::rebuildIdentIndex()
+{
+    m_track_ident_index.clear();
+    for (unsigned int i = 0; i < m_tracks.size(); i++)
+    {
+        m_track_ident_index.insert(std::make_pair(m_tracks[i]->getIdent(),
+                                                  (int)i));
+    }
+}   // rebuildIdentIndex
+
 // ----------------------------------------------------------------------------
 /** \brief Updates the groups after a track was read in.
   * \param track Pointer to the new track, whose groups are now analysed.
@@ -332,12 +391,14 @@ void TrackManager::updateGroups(const Track* track)
 }   // updateGroups
 
 // ----------------------------------------------------------------------------
+/** Returns the index of the track with the given identifier in m_tracks, or
+ *  -1 if there is no such track. This is called by the network thread for
+ *  each ping packet of a client, so it uses a hash map instead of comparing
+ *  all identifiers.
+ *  \param ident Identifier of the track.
+ */
 int TrackManager::getTrackIndexByIdent(const std::string& ident) const
 {
-    for (unsigned i = 0; i < m_tracks.size(); i++)
-    {
-        if (m_tracks[i]->getIdent() == ident)
-            return i;
-    }
-    return -1;
+    auto it = m_track_ident_index.find(ident);
+    return it == m_track_ident_index.end() ? -1 : it->second;
 }   // getTrackIndexByIdent
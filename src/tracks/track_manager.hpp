@@ -20,6 +20,7 @@
 #define HEADER_TRACK_MANAGER_HPP
 
 #include <string>
+#include <unordered_map>
 #include <vector>
 #include <map>
 
@@ -43,6 +44,10 @@ private:
     /** All track objects. */
     Tracks                                   m_tracks;
 
+    /** Maps the identifier of a track to its index in m_tracks. If several
+     *  tracks have the same identifier, the first one is used. */
+    std::unordered_map<std::string, int>     m_track_ident_index;
+
     typedef std::map<std::string, std::vector<int> > Group2Indices;
     /** List of all racing track groups. */
     Group2Indices                            m_track_groups;
@@ -68,6 +73,7 @@ private:
     std::vector<bool>                        m_track_avail;
 
     void          updateGroups(const Track* track);
+    void          rebuildIdentIndex();
 
 public:
                 TrackManager();
@@ -79,6 +85,7 @@ public:
 
     /** Load all .track files from all directories */
     void  loadTrackList();
+    void  getTrackListXMLFiles(std::vector<std::string> *files) const;
     void  removeTrack(const std::string &ident);
     bool  loadTrack(const std::string& dirname);
     void  removeAllCachedData();
@@ -0,0 +1,88 @@
+//
+//  SuperTuxKart - a fun racing game with go-kart
+//  Copyright (C) 2019 SuperTuxKart-Team
+//
+//  This program is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU General Public License
+//  as published by the Free Software Foundation; either version 3
+//  of the License, or (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+
+#ifndef HEADER_BLOCK_POOL_HPP
+#define HEADER_BLOCK_POOL_HPP
+
+#include "utils/no_copy.hpp"
+
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+/** A free list of memory blocks of the same size, used by class specific
+ *  operator new and delete of small objects which are created and deleted
+ *  at a high rate (e.g. one for each network message). Reusing the memory of
+ *  deleted objects avoids the allocator and keeps them close together in
+ *  memory. The objects can be created and deleted in different threads, so
+ *  the pool is locked. The memory is never returned to the system.
+ */
+template<size_t BLOCK_SIZE, unsigned BLOCKS_PER_CHUNK = 1024>
+class BlockPool : public NoCopy
+{
+private:
+    union Block
+    {
+        Block* m_next;
+        long double m_align;
+        char m_data[BLOCK_SIZE];
+    };
+
+    std::mutex m_mutex;
+
+    /** First block of the free list. */
+    Block* m_free;
+
+    /** All memory allocated for the pool. */
+    std::vector<std::unique_ptr<Block[]> > m_chunks;
+
+public:
+    BlockPool() : m_free(NULL) {}
+    // ------------------------------------------------------------------------
+    /** Returns if an object of the given size fits into a block. */
+    static bool fits(size_t size) { return size <= BLOCK_SIZE; }
+    // ------------------------------------------------------------------------
+    void* allocate()
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (!m_free)
+        {
+            Block* chunk = new Block[BLOCKS_PER_CHUNK];
+            m_chunks.emplace_back(chunk);
+            for (unsigned i = BLOCKS_PER_CHUNK; i > 0; i--)
+            {
+                chunk[i - 1].m_next = m_free;
+                m_free = &chunk[i - 1];
+            }
+        }
+        Block* block = m_free;
+        m_free = block->m_next;
+        return block;
+    }   // allocate
+    // ------------------------------------------------------------------------
+    void free(void* ptr)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        Block* block = (Block*)ptr;
+        block->m_next = m_free;
+        m_free = block;
+    }   // free
+};   // BlockPool
+
+#endif
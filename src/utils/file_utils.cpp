@@ -19,9 +19,14 @@
 #include "utils/log.hpp"
 #include "utils/string_utils.hpp"
 
+#include <atomic>
 #include <stdio.h>
+#include <string.h>
 #include <string>
 #include <sys/stat.h>
+#if !defined(WIN32)
+#include <unistd.h>
+#endif
 
 // ----------------------------------------------------------------------------
 #if defined(WIN32)
@@ -166,3 +171,74 @@ int FileUtils::renameU8Path(const std::string& u8_path_old,
     return rename(u8_path_old.c_str(), u8_path_new.c_str());
 #endif
 }   // renameU8Path
+
+// ----------------------------------------------------------------------------
+/** Returns a name for a temporary file next to u8_path, which is unique for
+ *  each call in this process and contains the process id. A file can be
+ *  written under this name and then be renamed to u8_path, without another
+ *  process or thread writing the same temporary file at the same time.
+ */
+std::string FileUtils::getTemporaryPath(const std::string& u8_path)
+{
+    static std::atomic<unsigned> counter(0);
+#if defined(WIN32)
+    const unsigned pid = (unsigned)GetCurrentProcessId();
+#else
+    const unsigned pid = (unsigned)getpid();
+#endif
+    return u8_path + "." + StringUtils::toString(pid) + "-" +
+        StringUtils::toString(counter.fetch_add(1)) + ".tmp";
+}   // getTemporaryPath
+
+// ----------------------------------------------------------------------------
+/** Writes a file under a temporary name from getTemporaryPath() and then
+ *  renames it to u8_path. So other processes (e.g. several servers sharing
+ *  a cache file) never read a partially written file, and if two processes
+ *  write the same file the last one wins. Returns false and removes the
+ *  temporary file if writing or renaming failed.
+ *  \param u8_path Name of the file to write.
+ *  \param write Writes the content to the opened file and returns false on
+ *         errors.
+ */
+bool FileUtils::writeFileAtomically(const std::string& u8_path,
+                                    const std::function<bool(FILE*)>& write)
+{
+    const std::string tmp = getTemporaryPath(u8_path);
+    FILE* f = fopenU8Path(tmp, "wb");
+    if (!f)
+        return false;
+    bool ok = write(f);
+    ok = fclose(f) == 0 && ok;
+    if (ok && renameU8Path(tmp, u8_path) != 0)
+    {
+        // Windows does not replace existing files when renaming
+        remove(u8_path.c_str());
+        ok = renameU8Path(tmp, u8_path) == 0;
+    }
+    if (!ok)
+        remove(tmp.c_str());
+    return ok;
+}   // writeFileAtomically
+
+// ----------------------------------------------------------------------------
+/** A 64 bit FNV-1a variant that hashes 8 bytes at a time, used to detect
+ *  damaged or outdated cache files. Hashes of several blocks can be
+ *  chained by passing the previous result as start value.
+ *  \param data The bytes to hash.
+ *  \param size Number of bytes.
+ *  \param hash Start value, HASH_SEED for the first block.
+ */
+uint64_t FileUtils::hashBytes(const void* data, size_t size, uint64_t hash)
+{
+    const unsigned char* p = (const unsigned char*)data;
+    const uint64_t prime = 0x100000001b3ULL;
+    for (; size >= 8; size -= 8, p += 8)
+    {
+        uint64_t word;
+        memcpy(&word, p, 8);
+        hash = (hash ^ word) * prime;
+    }
+    for (; size > 0; size--, p++)
+        hash = (hash ^ *p) * prime;
+    return hash;
+}   // hashBytes
@@ -18,7 +18,9 @@
 #ifndef HEADER_FILE_UTILS_HPP
 #define HEADER_FILE_UTILS_HPP
 
+#include <stdint.h>
 #include <stdio.h>
+#include <functional>
 #include <string>
 #include <sys/stat.h>
 #include "irrString.h"
@@ -39,6 +41,16 @@ namespace FileUtils
     int renameU8Path(const std::string& u8_path_old,
                      const std::string& u8_path_new);
     // ------------------------------------------------------------------------
+    std::string getTemporaryPath(const std::string& u8_path);
+    // ------------------------------------------------------------------------
+    bool writeFileAtomically(const std::string& u8_path,
+                             const std::function<bool(FILE*)>& write);
+    // ------------------------------------------------------------------------
+    /** Start value of hashBytes(). */
+    const uint64_t HASH_SEED = 0xcbf29ce484222325ULL;
+    uint64_t hashBytes(const void* data, size_t size,
+                       uint64_t hash = HASH_SEED);
+    // ------------------------------------------------------------------------
     /* Return a path which can be opened for writing in all systems, as long as
      * u8_path is unicode encoded. */
     inline std::string getPortableWritingPath(const std::string& u8_path)
@@ -0,0 +1,155 @@
+//
+//  SuperTuxKart - a fun racing game with go-kart
+//  Copyright (C) 2019 SuperTuxKart-Team
+//
+//  This program is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU General Public License
+//  as published by the Free Software Foundation; either version 3
+//  of the License, or (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+
+#include "utils/thread_pool.hpp"
+
+#include "utils/vs.hpp"
+
+namespace
+{
+    /** True if the current thread is running jobs of any thread pool, used
+     *  to run nested parallelFor calls serially instead of deadlocking. */
+    thread_local bool g_in_thread_pool = false;
+}
+
+// ----------------------------------------------------------------------------
+/** Creates the pool and starts the worker threads.
+ *  \param num_threads Number of worker threads, 0 means all jobs are run by
+ *         the thread calling parallelFor.
+ *  \param name Name of the worker threads (for debugging).
+ */
+ThreadPool::ThreadPool(unsigned num_threads, const std::string& name)
+{
+    m_job            = NULL;
+    m_job_count      = 0;
+    m_next_job.store(0);
+    m_finished_jobs  = 0;
+    m_active_workers = 0;
+    m_generation     = 0;
+    m_exit           = false;
+    for (unsigned i = 0; i < num_threads; i++)
+    {
+        m_threads.emplace_back(std::bind(&ThreadPool::workerLoop, this,
+            name));
+    }
+}   // ThreadPool
+
+// ----------------------------------------------------------------------------
+ThreadPool::~ThreadPool()
+{
+    std::unique_lock<std::mutex> ul(m_mutex);
+    m_exit = true;
+    m_job_cv.notify_all();
+    ul.unlock();
+    for (std::thread& t : m_threads)
+        t.join();
+}   // ~ThreadPool
+
+// ----------------------------------------------------------------------------
+/** Picks up jobs of the current job set until none are left.
+ *  \return Number of jobs run by this thread.
+ */
+unsigned ThreadPool::runJobs(const std::function<void(unsigned)>& job,
+                             unsigned count)
+{
+    unsigned done = 0;
+    const bool in_thread_pool = g_in_thread_pool;
+    g_in_thread_pool = true;
+    while (true)
+    {
+        const unsigned i = m_next_job.fetch_add(1);
+        if (i >= count)
+            break;
+        job(i);
+        done++;
+    }
+    g_in_thread_pool = in_thread_pool;
+    return done;
+}   // runJobs
+
+// ----------------------------------------------------------------------------
+void ThreadPool::workerLoop(const std::string& name)
+{
+    VS::setThreadName(name.c_str());
+    unsigned seen_generation = 0;
+    std::unique_lock<std::mutex> ul(m_mutex);
+    while (true)
+    {
+        m_job_cv.wait(ul, [this, seen_generation]()
+            {
+                return m_exit ||
+                    (m_job != NULL && m_generation != seen_generation);
+            });
+        if (m_exit)
+            return;
+        seen_generation = m_generation;
+        const std::function<void(unsigned)>* job = m_job;
+        const unsigned count = m_job_count;
+        m_active_workers++;
+        ul.unlock();
+
+        const unsigned done = runJobs(*job, count);
+
+        ul.lock();
+        m_finished_jobs += done;
+        m_active_workers--;
+        if (m_finished_jobs == m_job_count && m_active_workers == 0)
+            m_done_cv.notify_one();
+    }
+}   // workerLoop
+
+// ----------------------------------------------------------------------------
+/** Calls job(i) for each i in [0, count) using the worker threads and the
+ *  calling thread, and returns when all jobs are finished. The order in
+ *  which the jobs are run is not defined, so each job must only write to
+ *  its own data.
+ *  \param count Number of jobs.
+ *  \param job Function to call for each job index.
+ */
+void ThreadPool::parallelFor(unsigned count,
+                             const std::function<void(unsigned)>& job)
+{
+    if (count == 0)
+        return;
+    if (m_threads.empty() || count == 1 || g_in_thread_pool)
+    {
+        for (unsigned i = 0; i < count; i++)
+            job(i);
+        return;
+    }
+
+    std::lock_guard<std::mutex> submit_lock(m_submit_mutex);
+    std::unique_lock<std::mutex> ul(m_mutex);
+    m_job           = &job;
+    m_job_count     = count;
+    m_next_job.store(0);
+    m_finished_jobs = 0;
+    m_generation++;
+    m_job_cv.notify_all();
+    ul.unlock();
+
+    const unsigned done = runJobs(job, count);
+
+    ul.lock();
+    m_finished_jobs += done;
+    m_done_cv.wait(ul, [this]()
+        {
+            return m_finished_jobs == m_job_count && m_active_workers == 0;
+        });
+    m_job = NULL;
+}   // parallelFor
@@ -0,0 +1,97 @@
+//
+//  SuperTuxKart - a fun racing game with go-kart
+//  Copyright (C) 2019 SuperTuxKart-Team
+//
+//  This program is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU General Public License
+//  as published by the Free Software Foundation; either version 3
+//  of the License, or (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+
+#ifndef HEADER_THREAD_POOL_HPP
+#define HEADER_THREAD_POOL_HPP
+
+#include "utils/no_copy.hpp"
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/** A small fixed size pool of worker threads used to split independent work
+ *  (e.g. one job per peer or per kart) across cpu cores. Work is submitted
+ *  with parallelFor(), which blocks until all jobs are done, so callers don't
+ *  need any extra synchronisation for the results. The calling thread works
+ *  on the jobs too.
+ *  Calling parallelFor() from inside a job runs the nested jobs serially.
+ */
+class ThreadPool : public NoCopy
+{
+private:
+    /** The worker threads, can be empty if no extra thread is used. */
+    std::vector<std::thread> m_threads;
+
+    /** Serialises concurrent parallelFor calls from different threads. */
+    std::mutex m_submit_mutex;
+
+    /** Protects the job state below and is used with the condition
+     *  variables. */
+    std::mutex m_mutex;
+
+    /** Signals the workers that a new job set is available or exit. */
+    std::condition_variable m_job_cv;
+
+    /** Signals the submitting thread that all jobs are finished. */
+    std::condition_variable m_done_cv;
+
+    /** The function executed for each job index. */
+    const std::function<void(unsigned)>* m_job;
+
+    /** Number of jobs of the current job set. */
+    unsigned m_job_count;
+
+    /** Next job index to be picked up by any thread. */
+    std::atomic<unsigned> m_next_job;
+
+    /** Number of jobs finished in the current job set. */
+    unsigned m_finished_jobs;
+
+    /** Number of workers which are currently running jobs of the current
+     *  job set. */
+    unsigned m_active_workers;
+
+    /** Increased for each job set so that workers can detect new work. */
+    unsigned m_generation;
+
+    /** Set when the pool is destroyed. */
+    bool m_exit;
+
+    // ------------------------------------------------------------------------
+    void workerLoop(const std::string& name);
+    // ------------------------------------------------------------------------
+    unsigned runJobs(const std::function<void(unsigned)>& job,
+                     unsigned count);
+
+public:
+    ThreadPool(unsigned num_threads, const std::string& name);
+    // ------------------------------------------------------------------------
+    ~ThreadPool();
+    // ------------------------------------------------------------------------
+    void parallelFor(unsigned count, const std::function<void(unsigned)>& job);
+    // ------------------------------------------------------------------------
+    /** Returns the number of worker threads (excluding the calling thread).*/
+    unsigned getNumThreads() const { return (unsigned)m_threads.size(); }
+};   // ThreadPool
+
+#endif
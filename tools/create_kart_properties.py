@@ -201,12 +201,23 @@ def createKpGetter(groups):
             typeC = m.typeC
             result = "result"
 
+            # Floats and bools are read directly from the flat table of the
+            # cache, the other types are copied by the generic getters
+            if typeC == "float":
+                getter = "getFloat(\n        AbstractCharacteristic::{0})".format(
+                    nameUnderscore.upper())
+            elif typeC == "bool":
+                getter = "getBool(\n        AbstractCharacteristic::{0})".format(
+                    nameUnderscore.upper())
+            else:
+                getter = "get{0}()".format(nameTitle)
+
             print("""// ----------------------------------------------------------------------------
 {1} KartProperties::get{0}() const
 {{
-    return m_cached_characteristic->get{0}();
+    return m_cached_characteristic->{2};
 }}  // get{0}
-""".format(nameTitle, typeC))
+""".format(nameTitle, typeC, getter))
 
 def createGetType(groups):
     for g in groups: